@@ -244,6 +244,11 @@ bool Application::Frame(Input* input) {
         return false;
     }
 
+	// Upload streamed textures before anything is rendered (new skyboxes render their environment maps here)
+	if(!m_DemoScene->UpdateTextureUploads()) {
+		return false;
+	}
+
 	// Render 3D scene to render texture
 	if(!RenderSceneToScreenTexture()) {
 		return false;
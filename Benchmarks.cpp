@@ -0,0 +1,1912 @@
+#include "Benchmarks.h"
+
+#include "Texture.h"
+#include "Model.h"
+#include "PrimitiveGenerator.h"
+#include "Camera.h"
+#include "GeometryArena.h"
+#include "OffsetAllocator.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
+#include "HDRDecoder.h"
+#include "DDSFile.h"
+#include "MipGenerator.h"
+#include "BlockCompressor.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "MeshletCuller.h"
+#include "MeshBVH.h"
+#include "BoundingVolumes.h"
+#include "TangentGenerator.h"
+
+#include "stb_image.h"
+
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace {
+	using SceneData = Benchmarks::SceneData;
+
+	/// Shared fixtures
+
+	float GetElapsedMilliseconds(std::chrono::steady_clock::time_point startTime) {
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	// Best of runCount runs of function in milliseconds, prepare runs untimed before each one (e.g. to copy the data function changes)
+	template<typename Prepare, typename Function>
+	float GetBestTime(int runCount, const Prepare& prepare, const Function& function) {
+		float bestTime = FLT_MAX;
+		for(int run = 0; run < runCount; run++) {
+			prepare();
+			auto startTime = std::chrono::steady_clock::now();
+			function();
+			bestTime = std::min(bestTime, GetElapsedMilliseconds(startTime));
+		}
+		return bestTime;
+	}
+
+	template<typename Function>
+	float GetBestTime(int runCount, const Function& function) {
+		return GetBestTime(runCount, []() {}, function);
+	}
+
+	void FillRandomBytes(std::vector<unsigned char>& data, std::mt19937& randomEngine) {
+		std::generate(data.begin(), data.end(), [&]() { return (unsigned char)randomEngine(); });
+	}
+
+	// Files and directories the benchmarks write, each removes its own before returning
+	std::filesystem::path GetTemporaryPath(const std::string& fileName) {
+		return std::filesystem::temp_directory_path() / fileName;
+	}
+
+	std::vector<unsigned char> ReadWholeFile(const std::string& filePath) {
+		std::ifstream fin {filePath, std::ios::binary | std::ios::ate};
+		std::vector<unsigned char> data((size_t)std::max<std::streamoff>(0, fin.tellg()));
+		fin.seekg(0);
+		fin.read((char*)data.data(), data.size());
+		return data;
+	}
+
+	bool WriteWholeFile(const std::string& filePath, const std::vector<unsigned char>& data) {
+		std::ofstream fout {filePath, std::ios::binary | std::ios::trunc};
+		fout.write((const char*)data.data(), data.size());
+		return fout.good();
+	}
+
+	// Same steps as Model::CookMesh up to the meshlets, the BVH is left to the caller
+	bool GenerateCookedMesh(const std::string& modelName, MeshData& meshData) {
+		if(!PrimitiveGenerator::GenerateFromName(modelName, meshData)) {
+			std::cout << modelName << ": could not generate mesh\n";
+			return false;
+		}
+		BoundingVolumes::ComputeBounds(meshData);
+		MeshOptimizer::OptimizeMesh(meshData);
+		MeshSimplifier::GenerateLODs(meshData);
+		MeshletBuilder::BuildMeshlets(meshData);
+		return true;
+	}
+
+	/// Benchmarks
+
+	// Loads every PBR material with 1, 2, 4... decode threads up to one per hardware thread and prints the wall time of each
+	// Note: the first pass only warms the file cache, the upload stage stays on the main thread and bounds the scaling
+	void BenchmarkTextureLoading(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const SceneData& sceneData) {
+		std::vector<Benchmarks::TextureFile> textureFiles {};
+		for(const std::vector<Benchmarks::TextureFile>& materialTextureFiles : sceneData.materialTextureFiles) {
+			textureFiles.insert(textureFiles.end(), materialTextureFiles.begin(), materialTextureFiles.end());
+		}
+
+		int maxThreadCount = std::max(1, (int)std::thread::hardware_concurrency());
+		std::vector<int> threadCounts {maxThreadCount};
+		for(int threadCount = 1; threadCount < maxThreadCount; threadCount *= 2) {
+			threadCounts.push_back(threadCount);
+		}
+		threadCounts.push_back(maxThreadCount);
+
+		float singleThreadLoadTime {};
+		for(size_t run = 0; run < threadCounts.size(); run++) {
+			std::vector<Texture> textures(textureFiles.size());
+			TextureLoader loader {};
+
+			auto startTime = std::chrono::steady_clock::now();
+			loader.Initialize(threadCounts[run]);
+			for(size_t i = 0; i < textureFiles.size(); i++) {
+				loader.Load(&textures[i], textureFiles[i].filePath, textureFiles[i].sourceFilePaths, DXGI_FORMAT_R8G8B8A8_UNORM);
+			}
+			bool result = loader.WaitAll(device, deviceContext);
+			float loadTime = GetElapsedMilliseconds(startTime);
+
+			loader.Shutdown();
+			for(Texture& texture : textures) {
+				texture.Shutdown();
+			}
+
+			if(!result) {
+				std::cout << "Texture load benchmark: could not load every texture\n";
+				return;
+			}
+			if(run == 0) {
+				continue;
+			}
+			if(threadCounts[run] == 1) {
+				singleThreadLoadTime = loadTime;
+			}
+			std::cout << "Texture load benchmark: " << textureFiles.size() << " textures, " << threadCounts[run] << " threads: " << loadTime << " ms (" << singleThreadLoadTime / loadTime << "x)\n";
+		}
+	}
+
+	// Decodes every skybox with stbi_loadf, then with HDRDecoder in each output format on 1 and every hardware thread, and prints the wall time and size of each
+	// Note: the first stbi_loadf only warms the file cache
+	void BenchmarkHDRDecoding(const SceneData& sceneData) {
+		constexpr const char* s_OutputFormatNames[HDRDecoder::Num_OutputFormats] {"R32G32B32A32_FLOAT", "R16G16B16A16_FLOAT", "R9G9B9E5_SHAREDEXP"};
+
+		int maxThreadCount = std::max(1, (int)std::thread::hardware_concurrency());
+		for(const std::string& filePath : sceneData.cubemapFilePaths) {
+
+			float stbLoadTime {};
+			int width {}, height {}, nrComponents {};
+			for(int run = 0; run < 2; run++) {
+				auto startTime = std::chrono::steady_clock::now();
+				float* floatData = stbi_loadf(filePath.c_str(), &width, &height, &nrComponents, 4);
+				stbLoadTime = GetElapsedMilliseconds(startTime);
+				if(!floatData) {
+					std::cout << filePath << ": could not load HDR map\n";
+					return;
+				}
+				stbi_image_free(floatData);
+			}
+			float megabytesPerTexel = 1.0f / (1024.0f * 1024.0f);
+			std::cout << "HDR decode benchmark: " << filePath << " " << width << "x" << height << ", stbi_loadf: " << stbLoadTime << " ms, " << width * height * 16 * megabytesPerTexel << " MB\n";
+
+			for(int format = 0; format < HDRDecoder::Num_OutputFormats; format++) {
+				for(int threadCount : {1, maxThreadCount}) {
+					unsigned char* data {};
+					auto startTime = std::chrono::steady_clock::now();
+					bool result = HDRDecoder::Decode(filePath.c_str(), (HDRDecoder::OutputFormat)format, threadCount, &data, width, height);
+					float loadTime = GetElapsedMilliseconds(startTime);
+					delete[] data;
+					if(!result) {
+						std::cout << filePath << ": could not decode HDR map\n";
+						return;
+					}
+					std::cout << "HDR decode benchmark: " << s_OutputFormatNames[format] << ", " << threadCount << " threads: " << loadTime << " ms (" << stbLoadTime / loadTime << "x), "
+						<< width * height * HDRDecoder::GetTexelSize((HDRDecoder::OutputFormat)format) * megabytesPerTexel << " MB\n";
+				}
+			}
+		}
+	}
+
+	constexpr int s_SyntheticModelVertexCount = 5000000;
+
+	// Model::LoadModel as it was before it mapped the file and parsed it with std::from_chars on several threads
+	int ParseTextModelWithStream(const std::string& filePath, std::vector<float>& vertexData) {
+		std::ifstream fin {filePath};
+		if(fin.fail()) {
+			return -1;
+		}
+
+		char input {};
+		while(input != ':' && fin.get(input)) {}
+		int vertexCount {};
+		fin >> vertexCount;
+		vertexData.resize((size_t)std::max(0, vertexCount) * 8);
+
+		input = {};
+		while(input != ':' && fin.get(input)) {}
+		for(float& value : vertexData) {
+			fin >> value;
+		}
+		return fin.fail() ? -1 : vertexCount;
+	}
+
+	// Random vertices written like the rastertek exporter writes them (6 significant digits, one vertex per line)
+	bool WriteSyntheticTextModel(const std::string& filePath, int vertexCount) {
+		FILE* file = std::fopen(filePath.c_str(), "wb");
+		if(!file) {
+			return false;
+		}
+
+		std::mt19937 random {1};
+		std::uniform_real_distribution<float> distribution {-1.0f, 1.0f};
+		std::fprintf(file, "Vertex Count: %d\n\nData:\n\n", vertexCount);
+		for(int i = 0; i < vertexCount; i++) {
+			float values[8] {};
+			for(float& value : values) {
+				value = distribution(random);
+			}
+			std::fprintf(file, "%g %g %g %g %g %g %g %g\n", values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7]);
+		}
+		return std::fclose(file) == 0;
+	}
+
+	// Parses the scene's text model and a generated s_SyntheticModelVertexCount vertex file with both readers and prints their rate in vertices/sec
+	// Note: each reader parses every file twice and the faster run is kept, so both see a warm file cache
+	void BenchmarkModelParsing(const SceneData& sceneData) {
+		std::string syntheticFilePath = GetTemporaryPath("model_parse_benchmark.txt").string();
+		if(!WriteSyntheticTextModel(syntheticFilePath, s_SyntheticModelVertexCount)) {
+			std::cout << syntheticFilePath << ": could not write model\n";
+			return;
+		}
+
+		for(const std::string& filePath : {sceneData.textModelFilePath, syntheticFilePath}) {
+			int streamVertexCount {}, parallelVertexCount {};
+			std::vector<float> vertexData {};
+			double streamTime = GetBestTime(2, [&]() { streamVertexCount = ParseTextModelWithStream(filePath, vertexData); }) * 1e-3;
+			double parallelTime = GetBestTime(2, [&]() { parallelVertexCount = Model::ParseTextModel(filePath); }) * 1e-3;
+
+			if(streamVertexCount <= 0 || parallelVertexCount != streamVertexCount) {
+				std::cout << filePath << ": could not parse model (" << streamVertexCount << " / " << parallelVertexCount << " vertices)\n";
+				continue;
+			}
+			std::cout << "Model parse benchmark: " << filePath << ", " << parallelVertexCount << " vertices, ifstream " << streamVertexCount / streamTime << " vertices/s, from_chars on "
+				<< std::thread::hardware_concurrency() << " threads " << parallelVertexCount / parallelTime << " vertices/s (" << streamTime / parallelTime << "x)\n";
+		}
+
+		std::filesystem::remove(syntheticFilePath);
+	}
+
+	// Triangles as position/uv corners, each rotated to start at its smallest corner and sorted, so meshes compare equal whatever their triangle and vertex order
+	std::vector<std::array<float, 15>> GetSortedTriangles(const MeshData& meshData) {
+		std::vector<std::array<float, 15>> triangles(meshData.indices.size() / 3);
+		for(size_t i = 0; i < triangles.size(); i++) {
+			std::array<std::array<float, 5>, 3> corners {};
+			for(int corner = 0; corner < 3; corner++) {
+				const MeshVertex& vertex = meshData.vertices[meshData.indices[i * 3 + corner]];
+				corners[corner] = {vertex.position.x, vertex.position.y, vertex.position.z, vertex.texture.x, vertex.texture.y};
+			}
+			int first = (int)(std::min_element(corners.begin(), corners.end()) - corners.begin());
+			for(int corner = 0; corner < 3; corner++) {
+				std::copy(corners[(first + corner) % 3].begin(), corners[(first + corner) % 3].end(), triangles[i].begin() + corner * 5);
+			}
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// Runs MeshOptimizer on every demo primitive and a dense sphere, in generator order and with their triangles shuffled like an unoptimized import
+	// and prints the simulated ACMR/ATVR (FIFO cache of MeshOptimizer::kVertexCacheSize) before and after
+	void BenchmarkMeshOptimization(const SceneData& sceneData) {
+		std::vector<std::string> meshNames {};
+		for(const std::string& modelName : sceneData.modelNames) {
+			if(PrimitiveGenerator::IsPrimitiveName(modelName)) {
+				meshNames.push_back(modelName);
+			}
+		}
+		meshNames.push_back("sphere:256x128");
+
+		std::mt19937 random {1};
+		for(const std::string& meshName : meshNames) {
+			MeshData generatedMeshData {};
+			if(!PrimitiveGenerator::GenerateFromName(meshName, generatedMeshData)) {
+				std::cout << meshName << ": could not generate mesh\n";
+				return;
+			}
+
+			for(bool b_IsShuffled : {false, true}) {
+				MeshData meshData = generatedMeshData;
+				if(b_IsShuffled) {
+					std::vector<uint32_t> triangleOrder(meshData.indices.size() / 3);
+					for(uint32_t i = 0; i < (uint32_t)triangleOrder.size(); i++) {
+						triangleOrder[i] = i;
+					}
+					std::shuffle(triangleOrder.begin(), triangleOrder.end(), random);
+					for(size_t i = 0; i < triangleOrder.size(); i++) {
+						std::copy_n(generatedMeshData.indices.begin() + triangleOrder[i] * 3, 3, meshData.indices.begin() + i * 3);
+					}
+				}
+
+				MeshOptimizer::VertexCacheStats statsBefore = MeshOptimizer::AnalyzeVertexCache(meshData.indices, meshData.vertices.size());
+				auto startTime = std::chrono::steady_clock::now();
+				MeshOptimizer::OptimizeMesh(meshData);
+				float optimizeTime = GetElapsedMilliseconds(startTime);
+				MeshOptimizer::VertexCacheStats statsAfter = MeshOptimizer::AnalyzeVertexCache(meshData.indices, meshData.vertices.size());
+
+				bool b_KeepsTriangles = GetSortedTriangles(meshData) == GetSortedTriangles(generatedMeshData);
+				std::cout << "Mesh optimizer benchmark: " << meshName << (b_IsShuffled ? " (shuffled)" : "") << ", " << meshData.indices.size() / 3 << " triangles, ACMR " << statsBefore.acmr << " -> " << statsAfter.acmr
+					<< ", ATVR " << statsBefore.atvr << " -> " << statsAfter.atvr << ", " << optimizeTime << " ms" << (b_KeepsTriangles ? "" : ", TRIANGLES CHANGED") << "\n";
+			}
+		}
+	}
+
+	// The per face routine TangentGenerator replaced (Model::CalculateModelVectors), for unindexed triangle lists
+	// Note: no smoothing across triangles and no guard against degenerate uvs
+	void CalculateFaceTangents(MeshData& meshData) {
+		for(size_t i = 0; i + 2 < meshData.vertices.size(); i += 3) {
+			MeshVertex* vertices = &meshData.vertices[i];
+			float vector1[3] {vertices[1].position.x - vertices[0].position.x, vertices[1].position.y - vertices[0].position.y, vertices[1].position.z - vertices[0].position.z};
+			float vector2[3] {vertices[2].position.x - vertices[0].position.x, vertices[2].position.y - vertices[0].position.y, vertices[2].position.z - vertices[0].position.z};
+			float tuVector[2] {vertices[1].texture.x - vertices[0].texture.x, vertices[2].texture.x - vertices[0].texture.x};
+			float tvVector[2] {vertices[1].texture.y - vertices[0].texture.y, vertices[2].texture.y - vertices[0].texture.y};
+
+			float den = 1.0f / (tuVector[0] * tvVector[1] - tuVector[1] * tvVector[0]);
+			XMFLOAT3 tangent((tvVector[1] * vector1[0] - tvVector[0] * vector2[0]) * den, (tvVector[1] * vector1[1] - tvVector[0] * vector2[1]) * den, (tvVector[1] * vector1[2] - tvVector[0] * vector2[2]) * den);
+			XMFLOAT3 binormal((tuVector[0] * vector2[0] - tuVector[1] * vector1[0]) * den, (tuVector[0] * vector2[1] - tuVector[1] * vector1[1]) * den, (tuVector[0] * vector2[2] - tuVector[1] * vector1[2]) * den);
+			XMStoreFloat3(&tangent, XMVector3Normalize(XMLoadFloat3(&tangent)));
+			XMStoreFloat3(&binormal, XMVector3Normalize(XMLoadFloat3(&binormal)));
+
+			for(int corner = 0; corner < 3; corner++) {
+				vertices[corner].tangent = tangent;
+				vertices[corner].binormal = binormal;
+			}
+		}
+	}
+
+	// The old routine only handles unindexed meshes, so it runs on the sphere's triangle list (what the text models used to load as)
+	// TangentGenerator runs on the same triangle list and on the welded sphere Model::CookMesh passes it
+	void BenchmarkTangentGeneration() {
+		MeshData weldedMeshData {};
+		if(!PrimitiveGenerator::GenerateFromName("sphere:1024x340", weldedMeshData)) {
+			std::cout << "sphere:1024x340: could not generate mesh\n";
+			return;
+		}
+
+		MeshData triangleListMeshData {};
+		triangleListMeshData.vertices.resize(weldedMeshData.indices.size());
+		triangleListMeshData.indices.resize(weldedMeshData.indices.size());
+		for(size_t i = 0; i < weldedMeshData.indices.size(); i++) {
+			triangleListMeshData.vertices[i] = weldedMeshData.vertices[weldedMeshData.indices[i]];
+			triangleListMeshData.indices[i] = (uint32_t)i;
+		}
+
+		// Every run on a fresh copy of the mesh
+		MeshData meshData {};
+		float faceTangentTime = GetBestTime(3, [&]() { meshData = triangleListMeshData; }, [&]() { CalculateFaceTangents(meshData); });
+		float triangleListTime = GetBestTime(3, [&]() { meshData = triangleListMeshData; }, [&]() { TangentGenerator::GenerateTangents(meshData); });
+		float weldedTime = GetBestTime(3, [&]() { meshData = weldedMeshData; }, [&]() { TangentGenerator::GenerateTangents(meshData); });
+
+		// Every frame must come out orthonormal, binormal = cross(normal, tangent) * handedness
+		float maxError = 0.0f;
+		for(const MeshVertex& vertex : meshData.vertices) {
+			XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&vertex.normal));
+			XMVECTOR tangent = XMLoadFloat3(&vertex.tangent);
+			XMVECTOR binormal = XMLoadFloat3(&vertex.binormal);
+			float handednessError = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMVectorAbs(binormal), XMVectorAbs(XMVector3Cross(normal, tangent)))));
+			maxError = std::max({maxError, std::abs(XMVectorGetX(XMVector3Length(tangent)) - 1.0f), std::abs(XMVectorGetX(XMVector3Dot(normal, tangent))), handednessError});
+		}
+
+		std::cout << "Tangent benchmark: " << weldedMeshData.indices.size() / 3 << " triangles, " << std::max(1u, std::thread::hardware_concurrency()) << " hardware threads\n";
+		std::cout << "Tangent benchmark: old per face routine (" << triangleListMeshData.vertices.size() << " vertex triangle list) " << faceTangentTime << " ms\n";
+		std::cout << "Tangent benchmark: TangentGenerator on the triangle list " << triangleListTime << " ms (" << faceTangentTime / triangleListTime << "x)\n";
+		std::cout << "Tangent benchmark: TangentGenerator on the welded mesh (" << weldedMeshData.vertices.size() << " vertices) " << weldedTime << " ms (" << faceTangentTime / weldedTime << "x)"
+			<< ", max orthonormality error " << maxError << "\n";
+	}
+
+	// Culls the meshlets of the demo sphere and ground from a few cameras and prints the fraction of clusters (and triangles) dropped before the draw
+	// Every culled meshlet is checked triangle by triangle in world space: entirely outside one frustum plane, or (without displacement) entirely backfacing
+	void BenchmarkMeshletCulling(const SceneData& sceneData) {
+		struct CullObject {
+			std::string modelName;
+			XMFLOAT3 position;
+			XMFLOAT3 scale;
+		};
+		// Same placement as the demo scene's middle sphere and ground
+		const std::vector<CullObject> cullObjects {
+			{"sphere", {0.0f, 4.0f, 0.0f}, {1.0f, 1.0f, 1.0f}},
+			{"plane",  {0.0f, 0.0f, 0.0f}, {5.0f, 1.0f, 5.0f}},
+		};
+
+		struct CullView {
+			std::string name;
+			XMFLOAT3 position;
+			XMFLOAT3 rotation;
+		};
+		const std::vector<CullView> cullViews {
+			{"start camera",     {0.0f, 4.0f, -10.0f}, {0.0f, 0.0f, 0.0f}},
+			{"close up",         {0.0f, 4.0f, -2.0f},  {0.0f, 0.0f, 0.0f}},
+			{"sphere at edge",   {3.5f, 4.0f, -4.0f},  {0.0f, 0.0f, 0.0f}},
+			{"looking down",     {0.0f, 4.0f, -10.0f}, {0.0f, 30.0f, 0.0f}},
+			{"turned away",      {0.0f, 4.0f, -10.0f}, {180.0f, 0.0f, 0.0f}},
+		};
+
+		for(const CullObject& cullObject : cullObjects) {
+			MeshData meshData {};
+			if(!GenerateCookedMesh(cullObject.modelName, meshData)) {
+				return;
+			}
+			const MeshLOD& lod = meshData.lods[0];
+			const Meshlet* meshlets = meshData.meshlets.data() + lod.firstMeshlet;
+
+			XMMATRIX worldMatrix = XMMatrixMultiply(XMMatrixScaling(cullObject.scale.x, cullObject.scale.y, cullObject.scale.z), XMMatrixTranslation(cullObject.position.x, cullObject.position.y, cullObject.position.z));
+			std::vector<XMFLOAT3> worldPositions(meshData.vertices.size());
+			for(size_t i = 0; i < meshData.vertices.size(); i++) {
+				XMStoreFloat3(&worldPositions[i], XMVector3TransformCoord(XMLoadFloat3(&meshData.vertices[i].position), worldMatrix));
+			}
+
+			for(const CullView& cullView : cullViews) {
+				Camera camera {};
+				camera.SetPosition(cullView.position.x, cullView.position.y, cullView.position.z);
+				camera.SetRotation(cullView.rotation.x, cullView.rotation.y, cullView.rotation.z);
+				camera.Update();
+				camera.UpdateFrustum(sceneData.projectionMatrix, sceneData.screenDepth);
+				std::array<XMFLOAT4, 6> frustumPlanes = camera.GetFrustumPlanes();
+
+				// No displacement (backface culling on), then the demo spheres' displacement (backface culling off, grown spheres)
+				for(float displacementBias : {0.0f, 0.1f}) {
+					std::vector<MeshletCuller::DrawRange> drawRanges {};
+					auto startTime = std::chrono::steady_clock::now();
+					MeshletCuller::CullStats stats = MeshletCuller::CullMeshlets(meshlets, lod.meshletCount, worldMatrix, frustumPlanes, camera.GetPosition(), displacementBias, drawRanges);
+					float cullTime = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+
+					uint32_t drawnIndexCount = 0;
+					for(const MeshletCuller::DrawRange& drawRange : drawRanges) {
+						drawnIndexCount += drawRange.indexCount;
+					}
+
+					/// Meshlets missing from the draw ranges must not hold a single visible triangle
+					std::vector<bool> indexDrawn(lod.indexCount, false);
+					for(const MeshletCuller::DrawRange& drawRange : drawRanges) {
+						std::fill_n(indexDrawn.begin() + (drawRange.firstIndex - lod.firstIndex), drawRange.indexCount, true);
+					}
+					int wronglyCulledCount = 0;
+					for(uint32_t i = 0; i < lod.meshletCount; i++) {
+						const Meshlet& meshlet = meshlets[i];
+						if(indexDrawn[meshlet.firstIndex - lod.firstIndex]) {
+							continue;
+						}
+						for(uint32_t t = 0; t < meshlet.triangleCount; t++) {
+							const uint32_t* triangle = &meshData.indices[meshlet.firstIndex + t * 3];
+							XMVECTOR p0 = XMLoadFloat3(&worldPositions[triangle[0]]);
+							XMVECTOR p1 = XMLoadFloat3(&worldPositions[triangle[1]]);
+							XMVECTOR p2 = XMLoadFloat3(&worldPositions[triangle[2]]);
+
+							bool b_IsOutside = false;
+							for(const XMFLOAT4& plane : frustumPlanes) {
+								XMVECTOR planeVector = XMLoadFloat4(&plane);
+								float margin = -displacementBias * std::max({cullObject.scale.x, cullObject.scale.y, cullObject.scale.z});
+								if(XMVectorGetX(XMPlaneDotCoord(planeVector, p0)) < margin && XMVectorGetX(XMPlaneDotCoord(planeVector, p1)) < margin && XMVectorGetX(XMPlaneDotCoord(planeVector, p2)) < margin) {
+									b_IsOutside = true;
+									break;
+								}
+							}
+							// Front faces are clockwise (left handed), cross(p1 - p0, p2 - p0) points away from a camera behind the triangle
+							XMVECTOR faceNormal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+							bool b_IsBackfacing = displacementBias <= 0.0f && XMVectorGetX(XMVector3Dot(faceNormal, XMVectorSubtract(p0, XMLoadFloat3(&cullView.position)))) >= 0.0f;
+							if(!b_IsOutside && !b_IsBackfacing) {
+								wronglyCulledCount++;
+							}
+						}
+					}
+
+					int culledCount = stats.frustumCulledCount + stats.backfaceCulledCount;
+					std::cout << "Meshlet cull benchmark: " << cullObject.modelName << ", " << cullView.name << (displacementBias > 0.0f ? " (displaced)" : "") << ": " << culledCount << " / " << stats.meshletCount
+						<< " meshlets culled (" << 100.0f * culledCount / std::max(stats.meshletCount, 1) << "%, " << stats.frustumCulledCount << " frustum, " << stats.backfaceCulledCount << " backface), "
+						<< drawnIndexCount / 3 << " / " << lod.indexCount / 3 << " triangles in " << stats.drawRangeCount << " draws, " << cullTime << " us"
+						<< (wronglyCulledCount > 0 ? ", " + std::to_string(wronglyCulledCount) + " VISIBLE TRIANGLES CULLED" : "") << "\n";
+				}
+			}
+		}
+	}
+
+	// Casts random rays at each mesh through its BVH and by testing every triangle, then prints both ray rates
+	// Rays start outside the bounding sphere and aim at a point inside it, so most hit and some graze past the silhouette
+	// Note: rays through a shared edge may report either triangle, so only the hit flag and the distance are compared
+	void BenchmarkMeshPicking() {
+		const std::vector<std::pair<std::string, int>> pickMeshes {
+			{"sphere", 20000},
+			{"plane", 20000},
+			{"sphere:1024x340", 500},
+		};
+
+		for(const auto& [modelName, rayCount] : pickMeshes) {
+			// The BVH is built over LOD 0's final triangle order, like Model::CookMesh does
+			MeshData meshData {};
+			if(!GenerateCookedMesh(modelName, meshData)) {
+				return;
+			}
+			auto buildStartTime = std::chrono::steady_clock::now();
+			MeshBVH::BuildBVH(meshData);
+			float buildTime = GetElapsedMilliseconds(buildStartTime);
+
+			const MeshBounds& bounds = meshData.bounds;
+			std::mt19937 randomEngine(1234);
+			std::normal_distribution<float> normalDistribution(0.0f, 1.0f);
+			std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+			auto randomDirection = [&]() {
+				XMVECTOR direction = XMVectorSet(normalDistribution(randomEngine), normalDistribution(randomEngine), normalDistribution(randomEngine), 0.0f);
+				return XMVector3Normalize(direction);
+			};
+			std::vector<XMFLOAT3> rayOrigins(rayCount);
+			std::vector<XMFLOAT3> rayDirections(rayCount);
+			for(int i = 0; i < rayCount; i++) {
+				XMVECTOR center = XMLoadFloat3(&bounds.sphereCenter);
+				XMVECTOR origin = XMVectorAdd(center, XMVectorScale(randomDirection(), bounds.sphereRadius * 3.0f));
+				XMVECTOR target = XMVectorAdd(center, XMVectorScale(randomDirection(), bounds.sphereRadius * std::cbrt(unitDistribution(randomEngine))));
+				XMStoreFloat3(&rayOrigins[i], origin);
+				XMStoreFloat3(&rayDirections[i], XMVector3Normalize(XMVectorSubtract(target, origin)));
+			}
+
+			std::vector<MeshBVH::RayHit> bvhHits(rayCount);
+			std::vector<bool> bvhHitFlags(rayCount);
+			auto startTime = std::chrono::steady_clock::now();
+			for(int i = 0; i < rayCount; i++) {
+				bvhHitFlags[i] = MeshBVH::RayCast(meshData.bvhNodes.data(), meshData.bvhNodes.size(), meshData.bvhTriangles.data(), rayOrigins[i], rayDirections[i], FLT_MAX, bvhHits[i]);
+			}
+			float bvhTime = GetElapsedMilliseconds(startTime);
+
+			std::vector<MeshBVH::RayHit> bruteForceHits(rayCount);
+			std::vector<bool> bruteForceHitFlags(rayCount);
+			startTime = std::chrono::steady_clock::now();
+			for(int i = 0; i < rayCount; i++) {
+				bruteForceHitFlags[i] = MeshBVH::RayCastBruteForce(meshData.bvhTriangles.data(), meshData.bvhTriangles.size(), rayOrigins[i], rayDirections[i], FLT_MAX, bruteForceHits[i]);
+			}
+			float bruteForceTime = GetElapsedMilliseconds(startTime);
+
+			int hitCount = 0;
+			int mismatchCount = 0;
+			for(int i = 0; i < rayCount; i++) {
+				hitCount += bvhHitFlags[i] ? 1 : 0;
+				if(bvhHitFlags[i] != bruteForceHitFlags[i] || (bvhHitFlags[i] && std::abs(bvhHits[i].distance - bruteForceHits[i].distance) > 1e-5f * std::max(1.0f, bruteForceHits[i].distance))) {
+					mismatchCount++;
+				}
+			}
+
+			std::cout << "Mesh pick benchmark: " << modelName << ", " << meshData.bvhTriangles.size() << " triangles, " << meshData.bvhNodes.size() << " nodes built in " << buildTime << " ms: "
+				<< hitCount << " / " << rayCount << " rays hit, BVH " << rayCount / (bvhTime * 1e-3f) << " rays/s, brute force " << rayCount / (bruteForceTime * 1e-3f) << " rays/s ("
+				<< bruteForceTime / bvhTime << "x)" << (mismatchCount > 0 ? ", " + std::to_string(mismatchCount) + " RAYS DISAGREE" : "") << "\n";
+		}
+	}
+
+	// Copies byteSize bytes at byteOffset of a default usage buffer back to the CPU through a staging buffer
+	bool ReadBackBuffer(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ID3D11Buffer* buffer, uint32_t byteOffset, uint32_t byteSize, std::vector<unsigned char>& data) {
+		D3D11_BUFFER_DESC stagingBufferDesc {};
+		stagingBufferDesc.ByteWidth = byteSize;
+		stagingBufferDesc.Usage = D3D11_USAGE_STAGING;
+		stagingBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		ID3D11Buffer* stagingBuffer = nullptr;
+		if(FAILED(device->CreateBuffer(&stagingBufferDesc, nullptr, &stagingBuffer))) {
+			return false;
+		}
+
+		D3D11_BOX sourceBox {byteOffset, 0, 0, byteOffset + byteSize, 1, 1};
+		deviceContext->CopySubresourceRegion(stagingBuffer, 0, 0, 0, 0, buffer, 0, &sourceBox);
+		D3D11_MAPPED_SUBRESOURCE mappedResource {};
+		bool b_Mapped = SUCCEEDED(deviceContext->Map(stagingBuffer, 0, D3D11_MAP_READ, 0, &mappedResource));
+		if(b_Mapped) {
+			data.assign((const unsigned char*)mappedResource.pData, (const unsigned char*)mappedResource.pData + byteSize);
+			deviceContext->Unmap(stagingBuffer, 0);
+		}
+		stagingBuffer->Release();
+		return b_Mapped;
+	}
+
+	// Random allocate/free on a bare OffsetAllocator, every allocation is checked against its neighbours and the storage report against the live set
+	// Then random add/remove on a GeometryArena with a Flush per frame (like the render loop), reading back every live mesh now and then
+	// Note: mesh contents are random bytes, nothing is drawn from the arena
+	void BenchmarkGeometryArena(ID3D11Device* device, ID3D11DeviceContext* deviceContext) {
+		std::mt19937 randomEngine(1234);
+
+		/// Allocator
+		const uint32_t allocatorSize = 1u << 24;
+		const int allocatorOpCount = 200000;
+		OffsetAllocator allocator {};
+		allocator.Reset(allocatorSize);
+		// Live allocations by offset, to find the neighbours of a new one
+		std::map<uint32_t, std::pair<uint32_t, OffsetAllocator::Allocation>> liveAllocations {};
+		uint64_t liveSize = 0;
+		int failedAllocationCount = 0;
+		int allocatorErrorCount = 0;
+		auto startTime = std::chrono::steady_clock::now();
+		for(int op = 0; op < allocatorOpCount; op++) {
+			if(liveAllocations.empty() || randomEngine() % 100 < 55) {
+				// Mostly small ranges with a long tail, like meshes
+				uint32_t size = 1 + randomEngine() % ((randomEngine() % 16 == 0) ? 65536 : 1024);
+				OffsetAllocator::Allocation allocation = allocator.Allocate(size);
+				if(allocation.offset == OffsetAllocator::kNoSpace) {
+					failedAllocationCount++;
+					continue;
+				}
+				auto next = liveAllocations.lower_bound(allocation.offset);
+				bool b_OverlapsNext = next != liveAllocations.end() && next->first < allocation.offset + size;
+				bool b_OverlapsPrevious = next != liveAllocations.begin() && std::prev(next)->first + std::prev(next)->second.first > allocation.offset;
+				if(b_OverlapsNext || b_OverlapsPrevious || allocation.offset + size > allocatorSize) {
+					allocatorErrorCount++;
+				}
+				liveAllocations[allocation.offset] = {size, allocation};
+				liveSize += size;
+			}
+			else {
+				auto it = liveAllocations.lower_bound(randomEngine() % allocatorSize);
+				if(it == liveAllocations.end()) {
+					it = liveAllocations.begin();
+				}
+				allocator.Free(it->second.second);
+				liveSize -= it->second.first;
+				liveAllocations.erase(it);
+			}
+		}
+		float allocatorTime = GetElapsedMilliseconds(startTime);
+		OffsetAllocator::StorageReport storageReport = allocator.GetStorageReport();
+		if(storageReport.totalFree != allocatorSize - liveSize || storageReport.allocationCount != liveAllocations.size()) {
+			allocatorErrorCount++;
+		}
+		for(const auto& liveAllocation : liveAllocations) {
+			allocator.Free(liveAllocation.second.second);
+		}
+		storageReport = allocator.GetStorageReport();
+		if(storageReport.freeRegionCount != 1 || storageReport.largestFreeRegion != allocatorSize) {
+			allocatorErrorCount++;
+		}
+		std::cout << "Geometry arena benchmark: allocator " << allocatorOpCount << " ops in " << allocatorTime << " ms (" << allocatorTime * 1e6f / allocatorOpCount << " ns/op), "
+			<< failedAllocationCount << " allocations did not fit" << (allocatorErrorCount > 0 ? ", " + std::to_string(allocatorErrorCount) + " ERRORS" : "") << "\n";
+
+		/// Arena
+		struct StressMesh {
+			std::vector<unsigned char> vertexStreams[Num_VertexStreams];
+			std::vector<unsigned char> indices;
+			uint32_t indexStride;
+		};
+		const VertexFormat vertexFormat = kPackedVertexFormat;
+		uint32_t vertexStrides[Num_VertexStreams] {};
+		for(int i = 0; i < Num_VertexStreams; i++) {
+			vertexStrides[i] = GetVertexStreamStride(vertexFormat, (VertexStream)i);
+		}
+
+		GeometryArena geometryArena {};
+		geometryArena.Initialize(vertexFormat);
+		std::map<GeometryArena::Handle, StressMesh> liveMeshes {};
+		int mismatchCount = 0;
+		// Reads back every live mesh from the buffers the arena binds for it
+		auto checkLiveMeshes = [&]() {
+			for(const auto& [handle, mesh] : liveMeshes) {
+				GeometryArena::Range range = geometryArena.GetRange(handle);
+				if(!range.isResident) {
+					mismatchCount++;
+					continue;
+				}
+				geometryArena.Bind(deviceContext, mesh.indexStride, false);
+				ID3D11Buffer* vertexBuffers[Num_VertexStreams] {};
+				UINT strides[Num_VertexStreams] {}, offsets[Num_VertexStreams] {};
+				deviceContext->IAGetVertexBuffers(0, Num_VertexStreams, vertexBuffers, strides, offsets);
+				ID3D11Buffer* indexBuffer = nullptr;
+				DXGI_FORMAT indexFormat {};
+				UINT indexOffset {};
+				deviceContext->IAGetIndexBuffer(&indexBuffer, &indexFormat, &indexOffset);
+
+				std::vector<unsigned char> data {};
+				for(int i = 0; i < Num_VertexStreams; i++) {
+					if(!vertexBuffers[i] || !ReadBackBuffer(device, deviceContext, vertexBuffers[i], range.baseVertex * vertexStrides[i], (uint32_t)mesh.vertexStreams[i].size(), data) || data != mesh.vertexStreams[i]) {
+						mismatchCount++;
+					}
+				}
+				if(!indexBuffer || !ReadBackBuffer(device, deviceContext, indexBuffer, range.firstIndex * mesh.indexStride, (uint32_t)mesh.indices.size(), data) || data != mesh.indices) {
+					mismatchCount++;
+				}
+
+				for(ID3D11Buffer* buffer : vertexBuffers) {
+					if(buffer) {
+						buffer->Release();
+					}
+				}
+				if(indexBuffer) {
+					indexBuffer->Release();
+				}
+			}
+		};
+
+		const int frameCount = 300;
+		float totalFlushTime = 0.0f;
+		float maxFlushTime = 0.0f;
+		for(int frame = 0; frame < frameCount; frame++) {
+			int addCount = randomEngine() % 6;
+			int removeCount = randomEngine() % 5;
+			for(int i = 0; i < addCount; i++) {
+				// 1 in 8 meshes needs 32 bit indices
+				uint32_t vertexCount = 1 + randomEngine() % ((randomEngine() % 8 == 0) ? 90000 : 3000);
+				uint32_t indexCount = 3 * (1 + randomEngine() % 5000);
+				StressMesh mesh {};
+				mesh.indexStride = vertexCount > 65535 ? sizeof(uint32_t) : sizeof(uint16_t);
+				const void* vertexStreams[Num_VertexStreams] {};
+				for(int j = 0; j < Num_VertexStreams; j++) {
+					mesh.vertexStreams[j].resize((size_t)vertexCount * vertexStrides[j]);
+					FillRandomBytes(mesh.vertexStreams[j], randomEngine);
+					vertexStreams[j] = mesh.vertexStreams[j].data();
+				}
+				mesh.indices.resize((size_t)indexCount * mesh.indexStride);
+				FillRandomBytes(mesh.indices, randomEngine);
+				GeometryArena::Handle handle = geometryArena.Add(vertexStreams, vertexCount, mesh.indices.data(), indexCount, mesh.indexStride);
+				if(handle == GeometryArena::kInvalidHandle) {
+					mismatchCount++;
+					continue;
+				}
+				liveMeshes[handle] = std::move(mesh);
+			}
+			for(int i = 0; i < removeCount && !liveMeshes.empty(); i++) {
+				auto it = liveMeshes.begin();
+				std::advance(it, randomEngine() % liveMeshes.size());
+				geometryArena.Remove(it->first);
+				liveMeshes.erase(it);
+			}
+
+			startTime = std::chrono::steady_clock::now();
+			if(!geometryArena.Flush(device, deviceContext)) {
+				std::cout << "Geometry arena benchmark: Flush failed in frame " << frame << "\n";
+				break;
+			}
+			float flushTime = GetElapsedMilliseconds(startTime);
+			totalFlushTime += flushTime;
+			maxFlushTime = std::max(maxFlushTime, flushTime);
+
+			if(frame % 60 == 59) {
+				checkLiveMeshes();
+			}
+		}
+
+		GeometryArena::ArenaStats arenaStats = geometryArena.GetStats();
+		std::cout << "Geometry arena benchmark: " << frameCount << " frames, " << liveMeshes.size() << " live meshes, " << arenaStats.compactionCount << " compactions, Flush "
+			<< totalFlushTime / frameCount << " ms average, " << maxFlushTime << " ms max, vertex pool " << arenaStats.pools[GeometryArena::kVertexPool].capacity << " vertices ("
+			<< 100.0f * OffsetAllocator::GetFragmentation(arenaStats.pools[GeometryArena::kVertexPool].storage) << "% fragmented)"
+			<< (mismatchCount > 0 ? ", " + std::to_string(mismatchCount) + " RANGES DO NOT MATCH" : "") << "\n";
+		geometryArena.Shutdown();
+	}
+
+	// Loads every PBR material (all mips, in the demo's block compressed formats) and the default skybox, then calls Upload once per simulated frame until all are done
+	// The first run has no budget and also cooks the texture cache, the budgeted runs start from decoded files in the OS file cache like a second launch
+	// Note: frames where no load was decoded yet are not counted, a frame over the time budget is one that took 10% longer than it
+	void BenchmarkTextureUploadBudgets(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const SceneData& sceneData) {
+		struct UploadLoad {
+			Benchmarks::TextureFile textureFile;
+			int mipLevels;
+		};
+		std::vector<UploadLoad> uploadLoads {};
+		for(const std::vector<Benchmarks::TextureFile>& materialTextureFiles : sceneData.materialTextureFiles) {
+			for(const Benchmarks::TextureFile& textureFile : materialTextureFiles) {
+				uploadLoads.push_back({textureFile, 0});
+			}
+		}
+		const std::string& skyboxFilePath = sceneData.cubemapFilePaths[sceneData.defaultCubemapIndex];
+		uploadLoads.push_back({{skyboxFilePath, {skyboxFilePath}, DXGI_FORMAT_R9G9B9E5_SHAREDEXP}, 1});
+
+		const std::vector<TextureLoader::UploadBudget> uploadBudgets {
+			{0, 0.0f},
+			{sceneData.textureUploadBudgetBytes, sceneData.textureUploadBudgetMilliseconds},
+			{1024 * 1024, 0.0f},
+			{0, 1.0f},
+		};
+		for(const TextureLoader::UploadBudget& uploadBudget : uploadBudgets) {
+			std::vector<Texture> textures(uploadLoads.size());
+			TextureLoader loader {};
+			loader.Initialize();
+			std::vector<TextureLoader::Handle> loadHandles {};
+			for(size_t i = 0; i < uploadLoads.size(); i++) {
+				const Benchmarks::TextureFile& textureFile = uploadLoads[i].textureFile;
+				loadHandles.push_back(loader.Load(&textures[i], textureFile.filePath, textureFile.sourceFilePaths, textureFile.format, uploadLoads[i].mipLevels));
+			}
+
+			std::vector<float> frameTimes {};
+			uint64_t totalUploadedBytes = 0;
+			uint32_t maxFrameBytes = 0;
+			int overTimeBudgetCount = 0;
+			int overByteBudgetCount = 0;
+			bool result = true;
+			auto startTime = std::chrono::steady_clock::now();
+			size_t finishedCount = 0;
+			while(finishedCount < loadHandles.size()) {
+				if(!loader.Upload(device, deviceContext, uploadBudget)) {
+					result = false;
+				}
+				TextureLoader::UploadStats uploadStats = loader.GetLastUploadStats();
+				if(uploadStats.uploadedBytes > 0 || uploadStats.finishedCount > 0) {
+					frameTimes.push_back(uploadStats.milliseconds);
+					totalUploadedBytes += uploadStats.uploadedBytes;
+					maxFrameBytes = std::max(maxFrameBytes, uploadStats.uploadedBytes);
+					overTimeBudgetCount += uploadBudget.milliseconds > 0.0f && uploadStats.milliseconds > uploadBudget.milliseconds * 1.1f ? 1 : 0;
+					overByteBudgetCount += uploadBudget.byteCount > 0 && uploadStats.uploadedBytes > uploadBudget.byteCount ? 1 : 0;
+				}
+				else {
+					// Still decoding
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+
+				finishedCount = 0;
+				for(TextureLoader::Handle loadHandle : loadHandles) {
+					TextureLoader::LoadState loadState = loader.GetLoadState(loadHandle);
+					finishedCount += loadState == TextureLoader::kUploaded || loadState == TextureLoader::kLoadFailed ? 1 : 0;
+				}
+			}
+			float totalTime = GetElapsedMilliseconds(startTime);
+
+			loader.Shutdown();
+			for(Texture& texture : textures) {
+				texture.Shutdown();
+			}
+			if(!result) {
+				std::cout << "Texture upload benchmark: could not load every texture\n";
+				return;
+			}
+
+			std::vector<float> sortedFrameTimes = frameTimes;
+			std::sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+			float frameTimeSum = 0.0f;
+			for(float frameTime : frameTimes) {
+				frameTimeSum += frameTime;
+			}
+			size_t frameCount = std::max<size_t>(frameTimes.size(), 1);
+			std::ostringstream budgetName {};
+			if(uploadBudget.byteCount == 0 && uploadBudget.milliseconds <= 0.0f) {
+				budgetName << "no budget";
+			}
+			else {
+				if(uploadBudget.byteCount > 0) {
+					budgetName << uploadBudget.byteCount / 1024 << " KB";
+				}
+				if(uploadBudget.milliseconds > 0.0f) {
+					budgetName << (uploadBudget.byteCount > 0 ? " / " : "") << uploadBudget.milliseconds << " ms";
+				}
+			}
+			std::cout << std::fixed << std::setprecision(2) << "Texture upload benchmark: " << budgetName.str() << ": " << uploadLoads.size() << " textures, " << totalUploadedBytes / (1024.0f * 1024.0f) << " MB in " << frameTimes.size() << " frames ("
+				<< totalTime << " ms wall), per frame " << frameTimeSum / frameCount << " ms average, " << (sortedFrameTimes.empty() ? 0.0f : sortedFrameTimes[sortedFrameTimes.size() * 95 / 100]) << " ms p95, "
+				<< (sortedFrameTimes.empty() ? 0.0f : sortedFrameTimes.back()) << " ms max, " << maxFrameBytes / 1024 << " KB max, " << overTimeBudgetCount << " over the time budget, " << overByteBudgetCount << " over the byte budget\n"
+				<< std::defaultfloat;
+		}
+	}
+
+	struct CompressionImage {
+		std::string name;
+		int width;
+		int height;
+		std::vector<unsigned char> texels;
+		// Lowest PSNR per format that still counts as a pass, 0 to only print it
+		float minPSNR[BlockCompressor::Num_BlockFormats];
+	};
+
+	// Synthetic images with a known expected quality
+	// Note: floors sit a few dB under what the encoders reach, so they catch regressions but not small changes
+	std::vector<CompressionImage> GenerateCompressionImages() {
+		constexpr int s_Size = 512;
+		std::vector<CompressionImage> images {};
+		std::mt19937 randomEngine(1234);
+
+		// Smooth in every channel, what block compression handles best
+		CompressionImage gradient {"gradient", s_Size, s_Size, std::vector<unsigned char>((size_t)s_Size * s_Size * 4), {39.0f, 40.0f, 45.0f, 45.0f, 50.0f}};
+		for(int y = 0; y < s_Size; y++) {
+			for(int x = 0; x < s_Size; x++) {
+				unsigned char* texel = &gradient.texels[((size_t)y * s_Size + x) * 4];
+				texel[0] = (unsigned char)(x / 2);
+				texel[1] = (unsigned char)(y / 2);
+				texel[2] = (unsigned char)((x + y) / 4);
+				texel[3] = (unsigned char)(255 - x / 2);
+			}
+		}
+		images.push_back(std::move(gradient));
+
+		// One color per block, single channel formats must store it exactly
+		CompressionImage flatBlocks {"flat blocks", s_Size, s_Size, std::vector<unsigned char>((size_t)s_Size * s_Size * 4), {0.0f, 0.0f, INFINITY, INFINITY, 48.0f}};
+		std::vector<unsigned char> blockColors((size_t)(s_Size / 4) * (s_Size / 4) * 4);
+		FillRandomBytes(blockColors, randomEngine);
+		for(int y = 0; y < s_Size; y++) {
+			for(int x = 0; x < s_Size; x++) {
+				std::memcpy(&flatBlocks.texels[((size_t)y * s_Size + x) * 4], &blockColors[((size_t)(y / 4) * (s_Size / 4) + x / 4) * 4], 4);
+			}
+		}
+		images.push_back(std::move(flatBlocks));
+
+		// Tangent space normals of a bumpy height field, what BC5 is used for
+		CompressionImage normalMap {"normal map", s_Size, s_Size, std::vector<unsigned char>((size_t)s_Size * s_Size * 4), {0.0f, 0.0f, 0.0f, 40.0f, 0.0f}};
+		for(int y = 0; y < s_Size; y++) {
+			for(int x = 0; x < s_Size; x++) {
+				float dx = 0.3f * 2.0f * std::cos(x * 0.3f) * std::cos(y * 0.2f);
+				float dy = -0.2f * 2.0f * std::sin(x * 0.3f) * std::sin(y * 0.2f);
+				XMFLOAT3 normal {};
+				XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(-dx, -dy, 1.0f, 0.0f)));
+				unsigned char* texel = &normalMap.texels[((size_t)y * s_Size + x) * 4];
+				texel[0] = (unsigned char)std::lround((normal.x * 0.5f + 0.5f) * 255.0f);
+				texel[1] = (unsigned char)std::lround((normal.y * 0.5f + 0.5f) * 255.0f);
+				texel[2] = (unsigned char)std::lround((normal.z * 0.5f + 0.5f) * 255.0f);
+				texel[3] = 255;
+			}
+		}
+		images.push_back(std::move(normalMap));
+
+		// Worst case, no structure to exploit, only printed
+		CompressionImage noise {"noise", s_Size, s_Size, std::vector<unsigned char>((size_t)s_Size * s_Size * 4), {}};
+		FillRandomBytes(noise.texels, randomEngine);
+		images.push_back(std::move(noise));
+
+		return images;
+	}
+
+	// Compresses every image to every format (best time of 3), decodes it back and prints the encode rate and the PSNR
+	// The demo materials' albedo and normal maps are added when they can be decoded, without a floor
+	void BenchmarkBlockCompression(const SceneData& sceneData) {
+		constexpr const char* s_BlockFormatNames[BlockCompressor::Num_BlockFormats] {"BC1", "BC3", "BC4", "BC5", "BC7"};
+
+		std::vector<CompressionImage> images = GenerateCompressionImages();
+		for(const std::vector<Benchmarks::TextureFile>& materialTextureFiles : sceneData.materialTextureFiles) {
+			for(size_t i = 0; i < std::min<size_t>(2, materialTextureFiles.size()); i++) {
+				Texture::ImageData image {};
+				if(Texture::DecodeFile(materialTextureFiles[i].filePath, image) && image.uCharData && image.width % 4 == 0 && image.height % 4 == 0) {
+					images.push_back({materialTextureFiles[i].filePath, image.width, image.height, std::vector<unsigned char>(image.uCharData, image.uCharData + (size_t)image.width * image.height * 4), {}});
+				}
+				Texture::FreeImageData(image);
+			}
+		}
+
+		int belowFloorCount = 0;
+		for(const CompressionImage& image : images) {
+			std::vector<unsigned char> decodedTexels(image.texels.size());
+			std::ostringstream line {};
+			line << "Block compression benchmark: " << image.name << " (" << image.width << "x" << image.height << "):";
+			for(int format = 0; format < BlockCompressor::Num_BlockFormats; format++) {
+				BlockCompressor::BlockFormat blockFormat = (BlockCompressor::BlockFormat)format;
+				std::vector<unsigned char> blocks(BlockCompressor::GetCompressedSize(blockFormat, image.width, image.height));
+				float bestTime = GetBestTime(3, [&]() { BlockCompressor::Compress(blockFormat, image.texels.data(), image.width, image.height, blocks.data()); });
+				BlockCompressor::Decompress(blockFormat, blocks.data(), image.width, image.height, decodedTexels.data());
+				float psnr = BlockCompressor::ComputePSNR(blockFormat, image.texels.data(), decodedTexels.data(), image.width, image.height);
+
+				bool b_IsBelowFloor = image.minPSNR[format] > 0.0f && psnr < image.minPSNR[format];
+				belowFloorCount += b_IsBelowFloor ? 1 : 0;
+				line << " " << s_BlockFormatNames[format] << " " << psnr << " dB " << (float)image.width * image.height / (bestTime * 1e3f) << " MP/s" << (b_IsBelowFloor ? " (BELOW " + std::to_string((int)image.minPSNR[format]) + " dB)" : "") << ",";
+			}
+			std::string lineText = line.str();
+			lineText.pop_back();
+			std::cout << lineText << "\n";
+		}
+		std::cout << "Block compression benchmark: " << belowFloorCount << " results below their quality floor\n";
+	}
+
+	struct DDSCase {
+		std::string name;
+		DXGI_FORMAT format;
+		int width;
+		int height;
+		// 0 for the full chain
+		int mipCount;
+	};
+
+	// Random mips of the sizes DDSFile expects (block rows for block compressed formats)
+	std::vector<std::vector<unsigned char>> GenerateDDSMips(const DDSCase& ddsCase, std::mt19937& randomEngine) {
+		int mipCount = ddsCase.mipCount;
+		if(mipCount == 0) {
+			mipCount = 1;
+			while((std::max(ddsCase.width, ddsCase.height) >> mipCount) > 0) {
+				mipCount++;
+			}
+		}
+		std::vector<std::vector<unsigned char>> mips(mipCount);
+		for(int mip = 0; mip < mipCount; mip++) {
+			int mipWidth = std::max(1, ddsCase.width >> mip);
+			int mipHeight = std::max(1, ddsCase.height >> mip);
+			mips[mip].resize((size_t)DDSFile::GetRowPitch(ddsCase.format, mipWidth) * DDSFile::GetRowCount(ddsCase.format, mipHeight));
+			FillRandomBytes(mips[mip], randomEngine);
+		}
+		return mips;
+	}
+
+	bool MatchesDDS(const DDSFile& ddsFile, DXGI_FORMAT format, int width, int height, const std::vector<std::vector<unsigned char>>& mips, const uint32_t* metadata) {
+		if(ddsFile.GetFormat() != format || ddsFile.GetWidth() != width || ddsFile.GetHeight() != height || ddsFile.GetMipCount() != (int)mips.size()) {
+			return false;
+		}
+		if(metadata && std::memcmp(ddsFile.GetMetadata(), metadata, DDSFile::kMetadataCount * sizeof(uint32_t)) != 0) {
+			return false;
+		}
+		for(int mip = 0; mip < (int)mips.size(); mip++) {
+			if(ddsFile.GetMipSize(mip) != mips[mip].size() || std::memcmp(ddsFile.GetMipData(mip), mips[mip].data(), mips[mip].size()) != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Every case is written with DDSFile::Write, then read back mapped and from memory and compared mip by mip and with its metadata
+	// The first block compressed and the RGBA8 file are also rewritten with a legacy header (DXT5 four CC, RGBA bit masks), and corrupted copies must be rejected
+	// Last a 4K BC7 chain is loaded by DDSFile (mapped, validated) and by reading the file, then created on the device from the mapped data
+	void BenchmarkDDSRoundTrip(ID3D11Device* device, ID3D11DeviceContext* deviceContext) {
+		const std::vector<DDSCase> ddsCases {
+			{"BC1 256x128", DXGI_FORMAT_BC1_UNORM, 256, 128, 0},
+			{"BC3 260x36 (partial blocks in the mips)", DXGI_FORMAT_BC3_UNORM, 260, 36, 0},
+			{"BC5 64x64", DXGI_FORMAT_BC5_UNORM, 64, 64, 1},
+			{"BC7 sRGB 1024x1024", DXGI_FORMAT_BC7_UNORM_SRGB, 1024, 1024, 0},
+			{"RGBA8 13x7", DXGI_FORMAT_R8G8B8A8_UNORM, 13, 7, 0},
+			{"R9G9B9E5 512x256", DXGI_FORMAT_R9G9B9E5_SHAREDEXP, 512, 256, 1},
+			{"RGBA16F 33x65", DXGI_FORMAT_R16G16B16A16_FLOAT, 33, 65, 0},
+		};
+		std::string filePath = GetTemporaryPath("dds_round_trip.dds").string();
+		std::mt19937 randomEngine(1234);
+
+		int failedCount = 0;
+		for(const DDSCase& ddsCase : ddsCases) {
+			std::vector<std::vector<unsigned char>> mips = GenerateDDSMips(ddsCase, randomEngine);
+			uint32_t metadata[DDSFile::kMetadataCount] {};
+			std::generate(std::begin(metadata), std::end(metadata), [&]() { return (uint32_t)randomEngine(); });
+
+			DDSFile ddsFile {};
+			bool b_IsWritten = DDSFile::Write(filePath, ddsCase.format, ddsCase.width, ddsCase.height, mips, metadata);
+			bool b_MappedMatches = b_IsWritten && ddsFile.Initialize(filePath) && MatchesDDS(ddsFile, ddsCase.format, ddsCase.width, ddsCase.height, mips, metadata);
+			ddsFile.Shutdown();
+			std::vector<unsigned char> fileData = ReadWholeFile(filePath);
+			bool b_MemoryMatches = b_IsWritten && ddsFile.Initialize(fileData.data(), fileData.size()) && MatchesDDS(ddsFile, ddsCase.format, ddsCase.width, ddsCase.height, mips, metadata);
+			ddsFile.Shutdown();
+
+			/// Legacy header: the DX10 extension is dropped and the format goes into the pixel format
+			const size_t headerEnd = sizeof(DDSFile::kMagic) + sizeof(DDSFile::DDSHeader);
+			std::string legacyResult {};
+			if(b_IsWritten && (ddsCase.format == DXGI_FORMAT_BC3_UNORM || ddsCase.format == DXGI_FORMAT_R8G8B8A8_UNORM)) {
+				std::vector<unsigned char> legacyData(fileData.begin(), fileData.begin() + headerEnd);
+				legacyData.insert(legacyData.end(), fileData.begin() + headerEnd + sizeof(DDSFile::DDSHeaderDX10), fileData.end());
+				DDSFile::DDSHeader* legacyHeader = (DDSFile::DDSHeader*)(legacyData.data() + sizeof(DDSFile::kMagic));
+				if(ddsCase.format == DXGI_FORMAT_BC3_UNORM) {
+					legacyHeader->ddspf.fourCC = (uint32_t)'D' | (uint32_t)'X' << 8 | (uint32_t)'T' << 16 | (uint32_t)'5' << 24;
+				}
+				else {
+					// DDPF_RGB | DDPF_ALPHAPIXELS with r in the low byte
+					legacyHeader->ddspf.flags = 0x40 | 0x1;
+					legacyHeader->ddspf.fourCC = 0;
+					legacyHeader->ddspf.rgbBitCount = 32;
+					legacyHeader->ddspf.rBitMask = 0x000000FF;
+					legacyHeader->ddspf.gBitMask = 0x0000FF00;
+					legacyHeader->ddspf.bBitMask = 0x00FF0000;
+					legacyHeader->ddspf.aBitMask = 0xFF000000;
+				}
+				bool b_LegacyMatches = ddsFile.Initialize(legacyData.data(), legacyData.size()) && MatchesDDS(ddsFile, ddsCase.format, ddsCase.width, ddsCase.height, mips, metadata);
+				ddsFile.Shutdown();
+				legacyResult = b_LegacyMatches ? ", legacy header ok" : ", LEGACY HEADER FAILED";
+				failedCount += b_LegacyMatches ? 0 : 1;
+			}
+
+			/// Broken copies, every one must be rejected
+			std::vector<std::pair<std::string, std::vector<unsigned char>>> brokenFiles {};
+			if(b_IsWritten) {
+				brokenFiles.push_back({"truncated", std::vector<unsigned char>(fileData.begin(), fileData.end() - 1)});
+				brokenFiles.push_back({"magic", fileData});
+				brokenFiles.back().second[0] = 'X';
+				brokenFiles.push_back({"cubemap", fileData});
+				((DDSFile::DDSHeader*)(brokenFiles.back().second.data() + sizeof(DDSFile::kMagic)))->caps2 |= 0x200;
+				brokenFiles.push_back({"array", fileData});
+				((DDSFile::DDSHeaderDX10*)(brokenFiles.back().second.data() + headerEnd))->arraySize = 2;
+				brokenFiles.push_back({"mip count", fileData});
+				((DDSFile::DDSHeader*)(brokenFiles.back().second.data() + sizeof(DDSFile::kMagic)))->mipMapCount = 16;
+				brokenFiles.push_back({"format", fileData});
+				((DDSFile::DDSHeaderDX10*)(brokenFiles.back().second.data() + headerEnd))->dxgiFormat = DXGI_FORMAT_UNKNOWN;
+				if(DDSFile::IsBlockCompressed(ddsCase.format)) {
+					brokenFiles.push_back({"partial top block", fileData});
+					((DDSFile::DDSHeader*)(brokenFiles.back().second.data() + sizeof(DDSFile::kMagic)))->width += 1;
+				}
+			}
+			std::string acceptedBrokenNames {};
+			for(const auto& [brokenName, brokenData] : brokenFiles) {
+				if(ddsFile.Initialize(brokenData.data(), brokenData.size())) {
+					acceptedBrokenNames += " " + brokenName;
+				}
+				ddsFile.Shutdown();
+			}
+
+			bool b_Passed = b_MappedMatches && b_MemoryMatches && acceptedBrokenNames.empty();
+			failedCount += b_Passed ? 0 : 1;
+			std::cout << "DDS round trip: " << ddsCase.name << ", " << mips.size() << " mips: " << (b_MappedMatches ? "mapped ok" : "MAPPED FAILED") << ", " << (b_MemoryMatches ? "memory ok" : "MEMORY FAILED")
+				<< legacyResult << ", " << brokenFiles.size() - (acceptedBrokenNames.empty() ? 0 : std::count(acceptedBrokenNames.begin(), acceptedBrokenNames.end(), ' ')) << " / " << brokenFiles.size() << " broken copies rejected"
+				<< (acceptedBrokenNames.empty() ? "" : " (ACCEPTED:" + acceptedBrokenNames + ")") << "\n";
+		}
+
+		/// Load time of a 4K BC7 chain, mapped (no copy until the driver reads it) against reading the whole file
+		DDSCase largeCase {"BC7 4096x4096", DXGI_FORMAT_BC7_UNORM, 4096, 4096, 0};
+		std::vector<std::vector<unsigned char>> largeMips = GenerateDDSMips(largeCase, randomEngine);
+		if(DDSFile::Write(filePath, largeCase.format, largeCase.width, largeCase.height, largeMips)) {
+			auto startTime = std::chrono::steady_clock::now();
+			DDSFile ddsFile {};
+			bool b_IsMapped = ddsFile.Initialize(filePath);
+			float mapTime = GetElapsedMilliseconds(startTime);
+
+			startTime = std::chrono::steady_clock::now();
+			std::vector<unsigned char> fileData = ReadWholeFile(filePath);
+			float readTime = GetElapsedMilliseconds(startTime);
+
+			startTime = std::chrono::steady_clock::now();
+			Texture texture {};
+			bool b_IsCreated = b_IsMapped && texture.Initialize(device, deviceContext, filePath, largeCase.format, 0) && texture.GetTextureSRV() != nullptr;
+			float createTime = GetElapsedMilliseconds(startTime);
+			texture.Shutdown();
+			ddsFile.Shutdown();
+
+			failedCount += b_IsMapped && b_IsCreated ? 0 : 1;
+			std::cout << "DDS round trip: " << largeCase.name << " (" << fileData.size() / (1024 * 1024) << " MB): map and validate " << mapTime << " ms, read " << readTime << " ms, texture from the mapped file " << createTime << " ms"
+				<< (b_IsCreated ? "" : ", TEXTURE NOT CREATED") << "\n";
+		}
+		std::filesystem::remove(filePath);
+		std::cout << "DDS round trip: " << failedCount << " failures\n";
+	}
+
+	const char* const s_MipFilterNames[MipGenerator::Num_Filters] = {"box", "Kaiser", "Lanczos"};
+
+	float DecodeSRGB(unsigned char value) {
+		float c = value / 255.0f;
+		return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	// What the texture path did before MipGenerator: each mip a 2x2 average of the previous one's 8 bit texels, in whatever space they are stored
+	void GenerateScalarBoxMips(const unsigned char* texels, int width, int height, std::vector<std::vector<unsigned char>>& mips) {
+		mips.resize(MipGenerator::GetMipCount(width, height) - 1);
+		for(size_t mip = 0; mip < mips.size(); mip++) {
+			const unsigned char* source = mip == 0 ? texels : mips[mip - 1].data();
+			int mipWidth = std::max(1, width / 2);
+			int mipHeight = std::max(1, height / 2);
+			mips[mip].resize((size_t)mipWidth * mipHeight * 4);
+			for(int y = 0; y < mipHeight; y++) {
+				for(int x = 0; x < mipWidth; x++) {
+					int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+					int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+					for(int c = 0; c < 4; c++) {
+						int sum = source[((size_t)y0 * width + x0) * 4 + c] + source[((size_t)y0 * width + x1) * 4 + c] + source[((size_t)y1 * width + x0) * 4 + c] + source[((size_t)y1 * width + x1) * 4 + c];
+						mips[mip][((size_t)y * mipWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+					}
+				}
+			}
+			width = mipWidth;
+			height = mipHeight;
+		}
+	}
+
+	// Root mean square of the rgb channels around their mean, in 8 bit steps
+	float GetChannelDeviation(const std::vector<unsigned char>& texels) {
+		double sum = 0.0;
+		double squareSum = 0.0;
+		size_t count = 0;
+		for(size_t i = 0; i < texels.size(); i++) {
+			if(i % 4 != 3) {
+				sum += texels[i];
+				squareSum += (double)texels[i] * texels[i];
+				count++;
+			}
+		}
+		double mean = sum / count;
+		return (float)sqrt(std::max(0.0, squareSum / count - mean * mean));
+	}
+
+	// Exact checks first, every filter must pass them:
+	// - box mips of an even sized linear image are the rounded 2x2 average of the previous mip (the chain is kept in float, so within 1 of the 8 bit average)
+	// - a black and white sRGB checkerboard filters to linear 0.5 (sRGB 188), not 128 as averaging the stored values gives
+	// - a flat image stays flat down to 1x1, so the windowed sinc weights are normalized at the clamped edges too
+	// - filtered normal map texels decode to unit length
+	// Then a stripe pattern above the mip 1 Nyquist rate shows how much aliasing each filter lets through, and a 2048x2048 sRGB image gives the throughput
+	void BenchmarkMipGeneration() {
+		std::mt19937 randomEngine(1234);
+		int failedCount = 0;
+
+		/// 2x2 average
+		{
+			const int size = 256;
+			std::vector<unsigned char> texels((size_t)size * size * 4);
+			FillRandomBytes(texels, randomEngine);
+			std::vector<std::vector<unsigned char>> mips {};
+			std::vector<std::vector<unsigned char>> referenceMips {};
+			MipGenerator::GenerateMips(texels.data(), size, size, 2, {MipGenerator::kBoxFilter, false, false}, mips);
+			GenerateScalarBoxMips(texels.data(), size, size, referenceMips);
+			int maxDifference = 0;
+			for(size_t i = 0; i < mips[0].size(); i++) {
+				maxDifference = std::max(maxDifference, std::abs((int)mips[0][i] - (int)referenceMips[0][i]));
+			}
+			failedCount += maxDifference <= 1 ? 0 : 1;
+			std::cout << "Mip generation benchmark: box 256x256 mip 1 against the 2x2 average, max difference " << maxDifference << (maxDifference <= 1 ? "" : ", ABOVE 1") << "\n";
+		}
+
+		/// Gamma-correct sRGB
+		{
+			const int size = 64;
+			std::vector<unsigned char> texels((size_t)size * size * 4);
+			for(int y = 0; y < size; y++) {
+				for(int x = 0; x < size; x++) {
+					unsigned char value = (x + y) % 2 == 0 ? 255 : 0;
+					unsigned char* texel = &texels[((size_t)y * size + x) * 4];
+					texel[0] = texel[1] = texel[2] = value;
+					texel[3] = value;
+				}
+			}
+			std::vector<std::vector<unsigned char>> referenceMips {};
+			GenerateScalarBoxMips(texels.data(), size, size, referenceMips);
+			for(int filter = 0; filter < MipGenerator::Num_Filters; filter++) {
+				std::vector<std::vector<unsigned char>> mips {};
+				MipGenerator::GenerateMips(texels.data(), size, size, 0, {(MipGenerator::Filter)filter, true, false}, mips);
+				// The centre texel of mip 1 and 3, away from the clamped edges; alpha is linear so it must average to 128
+				const std::vector<unsigned char>& mip1 = mips[0];
+				const std::vector<unsigned char>& mip3 = mips[2];
+				const unsigned char* texel1 = &mip1[((size_t)(size / 4) * (size / 2) + size / 4) * 4];
+				const unsigned char* texel3 = &mip3[((size_t)(size / 16) * (size / 8) + size / 16) * 4];
+				bool b_IsGammaCorrect = std::abs(texel1[0] - 188) <= 1 && std::abs(texel3[0] - 188) <= 1 && std::abs(texel1[3] - 128) <= 1;
+				failedCount += b_IsGammaCorrect ? 0 : 1;
+				std::cout << "Mip generation benchmark: " << s_MipFilterNames[filter] << " sRGB checkerboard mip 1 rgb " << (int)texel1[0] << " alpha " << (int)texel1[3] << ", mip 3 rgb " << (int)texel3[0]
+					<< " (linear 0.5 is 188, the stored value average " << (int)referenceMips[0][0] << ")" << (b_IsGammaCorrect ? "" : ", NOT GAMMA CORRECT") << "\n";
+			}
+		}
+
+		/// Flat images and unit normals
+		{
+			const int width = 300;
+			const int height = 97;
+			std::vector<unsigned char> flatTexels((size_t)width * height * 4);
+			for(size_t i = 0; i < flatTexels.size(); i++) {
+				flatTexels[i] = (unsigned char)(37 + 60 * (i % 4));
+			}
+			std::vector<unsigned char> normalTexels((size_t)width * height * 4);
+			std::normal_distribution<float> normalDistribution {};
+			for(size_t i = 0; i < normalTexels.size(); i += 4) {
+				// Bumps around +z, as a tangent space normal map has
+				float x = normalDistribution(randomEngine) * 0.4f;
+				float y = normalDistribution(randomEngine) * 0.4f;
+				float length = sqrtf(x * x + y * y + 1.0f);
+				normalTexels[i + 0] = (unsigned char)lroundf((x / length * 0.5f + 0.5f) * 255.0f);
+				normalTexels[i + 1] = (unsigned char)lroundf((y / length * 0.5f + 0.5f) * 255.0f);
+				normalTexels[i + 2] = (unsigned char)lroundf((1.0f / length * 0.5f + 0.5f) * 255.0f);
+				normalTexels[i + 3] = 255;
+			}
+
+			for(int filter = 0; filter < MipGenerator::Num_Filters; filter++) {
+				std::vector<std::vector<unsigned char>> mips {};
+				MipGenerator::GenerateMips(flatTexels.data(), width, height, 0, {(MipGenerator::Filter)filter, true, false}, mips);
+				int changedCount = 0;
+				for(const std::vector<unsigned char>& mip : mips) {
+					for(size_t i = 0; i < mip.size(); i++) {
+						changedCount += mip[i] != flatTexels[i % 4] ? 1 : 0;
+					}
+				}
+
+				MipGenerator::GenerateMips(normalTexels.data(), width, height, 0, {(MipGenerator::Filter)filter, false, true}, mips);
+				float maxLengthError = 0.0f;
+				for(const std::vector<unsigned char>& mip : mips) {
+					for(size_t i = 0; i < mip.size(); i += 4) {
+						float x = mip[i + 0] / 127.5f - 1.0f;
+						float y = mip[i + 1] / 127.5f - 1.0f;
+						float z = mip[i + 2] / 127.5f - 1.0f;
+						maxLengthError = std::max(maxLengthError, std::abs(sqrtf(x * x + y * y + z * z) - 1.0f));
+					}
+				}
+
+				// 8 bit quantization alone moves a unit normal's length by up to about 0.007
+				bool b_Passed = changedCount == 0 && maxLengthError < 0.01f;
+				failedCount += b_Passed ? 0 : 1;
+				std::cout << "Mip generation benchmark: " << s_MipFilterNames[filter] << " 300x97 flat image " << changedCount << " changed texels, normal map max length error " << maxLengthError
+					<< (b_Passed ? "" : ", FAILED") << "\n";
+			}
+		}
+
+		/// Aliasing: stripes at 0.4 cycles per texel are above the Nyquist rate of mip 1 and should filter to flat grey
+		{
+			const int size = 512;
+			std::vector<unsigned char> texels((size_t)size * size * 4);
+			for(int y = 0; y < size; y++) {
+				for(int x = 0; x < size; x++) {
+					unsigned char value = (unsigned char)lroundf(127.5f + 127.5f * cosf(2.0f * 3.14159265f * 0.4f * (x + y * 0.5f)));
+					unsigned char* texel = &texels[((size_t)y * size + x) * 4];
+					texel[0] = texel[1] = texel[2] = value;
+					texel[3] = 255;
+				}
+			}
+			float deviations[MipGenerator::Num_Filters] {};
+			for(int filter = 0; filter < MipGenerator::Num_Filters; filter++) {
+				std::vector<std::vector<unsigned char>> mips {};
+				MipGenerator::GenerateMips(texels.data(), size, size, 2, {(MipGenerator::Filter)filter, false, false}, mips);
+				deviations[filter] = GetChannelDeviation(mips[0]);
+			}
+			// The windowed sincs cut off at the mip's Nyquist rate, the box only averages pairs, so they must alias less
+			bool b_Passed = deviations[MipGenerator::kKaiserFilter] < deviations[MipGenerator::kBoxFilter] && deviations[MipGenerator::kLanczosFilter] < deviations[MipGenerator::kBoxFilter];
+			failedCount += b_Passed ? 0 : 1;
+			std::cout << "Mip generation benchmark: 512x512 stripes above the mip 1 Nyquist rate, aliasing left in mip 1 (rms, 8 bit steps):";
+			for(int filter = 0; filter < MipGenerator::Num_Filters; filter++) {
+				std::cout << " " << s_MipFilterNames[filter] << " " << deviations[filter];
+			}
+			std::cout << (b_Passed ? "" : ", SINC FILTERS ALIAS MORE THAN THE BOX") << "\n";
+		}
+
+		/// Throughput of a full 2048x2048 sRGB chain
+		{
+			const int size = 2048;
+			const int runCount = 3;
+			std::vector<unsigned char> texels((size_t)size * size * 4);
+			FillRandomBytes(texels, randomEngine);
+			std::vector<std::vector<unsigned char>> mips {};
+			float scalarTime = GetBestTime(runCount, [&]() { GenerateScalarBoxMips(texels.data(), size, size, mips); });
+			std::cout << "Mip generation benchmark: 2048x2048 full chain, scalar 2x2 box (not gamma correct) " << scalarTime << " ms";
+			for(int filter = 0; filter < MipGenerator::Num_Filters; filter++) {
+				float time = GetBestTime(runCount, [&]() { MipGenerator::GenerateMips(texels.data(), size, size, 0, {(MipGenerator::Filter)filter, true, false}, mips); });
+				std::cout << ", " << s_MipFilterNames[filter] << " " << time << " ms (" << size * size / (time * 1000.0f) << " MP/s)";
+			}
+			std::cout << "\n";
+		}
+
+		std::cout << "Mip generation benchmark: " << failedCount << " failures\n";
+	}
+
+	struct TargaLayout {
+		int bitsPerTexel;
+		bool isRLE;
+		bool isTopToBottom;
+	};
+
+	// RGBA texels in horizontal runs of random colors, so RLE files have runs and raw packets, some of them crossing rows
+	std::vector<unsigned char> GenerateTargaTexels(int width, int height, std::mt19937& randomEngine) {
+		std::vector<unsigned char> texels((size_t)width * height * 4);
+		std::uniform_int_distribution<int> runLengthDistribution(1, 40);
+		for(size_t i = 0; i < texels.size(); ) {
+			unsigned char color[4] {(unsigned char)randomEngine(), (unsigned char)randomEngine(), (unsigned char)randomEngine(), (unsigned char)randomEngine()};
+			for(int run = runLengthDistribution(randomEngine); run > 0 && i < texels.size(); run--, i += 4) {
+				memcpy(&texels[i], color, 4);
+			}
+		}
+		return texels;
+	}
+
+	// idLength bytes of image id are written after the header, readers must skip them
+	std::vector<unsigned char> EncodeTarga(const std::vector<unsigned char>& texels, int width, int height, const TargaLayout& layout, int idLength) {
+		int bytesPerTexel = layout.bitsPerTexel / 8;
+		std::vector<unsigned char> file(18 + idLength, 0);
+		file[0] = (unsigned char)idLength;
+		file[2] = layout.isRLE ? 10 : 2;
+		file[12] = (unsigned char)(width & 0xFF);
+		file[13] = (unsigned char)(width >> 8);
+		file[14] = (unsigned char)(height & 0xFF);
+		file[15] = (unsigned char)(height >> 8);
+		file[16] = (unsigned char)layout.bitsPerTexel;
+		file[17] = (unsigned char)((layout.bitsPerTexel == 32 ? 8 : 0) | (layout.isTopToBottom ? 0x20 : 0));
+		for(int i = 0; i < idLength; i++) {
+			file[18 + i] = (unsigned char)('a' + i % 26);
+		}
+
+		// BGR(A) texels in file order, then packed into packets as one stream
+		std::vector<unsigned char> stored {};
+		stored.reserve((size_t)width * height * bytesPerTexel);
+		for(int row = 0; row < height; row++) {
+			int y = layout.isTopToBottom ? row : height - 1 - row;
+			for(int x = 0; x < width; x++) {
+				const unsigned char* texel = &texels[((size_t)y * width + x) * 4];
+				stored.insert(stored.end(), {texel[2], texel[1], texel[0]});
+				if(bytesPerTexel == 4) {
+					stored.push_back(texel[3]);
+				}
+			}
+		}
+		if(!layout.isRLE) {
+			file.insert(file.end(), stored.begin(), stored.end());
+			return file;
+		}
+
+		size_t texelCount = (size_t)width * height;
+		auto IsSameTexel = [&](size_t a, size_t b) { return memcmp(&stored[a * bytesPerTexel], &stored[b * bytesPerTexel], bytesPerTexel) == 0; };
+		for(size_t i = 0; i < texelCount; ) {
+			size_t runLength = 1;
+			while(i + runLength < texelCount && runLength < 128 && IsSameTexel(i, i + runLength)) {
+				runLength++;
+			}
+			if(runLength > 1) {
+				file.push_back((unsigned char)(0x80 | (runLength - 1)));
+				file.insert(file.end(), &stored[i * bytesPerTexel], &stored[(i + 1) * bytesPerTexel]);
+				i += runLength;
+				continue;
+			}
+			size_t rawLength = 1;
+			while(i + rawLength < texelCount && rawLength < 128 && !(i + rawLength + 1 < texelCount && IsSameTexel(i + rawLength, i + rawLength + 1))) {
+				rawLength++;
+			}
+			file.push_back((unsigned char)(rawLength - 1));
+			file.insert(file.end(), &stored[i * bytesPerTexel], &stored[(i + rawLength) * bytesPerTexel]);
+			i += rawLength;
+		}
+		return file;
+	}
+
+	// Every layout is decoded at sizes that leave scalar tails after the 4 texel shuffles (1x1, 5x3, 37x19) and at 512x256, then compared with the source texels (alpha 255 for 24 bit) and stb_image
+	// Broken files (truncated raw and RLE data, right to left, 16 bit, color mapped) must fail to load
+	// Last 2048x2048 files of each layout are decoded by Texture and by stb_image, best of 3
+	void BenchmarkTargaDecode() {
+		const std::vector<TargaLayout> layouts {
+			{32, false, false}, {32, false, true}, {24, false, false}, {24, false, true},
+			{32, true, false}, {32, true, true}, {24, true, false}, {24, true, true},
+		};
+		auto GetLayoutName = [](const TargaLayout& layout) {
+			return std::to_string(layout.bitsPerTexel) + " bit " + (layout.isRLE ? "RLE" : "raw") + (layout.isTopToBottom ? " top down" : " bottom up");
+		};
+		const std::vector<std::pair<int, int>> sizes {{1, 1}, {5, 3}, {37, 19}, {512, 256}};
+		std::string filePath = GetTemporaryPath("targa_decode.tga").string();
+		std::mt19937 randomEngine(1234);
+
+		int failedCount = 0;
+		for(const TargaLayout& layout : layouts) {
+			std::string mismatchedSizes {};
+			for(const auto& [width, height] : sizes) {
+				std::vector<unsigned char> texels = GenerateTargaTexels(width, height, randomEngine);
+				if(layout.bitsPerTexel == 24) {
+					for(size_t i = 3; i < texels.size(); i += 4) {
+						texels[i] = 255;
+					}
+				}
+
+				Texture::ImageData image {};
+				bool b_IsDecoded = WriteWholeFile(filePath, EncodeTarga(texels, width, height, layout, width % 7)) && Texture::DecodeFile(filePath, image);
+				bool b_Matches = b_IsDecoded && image.width == width && image.height == height && memcmp(image.uCharData, texels.data(), texels.size()) == 0;
+				Texture::FreeImageData(image);
+
+				int stbWidth = 0;
+				int stbHeight = 0;
+				int stbComponentCount = 0;
+				unsigned char* stbTexels = stbi_load(filePath.c_str(), &stbWidth, &stbHeight, &stbComponentCount, 4);
+				bool b_MatchesSTB = stbTexels && stbWidth == width && stbHeight == height && memcmp(stbTexels, texels.data(), texels.size()) == 0;
+				stbi_image_free(stbTexels);
+
+				if(!b_Matches || !b_MatchesSTB) {
+					mismatchedSizes += " " + std::to_string(width) + "x" + std::to_string(height) + (b_Matches ? " (stb_image)" : "");
+				}
+			}
+			failedCount += mismatchedSizes.empty() ? 0 : 1;
+			std::cout << "Targa decode benchmark: " << GetLayoutName(layout) << ": " << (mismatchedSizes.empty() ? "every size matches" : "MISMATCH AT" + mismatchedSizes) << "\n";
+		}
+
+		/// Broken files
+		{
+			std::vector<unsigned char> texels = GenerateTargaTexels(37, 19, randomEngine);
+			std::vector<unsigned char> rawFile = EncodeTarga(texels, 37, 19, {32, false, false}, 0);
+			std::vector<unsigned char> rleFile = EncodeTarga(texels, 37, 19, {24, true, false}, 0);
+			std::vector<std::pair<std::string, std::vector<unsigned char>>> brokenFiles {
+				{"truncated raw", std::vector<unsigned char>(rawFile.begin(), rawFile.end() - 1)},
+				{"truncated RLE", std::vector<unsigned char>(rleFile.begin(), rleFile.end() - 1)},
+				{"header only", std::vector<unsigned char>(rawFile.begin(), rawFile.begin() + 18)},
+				{"right to left", rawFile},
+				{"16 bit", rawFile},
+				{"color mapped", rawFile},
+			};
+			brokenFiles[3].second[17] |= 0x10;
+			brokenFiles[4].second[16] = 16;
+			brokenFiles[5].second[2] = 1;
+
+			std::string acceptedNames {};
+			for(const auto& [brokenName, brokenFile] : brokenFiles) {
+				Texture::ImageData image {};
+				if(WriteWholeFile(filePath, brokenFile) && Texture::DecodeFile(filePath, image)) {
+					acceptedNames += " " + brokenName;
+				}
+				Texture::FreeImageData(image);
+			}
+			failedCount += acceptedNames.empty() ? 0 : 1;
+			std::cout << "Targa decode benchmark: " << (acceptedNames.empty() ? "every broken file rejected" : "BROKEN FILES ACCEPTED:" + acceptedNames) << "\n";
+		}
+
+		/// Decode times
+		{
+			const int size = 2048;
+			const int runCount = 3;
+			std::vector<unsigned char> texels = GenerateTargaTexels(size, size, randomEngine);
+			for(const TargaLayout& layout : layouts) {
+				if(!WriteWholeFile(filePath, EncodeTarga(texels, size, size, layout, 0))) {
+					continue;
+				}
+				float bestTime = GetBestTime(runCount, [&]() {
+					Texture::ImageData image {};
+					Texture::DecodeFile(filePath, image);
+					Texture::FreeImageData(image);
+				});
+				float bestSTBTime = GetBestTime(runCount, [&]() {
+					int stbWidth = 0;
+					int stbHeight = 0;
+					int stbComponentCount = 0;
+					stbi_image_free(stbi_load(filePath.c_str(), &stbWidth, &stbHeight, &stbComponentCount, 4));
+				});
+				std::cout << "Targa decode benchmark: 2048x2048 " << GetLayoutName(layout) << " " << bestTime << " ms, stb_image " << bestSTBTime << " ms\n";
+			}
+		}
+
+		std::filesystem::remove(filePath);
+		std::cout << "Targa decode benchmark: " << failedCount << " failures\n";
+	}
+
+	// PBR.ps reads the packed map as r ao, g roughness, b metallic, a height
+	const char* const s_PackedChannelNames[4] = {"ao", "roughness", "metallic", "height"};
+
+	// Uncompressed 32 bit, top to bottom targa
+	bool WritePackingSourceFile(const std::string& filePath, const std::vector<unsigned char>& texels, int width, int height) {
+		return WriteWholeFile(filePath, EncodeTarga(texels, width, height, {32, false, true}, 0));
+	}
+
+	// PSNR of one channel of packed texels against the red channel of source texels
+	float ComputeChannelPSNR(const unsigned char* packedTexels, int channel, const std::vector<unsigned char>& sourceTexels) {
+		double squareErrorSum = 0.0;
+		for(size_t i = 0; i < sourceTexels.size(); i += 4) {
+			double error = (double)packedTexels[i + channel] - sourceTexels[i];
+			squareErrorSum += error * error;
+		}
+		double meanSquareError = squareErrorSum / (sourceTexels.size() / 4);
+		return meanSquareError == 0.0 ? INFINITY : (float)(10.0 * log10(255.0 * 255.0 / meanSquareError));
+	}
+
+	// Four 256x256 sources, each a different smooth pattern in red and its inverse in green and blue, so reading the wrong channel or source shows
+	// - the scene materials' packed sources must be listed in PBR.ps's channel order
+	// - packing to RGBA8 puts each source's red channel, exactly, in its own channel; fewer sources leave the rest 0 (alpha 255); sources of another size are rejected
+	// - cooked to the packed map's block format and decoded again, every channel must be closest to its own source
+	void BenchmarkChannelPacking(const SceneData& sceneData) {
+		int failedCount = 0;
+
+		/// Source order of the materials
+		{
+			bool b_IsInShaderOrder = true;
+			for(const std::vector<Benchmarks::TextureFile>& materialTextureFiles : sceneData.materialTextureFiles) {
+				const std::vector<std::string>& sourceFilePaths = materialTextureFiles[2].sourceFilePaths;
+				b_IsInShaderOrder = b_IsInShaderOrder && sourceFilePaths.size() == 4;
+				for(int channel = 0; b_IsInShaderOrder && channel < 4; channel++) {
+					b_IsInShaderOrder = sourceFilePaths[channel].find(std::string("_") + s_PackedChannelNames[channel] + ".") != std::string::npos;
+				}
+			}
+			failedCount += b_IsInShaderOrder ? 0 : 1;
+			std::cout << "Channel packing benchmark: material sources " << (b_IsInShaderOrder ? "in" : "NOT IN") << " PBR.ps channel order\n";
+		}
+
+		const int size = 256;
+		std::filesystem::path directoryPath = GetTemporaryPath("channel_packing");
+		std::filesystem::create_directories(directoryPath);
+		std::vector<std::string> sourceFilePaths {};
+		std::vector<std::vector<unsigned char>> sourceTexels(4, std::vector<unsigned char>((size_t)size * size * 4));
+		for(int channel = 0; channel < 4; channel++) {
+			for(int y = 0; y < size; y++) {
+				for(int x = 0; x < size; x++) {
+					float u = (x + 0.5f) / size;
+					float v = (y + 0.5f) / size;
+					float values[4] = {u, v, sqrtf((u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f)) * 1.4f, 0.5f + 0.5f * sinf((u + v) * 9.0f)};
+					unsigned char value = (unsigned char)lroundf(std::clamp(values[channel], 0.0f, 1.0f) * 255.0f);
+					unsigned char* texel = &sourceTexels[channel][((size_t)y * size + x) * 4];
+					texel[0] = value;
+					texel[1] = texel[2] = (unsigned char)(255 - value);
+					texel[3] = 255;
+				}
+			}
+			sourceFilePaths.push_back((directoryPath / (std::string("material_") + s_PackedChannelNames[channel] + ".tga")).string());
+			WritePackingSourceFile(sourceFilePaths.back(), sourceTexels[channel], size, size);
+		}
+		std::string packedFilePath = (directoryPath / "material_packed").string();
+
+		/// Uncompressed
+		{
+			Texture::ImageData image {};
+			bool b_IsPacked = Texture::DecodeFile(packedFilePath, sourceFilePaths, DXGI_FORMAT_R8G8B8A8_UNORM, 1, image) && image.uCharData && image.width == size && image.height == size;
+			std::string mismatchedChannels {};
+			for(int channel = 0; b_IsPacked && channel < 4; channel++) {
+				if(ComputeChannelPSNR(image.uCharData, channel, sourceTexels[channel]) != INFINITY) {
+					mismatchedChannels += std::string(" ") + s_PackedChannelNames[channel];
+				}
+			}
+			Texture::FreeImageData(image);
+
+			// Two sources: b 0 and a 255
+			bool b_IsPartialPacked = Texture::DecodeFile(packedFilePath, {sourceFilePaths[0], sourceFilePaths[1]}, DXGI_FORMAT_R8G8B8A8_UNORM, 1, image) && image.uCharData;
+			for(size_t i = 0; b_IsPartialPacked && i < (size_t)size * size * 4; i += 4) {
+				b_IsPartialPacked = image.uCharData[i + 0] == sourceTexels[0][i] && image.uCharData[i + 1] == sourceTexels[1][i] && image.uCharData[i + 2] == 0 && image.uCharData[i + 3] == 255;
+			}
+			Texture::FreeImageData(image);
+
+			std::string smallFilePath = (directoryPath / "material_small.tga").string();
+			WritePackingSourceFile(smallFilePath, std::vector<unsigned char>((size_t)size * size, 255), size / 2, size / 2);
+			bool b_IsMismatchRejected = !Texture::DecodeFile(packedFilePath, {sourceFilePaths[0], smallFilePath}, DXGI_FORMAT_R8G8B8A8_UNORM, 1, image);
+			Texture::FreeImageData(image);
+
+			bool b_Passed = b_IsPacked && mismatchedChannels.empty() && b_IsPartialPacked && b_IsMismatchRejected;
+			failedCount += b_Passed ? 0 : 1;
+			std::cout << "Channel packing benchmark: RGBA8 " << (b_IsPacked && mismatchedChannels.empty() ? "every channel exact" : "MISMATCHED CHANNELS:" + mismatchedChannels)
+				<< ", 2 sources " << (b_IsPartialPacked ? "ok" : "WRONG DEFAULTS") << ", other size " << (b_IsMismatchRejected ? "rejected" : "ACCEPTED") << "\n";
+		}
+
+		/// Cooked
+		{
+			const DXGI_FORMAT packedFormat = sceneData.materialTextureFiles[0][2].format;
+			BlockCompressor::BlockFormat blockFormat {};
+			Texture::ImageData image {};
+			bool b_IsCooked = TextureCache::GetBlockFormat(packedFormat, blockFormat) && Texture::DecodeFile(packedFilePath, sourceFilePaths, packedFormat, 0, image) && image.ddsFile;
+			std::vector<unsigned char> decodedTexels((size_t)size * size * 4);
+			if(b_IsCooked) {
+				BlockCompressor::Decompress(blockFormat, image.ddsFile->GetMipData(0), size, size, decodedTexels.data());
+			}
+
+			// Row: decoded channel, column: source
+			std::cout << "Channel packing benchmark: cooked, PSNR of each channel against each source (dB)\n";
+			std::string misplacedChannels {};
+			for(int channel = 0; b_IsCooked && channel < 4; channel++) {
+				std::cout << "\t" << s_PackedChannelNames[channel] << ":";
+				int closestSource = 0;
+				float closestPSNR = -1.0f;
+				for(int source = 0; source < 4; source++) {
+					float psnr = ComputeChannelPSNR(decodedTexels.data(), channel, sourceTexels[source]);
+					std::cout << " " << psnr;
+					if(psnr > closestPSNR) {
+						closestPSNR = psnr;
+						closestSource = source;
+					}
+				}
+				std::cout << "\n";
+				if(closestSource != channel) {
+					misplacedChannels += std::string(" ") + s_PackedChannelNames[channel];
+				}
+			}
+
+			// The same maps as 4 separate RGBA8 textures with every mip, as they were loaded before packing
+			size_t packedSize = 0;
+			size_t unpackedSize = 0;
+			for(int mip = 0; b_IsCooked && mip < image.ddsFile->GetMipCount(); mip++) {
+				packedSize += image.ddsFile->GetMipSize(mip);
+				unpackedSize += (size_t)4 * image.ddsFile->GetMipWidth(mip) * image.ddsFile->GetMipHeight(mip) * 4;
+			}
+			Texture::FreeImageData(image);
+
+			bool b_Passed = b_IsCooked && misplacedChannels.empty();
+			failedCount += b_Passed ? 0 : 1;
+			std::cout << "Channel packing benchmark: cooked " << (!b_IsCooked ? "FAILED" : misplacedChannels.empty() ? "channels in place" : "MISPLACED CHANNELS:" + misplacedChannels)
+				<< ", " << packedSize / 1024 << " KB against " << unpackedSize / 1024 << " KB for 4 RGBA8 textures\n";
+		}
+
+		std::filesystem::remove_all(directoryPath);
+		std::cout << "Channel packing benchmark: " << failedCount << " failures\n";
+	}
+
+	// Residency request of a block compressed texture as TextureStreamer::Update builds it from a streamed Texture
+	TextureStreamer::ResidencyRequest GetStreamingRequest(DXGI_FORMAT format, int size, int tailSize) {
+		TextureStreamer::ResidencyRequest request {};
+		int mipCount = MipGenerator::GetMipCount(size, size);
+		for(int mip = mipCount - 1; mip >= 0; mip--) {
+			int mipSize = std::max(1, size >> mip);
+			request.mipChainSizes[mip] = (size_t)DDSFile::GetRowPitch(format, mipSize) * DDSFile::GetRowCount(format, mipSize) + (mip + 1 < mipCount ? request.mipChainSizes[mip + 1] : 0);
+			if(mipSize % 4 == 0) {
+				request.validMipMask |= 1u << mip;
+				// The finest valid mip no larger than the tail size, like Texture::GetMipTailFirstMip
+				if(mipSize <= tailSize) {
+					request.tailMip = mip;
+				}
+			}
+		}
+		return request;
+	}
+
+	// Mip SelectResidentMips starts from before dropping any, the finest valid one at or above the request
+	int GetRequestedResidentMip(const TextureStreamer::ResidencyRequest& request) {
+		for(int mip = std::clamp(request.requestedMip, 0, request.tailMip); mip >= 0; mip--) {
+			if((request.validMipMask >> mip) & 1) {
+				return mip;
+			}
+		}
+		return request.tailMip;
+	}
+
+	// Part 1, CPU only: the scene's materials, 3 textures each (4096 and 2048 alternating, 1 byte per texel like BC7/BC5/BC3) on objects 10 units apart,
+	// a camera flying past them requests each one's mip from its projected size (like GameObject::RequestTextureMips) and SelectResidentMips picks the resident mips every frame
+	// Every frame must stay under budget unless every texture is at its tail, never go finer than requested or coarser than the tail, keep exactly the requests when they fit,
+	// and drop largest first: no texture's next mip may be larger than the smallest mip dropped
+	// Part 2, on the device: 8 streamed 1024x1024 BC1 textures all requesting mip 0 under a budget that holds about a third of them,
+	// then no requests, they must stay until the eviction delay has passed and then fall back to their tails
+	void BenchmarkTextureStreaming(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const SceneData& sceneData) {
+		int failedCount = 0;
+
+		/// Part 1
+		{
+			const int materialCount = (int)sceneData.materialTextureFiles.size();
+			const int frameCount = 600;
+			const float viewportHeight = 1080.0f;
+			const float fieldOfView = 3.14159265f / 3.0f;
+			// Texture repeats per world unit, and the objects' bounding sphere radius
+			const float uvPerUnit = 0.5f;
+			const float objectRadius = 1.0f;
+
+			std::vector<TextureStreamer::ResidencyRequest> baseRequests {};
+			for(int material = 0; material < materialCount; material++) {
+				for(int i = 0; i < 3; i++) {
+					baseRequests.push_back(GetStreamingRequest(sceneData.materialTextureFiles[material][i].format, material % 2 == 0 ? 4096 : 2048, sceneData.streamingMipTailSize));
+				}
+			}
+			size_t tailBytes = 0;
+			size_t fullBytes = 0;
+			for(const TextureStreamer::ResidencyRequest& request : baseRequests) {
+				tailBytes += request.mipChainSizes[request.tailMip];
+				fullBytes += request.mipChainSizes[0];
+			}
+			std::cout << "Texture streaming benchmark: " << baseRequests.size() << " textures, every mip " << fullBytes / (1024 * 1024) << " MB, tails " << tailBytes / 1024 << " KB\n";
+
+			const std::vector<size_t> budgets {0, sceneData.textureStreamingBudgetBytes, 32 * 1024 * 1024, 8 * 1024 * 1024, tailBytes / 2};
+			for(size_t budget : budgets) {
+				double requestedMegabytes = 0.0;
+				double residentMegabytes = 0.0;
+				size_t peakResidentBytes = 0;
+				int overBudgetFrameCount = 0;
+				int droppedMipCount = 0;
+				int violationCount = 0;
+				std::vector<TextureStreamer::ResidencyRequest> requests = baseRequests;
+				std::vector<int> residentMips {};
+				for(int frame = 0; frame < frameCount; frame++) {
+					float cameraZ = -20.0f + 170.0f * frame / (frameCount - 1);
+					size_t requestedBytes = 0;
+					for(size_t i = 0; i < requests.size(); i++) {
+						int size = (int)sqrt((double)(requests[i].mipChainSizes[0] - requests[i].mipChainSizes[1]));
+						float distance = 10.0f * (int)(i / 3) - cameraZ - objectRadius;
+						int requestedMip = requests[i].tailMip;
+						if(distance > -2.0f * objectRadius) {
+							float pixelsPerUnit = viewportHeight / (2.0f * tanf(fieldOfView * 0.5f) * std::max(distance, 0.1f));
+							float screenSize = pixelsPerUnit / uvPerUnit;
+							requestedMip = screenSize >= size ? 0 : std::clamp((int)floor(log2(size / screenSize)), 0, requests[i].tailMip);
+						}
+						requests[i].requestedMip = requestedMip;
+						requestedBytes += requests[i].mipChainSizes[GetRequestedResidentMip(requests[i])];
+					}
+					TextureStreamer::SelectResidentMips(requests, budget, residentMips);
+
+					size_t residentBytes = 0;
+					bool b_IsEveryTextureAtTail = true;
+					size_t smallestDroppedBytes = SIZE_MAX;
+					size_t largestNextDropBytes = 0;
+					for(size_t i = 0; i < requests.size(); i++) {
+						const TextureStreamer::ResidencyRequest& request = requests[i];
+						int mip = residentMips[i];
+						int requestedMip = GetRequestedResidentMip(request);
+						residentBytes += request.mipChainSizes[mip];
+						b_IsEveryTextureAtTail = b_IsEveryTextureAtTail && mip == request.tailMip;
+						if(mip < requestedMip || mip > request.tailMip || !((request.validMipMask >> mip) & 1)) {
+							violationCount++;
+						}
+						if(mip > requestedMip) {
+							droppedMipCount += mip - requestedMip;
+							int finerMip = mip - 1;
+							while(!((request.validMipMask >> finerMip) & 1)) {
+								finerMip--;
+							}
+							smallestDroppedBytes = std::min(smallestDroppedBytes, request.mipChainSizes[finerMip] - request.mipChainSizes[mip]);
+						}
+						int nextMip = mip + 1;
+						while(nextMip <= request.tailMip && !((request.validMipMask >> nextMip) & 1)) {
+							nextMip++;
+						}
+						if(nextMip <= request.tailMip) {
+							largestNextDropBytes = std::max(largestNextDropBytes, request.mipChainSizes[mip] - request.mipChainSizes[nextMip]);
+						}
+					}
+					bool b_IsOverBudget = budget > 0 && residentBytes > budget;
+					overBudgetFrameCount += b_IsOverBudget ? 1 : 0;
+					violationCount += b_IsOverBudget && !b_IsEveryTextureAtTail ? 1 : 0;
+					violationCount += (budget == 0 || requestedBytes <= budget) && residentBytes != requestedBytes ? 1 : 0;
+					violationCount += smallestDroppedBytes != SIZE_MAX && largestNextDropBytes > smallestDroppedBytes ? 1 : 0;
+
+					requestedMegabytes += requestedBytes / (1024.0 * 1024.0) / frameCount;
+					residentMegabytes += residentBytes / (1024.0 * 1024.0) / frameCount;
+					peakResidentBytes = std::max(peakResidentBytes, residentBytes);
+				}
+
+				failedCount += violationCount > 0 ? 1 : 0;
+				std::cout << "Texture streaming benchmark: budget " << (budget == 0 ? std::string("none") : std::to_string(budget / 1024) + " KB") << ": requested " << requestedMegabytes << " MB, resident " << residentMegabytes
+					<< " MB average, " << peakResidentBytes / 1024 << " KB peak, " << overBudgetFrameCount << " frames over budget, " << (double)droppedMipCount / (frameCount * requests.size()) << " mips dropped per texture"
+					<< (violationCount > 0 ? ", " + std::to_string(violationCount) + " VIOLATIONS" : "") << "\n";
+			}
+		}
+
+		/// Part 2
+		{
+			const int textureCount = 8;
+			const int size = 1024;
+			const size_t residentByteCount = 1536 * 1024;
+			const uint32_t uploadByteCount = 128 * 1024;
+			// TextureStreamer's eviction delay
+			const int evictionFrameCount = 240;
+
+			std::filesystem::path directoryPath = GetTemporaryPath("texture_streaming");
+			std::filesystem::create_directories(directoryPath);
+			std::mt19937 randomEngine(1234);
+			std::vector<Texture> textures(textureCount);
+			TextureStreamer textureStreamer {};
+			bool b_IsInitialized = true;
+			for(int i = 0; i < textureCount; i++) {
+				std::vector<std::vector<unsigned char>> mips {};
+				for(int mipSize = size; mipSize > 0; mipSize /= 2) {
+					mips.emplace_back((size_t)DDSFile::GetRowPitch(DXGI_FORMAT_BC1_UNORM, mipSize) * DDSFile::GetRowCount(DXGI_FORMAT_BC1_UNORM, mipSize));
+					FillRandomBytes(mips.back(), randomEngine);
+				}
+				std::string filePath = (directoryPath / ("texture" + std::to_string(i) + ".dds")).string();
+				Texture::ImageData image {};
+				b_IsInitialized = b_IsInitialized && DDSFile::Write(filePath, DXGI_FORMAT_BC1_UNORM, size, size, mips) && Texture::DecodeFile(filePath, image)
+					&& textures[i].InitializeStreamed(device, deviceContext, image, Texture::GetMipTailFirstMip(image, sceneData.streamingMipTailSize));
+				Texture::FreeImageData(image);
+				textureStreamer.Add(&textures[i]);
+			}
+
+			if(b_IsInitialized) {
+				// The first update only sees the tails
+				TextureStreamer::Budget budget {residentByteCount, uploadByteCount};
+				textureStreamer.Update(device, deviceContext, budget);
+				size_t tailBytes = textureStreamer.GetLastStats().residentBytes;
+
+				int overBudgetFrameCount = 0;
+				int settledFrame = -1;
+				bool b_IsUpdated = true;
+				for(int frame = 0; frame < 120; frame++) {
+					for(Texture& texture : textures) {
+						texture.RequestMip(0);
+					}
+					b_IsUpdated = textureStreamer.Update(device, deviceContext, budget) && b_IsUpdated;
+					TextureStreamer::Stats stats = textureStreamer.GetLastStats();
+					overBudgetFrameCount += stats.residentBytes > residentByteCount ? 1 : 0;
+					if(settledFrame < 0 && stats.streamingCount == 0) {
+						settledFrame = frame;
+					}
+				}
+				size_t streamedBytes = textureStreamer.GetLastStats().residentBytes;
+
+				// No more requests: nothing moves until the eviction delay is up
+				size_t bytesBeforeEviction = 0;
+				for(int frame = 0; frame < evictionFrameCount + 1; frame++) {
+					b_IsUpdated = textureStreamer.Update(device, deviceContext, budget) && b_IsUpdated;
+					if(frame == evictionFrameCount - 2) {
+						bytesBeforeEviction = textureStreamer.GetLastStats().residentBytes;
+					}
+				}
+				size_t evictedBytes = textureStreamer.GetLastStats().residentBytes;
+
+				bool b_Passed = b_IsUpdated && overBudgetFrameCount == 0 && settledFrame >= 0 && streamedBytes > tailBytes && bytesBeforeEviction == streamedBytes && evictedBytes == tailBytes;
+				failedCount += b_Passed ? 0 : 1;
+				std::cout << "Texture streaming benchmark: " << textureCount << " streamed 1024x1024 BC1 textures under " << residentByteCount / 1024 << " KB: tails " << tailBytes / 1024 << " KB, streamed "
+					<< streamedBytes / 1024 << " KB after " << settledFrame + 1 << " frames, " << overBudgetFrameCount << " frames over budget, " << bytesBeforeEviction / 1024 << " KB until the eviction delay, "
+					<< evictedBytes / 1024 << " KB after it" << (b_Passed ? "" : ", FAILED") << "\n";
+			}
+			else {
+				failedCount++;
+				std::cout << "Texture streaming benchmark: COULD NOT INITIALIZE THE STREAMED TEXTURES\n";
+			}
+
+			textureStreamer.Shutdown();
+			for(Texture& texture : textures) {
+				texture.Shutdown();
+			}
+			std::filesystem::remove_all(directoryPath);
+		}
+
+		std::cout << "Texture streaming benchmark: " << failedCount << " failures\n";
+	}
+}
+
+void Benchmarks::Run(uint32_t benchmarks, ID3D11Device* device, ID3D11DeviceContext* deviceContext, const SceneData& sceneData) {
+	if(benchmarks & kTextureLoad) {
+		BenchmarkTextureLoading(device, deviceContext, sceneData);
+	}
+	if(benchmarks & kHDRDecode) {
+		BenchmarkHDRDecoding(sceneData);
+	}
+	if(benchmarks & kModelParse) {
+		BenchmarkModelParsing(sceneData);
+	}
+	if(benchmarks & kMeshOptimizer) {
+		BenchmarkMeshOptimization(sceneData);
+	}
+	if(benchmarks & kTangent) {
+		BenchmarkTangentGeneration();
+	}
+	if(benchmarks & kMeshletCull) {
+		BenchmarkMeshletCulling(sceneData);
+	}
+	if(benchmarks & kMeshPick) {
+		BenchmarkMeshPicking();
+	}
+	if(benchmarks & kGeometryArena) {
+		BenchmarkGeometryArena(device, deviceContext);
+	}
+	if(benchmarks & kTextureUpload) {
+		BenchmarkTextureUploadBudgets(device, deviceContext, sceneData);
+	}
+	if(benchmarks & kBlockCompression) {
+		BenchmarkBlockCompression(sceneData);
+	}
+	if(benchmarks & kDDSRoundTrip) {
+		BenchmarkDDSRoundTrip(device, deviceContext);
+	}
+	if(benchmarks & kMipGeneration) {
+		BenchmarkMipGeneration();
+	}
+	if(benchmarks & kTargaDecode) {
+		BenchmarkTargaDecode();
+	}
+	if(benchmarks & kChannelPacking) {
+		BenchmarkChannelPacking(sceneData);
+	}
+	if(benchmarks & kTextureStreaming) {
+		BenchmarkTextureStreaming(device, deviceContext, sceneData);
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+// Startup benchmarks of the engine's loaders, mesh cooking and texture paths, each also checks the results it times
+// Everything is printed with std::cout, a check that does not pass prints in capitals (e.g. "TRIANGLES CHANGED") or counts itself in a "failures" line
+// Note: some write files to the temp directory, each removes its own before returning
+class Benchmarks {
+public:
+	enum Benchmark : uint32_t {
+		// How the PBR texture load time scales with the number of decode threads
+		kTextureLoad       = 1 << 0,
+		// HDRDecoder's skybox decode time in each output format against stb_image
+		kHDRDecode         = 1 << 1,
+		// The text model parse rate of Model::ParseTextModel against the old ifstream reader, on the scene's text model and a generated 5M vertex file
+		kModelParse        = 1 << 2,
+		// The post-transform cache ACMR/ATVR of the scene's primitives before and after MeshOptimizer, and that no triangle is lost
+		kMeshOptimizer     = 1 << 3,
+		// TangentGenerator's time against the old per face tangent routine on a dense sphere, unwelded and welded
+		kTangent           = 1 << 4,
+		// The fraction of meshlets MeshletCuller drops for the demo sphere and ground from a few cameras, and that no visible triangle is culled
+		kMeshletCull       = 1 << 5,
+		// MeshBVH's ray rate against brute force on the demo meshes and a dense sphere, and that both find the same closest hit
+		kMeshPick          = 1 << 6,
+		// OffsetAllocator and GeometryArena under random allocate/free and add/remove, Flush times and compactions, every live mesh's bytes checked on the GPU
+		kGeometryArena     = 1 << 7,
+		// The per frame time and bytes of TextureLoader::Upload under a few budgets while every material and the default skybox upload
+		kTextureUpload     = 1 << 8,
+		// BlockCompressor's encode rate and PSNR per format on synthetic images and the scene's materials, against a quality floor
+		kBlockCompression  = 1 << 9,
+		// DDS files written and read back (mapped and from memory, DX10 and legacy headers), broken headers rejected, load time against a plain read
+		kDDSRoundTrip      = 1 << 10,
+		// MipGenerator's filters against exact references, their aliasing and their throughput against a scalar 2x2 box
+		kMipGeneration     = 1 << 11,
+		// Targa files in every layout the loader takes decoded against the source and stb_image, broken files rejected, decode times against stb_image
+		kTargaDecode       = 1 << 12,
+		// Generated source maps packed like a material's ao/roughness/metallic/height, uncompressed and cooked, every channel in the order PBR.ps reads them
+		kChannelPacking    = 1 << 13,
+		// TextureStreamer's residency simulated for a camera flying past the materials under several budgets, then real textures streamed through TextureStreamer::Update
+		kTextureStreaming  = 1 << 14,
+		kAllBenchmarks     = (1 << 15) - 1
+	};
+
+	struct TextureFile {
+		// Names the texture, the source file itself unless it is packed from several (see Texture::DecodeFile)
+		std::string filePath;
+		std::vector<std::string> sourceFilePaths;
+		DXGI_FORMAT format;
+	};
+
+	// What the benchmarks take from the scene, so they load the same files under the same settings
+	struct SceneData {
+		// Per material, in GameObject's material texture order
+		std::vector<std::vector<TextureFile>> materialTextureFiles;
+		std::vector<std::string> cubemapFilePaths;
+		int defaultCubemapIndex;
+		// Primitive names among them are cooked, the others skipped
+		std::vector<std::string> modelNames;
+		// A rastertek text model
+		std::string textModelFilePath;
+		uint32_t textureUploadBudgetBytes;
+		float textureUploadBudgetMilliseconds;
+		int streamingMipTailSize;
+		size_t textureStreamingBudgetBytes;
+		// For the meshlet culling cameras
+		XMMATRIX projectionMatrix;
+		float screenDepth;
+	};
+
+public:
+	// Runs every benchmark in the benchmarks mask (Benchmark flags) in flag order, on the calling thread
+	static void Run(uint32_t benchmarks, ID3D11Device* device, ID3D11DeviceContext* deviceContext, const SceneData& sceneData);
+};
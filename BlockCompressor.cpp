@@ -0,0 +1,703 @@
+#include "BlockCompressor.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <vector>
+#include <emmintrin.h>
+
+namespace {
+	// Smaller images are encoded on a single thread, thread startup would cost more than the work
+	constexpr size_t s_MinBlockRowsPerTask = 16;
+
+	// Variance below this (squared 8 bit units) is a flat block, its endpoints are both the mean
+	constexpr float s_FlatBlockVariance = 1e-3f;
+	constexpr int s_PowerIterationCount = 8;
+
+	// Palette positions along endpoint 0 -> 1 in the index order each format stores
+	constexpr int s_BC1IndexOrder[4] = {0, 2, 3, 1};
+	constexpr int s_BC4IndexOrder[8] = {1, 7, 6, 5, 4, 3, 2, 0};
+	constexpr float s_BC1Weights[4] = {0.0f, 1.0f / 3.0f, 2.0f / 3.0f, 1.0f};
+	// BC7 4 bit index interpolation weights, out of 64
+	constexpr int s_BC7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+	constexpr float s_BC7WeightScale = 1.0f / 64.0f;
+
+	// Calls function(begin, end) on subranges of [0, count), one task per hardware thread at most
+	template<typename Function>
+	void ParallelFor(size_t count, size_t minCountPerTask, const Function& function) {
+		size_t taskCount = std::clamp<size_t>(count / minCountPerTask, 1, std::max(1u, std::thread::hardware_concurrency()));
+		if(taskCount == 1) {
+			function(0, count);
+			return;
+		}
+
+		std::vector<std::future<void>> futures(taskCount);
+		for(size_t i = 0; i < taskCount; i++) {
+			futures[i] = std::async(std::launch::async, function, count * i / taskCount, count * (i + 1) / taskCount);
+		}
+		for(std::future<void>& future : futures) {
+			future.get();
+		}
+	}
+
+	// 4x4 texels in SoA layout, one row of 4 texels per __m128
+	struct ColorBlock {
+		alignas(16) float channels[4][16];
+	};
+
+	float HorizontalMin(__m128 v) {
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+
+	float HorizontalMax(__m128 v) {
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+
+	float HorizontalSum(__m128 v) {
+		v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+
+	// Edge blocks repeat the last column/row of the image
+	void LoadBlock(const unsigned char* texels, int width, int height, int blockX, int blockY, ColorBlock& block) {
+		if(blockX * 4 + 4 <= width && blockY * 4 + 4 <= height) {
+			const __m128i zero = _mm_setzero_si128();
+			for(int y = 0; y < 4; y++) {
+				__m128i row = _mm_loadu_si128((const __m128i*)(texels + ((size_t)(blockY * 4 + y) * width + blockX * 4) * 4));
+				__m128i low = _mm_unpacklo_epi8(row, zero);
+				__m128i high = _mm_unpackhi_epi8(row, zero);
+				__m128 texel0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+				__m128 texel1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+				__m128 texel2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+				__m128 texel3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+				_MM_TRANSPOSE4_PS(texel0, texel1, texel2, texel3);
+				_mm_store_ps(&block.channels[0][y * 4], texel0);
+				_mm_store_ps(&block.channels[1][y * 4], texel1);
+				_mm_store_ps(&block.channels[2][y * 4], texel2);
+				_mm_store_ps(&block.channels[3][y * 4], texel3);
+			}
+			return;
+		}
+
+		for(int y = 0; y < 4; y++) {
+			const unsigned char* row = texels + (size_t)std::min(blockY * 4 + y, height - 1) * width * 4;
+			for(int x = 0; x < 4; x++) {
+				const unsigned char* texel = row + std::min(blockX * 4 + x, width - 1) * 4;
+				for(int channel = 0; channel < 4; channel++) {
+					block.channels[channel][y * 4 + x] = texel[channel];
+				}
+			}
+		}
+	}
+
+	/// Endpoint fitting shared by BC1 and BC7, over the first ChannelCount channels
+
+	// Endpoints at the extremes of the texels projected on their principal axis (power iteration on the covariance)
+	template<int ChannelCount>
+	void FindPrincipalEndpoints(const ColorBlock& block, float (&endpoints)[2][4]) {
+		float mean[4] {};
+		__m128 centered[4][4] {};
+		for(int channel = 0; channel < ChannelCount; channel++) {
+			const float* values = block.channels[channel];
+			__m128 sum = _mm_add_ps(_mm_add_ps(_mm_load_ps(values), _mm_load_ps(values + 4)), _mm_add_ps(_mm_load_ps(values + 8), _mm_load_ps(values + 12)));
+			mean[channel] = HorizontalSum(sum) / 16.0f;
+			for(int group = 0; group < 4; group++) {
+				centered[channel][group] = _mm_sub_ps(_mm_load_ps(values + group * 4), _mm_set1_ps(mean[channel]));
+			}
+		}
+
+		float covariance[4][4] {};
+		int maxVarianceChannel = 0;
+		for(int i = 0; i < ChannelCount; i++) {
+			for(int j = i; j < ChannelCount; j++) {
+				__m128 sum = _mm_setzero_ps();
+				for(int group = 0; group < 4; group++) {
+					sum = _mm_add_ps(sum, _mm_mul_ps(centered[i][group], centered[j][group]));
+				}
+				covariance[i][j] = covariance[j][i] = HorizontalSum(sum);
+			}
+			if(covariance[i][i] > covariance[maxVarianceChannel][maxVarianceChannel]) {
+				maxVarianceChannel = i;
+			}
+		}
+
+		for(int channel = 0; channel < 4; channel++) {
+			endpoints[0][channel] = endpoints[1][channel] = channel < ChannelCount ? mean[channel] : 255.0f;
+		}
+		if(covariance[maxVarianceChannel][maxVarianceChannel] < s_FlatBlockVariance) {
+			return;
+		}
+
+		// Starting from the covariance row of the most varying channel, it can't be orthogonal to the principal axis
+		float axis[4] {};
+		for(int channel = 0; channel < ChannelCount; channel++) {
+			axis[channel] = covariance[maxVarianceChannel][channel];
+		}
+		for(int iteration = 0; iteration < s_PowerIterationCount; iteration++) {
+			float nextAxis[4] {};
+			float maxComponent = 0.0f;
+			for(int i = 0; i < ChannelCount; i++) {
+				for(int j = 0; j < ChannelCount; j++) {
+					nextAxis[i] += covariance[i][j] * axis[j];
+				}
+				maxComponent = std::max(maxComponent, std::abs(nextAxis[i]));
+			}
+			for(int channel = 0; channel < ChannelCount; channel++) {
+				axis[channel] = nextAxis[channel] / maxComponent;
+			}
+		}
+
+		__m128 minProjection = _mm_set1_ps(FLT_MAX);
+		__m128 maxProjection = _mm_set1_ps(-FLT_MAX);
+		float axisLengthSquared = 0.0f;
+		for(int group = 0; group < 4; group++) {
+			__m128 projection = _mm_setzero_ps();
+			for(int channel = 0; channel < ChannelCount; channel++) {
+				projection = _mm_add_ps(projection, _mm_mul_ps(centered[channel][group], _mm_set1_ps(axis[channel])));
+			}
+			minProjection = _mm_min_ps(minProjection, projection);
+			maxProjection = _mm_max_ps(maxProjection, projection);
+		}
+		for(int channel = 0; channel < ChannelCount; channel++) {
+			axisLengthSquared += axis[channel] * axis[channel];
+		}
+
+		float minT = HorizontalMin(minProjection) / axisLengthSquared;
+		float maxT = HorizontalMax(maxProjection) / axisLengthSquared;
+		for(int channel = 0; channel < ChannelCount; channel++) {
+			endpoints[0][channel] = std::clamp(mean[channel] + axis[channel] * minT, 0.0f, 255.0f);
+			endpoints[1][channel] = std::clamp(mean[channel] + axis[channel] * maxT, 0.0f, 255.0f);
+		}
+	}
+
+	// Palette position (0 at endpoint 0, levelCount - 1 at endpoint 1) of every texel, nearest by projection on the endpoint line
+	template<int ChannelCount>
+	void FitPositions(const ColorBlock& block, const float (&endpoints)[2][4], int levelCount, int (&positions)[16]) {
+		float direction[4] {};
+		float lengthSquared = 0.0f;
+		for(int channel = 0; channel < ChannelCount; channel++) {
+			direction[channel] = endpoints[1][channel] - endpoints[0][channel];
+			lengthSquared += direction[channel] * direction[channel];
+		}
+		if(lengthSquared < s_FlatBlockVariance) {
+			std::fill(std::begin(positions), std::end(positions), 0);
+			return;
+		}
+
+		__m128 scale = _mm_set1_ps((levelCount - 1) / lengthSquared);
+		__m128 maxPosition = _mm_set1_ps((float)(levelCount - 1));
+		for(int group = 0; group < 4; group++) {
+			__m128 projection = _mm_setzero_ps();
+			for(int channel = 0; channel < ChannelCount; channel++) {
+				__m128 offset = _mm_sub_ps(_mm_load_ps(&block.channels[channel][group * 4]), _mm_set1_ps(endpoints[0][channel]));
+				projection = _mm_add_ps(projection, _mm_mul_ps(offset, _mm_set1_ps(direction[channel])));
+			}
+			projection = _mm_min_ps(_mm_max_ps(_mm_mul_ps(projection, scale), _mm_setzero_ps()), maxPosition);
+			_mm_storeu_si128((__m128i*)&positions[group * 4], _mm_cvtps_epi32(projection));
+		}
+	}
+
+	// Least squares endpoints for fixed positions (texel = (1 - w) * endpoint 0 + w * endpoint 1), false if the positions don't span a line
+	template<int ChannelCount>
+	bool RefitEndpoints(const ColorBlock& block, const int (&positions)[16], const float* weights, float (&endpoints)[2][4]) {
+		float a {}, b {}, c {};
+		float x[4] {}, y[4] {};
+		for(int i = 0; i < 16; i++) {
+			float weight = weights[positions[i]];
+			float inverseWeight = 1.0f - weight;
+			a += inverseWeight * inverseWeight;
+			b += inverseWeight * weight;
+			c += weight * weight;
+			for(int channel = 0; channel < ChannelCount; channel++) {
+				x[channel] += inverseWeight * block.channels[channel][i];
+				y[channel] += weight * block.channels[channel][i];
+			}
+		}
+
+		float determinant = a * c - b * b;
+		if(std::abs(determinant) < 1e-6f) {
+			return false;
+		}
+
+		for(int channel = 0; channel < ChannelCount; channel++) {
+			endpoints[0][channel] = std::clamp((c * x[channel] - b * y[channel]) / determinant, 0.0f, 255.0f);
+			endpoints[1][channel] = std::clamp((a * y[channel] - b * x[channel]) / determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	template<int ChannelCount>
+	float MeasureError(const ColorBlock& block, const float (*palette)[4], const int (&positions)[16]) {
+		float error = 0.0f;
+		for(int i = 0; i < 16; i++) {
+			for(int channel = 0; channel < ChannelCount; channel++) {
+				float difference = block.channels[channel][i] - palette[positions[i]][channel];
+				error += difference * difference;
+			}
+		}
+		return error;
+	}
+
+	/// BC4
+
+	void EncodeBC4(const float (&values)[16], unsigned char* output) {
+		__m128 minValue = _mm_load_ps(values);
+		__m128 maxValue = minValue;
+		for(int group = 1; group < 4; group++) {
+			minValue = _mm_min_ps(minValue, _mm_load_ps(values + group * 4));
+			maxValue = _mm_max_ps(maxValue, _mm_load_ps(values + group * 4));
+		}
+
+		// endpoint 0 > endpoint 1 selects the 8 value palette
+		int endpoint0 = (int)HorizontalMax(maxValue);
+		int endpoint1 = (int)HorizontalMin(minValue);
+		uint64_t bits = (uint64_t)endpoint0 | (uint64_t)endpoint1 << 8;
+
+		if(endpoint0 > endpoint1) {
+			__m128 scale = _mm_set1_ps(7.0f / (endpoint0 - endpoint1));
+			__m128 offset = _mm_set1_ps((float)endpoint1);
+			alignas(16) int positions[16];
+			for(int group = 0; group < 4; group++) {
+				__m128 position = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(values + group * 4), offset), scale);
+				_mm_store_si128((__m128i*)&positions[group * 4], _mm_cvtps_epi32(position));
+			}
+			for(int i = 0; i < 16; i++) {
+				bits |= (uint64_t)s_BC4IndexOrder[positions[i]] << (16 + 3 * i);
+			}
+		}
+
+		memcpy(output, &bits, sizeof(bits));
+	}
+
+	void DecodeBC4(const unsigned char* input, unsigned char (&values)[16]) {
+		uint64_t bits {};
+		memcpy(&bits, input, sizeof(bits));
+
+		int endpoint0 = (int)(bits & 0xFF);
+		int endpoint1 = (int)(bits >> 8 & 0xFF);
+		int palette[8] {endpoint0, endpoint1};
+		if(endpoint0 > endpoint1) {
+			for(int i = 2; i < 8; i++) {
+				palette[i] = ((8 - i) * endpoint0 + (i - 1) * endpoint1 + 3) / 7;
+			}
+		}
+		else {
+			for(int i = 2; i < 6; i++) {
+				palette[i] = ((6 - i) * endpoint0 + (i - 1) * endpoint1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		for(int i = 0; i < 16; i++) {
+			values[i] = (unsigned char)palette[bits >> (16 + 3 * i) & 0x7];
+		}
+	}
+
+	/// BC1
+
+	struct BC1Fit {
+		uint16_t colors[2];
+		int positions[16];
+		float error;
+	};
+
+	uint16_t QuantizeColor565(const float (&color)[4]) {
+		int r = (int)std::lround(color[0] * 31.0f / 255.0f);
+		int g = (int)std::lround(color[1] * 63.0f / 255.0f);
+		int b = (int)std::lround(color[2] * 31.0f / 255.0f);
+		return (uint16_t)(r << 11 | g << 5 | b);
+	}
+
+	void DequantizeColor565(uint16_t color, float (&result)[4]) {
+		int r = color >> 11 & 0x1F;
+		int g = color >> 5 & 0x3F;
+		int b = color & 0x1F;
+		result[0] = (float)(r << 3 | r >> 2);
+		result[1] = (float)(g << 2 | g >> 4);
+		result[2] = (float)(b << 3 | b >> 2);
+		result[3] = 255.0f;
+	}
+
+	// Always the 4 color palette (colors[0] > colors[1]), BC3 color blocks can't use the other one
+	BC1Fit FitBC1(const ColorBlock& block, const float (&endpoints)[2][4]) {
+		BC1Fit fit {};
+		fit.colors[0] = QuantizeColor565(endpoints[0]);
+		fit.colors[1] = QuantizeColor565(endpoints[1]);
+		if(fit.colors[0] < fit.colors[1]) {
+			std::swap(fit.colors[0], fit.colors[1]);
+		}
+
+		float palette[4][4] {};
+		DequantizeColor565(fit.colors[0], palette[0]);
+		DequantizeColor565(fit.colors[1], palette[3]);
+		for(int channel = 0; channel < 3; channel++) {
+			palette[1][channel] = (2.0f * palette[0][channel] + palette[3][channel]) / 3.0f;
+			palette[2][channel] = (palette[0][channel] + 2.0f * palette[3][channel]) / 3.0f;
+		}
+
+		// Equal colors would select the 3 color palette, every texel then uses color 0
+		if(fit.colors[0] == fit.colors[1]) {
+			std::fill(std::begin(fit.positions), std::end(fit.positions), 0);
+		}
+		else {
+			const float paletteEndpoints[2][4] {{palette[0][0], palette[0][1], palette[0][2]}, {palette[3][0], palette[3][1], palette[3][2]}};
+			FitPositions<3>(block, paletteEndpoints, 4, fit.positions);
+		}
+		fit.error = MeasureError<3>(block, palette, fit.positions);
+
+		return fit;
+	}
+
+	void EncodeBC1(const ColorBlock& block, unsigned char* output) {
+		float endpoints[2][4] {};
+		FindPrincipalEndpoints<3>(block, endpoints);
+		BC1Fit fit = FitBC1(block, endpoints);
+
+		// One least squares refit of the endpoints to the chosen positions
+		if(RefitEndpoints<3>(block, fit.positions, s_BC1Weights, endpoints)) {
+			BC1Fit refit = FitBC1(block, endpoints);
+			if(refit.error < fit.error) {
+				fit = refit;
+			}
+		}
+
+		uint32_t indices {};
+		for(int i = 0; i < 16; i++) {
+			indices |= (uint32_t)s_BC1IndexOrder[fit.positions[i]] << (2 * i);
+		}
+		memcpy(output, fit.colors, sizeof(fit.colors));
+		memcpy(output + 4, &indices, sizeof(indices));
+	}
+
+	void DecodeBC1(const unsigned char* input, unsigned char (&texels)[16][4]) {
+		uint16_t colors[2] {};
+		uint32_t indices {};
+		memcpy(colors, input, sizeof(colors));
+		memcpy(&indices, input + 4, sizeof(indices));
+
+		float endpoints[2][4] {};
+		DequantizeColor565(colors[0], endpoints[0]);
+		DequantizeColor565(colors[1], endpoints[1]);
+
+		int palette[4][4] {};
+		for(int channel = 0; channel < 3; channel++) {
+			int color0 = (int)endpoints[0][channel];
+			int color1 = (int)endpoints[1][channel];
+			palette[0][channel] = color0;
+			palette[1][channel] = color1;
+			if(colors[0] > colors[1]) {
+				palette[2][channel] = (2 * color0 + color1 + 1) / 3;
+				palette[3][channel] = (color0 + 2 * color1 + 1) / 3;
+			}
+			else {
+				palette[2][channel] = (color0 + color1 + 1) / 2;
+				palette[3][channel] = 0;
+			}
+		}
+		for(int i = 0; i < 4; i++) {
+			palette[i][3] = colors[0] <= colors[1] && i == 3 ? 0 : 255;
+		}
+
+		for(int i = 0; i < 16; i++) {
+			const int* color = palette[indices >> (2 * i) & 0x3];
+			for(int channel = 0; channel < 4; channel++) {
+				texels[i][channel] = (unsigned char)color[channel];
+			}
+		}
+	}
+
+	/// BC7 mode 6
+
+	// Little endian bit stream over a 16 byte block
+	struct BlockBits {
+		uint64_t words[2] {};
+		int position {};
+
+		void Write(uint32_t value, int bitCount) {
+			if(position < 64) {
+				words[0] |= (uint64_t)value << position;
+				if(position + bitCount > 64) {
+					words[1] |= (uint64_t)value >> (64 - position);
+				}
+			}
+			else {
+				words[1] |= (uint64_t)value << (position - 64);
+			}
+			position += bitCount;
+		}
+
+		uint32_t Read(int bitCount) {
+			uint64_t value = position < 64 ? words[0] >> position : words[1] >> (position - 64);
+			if(position < 64 && position + bitCount > 64) {
+				value |= words[1] << (64 - position);
+			}
+			position += bitCount;
+			return (uint32_t)(value & ((1ull << bitCount) - 1));
+		}
+	};
+
+	struct BC7Fit {
+		// 7 bit channels, endpoint = quantized << 1 | pBit
+		int quantized[2][4];
+		int pBits[2];
+		int positions[16];
+		float error;
+	};
+
+	// 7 bits per channel plus the shared lsb that fits the endpoint best
+	void QuantizeBC7Endpoint(const float (&endpoint)[4], int (&quantized)[4], int& pBit, float (&dequantized)[4]) {
+		float bestError = FLT_MAX;
+		for(int candidatePBit = 0; candidatePBit < 2; candidatePBit++) {
+			int candidate[4] {};
+			float error = 0.0f;
+			for(int channel = 0; channel < 4; channel++) {
+				candidate[channel] = std::clamp((int)std::lround((endpoint[channel] - candidatePBit) * 0.5f), 0, 127);
+				float difference = endpoint[channel] - (float)(candidate[channel] << 1 | candidatePBit);
+				error += difference * difference;
+			}
+			if(error < bestError) {
+				bestError = error;
+				pBit = candidatePBit;
+				std::copy(std::begin(candidate), std::end(candidate), std::begin(quantized));
+			}
+		}
+
+		for(int channel = 0; channel < 4; channel++) {
+			dequantized[channel] = (float)(quantized[channel] << 1 | pBit);
+		}
+	}
+
+	BC7Fit FitBC7(const ColorBlock& block, const float (&endpoints)[2][4]) {
+		BC7Fit fit {};
+		float dequantized[2][4] {};
+		QuantizeBC7Endpoint(endpoints[0], fit.quantized[0], fit.pBits[0], dequantized[0]);
+		QuantizeBC7Endpoint(endpoints[1], fit.quantized[1], fit.pBits[1], dequantized[1]);
+
+		// Note: positions assume evenly spaced weights, s_BC7Weights is off by less than half a step
+		FitPositions<4>(block, dequantized, 16, fit.positions);
+
+		float palette[16][4] {};
+		for(int i = 0; i < 16; i++) {
+			for(int channel = 0; channel < 4; channel++) {
+				palette[i][channel] = (float)(((64 - s_BC7Weights[i]) * (int)dequantized[0][channel] + s_BC7Weights[i] * (int)dequantized[1][channel] + 32) >> 6);
+			}
+		}
+		fit.error = MeasureError<4>(block, palette, fit.positions);
+
+		return fit;
+	}
+
+	void EncodeBC7(const ColorBlock& block, unsigned char* output) {
+		float endpoints[2][4] {};
+		FindPrincipalEndpoints<4>(block, endpoints);
+		BC7Fit fit = FitBC7(block, endpoints);
+
+		float weights[16] {};
+		for(int i = 0; i < 16; i++) {
+			weights[i] = s_BC7Weights[i] * s_BC7WeightScale;
+		}
+		if(RefitEndpoints<4>(block, fit.positions, weights, endpoints)) {
+			BC7Fit refit = FitBC7(block, endpoints);
+			if(refit.error < fit.error) {
+				fit = refit;
+			}
+		}
+
+		// The msb of texel 0's index is implied 0, swap the endpoints instead
+		if(fit.positions[0] >= 8) {
+			std::swap(fit.quantized[0], fit.quantized[1]);
+			std::swap(fit.pBits[0], fit.pBits[1]);
+			for(int& position : fit.positions) {
+				position = 15 - position;
+			}
+		}
+
+		BlockBits bits {};
+		bits.Write(1 << 6, 7);
+		for(int channel = 0; channel < 4; channel++) {
+			bits.Write((uint32_t)fit.quantized[0][channel], 7);
+			bits.Write((uint32_t)fit.quantized[1][channel], 7);
+		}
+		bits.Write((uint32_t)fit.pBits[0], 1);
+		bits.Write((uint32_t)fit.pBits[1], 1);
+		bits.Write((uint32_t)fit.positions[0], 3);
+		for(int i = 1; i < 16; i++) {
+			bits.Write((uint32_t)fit.positions[i], 4);
+		}
+
+		memcpy(output, bits.words, sizeof(bits.words));
+	}
+
+	void DecodeBC7(const unsigned char* input, unsigned char (&texels)[16][4]) {
+		BlockBits bits {};
+		memcpy(bits.words, input, sizeof(bits.words));
+
+		if(bits.Read(7) != 1 << 6) {
+			memset(texels, 0, sizeof(texels));
+			return;
+		}
+
+		int endpoints[2][4] {};
+		for(int channel = 0; channel < 4; channel++) {
+			endpoints[0][channel] = (int)bits.Read(7) << 1;
+			endpoints[1][channel] = (int)bits.Read(7) << 1;
+		}
+		int pBit0 = (int)bits.Read(1);
+		int pBit1 = (int)bits.Read(1);
+		for(int channel = 0; channel < 4; channel++) {
+			endpoints[0][channel] |= pBit0;
+			endpoints[1][channel] |= pBit1;
+		}
+
+		for(int i = 0; i < 16; i++) {
+			int weight = s_BC7Weights[bits.Read(i == 0 ? 3 : 4)];
+			for(int channel = 0; channel < 4; channel++) {
+				texels[i][channel] = (unsigned char)(((64 - weight) * endpoints[0][channel] + weight * endpoints[1][channel] + 32) >> 6);
+			}
+		}
+	}
+
+	void EncodeBlock(BlockCompressor::BlockFormat format, const ColorBlock& block, unsigned char* output) {
+		switch(format) {
+			case BlockCompressor::kBC1:
+				EncodeBC1(block, output);
+				break;
+			case BlockCompressor::kBC3:
+				EncodeBC4(block.channels[3], output);
+				EncodeBC1(block, output + 8);
+				break;
+			case BlockCompressor::kBC4:
+				EncodeBC4(block.channels[0], output);
+				break;
+			case BlockCompressor::kBC5:
+				EncodeBC4(block.channels[0], output);
+				EncodeBC4(block.channels[1], output + 8);
+				break;
+			case BlockCompressor::kBC7:
+				EncodeBC7(block, output);
+				break;
+			default:
+				break;
+		}
+	}
+
+	void DecodeBlock(BlockCompressor::BlockFormat format, const unsigned char* input, unsigned char (&texels)[16][4]) {
+		unsigned char values[16] {};
+		switch(format) {
+			case BlockCompressor::kBC1:
+				DecodeBC1(input, texels);
+				break;
+			case BlockCompressor::kBC3:
+				DecodeBC1(input + 8, texels);
+				DecodeBC4(input, values);
+				for(int i = 0; i < 16; i++) {
+					texels[i][3] = values[i];
+				}
+				break;
+			case BlockCompressor::kBC4:
+				DecodeBC4(input, values);
+				for(int i = 0; i < 16; i++) {
+					texels[i][0] = values[i];
+					texels[i][1] = texels[i][2] = 0;
+					texels[i][3] = 255;
+				}
+				break;
+			case BlockCompressor::kBC5:
+				DecodeBC4(input, values);
+				for(int i = 0; i < 16; i++) {
+					texels[i][0] = values[i];
+					texels[i][2] = 0;
+					texels[i][3] = 255;
+				}
+				DecodeBC4(input + 8, values);
+				for(int i = 0; i < 16; i++) {
+					texels[i][1] = values[i];
+				}
+				break;
+			case BlockCompressor::kBC7:
+				DecodeBC7(input, texels);
+				break;
+			default:
+				break;
+		}
+	}
+
+	// r, rg, rgb or rgba
+	int GetStoredChannelCount(BlockCompressor::BlockFormat format) {
+		switch(format) {
+			case BlockCompressor::kBC1:
+				return 3;
+			case BlockCompressor::kBC4:
+				return 1;
+			case BlockCompressor::kBC5:
+				return 2;
+			default:
+				return 4;
+		}
+	}
+}
+
+void BlockCompressor::Compress(BlockFormat format, const unsigned char* texels, int width, int height, unsigned char* blocks) {
+	int blockCountX = (width + 3) / 4;
+	int blockCountY = (height + 3) / 4;
+	int blockSize = GetBlockSize(format);
+
+	ParallelFor((size_t)blockCountY, s_MinBlockRowsPerTask, [&](size_t firstBlockRow, size_t endBlockRow) {
+		ColorBlock block {};
+		for(int blockY = (int)firstBlockRow; blockY < (int)endBlockRow; blockY++) {
+			for(int blockX = 0; blockX < blockCountX; blockX++) {
+				LoadBlock(texels, width, height, blockX, blockY, block);
+				EncodeBlock(format, block, blocks + ((size_t)blockY * blockCountX + blockX) * blockSize);
+			}
+		}
+	});
+}
+
+void BlockCompressor::Decompress(BlockFormat format, const unsigned char* blocks, int width, int height, unsigned char* texels) {
+	int blockCountX = (width + 3) / 4;
+	int blockCountY = (height + 3) / 4;
+	int blockSize = GetBlockSize(format);
+
+	unsigned char blockTexels[16][4] {};
+	for(int blockY = 0; blockY < blockCountY; blockY++) {
+		for(int blockX = 0; blockX < blockCountX; blockX++) {
+			DecodeBlock(format, blocks + ((size_t)blockY * blockCountX + blockX) * blockSize, blockTexels);
+
+			// Edge blocks only partially cover the image
+			for(int y = 0; y < 4 && blockY * 4 + y < height; y++) {
+				for(int x = 0; x < 4 && blockX * 4 + x < width; x++) {
+					memcpy(texels + ((size_t)(blockY * 4 + y) * width + blockX * 4 + x) * 4, blockTexels[y * 4 + x], 4);
+				}
+			}
+		}
+	}
+}
+
+float BlockCompressor::ComputePSNR(BlockFormat format, const unsigned char* texels, const unsigned char* decodedTexels, int width, int height) {
+	int channelCount = GetStoredChannelCount(format);
+	size_t texelCount = (size_t)width * height;
+
+	double squaredErrorSum = 0.0;
+	for(size_t i = 0; i < texelCount; i++) {
+		for(int channel = 0; channel < channelCount; channel++) {
+			double difference = (double)texels[i * 4 + channel] - (double)decodedTexels[i * 4 + channel];
+			squaredErrorSum += difference * difference;
+		}
+	}
+
+	double meanSquaredError = squaredErrorSum / ((double)texelCount * channelCount);
+	if(meanSquaredError == 0.0) {
+		return INFINITY;
+	}
+	return (float)(10.0 * std::log10(255.0 * 255.0 / meanSquaredError));
+}
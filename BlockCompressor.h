@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+
+// CPU encoders for the BCn block compressed formats, every 4x4 texel block is stored in 8 (BC1, BC4) or 16 bytes
+// Input is 4 channel 8 bit texels (like Texture::ImageData), blocks are written row by row in the layout D3D expects
+// Blocks are encoded with SSE and spread over threads by block rows, no device needed so it can run anywhere (e.g. cooking on a worker)
+class BlockCompressor {
+public:
+	enum BlockFormat {
+		// rgb, 4 colors interpolated between two 565 endpoints, alpha is dropped
+		kBC1 = 0,
+		// rgb as BC1 plus a BC4 alpha block
+		kBC3 = 1,
+		// r only, 8 values interpolated between two 8 bit endpoints (scalar maps)
+		kBC4 = 2,
+		// r and g as two BC4 blocks (tangent space normal maps, z is reconstructed in the shader)
+		kBC5 = 3,
+		// rgba, mode 6 only: one endpoint pair with 7 bit channels and a shared lsb per endpoint, 16 interpolated colors
+		kBC7 = 4,
+		Num_BlockFormats
+	};
+
+	static int GetBlockSize(BlockFormat format) { return format == kBC1 || format == kBC4 ? 8 : 16; }
+	static size_t GetCompressedSize(BlockFormat format, int width, int height) { return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format); }
+
+	// Encodes width x height texels into GetCompressedSize bytes
+	// Note: blocks on the right/bottom edge of sizes that are not a multiple of 4 repeat the last column/row
+	static void Compress(BlockFormat format, const unsigned char* texels, int width, int height, unsigned char* blocks);
+
+	// Decodes blocks back to 4 channel texels, channels the format does not store are 0 (alpha 255)
+	// Note: BC7 blocks of other modes than the one Compress writes are decoded as black
+	static void Decompress(BlockFormat format, const unsigned char* blocks, int width, int height, unsigned char* texels);
+
+	// Peak signal to noise ratio in dB over the channels format stores, infinite if both are the same
+	static float ComputePSNR(BlockFormat format, const unsigned char* texels, const unsigned char* decodedTexels, int width, int height);
+};
@@ -0,0 +1,322 @@
+#include "BoundingVolumes.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+	// Extreme point directions for the initial sphere: 3 axes, 4 cube diagonals and 6 edge diagonals
+	constexpr float s_ExtremeDirections[13][3] {
+		{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
+		{1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, -1.0f}, {1.0f, -1.0f, 1.0f}, {1.0f, -1.0f, -1.0f},
+		{1.0f, 1.0f, 0.0f}, {1.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 1.0f}, {1.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 1.0f}, {0.0f, 1.0f, -1.0f},
+	};
+
+	// Shrink and regrow passes after the initial Ritter sphere
+	constexpr int s_SphereRefinementCount = 8;
+	constexpr float s_SphereShrinkFactor = 0.95f;
+
+	constexpr int s_MaxJacobiSweeps = 32;
+
+	float DistanceSquared(const XMFLOAT3& a, const XMFLOAT3& b) {
+		float offset[3] {a.x - b.x, a.y - b.y, a.z - b.z};
+		return offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+	}
+
+	// Ritter's growth step: moves the sphere towards every outside point just enough to enclose it
+	void GrowSphere(const std::vector<XMFLOAT3>& positions, XMFLOAT3& center, float& radius) {
+		for(const XMFLOAT3& position : positions) {
+			float distanceSquared = DistanceSquared(position, center);
+			if(distanceSquared <= radius * radius) {
+				continue;
+			}
+
+			float distance = std::sqrt(distanceSquared);
+			float newRadius = (radius + distance) * 0.5f;
+			float shift = (newRadius - radius) / distance;
+			center.x += (position.x - center.x) * shift;
+			center.y += (position.y - center.y) * shift;
+			center.z += (position.z - center.z) * shift;
+			radius = newRadius;
+		}
+	}
+
+	// Eigen decomposition of a symmetric 3x3 matrix with cyclic Jacobi rotations, eigenvectors end up in the columns of eigenvectors
+	void SymmetricEigenvectors(double matrix[3][3], double eigenvectors[3][3]) {
+		for(int i = 0; i < 3; i++) {
+			for(int j = 0; j < 3; j++) {
+				eigenvectors[i][j] = i == j ? 1.0 : 0.0;
+			}
+		}
+
+		static const int s_Pairs[3][2] {{0, 1}, {0, 2}, {1, 2}};
+		for(int sweep = 0; sweep < s_MaxJacobiSweeps; sweep++) {
+			double offDiagonal = matrix[0][1] * matrix[0][1] + matrix[0][2] * matrix[0][2] + matrix[1][2] * matrix[1][2];
+			double diagonal = matrix[0][0] * matrix[0][0] + matrix[1][1] * matrix[1][1] + matrix[2][2] * matrix[2][2];
+			if(offDiagonal <= diagonal * 1e-20) {
+				break;
+			}
+
+			for(const int* pair : s_Pairs) {
+				int p = pair[0], q = pair[1];
+				if(matrix[p][q] == 0.0) {
+					continue;
+				}
+
+				// Rotation that zeroes matrix[p][q] (Golub & Van Loan 8.4.2)
+				double theta = (matrix[q][q] - matrix[p][p]) / (2.0 * matrix[p][q]);
+				double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+				double c = 1.0 / std::sqrt(t * t + 1.0);
+				double s = t * c;
+
+				for(int k = 0; k < 3; k++) {
+					double kp = matrix[k][p], kq = matrix[k][q];
+					matrix[k][p] = c * kp - s * kq;
+					matrix[k][q] = s * kp + c * kq;
+				}
+				for(int k = 0; k < 3; k++) {
+					double pk = matrix[p][k], qk = matrix[q][k];
+					matrix[p][k] = c * pk - s * qk;
+					matrix[q][k] = s * pk + c * qk;
+				}
+				for(int k = 0; k < 3; k++) {
+					double kp = eigenvectors[k][p], kq = eigenvectors[k][q];
+					eigenvectors[k][p] = c * kp - s * kq;
+					eigenvectors[k][q] = s * kp + c * kq;
+				}
+			}
+		}
+	}
+}
+
+void BoundingVolumes::ComputeBounds(MeshData& meshData) {
+	MeshBounds& bounds = meshData.bounds;
+	ComputeAABB(meshData.vertices, bounds.aabbMin, bounds.aabbMax);
+	ComputeBoundingSphere(meshData.vertices, bounds.sphereCenter, bounds.sphereRadius);
+	ComputeOrientedBox(meshData.vertices, meshData.indices, bounds.obbCenter, bounds.obbExtents, bounds.obbAxes);
+	bounds.uvDensity = ComputeUVDensity(meshData.vertices, meshData.indices);
+}
+
+void BoundingVolumes::ComputeAABB(const std::vector<MeshVertex>& vertices, XMFLOAT3& aabbMin, XMFLOAT3& aabbMax) {
+	if(vertices.empty()) {
+		aabbMin = aabbMax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		return;
+	}
+
+	aabbMin = aabbMax = vertices[0].position;
+	for(const MeshVertex& vertex : vertices) {
+		aabbMin.x = std::min(aabbMin.x, vertex.position.x); aabbMax.x = std::max(aabbMax.x, vertex.position.x);
+		aabbMin.y = std::min(aabbMin.y, vertex.position.y); aabbMax.y = std::max(aabbMax.y, vertex.position.y);
+		aabbMin.z = std::min(aabbMin.z, vertex.position.z); aabbMax.z = std::max(aabbMax.z, vertex.position.z);
+	}
+}
+
+void BoundingVolumes::ComputeBoundingSphere(const std::vector<MeshVertex>& vertices, XMFLOAT3& center, float& radius) {
+	center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	radius = 0.0f;
+	if(vertices.empty()) {
+		return;
+	}
+
+	std::vector<XMFLOAT3> positions(vertices.size());
+	for(size_t i = 0; i < vertices.size(); i++) {
+		positions[i] = vertices[i].position;
+	}
+
+	/// Initial sphere through the most distant pair of extreme points
+	XMFLOAT3 farthestA = positions[0], farthestB = positions[0];
+	float maxDistanceSquared = -1.0f;
+	for(const float* direction : s_ExtremeDirections) {
+		size_t minIndex = 0, maxIndex = 0;
+		float minProjection = FLT_MAX, maxProjection = -FLT_MAX;
+		for(size_t i = 0; i < positions.size(); i++) {
+			float projection = positions[i].x * direction[0] + positions[i].y * direction[1] + positions[i].z * direction[2];
+			if(projection < minProjection) {
+				minProjection = projection;
+				minIndex = i;
+			}
+			if(projection > maxProjection) {
+				maxProjection = projection;
+				maxIndex = i;
+			}
+		}
+
+		float distanceSquared = DistanceSquared(positions[minIndex], positions[maxIndex]);
+		if(distanceSquared > maxDistanceSquared) {
+			maxDistanceSquared = distanceSquared;
+			farthestA = positions[minIndex];
+			farthestB = positions[maxIndex];
+		}
+	}
+
+	XMFLOAT3 bestCenter((farthestA.x + farthestB.x) * 0.5f, (farthestA.y + farthestB.y) * 0.5f, (farthestA.z + farthestB.z) * 0.5f);
+	float bestRadius = std::sqrt(maxDistanceSquared) * 0.5f;
+	GrowSphere(positions, bestCenter, bestRadius);
+
+	/// Shrink and regrow, visiting the points in a different order every pass
+	// Note: fixed seed so cooking the same mesh twice gives the same bounds
+	uint32_t random = 0x9E3779B9u;
+	XMFLOAT3 refinedCenter = bestCenter;
+	for(int pass = 0; pass < s_SphereRefinementCount; pass++) {
+		float refinedRadius = bestRadius * s_SphereShrinkFactor;
+		for(size_t i = positions.size() - 1; i > 0; i--) {
+			random = random * 1664525u + 1013904223u;
+			std::swap(positions[i], positions[(random >> 8) % (i + 1)]);
+		}
+		GrowSphere(positions, refinedCenter, refinedRadius);
+
+		if(refinedRadius < bestRadius) {
+			bestCenter = refinedCenter;
+			bestRadius = refinedRadius;
+		}
+	}
+
+	/// Sphere around the AABB centre is sometimes tighter (e.g. boxes)
+	XMFLOAT3 aabbMin {}, aabbMax {};
+	ComputeAABB(vertices, aabbMin, aabbMax);
+	XMFLOAT3 aabbCenter((aabbMin.x + aabbMax.x) * 0.5f, (aabbMin.y + aabbMax.y) * 0.5f, (aabbMin.z + aabbMax.z) * 0.5f);
+
+	// Radii are recomputed exactly so float drift in GrowSphere can never leave a vertex outside
+	float bestRadiusSquared = 0.0f;
+	float aabbRadiusSquared = 0.0f;
+	for(const XMFLOAT3& position : positions) {
+		bestRadiusSquared = std::max(bestRadiusSquared, DistanceSquared(position, bestCenter));
+		aabbRadiusSquared = std::max(aabbRadiusSquared, DistanceSquared(position, aabbCenter));
+	}
+
+	if(aabbRadiusSquared < bestRadiusSquared) {
+		center = aabbCenter;
+		radius = std::sqrt(aabbRadiusSquared);
+	}
+	else {
+		center = bestCenter;
+		radius = std::sqrt(bestRadiusSquared);
+	}
+}
+
+void BoundingVolumes::ComputeOrientedBox(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, XMFLOAT3& center, XMFLOAT3& extents, XMFLOAT3 axes[3]) {
+	/// AABB as the fallback box
+	XMFLOAT3 aabbMin {}, aabbMax {};
+	ComputeAABB(vertices, aabbMin, aabbMax);
+	center = XMFLOAT3((aabbMin.x + aabbMax.x) * 0.5f, (aabbMin.y + aabbMax.y) * 0.5f, (aabbMin.z + aabbMax.z) * 0.5f);
+	extents = XMFLOAT3((aabbMax.x - aabbMin.x) * 0.5f, (aabbMax.y - aabbMin.y) * 0.5f, (aabbMax.z - aabbMin.z) * 0.5f);
+	axes[0] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	axes[1] = XMFLOAT3(0.0f, 1.0f, 0.0f);
+	axes[2] = XMFLOAT3(0.0f, 0.0f, 1.0f);
+
+	/// Covariance of the surface, each triangle integrated exactly (Gottschalk 2000, eq. 2.7)
+	// Note: accumulated in double, meshes far from the origin would otherwise lose the covariance to cancellation
+	double totalArea = 0.0;
+	double mean[3] {};
+	double secondMoment[3][3] {};
+	for(size_t t = 0; t + 2 < indices.size(); t += 3) {
+		const XMFLOAT3& p0 = vertices[indices[t]].position;
+		const XMFLOAT3& p1 = vertices[indices[t + 1]].position;
+		const XMFLOAT3& p2 = vertices[indices[t + 2]].position;
+		double corners[3][3] {{p0.x, p0.y, p0.z}, {p1.x, p1.y, p1.z}, {p2.x, p2.y, p2.z}};
+
+		double e1[3] {corners[1][0] - corners[0][0], corners[1][1] - corners[0][1], corners[1][2] - corners[0][2]};
+		double e2[3] {corners[2][0] - corners[0][0], corners[2][1] - corners[0][1], corners[2][2] - corners[0][2]};
+		double cross[3] {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+		double area = 0.5 * std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+		if(area <= 0.0) {
+			continue;
+		}
+
+		double centroid[3];
+		for(int i = 0; i < 3; i++) {
+			centroid[i] = (corners[0][i] + corners[1][i] + corners[2][i]) / 3.0;
+			mean[i] += area * centroid[i];
+		}
+		for(int i = 0; i < 3; i++) {
+			for(int j = 0; j < 3; j++) {
+				double cornerSum = corners[0][i] * corners[0][j] + corners[1][i] * corners[1][j] + corners[2][i] * corners[2][j];
+				secondMoment[i][j] += area / 12.0 * (9.0 * centroid[i] * centroid[j] + cornerSum);
+			}
+		}
+		totalArea += area;
+	}
+	if(totalArea <= 0.0) {
+		return;
+	}
+
+	double covariance[3][3];
+	for(int i = 0; i < 3; i++) {
+		mean[i] /= totalArea;
+	}
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) {
+			covariance[i][j] = secondMoment[i][j] / totalArea - mean[i] * mean[j];
+		}
+	}
+
+	double eigenvectors[3][3];
+	SymmetricEigenvectors(covariance, eigenvectors);
+
+	/// Box along the eigenvectors, right handed so the axes form a rotation
+	float boxAxes[3][3];
+	for(int a = 0; a < 3; a++) {
+		double length = std::sqrt(eigenvectors[0][a] * eigenvectors[0][a] + eigenvectors[1][a] * eigenvectors[1][a] + eigenvectors[2][a] * eigenvectors[2][a]);
+		for(int i = 0; i < 3; i++) {
+			boxAxes[a][i] = (float)(eigenvectors[i][a] / length);
+		}
+	}
+	boxAxes[2][0] = boxAxes[0][1] * boxAxes[1][2] - boxAxes[0][2] * boxAxes[1][1];
+	boxAxes[2][1] = boxAxes[0][2] * boxAxes[1][0] - boxAxes[0][0] * boxAxes[1][2];
+	boxAxes[2][2] = boxAxes[0][0] * boxAxes[1][1] - boxAxes[0][1] * boxAxes[1][0];
+
+	float projectionMin[3] {FLT_MAX, FLT_MAX, FLT_MAX};
+	float projectionMax[3] {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for(const MeshVertex& vertex : vertices) {
+		for(int a = 0; a < 3; a++) {
+			float projection = vertex.position.x * boxAxes[a][0] + vertex.position.y * boxAxes[a][1] + vertex.position.z * boxAxes[a][2];
+			projectionMin[a] = std::min(projectionMin[a], projection);
+			projectionMax[a] = std::max(projectionMax[a], projection);
+		}
+	}
+
+	// Only keep the fitted box if it is actually tighter, PCA is a heuristic and loses to the AABB on axis aligned meshes
+	float boxExtents[3];
+	for(int a = 0; a < 3; a++) {
+		boxExtents[a] = (projectionMax[a] - projectionMin[a]) * 0.5f;
+	}
+	if(boxExtents[0] * boxExtents[1] * boxExtents[2] >= extents.x * extents.y * extents.z) {
+		return;
+	}
+
+	center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	for(int a = 0; a < 3; a++) {
+		float middle = (projectionMin[a] + projectionMax[a]) * 0.5f;
+		center.x += boxAxes[a][0] * middle;
+		center.y += boxAxes[a][1] * middle;
+		center.z += boxAxes[a][2] * middle;
+		axes[a] = XMFLOAT3(boxAxes[a][0], boxAxes[a][1], boxAxes[a][2]);
+	}
+	extents = XMFLOAT3(boxExtents[0], boxExtents[1], boxExtents[2]);
+}
+
+float BoundingVolumes::ComputeUVDensity(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices) {
+	// Twice the areas, the factor cancels out
+	double uvArea = 0.0;
+	double surfaceArea = 0.0;
+	for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+		const MeshVertex& a = vertices[indices[i]];
+		const MeshVertex& b = vertices[indices[i + 1]];
+		const MeshVertex& c = vertices[indices[i + 2]];
+
+		// Mirrored UVs count as much as any others
+		double uv1[2] {b.texture.x - a.texture.x, b.texture.y - a.texture.y};
+		double uv2[2] {c.texture.x - a.texture.x, c.texture.y - a.texture.y};
+		uvArea += std::abs(uv1[0] * uv2[1] - uv1[1] * uv2[0]);
+
+		double edge1[3] {b.position.x - a.position.x, b.position.y - a.position.y, b.position.z - a.position.z};
+		double edge2[3] {c.position.x - a.position.x, c.position.y - a.position.y, c.position.z - a.position.z};
+		double cross[3] {edge1[1] * edge2[2] - edge1[2] * edge2[1], edge1[2] * edge2[0] - edge1[0] * edge2[2], edge1[0] * edge2[1] - edge1[1] * edge2[0]};
+		surfaceArea += std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+	}
+
+	if(uvArea <= 0.0 || surfaceArea <= 0.0) {
+		return 0.0f;
+	}
+	return (float)std::sqrt(uvArea / surfaceArea);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "MeshData.h"
+
+// Bounding volumes of a cooked mesh, computed once at cook time and stored in MeshCache
+// Run on the welded mesh, vertex order does not matter so later reordering keeps them valid
+class BoundingVolumes {
+public:
+	// Fills meshData.bounds
+	static void ComputeBounds(MeshData& meshData);
+
+	static void ComputeAABB(const std::vector<MeshVertex>& vertices, XMFLOAT3& aabbMin, XMFLOAT3& aabbMax);
+
+	// Ritter's sphere from extreme points along several directions, then shrunk and regrown a few times (Ericson, Real-Time Collision Detection 4.3.4)
+	// Usually within a few percent of the minimal sphere
+	static void ComputeBoundingSphere(const std::vector<MeshVertex>& vertices, XMFLOAT3& center, float& radius);
+
+	// Box aligned to the principal axes of the surface (area weighted triangle covariance, so vertex density does not skew it)
+	static void ComputeOrientedBox(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, XMFLOAT3& center, XMFLOAT3& extents, XMFLOAT3 axes[3]);
+
+	// sqrt(UV area / surface area) over every triangle, 0 if either is 0 (e.g. a mesh without UVs)
+	// Note: an average, meshes with unevenly spread UVs get finer mips than they need on some triangles and coarser on others
+	static float ComputeUVDensity(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices);
+};
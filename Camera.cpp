@@ -153,66 +153,37 @@ void Camera::UpdateFrustum(XMMATRIX projectionMatrix, float screenDepth) {
     m_FrustumPlanes[5].w /= t;
 }
 
-bool Camera::CheckRectangleInFrustum(float xCenter, float yCenter, float zCenter, float xSize, float ySize, float zSize, float bias) {
-    for(int i = 0; i < 6; i++) {
-        if(m_FrustumPlanes[i].x * (xCenter - xSize) +
-           m_FrustumPlanes[i].y * (yCenter - ySize) +
-           m_FrustumPlanes[i].z * (zCenter - zSize) + m_FrustumPlanes[i].w >= bias)
-        {
-            continue;
-        }
-
-        if(m_FrustumPlanes[i].x * (xCenter + xSize) +
-           m_FrustumPlanes[i].y * (yCenter - ySize) +
-           m_FrustumPlanes[i].z * (zCenter - zSize) + m_FrustumPlanes[i].w >= bias)
-        {
-            continue;
-        }
-
-        if(m_FrustumPlanes[i].x * (xCenter - xSize) +
-           m_FrustumPlanes[i].y * (yCenter + ySize) +
-           m_FrustumPlanes[i].z * (zCenter - zSize) + m_FrustumPlanes[i].w >= bias)
-        {
-            continue;
-        }
-
-        if(m_FrustumPlanes[i].x * (xCenter - xSize) +
-           m_FrustumPlanes[i].y * (yCenter - ySize) +
-           m_FrustumPlanes[i].z * (zCenter + zSize) + m_FrustumPlanes[i].w >= bias)
-        {
-            continue;
-        }
-
-        if(m_FrustumPlanes[i].x * (xCenter + xSize) +
-           m_FrustumPlanes[i].y * (yCenter + ySize) +
-           m_FrustumPlanes[i].z * (zCenter - zSize) + m_FrustumPlanes[i].w >= bias)
-        {
-            continue;
-        }
-
-        if(m_FrustumPlanes[i].x * (xCenter + xSize) +
-           m_FrustumPlanes[i].y * (yCenter - ySize) +
-           m_FrustumPlanes[i].z * (zCenter + zSize) + m_FrustumPlanes[i].w >= bias)
-        {
-            continue;
-        }
-
-        if(m_FrustumPlanes[i].x * (xCenter - xSize) +
-           m_FrustumPlanes[i].y * (yCenter + ySize) +
-           m_FrustumPlanes[i].z * (zCenter + zSize) + m_FrustumPlanes[i].w >= bias)
-        {
-            continue;
-        }
-
-        if(m_FrustumPlanes[i].x * (xCenter + xSize) +
-           m_FrustumPlanes[i].y * (yCenter + ySize) +
-           m_FrustumPlanes[i].z * (zCenter + zSize) + m_FrustumPlanes[i].w >= bias)
-        {
-            continue;
-        }
-
-        return false;
-    }
-
-    return true;
+bool Camera::CheckSphereInFrustum(XMFLOAT3 center, float radius) const {
+	for(const XMFLOAT4& plane : m_FrustumPlanes) {
+		if(plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Camera::CheckOrientedBoxInFrustum(XMFLOAT3 center, const std::array<XMFLOAT3, 3>& halfAxes) const {
+	for(const XMFLOAT4& plane : m_FrustumPlanes) {
+		// Projected half size of the box onto the plane normal
+		float radius = 0.0f;
+		for(const XMFLOAT3& halfAxis : halfAxes) {
+			radius += std::abs(plane.x * halfAxis.x + plane.y * halfAxis.y + plane.z * halfAxis.z);
+		}
+
+		if(plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Camera::GetScreenRay(XMMATRIX projectionMatrix, float ndcX, float ndcY, XMFLOAT3& origin, XMFLOAT3& direction) const {
+	// View space direction through the point on the z = 1 plane (perspective projection, left handed)
+	XMFLOAT4X4 projection {};
+	XMStoreFloat4x4(&projection, projectionMatrix);
+	XMVECTOR viewDirection = XMVectorSet(ndcX / projection._11, ndcY / projection._22, 1.0f, 0.0f);
+
+	XMMATRIX inverseView = XMMatrixInverse(nullptr, m_ViewMatrix);
+	XMStoreFloat3(&direction, XMVector3Normalize(XMVector3TransformNormal(viewDirection, inverseView)));
+	origin = XMFLOAT3(m_PositionX, m_PositionY, m_PositionZ);
 }
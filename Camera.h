@@ -32,11 +32,17 @@ public:
 
 	void UpdateFrustum(XMMATRIX projectionMatrix, float screenDepth);
 
-	// Bias is for vertex displacement factor
-	bool CheckRectangleInFrustum(float xCenter, float yCenter, float zCenter, float xSize, float ySize, float zSize, float bias);
+	// World space tests, planes face inwards so a volume is outside once it lies entirely behind any plane
+	bool CheckSphereInFrustum(XMFLOAT3 center, float radius) const;
+	// Box given by its center and its three half axes (i.e. the OBB axes scaled by the extents and transformed to world space)
+	bool CheckOrientedBoxInFrustum(XMFLOAT3 center, const std::array<XMFLOAT3, 3>& halfAxes) const;
 
 	std::array<XMFLOAT4, 6> GetFrustumPlanes() const { return m_FrustumPlanes; }
 
+	// World space ray through a point on screen (normalized device coordinates, y up), e.g. for mouse picking
+	// Starts at the camera position, direction is normalized
+	void GetScreenRay(XMMATRIX projectionMatrix, float ndcX, float ndcY, XMFLOAT3& origin, XMFLOAT3& direction) const;
+
 private:
 	float m_PositionX {}, m_PositionY {}, m_PositionZ {};
 	float m_RotationX {}, m_RotationY {}, m_RotationZ {};
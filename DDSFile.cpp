@@ -0,0 +1,311 @@
+#include "DDSFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace {
+	constexpr uint32_t MakeFourCC(char a, char b, char c, char d) {
+		return (uint32_t)(unsigned char)a | (uint32_t)(unsigned char)b << 8 | (uint32_t)(unsigned char)c << 16 | (uint32_t)(unsigned char)d << 24;
+	}
+
+	// D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION
+	constexpr uint32_t s_MaxTextureSize = 16384;
+
+	/// DDSHeader::flags
+	constexpr uint32_t s_HeaderFlagCaps        = 0x1;
+	constexpr uint32_t s_HeaderFlagHeight      = 0x2;
+	constexpr uint32_t s_HeaderFlagWidth       = 0x4;
+	constexpr uint32_t s_HeaderFlagPitch       = 0x8;
+	constexpr uint32_t s_HeaderFlagPixelFormat = 0x1000;
+	constexpr uint32_t s_HeaderFlagMipMapCount = 0x20000;
+	constexpr uint32_t s_HeaderFlagLinearSize  = 0x80000;
+	constexpr uint32_t s_HeaderFlagDepth       = 0x800000;
+
+	/// DDSPixelFormat::flags
+	constexpr uint32_t s_PixelFormatFlagFourCC = 0x4;
+	constexpr uint32_t s_PixelFormatFlagRGB    = 0x40;
+
+	/// DDSHeader::caps/caps2
+	constexpr uint32_t s_CapsComplex   = 0x8;
+	constexpr uint32_t s_CapsTexture   = 0x1000;
+	constexpr uint32_t s_CapsMipMap    = 0x400000;
+	constexpr uint32_t s_Caps2Cubemap  = 0x200;
+	constexpr uint32_t s_Caps2Volume   = 0x200000;
+
+	/// DDSHeaderDX10
+	constexpr uint32_t s_ResourceDimensionTexture2D = 3;
+	constexpr uint32_t s_MiscFlagTextureCube = 0x4;
+
+	// D3DFMT values legacy writers store as four CC
+	constexpr uint32_t s_LegacyFormatRGBA16Float = 113;
+	constexpr uint32_t s_LegacyFormatRGBA32Float = 116;
+}
+
+bool DDSFile::Initialize(const std::string& filePath) {
+	if(!m_File.Initialize(filePath)) {
+		return false;
+	}
+
+	if(!Initialize(m_File.GetData(), m_File.GetSize())) {
+		Shutdown();
+		return false;
+	}
+
+	return true;
+}
+
+bool DDSFile::Initialize(const unsigned char* data, size_t size) {
+	if(size < sizeof(kMagic) + sizeof(DDSHeader)) {
+		return false;
+	}
+
+	uint32_t magic {};
+	memcpy(&magic, data, sizeof(magic));
+	const DDSHeader* header = (const DDSHeader*)(data + sizeof(kMagic));
+	if(magic != kMagic || header->size != sizeof(DDSHeader) || header->ddspf.size != sizeof(DDSPixelFormat)) {
+		return false;
+	}
+
+	size_t dataOffset = sizeof(kMagic) + sizeof(DDSHeader);
+	DXGI_FORMAT format {};
+	if((header->ddspf.flags & s_PixelFormatFlagFourCC) && header->ddspf.fourCC == kDX10FourCC) {
+		if(size < dataOffset + sizeof(DDSHeaderDX10)) {
+			return false;
+		}
+
+		const DDSHeaderDX10* headerDX10 = (const DDSHeaderDX10*)(data + dataOffset);
+		if(headerDX10->resourceDimension != s_ResourceDimensionTexture2D || headerDX10->arraySize != 1 || (headerDX10->miscFlag & s_MiscFlagTextureCube)) {
+			return false;
+		}
+		format = (DXGI_FORMAT)headerDX10->dxgiFormat;
+		dataOffset += sizeof(DDSHeaderDX10);
+	}
+	else {
+		format = GetLegacyFormat(header->ddspf);
+	}
+
+	if(GetFormatSize(format) == 0) {
+		return false;
+	}
+
+	if((header->caps2 & (s_Caps2Cubemap | s_Caps2Volume)) || ((header->flags & s_HeaderFlagDepth) && header->depth > 1)) {
+		return false;
+	}
+
+	if(header->width == 0 || header->height == 0 || header->width > s_MaxTextureSize || header->height > s_MaxTextureSize) {
+		return false;
+	}
+
+	// D3D needs the top mip of block compressed textures to be whole blocks
+	if(IsBlockCompressed(format) && (header->width % 4 != 0 || header->height % 4 != 0)) {
+		return false;
+	}
+
+	uint32_t maxMipCount = 1;
+	while((std::max(header->width, header->height) >> maxMipCount) > 0) {
+		maxMipCount++;
+	}
+	uint32_t headerMipCount = (header->flags & s_HeaderFlagMipMapCount) && header->mipMapCount > 0 ? header->mipMapCount : 1;
+	if(headerMipCount > maxMipCount) {
+		return false;
+	}
+	int mipCount = (int)headerMipCount;
+
+	// Every mip must lie inside the data
+	uint64_t mipOffset = dataOffset;
+	for(int mip = 0; mip < mipCount; mip++) {
+		int mipWidth = std::max(1, (int)header->width >> mip);
+		int mipHeight = std::max(1, (int)header->height >> mip);
+		m_MipOffsets[mip] = (size_t)mipOffset;
+		mipOffset += (uint64_t)GetRowPitch(format, mipWidth) * GetRowCount(format, mipHeight);
+		if(mipOffset > size) {
+			return false;
+		}
+	}
+
+	m_Data = data;
+	m_Header = header;
+	m_Format = format;
+	m_MipCount = mipCount;
+
+	return true;
+}
+
+void DDSFile::Shutdown() {
+	m_Data = nullptr;
+	m_Header = nullptr;
+	m_Format = DXGI_FORMAT_UNKNOWN;
+	m_MipCount = 0;
+	m_File.Shutdown();
+}
+
+bool DDSFile::Write(const std::string& filePath, DXGI_FORMAT format, int width, int height, const std::vector<std::vector<unsigned char>>& mips, const uint32_t* metadata) {
+	if(mips.empty() || mips.size() > (size_t)kMaxMipCount || GetFormatSize(format) == 0 || width <= 0 || height <= 0) {
+		return false;
+	}
+
+	for(size_t mip = 0; mip < mips.size(); mip++) {
+		int mipWidth = std::max(1, width >> mip);
+		int mipHeight = std::max(1, height >> mip);
+		if(mips[mip].size() != (size_t)GetRowPitch(format, mipWidth) * GetRowCount(format, mipHeight)) {
+			return false;
+		}
+	}
+
+	bool b_IsBlockCompressed = IsBlockCompressed(format);
+
+	DDSHeader header {};
+	header.size = sizeof(DDSHeader);
+	header.flags = s_HeaderFlagCaps | s_HeaderFlagHeight | s_HeaderFlagWidth | s_HeaderFlagPixelFormat | s_HeaderFlagMipMapCount;
+	header.flags |= b_IsBlockCompressed ? s_HeaderFlagLinearSize : s_HeaderFlagPitch;
+	header.height = (uint32_t)height;
+	header.width = (uint32_t)width;
+	header.pitchOrLinearSize = b_IsBlockCompressed ? (uint32_t)mips[0].size() : (uint32_t)GetRowPitch(format, width);
+	header.mipMapCount = (uint32_t)mips.size();
+	if(metadata) {
+		memcpy(header.reserved1, metadata, sizeof(header.reserved1));
+	}
+	header.ddspf.size = sizeof(DDSPixelFormat);
+	header.ddspf.flags = s_PixelFormatFlagFourCC;
+	header.ddspf.fourCC = kDX10FourCC;
+	header.caps = s_CapsTexture | (mips.size() > 1 ? s_CapsComplex | s_CapsMipMap : 0);
+
+	DDSHeaderDX10 headerDX10 {};
+	headerDX10.dxgiFormat = (uint32_t)format;
+	headerDX10.resourceDimension = s_ResourceDimensionTexture2D;
+	headerDX10.arraySize = 1;
+
+	std::string tempFilePath = filePath + ".tmp";
+	{
+		std::ofstream fout {tempFilePath, std::ios::binary | std::ios::trunc};
+		if(fout.fail()) {
+			return false;
+		}
+
+		fout.write((const char*)&kMagic, sizeof(kMagic));
+		fout.write((const char*)&header, sizeof(DDSHeader));
+		fout.write((const char*)&headerDX10, sizeof(DDSHeaderDX10));
+		for(const std::vector<unsigned char>& mip : mips) {
+			fout.write((const char*)mip.data(), mip.size());
+		}
+
+		if(fout.fail()) {
+			fout.close();
+			std::filesystem::remove(tempFilePath);
+			return false;
+		}
+	}
+
+	std::error_code errorCode {};
+	std::filesystem::rename(tempFilePath, filePath, errorCode);
+	if(errorCode) {
+		std::filesystem::remove(tempFilePath, errorCode);
+		return false;
+	}
+
+	return true;
+}
+
+int DDSFile::GetFormatSize(DXGI_FORMAT format) {
+	switch(format) {
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_UNORM:
+		case DXGI_FORMAT_BC4_SNORM:
+			return 8;
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC5_UNORM:
+		case DXGI_FORMAT_BC5_SNORM:
+		case DXGI_FORMAT_BC6H_UF16:
+		case DXGI_FORMAT_BC6H_SF16:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return 16;
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			return 16;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+		case DXGI_FORMAT_R16G16B16A16_SNORM:
+		case DXGI_FORMAT_R32G32_FLOAT:
+			return 8;
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_R8G8B8A8_SNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_R10G10B10A2_UNORM:
+		case DXGI_FORMAT_R11G11B10_FLOAT:
+		case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+		case DXGI_FORMAT_R16G16_FLOAT:
+		case DXGI_FORMAT_R16G16_UNORM:
+		case DXGI_FORMAT_R16G16_SNORM:
+		case DXGI_FORMAT_R32_FLOAT:
+			return 4;
+		case DXGI_FORMAT_R8G8_UNORM:
+		case DXGI_FORMAT_R16_FLOAT:
+			return 2;
+		case DXGI_FORMAT_R8_UNORM:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+bool DDSFile::IsBlockCompressed(DXGI_FORMAT format) {
+	return (format >= DXGI_FORMAT_BC1_UNORM && format <= DXGI_FORMAT_BC5_SNORM) || (format >= DXGI_FORMAT_BC6H_UF16 && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+}
+
+int DDSFile::GetRowPitch(DXGI_FORMAT format, int width) {
+	return IsBlockCompressed(format) ? (width + 3) / 4 * GetFormatSize(format) : width * GetFormatSize(format);
+}
+
+int DDSFile::GetRowCount(DXGI_FORMAT format, int height) {
+	return IsBlockCompressed(format) ? (height + 3) / 4 : height;
+}
+
+DXGI_FORMAT DDSFile::GetLegacyFormat(const DDSPixelFormat& pixelFormat) {
+	if(pixelFormat.flags & s_PixelFormatFlagFourCC) {
+		switch(pixelFormat.fourCC) {
+			case MakeFourCC('D', 'X', 'T', '1'):
+				return DXGI_FORMAT_BC1_UNORM;
+			case MakeFourCC('D', 'X', 'T', '2'):
+			case MakeFourCC('D', 'X', 'T', '3'):
+				return DXGI_FORMAT_BC2_UNORM;
+			case MakeFourCC('D', 'X', 'T', '4'):
+			case MakeFourCC('D', 'X', 'T', '5'):
+				return DXGI_FORMAT_BC3_UNORM;
+			case MakeFourCC('A', 'T', 'I', '1'):
+			case MakeFourCC('B', 'C', '4', 'U'):
+				return DXGI_FORMAT_BC4_UNORM;
+			case MakeFourCC('B', 'C', '4', 'S'):
+				return DXGI_FORMAT_BC4_SNORM;
+			case MakeFourCC('A', 'T', 'I', '2'):
+			case MakeFourCC('B', 'C', '5', 'U'):
+				return DXGI_FORMAT_BC5_UNORM;
+			case MakeFourCC('B', 'C', '5', 'S'):
+				return DXGI_FORMAT_BC5_SNORM;
+			case s_LegacyFormatRGBA16Float:
+				return DXGI_FORMAT_R16G16B16A16_FLOAT;
+			case s_LegacyFormatRGBA32Float:
+				return DXGI_FORMAT_R32G32B32A32_FLOAT;
+			default:
+				return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+
+	if((pixelFormat.flags & s_PixelFormatFlagRGB) && pixelFormat.rgbBitCount == 32) {
+		if(pixelFormat.rBitMask == 0x000000FF && pixelFormat.gBitMask == 0x0000FF00 && pixelFormat.bBitMask == 0x00FF0000 && pixelFormat.aBitMask == 0xFF000000) {
+			return DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+		if(pixelFormat.rBitMask == 0x00FF0000 && pixelFormat.gBitMask == 0x0000FF00 && pixelFormat.bBitMask == 0x000000FF && pixelFormat.aBitMask == 0xFF000000) {
+			return DXGI_FORMAT_B8G8R8A8_UNORM;
+		}
+	}
+
+	return DXGI_FORMAT_UNKNOWN;
+}
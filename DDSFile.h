@@ -0,0 +1,101 @@
+#pragma once
+#include "MappedFile.h"
+
+#include <d3d11.h>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <vector>
+
+// DirectDraw Surface container: "DDS " | DDSHeader | DDSHeaderDX10 (if ddspf.fourCC is "DX10") | every mip, tightly packed from mip 0
+// Mips are stored in their final GPU layout, so a mapped file can be passed straight to CreateTexture2D as initial data
+// Note: only single 2D textures are supported, cubemaps, arrays and volumes are rejected
+class DDSFile {
+public:
+	static constexpr uint32_t kMagic = 0x20534444; // "DDS "
+	static constexpr uint32_t kDX10FourCC = 0x30315844; // "DX10"
+	// 16384 texels, the largest D3D11 texture
+	static constexpr int kMaxMipCount = 15;
+	// DDSHeader::reserved1, ignored by readers and free for the writer's own data (see TextureCache)
+	static constexpr int kMetadataCount = 11;
+
+	struct DDSPixelFormat {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t rBitMask;
+		uint32_t gBitMask;
+		uint32_t bBitMask;
+		uint32_t aBitMask;
+	};
+
+	struct DDSHeader {
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved1[kMetadataCount];
+		DDSPixelFormat ddspf;
+		uint32_t caps;
+		uint32_t caps2;
+		uint32_t caps3;
+		uint32_t caps4;
+		uint32_t reserved2;
+	};
+
+	struct DDSHeaderDX10 {
+		uint32_t dxgiFormat;
+		uint32_t resourceDimension;
+		uint32_t miscFlag;
+		uint32_t arraySize;
+		uint32_t miscFlags2;
+	};
+
+public:
+	DDSFile() {}
+	DDSFile(const DDSFile&) {}
+	~DDSFile() {}
+
+	// Maps and validates filePath
+	bool Initialize(const std::string& filePath);
+	// Validates a DDS file already in memory, data must stay valid until Shutdown
+	bool Initialize(const unsigned char* data, size_t size);
+	void Shutdown();
+
+	DXGI_FORMAT GetFormat() const { return m_Format; }
+	int GetWidth() const { return (int)m_Header->width; }
+	int GetHeight() const { return (int)m_Header->height; }
+	int GetMipCount() const { return m_MipCount; }
+	const uint32_t* GetMetadata() const { return m_Header->reserved1; }
+
+	const unsigned char* GetMipData(int mip) const { return m_Data + m_MipOffsets[mip]; }
+	size_t GetMipSize(int mip) const { return (size_t)GetRowPitch(m_Format, GetMipWidth(mip)) * GetRowCount(m_Format, GetMipHeight(mip)); }
+	int GetMipWidth(int mip) const { return std::max(1, GetWidth() >> mip); }
+	int GetMipHeight(int mip) const { return std::max(1, GetHeight() >> mip); }
+
+	// Writes a DX10 header DDS file through a temp file, mips from mip 0 in the layout GetRowPitch/GetRowCount describe
+	static bool Write(const std::string& filePath, DXGI_FORMAT format, int width, int height, const std::vector<std::vector<unsigned char>>& mips, const uint32_t* metadata = nullptr);
+
+	// Bytes per 4x4 block for block compressed formats, per texel otherwise, 0 for formats this reader doesn't support
+	static int GetFormatSize(DXGI_FORMAT format);
+	static bool IsBlockCompressed(DXGI_FORMAT format);
+	// Rows are block rows for block compressed formats
+	static int GetRowPitch(DXGI_FORMAT format, int width);
+	static int GetRowCount(DXGI_FORMAT format, int height);
+
+private:
+	// DXGI format of a header without the DX10 extension (DXTn/ATIn four CCs and 32 bit RGBA masks), DXGI_FORMAT_UNKNOWN otherwise
+	static DXGI_FORMAT GetLegacyFormat(const DDSPixelFormat& pixelFormat);
+
+private:
+	MappedFile m_File {};
+	const unsigned char* m_Data {};
+	const DDSHeader* m_Header {};
+	DXGI_FORMAT m_Format {};
+	int m_MipCount {};
+	size_t m_MipOffsets[kMaxMipCount] {};
+};
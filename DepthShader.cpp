@@ -16,25 +16,10 @@ bool DepthShader::Initialize(ID3D11Device* device, HWND hwnd) {
 
 	/// Compile and create shaders
 	ID3D10Blob* errorMessage {};
-	ID3D10Blob* vertexShaderBuffer {};
 	ID3D10Blob* pixelShaderBuffer {};
 	ID3D10Blob* hullShaderBuffer {};
 	ID3D10Blob* domainShaderBuffer {};
 
-	result = D3DCompileFromFile(vsFileName.c_str(), NULL, NULL, "DepthVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0,
-		&vertexShaderBuffer, &errorMessage);
-	if(FAILED(result)) {
-		// If the shader failed to compile it should have writen something to the error message.
-		if(errorMessage) {
-			OutputShaderErrorMessage(errorMessage, hwnd, vsFileName.c_str());
-		}
-		// If there was  nothing in the error message then it simply could not find the shader file itself.
-		else {
-			MessageBox(hwnd, vsFileName.c_str(), L"Missing Shader File", MB_OK);
-		}
-
-		return false;
-	}
 	result = D3DCompileFromFile(psFileName.c_str(), NULL, NULL, "DepthPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0,
 		&pixelShaderBuffer, &errorMessage);
 	if(FAILED(result)) {
@@ -70,8 +55,6 @@ bool DepthShader::Initialize(ID3D11Device* device, HWND hwnd) {
 		return false;
 	}
 
-	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_VertexShader);
-	if(FAILED(result)) return false;
 	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &m_PixelShader);
 	if(FAILED(result)) return false;
 	result = device->CreateHullShader(hullShaderBuffer->GetBufferPointer(), hullShaderBuffer->GetBufferSize(), NULL, &m_HullShader);
@@ -79,42 +62,11 @@ bool DepthShader::Initialize(ID3D11Device* device, HWND hwnd) {
 	result = device->CreateDomainShader(domainShaderBuffer->GetBufferPointer(), domainShaderBuffer->GetBufferSize(), NULL, &m_DomainShader);
 	if(FAILED(result)) return false;
 
-	// Create the vertex input layout description.
-	D3D11_INPUT_ELEMENT_DESC polygonLayout[3] {};
-	polygonLayout[0].SemanticName = "POSITION";
-	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[0].InputSlot = 0;
-	polygonLayout[0].AlignedByteOffset = 0;
-	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[0].InstanceDataStepRate = 0;
-
-	polygonLayout[1].SemanticName = "TEXCOORD";
-	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
-	polygonLayout[1].InputSlot = 0;
-	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[1].InstanceDataStepRate = 0;
-
-	polygonLayout[2].SemanticName = "NORMAL";
-	polygonLayout[2].SemanticIndex = 0;
-	polygonLayout[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[2].InputSlot = 0;
-	polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[2].InstanceDataStepRate = 0;
-
-	// Create the vertex input layout.
-	unsigned int numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
-	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &m_Layout);
-	if(FAILED(result)) {
+	// Initialize vertex shader and input layout for every vertex format
+	if(!InitializeVertexShaders(device, vsFileName, hwnd)) {
 		return false;
 	}
 
-	vertexShaderBuffer->Release();
-	vertexShaderBuffer = nullptr;
-
 	pixelShaderBuffer->Release();
 	pixelShaderBuffer = nullptr;
 
@@ -190,8 +142,54 @@ bool DepthShader::Initialize(ID3D11Device* device, HWND hwnd) {
 	return true;
 }
 
-bool DepthShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
-	XMMATRIX projectionMatrix, Texture* heightMap, const GameObject::GameObjectData& gameObjectData) {
+bool DepthShader::InitializeVertexShaders(ID3D11Device* device, const std::wstring& vsFileName, HWND hwnd) {
+	// Depth pass only reads position, uv and normal, i.e. only the geometry stream in slot 0 (see VertexStream)
+	// Input layouts need to match the geometry part of MeshVertex and PackedMeshVertex (see MeshData.h) and VertexInputType in Depth.vs
+	const D3D11_INPUT_ELEMENT_DESC fullLayout[3] {
+		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,                            D3D11_INPUT_PER_VERTEX_DATA, 0},
+		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+		{"NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	};
+
+	const D3D11_INPUT_ELEMENT_DESC packedLayout[3] {
+		{"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0,                            D3D11_INPUT_PER_VERTEX_DATA, 0},
+		{"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+		{"NORMAL",   0, DXGI_FORMAT_R16G16_SNORM,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+	};
+
+	HRESULT result {};
+	ID3D10Blob* errorMessage {};
+	D3D_SHADER_MACRO packedMacros[2] {{"PACKED_VERTEX", "1"}, {NULL, NULL}};
+	for(int i = 0; i < Num_VertexFormats; i++) {
+		ID3D10Blob* vertexShaderBuffer {};
+		const D3D_SHADER_MACRO* macros = i == kPackedVertexFormat ? packedMacros : NULL;
+
+		result = D3DCompileFromFile(vsFileName.c_str(), macros, NULL, "DepthVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
+		if(FAILED(result)) {
+			if(errorMessage) {
+				OutputShaderErrorMessage(errorMessage, hwnd, vsFileName.c_str());
+			}
+			else {
+				MessageBox(hwnd, vsFileName.c_str(), L"Missing Shader File", MB_OK);
+			}
+			return false;
+		}
+
+		result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_VertexShaders[i]);
+		if(FAILED(result)) return false;
+
+		const D3D11_INPUT_ELEMENT_DESC* layout = i == kPackedVertexFormat ? packedLayout : fullLayout;
+		result = device->CreateInputLayout(layout, 3, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &m_Layouts[i]);
+		if(FAILED(result)) return false;
+
+		vertexShaderBuffer->Release();
+		vertexShaderBuffer = nullptr;
+	}
+	return true;
+}
+
+bool DepthShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, int firstIndex, int baseVertex, VertexFormat vertexFormat, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+	XMMATRIX projectionMatrix, Texture* packedMap, const GameObject::GameObjectData& gameObjectData) {
 	HRESULT result {};
 	D3D11_MAPPED_SUBRESOURCE mappedResource {};
 
@@ -233,7 +231,7 @@ bool DepthShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, XMM
 	deviceContext->DSSetConstantBuffers(1, 1, &m_DepthMaterialBuffer);
 
 	/// Bind Domain Shader Textures
-	ID3D11ShaderResourceView* pTempSRV = heightMap->GetTextureSRV(); // height map
+	ID3D11ShaderResourceView* pTempSRV = packedMap->GetTextureSRV(); // height in a
 	deviceContext->DSSetShaderResources(0, 1, &pTempSRV);
 
 	/// Update HS buffers
@@ -252,16 +250,16 @@ bool DepthShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, XMM
 	deviceContext->HSSetConstantBuffers(0, 1, &m_TessellationBuffer);
 
 	/// Render
-	deviceContext->IASetInputLayout(m_Layout);
+	deviceContext->IASetInputLayout(m_Layouts[vertexFormat]);
 
-	deviceContext->VSSetShader(m_VertexShader, NULL, 0);
+	deviceContext->VSSetShader(m_VertexShaders[vertexFormat], NULL, 0);
 	deviceContext->PSSetShader(m_PixelShader, NULL, 0);
 	deviceContext->HSSetShader(m_HullShader, NULL, 0);
 	deviceContext->DSSetShader(m_DomainShader, NULL, 0);
 
 	deviceContext->DSSetSamplers(0, 1, &m_SampleStateWrap);
 
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+	deviceContext->DrawIndexed(indexCount, firstIndex, baseVertex);
 
 	return true;
 }
@@ -287,9 +285,11 @@ void DepthShader::Shutdown() {
 		m_SampleStateWrap = nullptr;
 	}
 
-	if(m_Layout) {
-		m_Layout->Release();
-		m_Layout = nullptr;
+	for(int i = 0; i < m_Layouts.size(); i++) {
+		if(m_Layouts[i]) {
+			m_Layouts[i]->Release();
+			m_Layouts[i] = nullptr;
+		}
 	}
 
 	if(m_PixelShader) {
@@ -297,9 +297,11 @@ void DepthShader::Shutdown() {
 		m_PixelShader = nullptr;
 	}
 
-	if(m_VertexShader) {
-		m_VertexShader->Release();
-		m_VertexShader = nullptr;
+	for(int i = 0; i < m_VertexShaders.size(); i++) {
+		if(m_VertexShaders[i]) {
+			m_VertexShaders[i]->Release();
+			m_VertexShaders[i] = nullptr;
+		}
 	}
 
 	if(m_HullShader) {
@@ -1,8 +1,11 @@
 #pragma once
 #include "GameObject.h"
+#include "MeshData.h"
 
 #include <d3d11.h>
 #include <directxmath.h>
+#include <array>
+#include <string>
 using namespace DirectX;
 
 class Texture;
@@ -33,18 +36,22 @@ public:
 
 	bool Initialize(ID3D11Device*, HWND);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext* deviceContext, int indexCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
-		XMMATRIX projectionMatrix, Texture* heightMap, const GameObject::GameObjectData& gameObjectData);
+	bool Render(ID3D11DeviceContext* deviceContext, int indexCount, int firstIndex, int baseVertex, VertexFormat vertexFormat, XMMATRIX worldMatrix, XMMATRIX viewMatrix,
+		XMMATRIX projectionMatrix, Texture* packedMap, const GameObject::GameObjectData& gameObjectData);
 
 private:
-	ID3D11VertexShader* m_VertexShader {};
+	bool InitializeVertexShaders(ID3D11Device* device, const std::wstring& vsFileName, HWND hwnd);
+
+private:
+	// Indexed by VertexFormat enum
+	std::array<ID3D11VertexShader*, Num_VertexFormats> m_VertexShaders {};
 	ID3D11PixelShader*  m_PixelShader {};
 	ID3D11HullShader*   m_HullShader {};
 	ID3D11DomainShader* m_DomainShader {};
 	
 	ID3D11SamplerState* m_SampleStateWrap {};
 
-	ID3D11InputLayout* m_Layout {};
+	std::array<ID3D11InputLayout*, Num_VertexFormats> m_Layouts {};
 	ID3D11Buffer* m_MatrixBuffer {};
 	ID3D11Buffer* m_DepthMaterialBuffer {};
 	ID3D11Buffer* m_TessellationBuffer {};
@@ -7,8 +7,33 @@
 #include "DirectionalLight.h"
 #include "Camera.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <iostream>
 
+namespace {
+	// Coarsest LOD whose geometric error projects to less than this many pixels is drawn
+	constexpr float s_MaxLODScreenError = 1.0f;
+
+	// Largest axis scale of a world matrix (row vectors are the transformed model axes)
+	float GetMaxAxisScale(XMMATRIX worldMatrix) {
+		float maxScale = 0.0f;
+		for(int i = 0; i < 3; i++) {
+			maxScale = std::max(maxScale, XMVectorGetX(XMVector3Length(worldMatrix.r[i])));
+		}
+		return maxScale;
+	}
+
+	float GetMinAxisScale(XMMATRIX worldMatrix) {
+		float minScale = FLT_MAX;
+		for(int i = 0; i < 3; i++) {
+			minScale = std::min(minScale, XMVectorGetX(XMVector3Length(worldMatrix.r[i])));
+		}
+		return minScale;
+	}
+}
+
 // Note: "instances" passed as parameters are cleaned up in scene class
 void GameObject::Initialize(PBRShader* pbrShaderInstance, DepthShader* depthShaderInstance, const std::vector<Texture*>& textureResources, Model* model, const GameObjectData& initialGameObjectData) {
 	m_MaterialTextures = textureResources;
@@ -20,51 +45,225 @@ void GameObject::Initialize(PBRShader* pbrShaderInstance, DepthShader* depthShad
 }
 
 bool GameObject::RenderToDepth(ID3D11DeviceContext* deviceContext, DirectionalLight* light, float time){
-	if(!mb_IsEnabled) {
+	if(!mb_IsEnabled || !m_ModelInstance->IsDrawable()) {
 		return true;
 	}
 
-	XMMATRIX srtMatrix = XMMatrixMultiply(XMMatrixMultiply(
-		XMMatrixScaling(m_GameObjectData.scale.x, m_GameObjectData.scale.y, m_GameObjectData.scale.z),
-		XMMatrixRotationY(time * m_GameObjectData.yRotSpeed)),
-		XMMatrixTranslation(m_GameObjectData.position.x, m_GameObjectData.position.y, m_GameObjectData.position.z)
-	);
+	XMMATRIX srtMatrix = GetWorldMatrix(time);
 
-	m_ModelInstance->Render(deviceContext, true);
+	// Geometry stream only, the depth pass never reads the tangent frame
+	m_ModelInstance->Render(deviceContext, true, true);
 
 	XMMATRIX lightView {};
 	XMMATRIX lightProjection {};
 	light->GetViewMatrix(lightView);
 	light->GetOrthoMatrix(lightProjection);
-	m_DepthShaderInstance->Render(deviceContext, m_ModelInstance->GetIndexCount(), srtMatrix, lightView, lightProjection, m_MaterialTextures[5], m_GameObjectData);
+	// Note: the depth pass runs after Render, so this is the LOD it picked (residency only changes between frames)
+	int lod = std::max(m_CurrentLOD, m_ModelInstance->GetResidentLOD());
+	GeometryArena::Range geometryRange = m_ModelInstance->GetArenaRange();
+	for(int i = 0; i < m_ModelInstance->GetSubMeshCount(); i++) {
+		const MeshLOD& subMeshLOD = m_ModelInstance->GetSubMeshLOD(lod, i);
+		if(subMeshLOD.indexCount == 0) {
+			continue;
+		}
+		m_DepthShaderInstance->Render(deviceContext, (int)subMeshLOD.indexCount, (int)(geometryRange.firstIndex + subMeshLOD.firstIndex), (int)geometryRange.baseVertex, m_ModelInstance->GetVertexFormat(), srtMatrix, lightView, lightProjection, m_MaterialTextures[2], m_GameObjectData);
+	}
 	return true;
 }
 
-// TODO: use CubeMapObject as parameter?
-bool GameObject::Render(ID3D11DeviceContext* deviceContext, XMMATRIX projectionMatrix, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, Camera* cullFrustumCamera, float time) {
-	if(!mb_IsEnabled) {
-		return true;
+bool GameObject::CullAndSelectLOD(XMMATRIX projectionMatrix, float viewportHeight, Camera* cullFrustumCamera, float time) {
+	m_MeshletCullStats = MeshletCuller::CullStats {};
+	if(!mb_IsEnabled || !m_ModelInstance->IsLoaded()) {
+		return false;
 	}
 
+	XMMATRIX srtMatrix = GetWorldMatrix(time);
+
 	/// Frustum visibililty check
-	/// WARNING: extents (bounding box) currently don't take rotation into account
-	XMFLOAT3 modelExtents = m_ModelInstance->GetExtents();
-	modelExtents.x *= m_GameObjectData.scale.x;
-	modelExtents.y *= m_GameObjectData.scale.y;
-	modelExtents.z *= m_GameObjectData.scale.z;
+	if(!CheckBoundsInFrustum(srtMatrix, cullFrustumCamera)) {
+		m_MeshletCullStats.meshletCount = (int)m_ModelInstance->GetLODs()[m_CurrentLOD].meshletCount;
+		m_MeshletCullStats.frustumCulledCount = m_MeshletCullStats.meshletCount;
+		return false;
+	}
 
-	// NOTE: make sure vertexDisplacementMapScale use matches shader (i.e. not shifted 0.5 or something)
-	if(!cullFrustumCamera->CheckRectangleInFrustum(m_GameObjectData.position.x, m_GameObjectData.position.y, m_GameObjectData.position.z, modelExtents.x, modelExtents.y, modelExtents.z, -m_GameObjectData.vertexDisplacementMapScale)) {
+	/// LOD selection by projected geometric error
+	m_CurrentLOD = SelectLOD(projectionMatrix, viewportHeight, srtMatrix, cullFrustumCamera);
+
+	/// Texture mips by projected texel density, streamed in by the scene's TextureStreamer
+	RequestTextureMips(projectionMatrix, viewportHeight, srtMatrix, cullFrustumCamera);
+
+	// Every meshlet counts as drawn unless meshlet culling runs after this
+	m_MeshletCullStats.meshletCount = (int)m_ModelInstance->GetLODs()[m_CurrentLOD].meshletCount;
+	return true;
+}
+
+// TODO: use CubeMapObject as parameter?
+bool GameObject::Render(ID3D11DeviceContext* deviceContext, XMMATRIX projectionMatrix, float viewportHeight, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, Camera* cullFrustumCamera, float time) {
+	if(!CullAndSelectLOD(projectionMatrix, viewportHeight, cullFrustumCamera, time)) {
 		return true;
 	}
 
-	/// Render
-	XMMATRIX srtMatrix = XMMatrixMultiply(XMMatrixMultiply(
+	// Streams the picked LOD in, until then the finest resident one is drawn
+	m_ModelInstance->RequestLOD(m_CurrentLOD);
+	if(!m_ModelInstance->IsDrawable()) {
+		return true;
+	}
+	m_CurrentLOD = std::max(m_CurrentLOD, m_ModelInstance->GetResidentLOD());
+
+	XMMATRIX srtMatrix = GetWorldMatrix(time);
+	m_ModelInstance->Render(deviceContext, true);
+	GeometryArena::Range geometryRange = m_ModelInstance->GetArenaRange();
+
+	// Every sub-mesh is culled and drawn on its own, its meshlets never merge into another sub-mesh's draw ranges
+	m_MeshletCullStats = MeshletCuller::CullStats {};
+	for(int i = 0; i < m_ModelInstance->GetSubMeshCount(); i++) {
+		const MeshLOD& subMeshLOD = m_ModelInstance->GetSubMeshLOD(m_CurrentLOD, i);
+
+		/// Meshlet culling, drops clusters before they reach the hull shader (which would otherwise cull them triangle by triangle)
+		MeshletCuller::CullStats cullStats = MeshletCuller::CullMeshlets(m_ModelInstance->GetMeshlets().data() + subMeshLOD.firstMeshlet, subMeshLOD.meshletCount, srtMatrix, cullFrustumCamera->GetFrustumPlanes(), cullFrustumCamera->GetPosition(), m_GameObjectData.vertexDisplacementMapScale, m_MeshletDrawRanges);
+		m_MeshletCullStats.meshletCount += cullStats.meshletCount;
+		m_MeshletCullStats.frustumCulledCount += cullStats.frustumCulledCount;
+		m_MeshletCullStats.backfaceCulledCount += cullStats.backfaceCulledCount;
+		m_MeshletCullStats.drawRangeCount += cullStats.drawRangeCount;
+		if(m_MeshletDrawRanges.empty()) {
+			continue;
+		}
+
+		/// Render
+		if(!m_PBRShaderInstance->Render(deviceContext, m_MeshletDrawRanges, geometryRange.firstIndex, (int)geometryRange.baseVertex, m_ModelInstance->GetVertexFormat(), srtMatrix, projectionMatrix, m_MaterialTextures, shadowMap, skybox, light, camera, cullFrustumCamera->GetFrustumPlanes(), time, m_GameObjectData)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GameObject::RayCast(XMFLOAT3 origin, XMFLOAT3 direction, float time, float maxDistance, float& hitDistance) const {
+	if(!mb_IsEnabled || !m_ModelInstance->IsLoaded()) {
+		return false;
+	}
+
+	XMMATRIX srtMatrix = GetWorldMatrix(time);
+
+	// Bounding sphere first, most rays miss most objects
+	XMFLOAT3 sphereCenter {};
+	float sphereRadius {};
+	GetWorldBoundingSphere(srtMatrix, sphereCenter, sphereRadius);
+	XMVECTOR directionVector = XMLoadFloat3(&direction);
+	XMVECTOR toCenter = XMVectorSubtract(XMLoadFloat3(&sphereCenter), XMLoadFloat3(&origin));
+	float directionLengthSquared = XMVectorGetX(XMVector3Dot(directionVector, directionVector));
+	float closestApproach = XMVectorGetX(XMVector3Dot(toCenter, directionVector)) / directionLengthSquared;
+	XMVECTOR closestOffset = XMVectorSubtract(toCenter, XMVectorScale(directionVector, closestApproach));
+	if(XMVectorGetX(XMVector3Dot(closestOffset, closestOffset)) > sphereRadius * sphereRadius) {
+		return false;
+	}
+
+	// Ray to model space, direction is not renormalized so ray distances are the same in both spaces
+	// Note: tests the undisplaced LOD 0 surface, vertex displacement only happens on the GPU
+	XMMATRIX inverseSRT = XMMatrixInverse(nullptr, srtMatrix);
+	XMFLOAT3 modelOrigin {}, modelDirection {};
+	XMStoreFloat3(&modelOrigin, XMVector3TransformCoord(XMLoadFloat3(&origin), inverseSRT));
+	XMStoreFloat3(&modelDirection, XMVector3TransformNormal(directionVector, inverseSRT));
+
+	MeshBVH::RayHit hit {};
+	if(!m_ModelInstance->RayCast(modelOrigin, modelDirection, maxDistance, hit)) {
+		return false;
+	}
+	hitDistance = hit.distance;
+	return true;
+}
+
+XMMATRIX GameObject::GetWorldMatrix(float time) const {
+	return XMMatrixMultiply(XMMatrixMultiply(
 		XMMatrixScaling(m_GameObjectData.scale.x, m_GameObjectData.scale.y, m_GameObjectData.scale.z),
 		XMMatrixRotationY(time * m_GameObjectData.yRotSpeed)),
 		XMMatrixTranslation(m_GameObjectData.position.x, m_GameObjectData.position.y, m_GameObjectData.position.z)
 	);
+}
 
-	m_ModelInstance->Render(deviceContext, true);
-	return m_PBRShaderInstance->Render(deviceContext, m_ModelInstance->GetIndexCount(), srtMatrix, projectionMatrix, m_MaterialTextures, shadowMap, skybox, light, camera, cullFrustumCamera->GetFrustumPlanes(), time, m_GameObjectData);
+void GameObject::GetWorldBoundingSphere(XMMATRIX worldMatrix, XMFLOAT3& center, float& radius) const {
+	const MeshBounds& bounds = m_ModelInstance->GetBounds();
+	XMStoreFloat3(&center, XMVector3TransformCoord(XMLoadFloat3(&bounds.sphereCenter), worldMatrix));
+
+	// NOTE: make sure vertexDisplacementMapScale use matches shader (i.e. not shifted 0.5 or something)
+	// Vertices move up to vertexDisplacementMapScale along their model space normal, so the model space radius grows by that much
+	// Scaled by the largest axis scale so the sphere stays conservative under non uniform scale
+	radius = (bounds.sphereRadius + std::max(m_GameObjectData.vertexDisplacementMapScale, 0.0f)) * GetMaxAxisScale(worldMatrix);
+}
+
+bool GameObject::CheckBoundsInFrustum(XMMATRIX worldMatrix, Camera* camera) const {
+	// Sphere first, it is cheaper and rejects most objects that are well outside
+	XMFLOAT3 sphereCenter {};
+	float sphereRadius {};
+	GetWorldBoundingSphere(worldMatrix, sphereCenter, sphereRadius);
+	if(!camera->CheckSphereInFrustum(sphereCenter, sphereRadius)) {
+		return false;
+	}
+
+	// Oriented box, grown by the displacement in model space and then transformed with the full SRT matrix (rotation and non uniform scale included)
+	const MeshBounds& bounds = m_ModelInstance->GetBounds();
+	float displacement = std::max(m_GameObjectData.vertexDisplacementMapScale, 0.0f);
+	const float extents[3] {bounds.obbExtents.x + displacement, bounds.obbExtents.y + displacement, bounds.obbExtents.z + displacement};
+
+	XMFLOAT3 boxCenter {};
+	XMStoreFloat3(&boxCenter, XMVector3TransformCoord(XMLoadFloat3(&bounds.obbCenter), worldMatrix));
+	std::array<XMFLOAT3, 3> halfAxes {};
+	for(int i = 0; i < 3; i++) {
+		XMStoreFloat3(&halfAxes[i], XMVector3TransformNormal(XMVectorScale(XMLoadFloat3(&bounds.obbAxes[i]), extents[i]), worldMatrix));
+	}
+	return camera->CheckOrientedBoxInFrustum(boxCenter, halfAxes);
+}
+
+int GameObject::SelectLOD(XMMATRIX projectionMatrix, float viewportHeight, XMMATRIX worldMatrix, Camera* camera) const {
+	const std::vector<MeshLOD>& lods = m_ModelInstance->GetLODs();
+	float pixelsPerUnit = GetPixelsPerUnit(projectionMatrix, viewportHeight, worldMatrix, camera);
+	if(pixelsPerUnit == FLT_MAX) {
+		return 0;
+	}
+
+	// Errors are in model units, scaled by the largest axis scale
+	float maxScale = GetMaxAxisScale(worldMatrix);
+
+	int selectedLOD = 0;
+	for(size_t i = 1; i < lods.size(); i++) {
+		if(lods[i].error * maxScale * pixelsPerUnit > s_MaxLODScreenError) {
+			break;
+		}
+		selectedLOD = (int)i;
+	}
+	return selectedLOD;
+}
+
+void GameObject::RequestTextureMips(XMMATRIX projectionMatrix, float viewportHeight, XMMATRIX worldMatrix, Camera* camera) const {
+	// Models without texture coordinates (or cached before the UV density was) keep whatever is resident
+	float uvDensity = m_ModelInstance->GetBounds().uvDensity;
+	if(uvDensity <= 0.0f) {
+		return;
+	}
+
+	// UV units per world unit, the smallest axis scale packs the most texels into a world unit so it is the one that needs the finest mip
+	// Note: a surface average, objects whose UVs are much denser in places get those places a little blurry
+	float uvPerUnit = uvDensity * m_GameObjectData.uvScale / GetMinAxisScale(worldMatrix);
+
+	// Pixels a whole texture repeat covers, at the closest point of the object
+	float screenSize = GetPixelsPerUnit(projectionMatrix, viewportHeight, worldMatrix, camera) / uvPerUnit;
+	for(Texture* texture : m_MaterialTextures) {
+		texture->RequestMip(texture->GetMipForScreenSize(screenSize));
+	}
+}
+
+float GameObject::GetPixelsPerUnit(XMMATRIX projectionMatrix, float viewportHeight, XMMATRIX worldMatrix, Camera* camera) const {
+	// Distance from the camera to the closest point of the object's bounding sphere
+	XMFLOAT3 sphereCenter {};
+	float sphereRadius {};
+	GetWorldBoundingSphere(worldMatrix, sphereCenter, sphereRadius);
+
+	XMFLOAT3 cameraPosition = camera->GetPosition();
+	float offset[3] {sphereCenter.x - cameraPosition.x, sphereCenter.y - cameraPosition.y, sphereCenter.z - cameraPosition.z};
+	float distance = std::sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]) - sphereRadius;
+	if(distance <= 0.0f) {
+		return FLT_MAX;
+	}
+
+	// projectionMatrix._22 = 1 / tan(fovY / 2), half the viewport height spans tan(fovY / 2) * distance world units
+	return XMVectorGetY(projectionMatrix.r[1]) * 0.5f * viewportHeight / distance;
 }
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <vector>
 
+#include "MeshletCuller.h"
+
 class DirectionalLight;
 class Model;
 class DepthShader;
@@ -46,10 +48,27 @@ public:
 public:
 	void Initialize(PBRShader* pbrShaderInstance, DepthShader* depthShaderInstance, const std::vector<Texture*>& textures, Model* model, const GameObjectData& initialGameObjectData);
 
-	bool Render(ID3D11DeviceContext* deviceContext, XMMATRIX projectionMatrix, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, Camera* cullFrustumCamera, float time);
+	// viewportHeight: pixel height of the render target cullFrustumCamera's view is drawn to, LODs and texture mips are picked for that view
+	bool Render(ID3D11DeviceContext* deviceContext, XMMATRIX projectionMatrix, float viewportHeight, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, Camera* cullFrustumCamera, float time);
 
 	bool RenderToDepth(ID3D11DeviceContext* deviceContext, DirectionalLight* light, float time);
 
+	// Object frustum culling and LOD selection of Render without drawing, for objects drawn by a StaticBatcher
+	// False if the object is disabled or outside the frustum, the picked LOD is read with GetCurrentLOD
+	bool CullAndSelectLOD(XMMATRIX projectionMatrix, float viewportHeight, Camera* cullFrustumCamera, float time);
+
+	// Scale, y rotation at time, then translation
+	XMMATRIX GetWorldMatrix(float time) const;
+
+	// Closest hit of a world space ray with the object's LOD 0 triangles, disabled objects are never hit
+	// hitDistance is the ray parameter of the hit (world units when direction is normalized)
+	bool RayCast(XMFLOAT3 origin, XMFLOAT3 direction, float time, float maxDistance, float& hitDistance) const;
+
+	// Result of the last Render call's meshlet culling, for the culling stats in IMGUI
+	const MeshletCuller::CullStats& GetMeshletCullStats() const { return m_MeshletCullStats; }
+	// LOD picked by the last Render call
+	int GetCurrentLOD() const { return m_CurrentLOD; }
+
 	void SetEnabled(bool state) { mb_IsEnabled = state; }
 	bool GetEnabled() const { return mb_IsEnabled; }
 
@@ -95,9 +114,14 @@ public:
 	void SetModel(std::string_view name, Model* newModel) {
 		m_GameObjectData.modelName = name;
 		m_ModelInstance = newModel;
+		m_CurrentLOD = 0;
 	}
 	std::string_view GetModelName() const { return m_GameObjectData.modelName; }
 
+	const GameObjectData& GetGameObjectData() const { return m_GameObjectData; }
+	Model* GetModel() const { return m_ModelInstance; }
+	const std::vector<Texture*>& GetMaterialTextures() const { return m_MaterialTextures; }
+
 private:
 	// Argument could be made that this should be a public variable
 	GameObjectData m_GameObjectData {};
@@ -107,6 +131,23 @@ private:
 	PBRShader* m_PBRShaderInstance {};
 	DepthShader* m_DepthShaderInstance {};
 
-	// Order of materialTextures array: albedoMap, normalMap, metallicMap, roughnessMap, aoMap, heightMap
+	// Order of materialTextures array: albedoMap, normalMap, packedMap (ao, roughness, metallic, height in r, g, b, a)
 	std::vector<Texture*> m_MaterialTextures {};
+
+	// Per object since models are shared between game objects, reused every frame to avoid allocations
+	std::vector<MeshletCuller::DrawRange> m_MeshletDrawRanges {};
+	MeshletCuller::CullStats m_MeshletCullStats {};
+
+	// Index into the model's LODs, also drawn by the depth pass (which has no view camera to pick its own)
+	int m_CurrentLOD {};
+
+	int SelectLOD(XMMATRIX projectionMatrix, float viewportHeight, XMMATRIX worldMatrix, Camera* camera) const;
+	// Finest mip each material texture needs at the object's projected texel density (see Texture::RequestMip)
+	void RequestTextureMips(XMMATRIX projectionMatrix, float viewportHeight, XMMATRIX worldMatrix, Camera* camera) const;
+	// Pixels per world unit at the closest point of the object's bounding sphere, FLT_MAX when the camera is inside it
+	float GetPixelsPerUnit(XMMATRIX projectionMatrix, float viewportHeight, XMMATRIX worldMatrix, Camera* camera) const;
+
+	// Model bounds transformed by worldMatrix, including the vertex displacement
+	void GetWorldBoundingSphere(XMMATRIX worldMatrix, XMFLOAT3& center, float& radius) const;
+	bool CheckBoundsInFrustum(XMMATRIX worldMatrix, Camera* camera) const;
 };
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "GeometryArena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+	// First buffer sizes in vertices / indices, pools double from there when a mesh does not fit
+	constexpr uint32_t s_MinPoolCapacities[GeometryArena::Num_Pools] {1 << 16, 1 << 18, 1 << 18};
+	// D3D11 buffer sizes are 32 bit, the driver may still refuse buffers well below this
+	constexpr uint64_t s_MaxPoolBufferSize = 1ull << 31;
+
+	// Pools whose largest free region holds less than this share of their free space are compacted
+	constexpr float s_MaxFragmentation = 0.5f;
+}
+
+void GeometryArena::Initialize(VertexFormat vertexFormat) {
+	m_VertexFormat = vertexFormat;
+
+	PoolBuffers& vertexPool = m_Pools[kVertexPool];
+	vertexPool.bufferCount = Num_VertexStreams;
+	for(int i = 0; i < Num_VertexStreams; i++) {
+		vertexPool.strides[i] = GetVertexStreamStride(vertexFormat, (VertexStream)i);
+	}
+	vertexPool.bindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+	m_Pools[kIndex16Pool].bufferCount = 1;
+	m_Pools[kIndex16Pool].strides[0] = sizeof(uint16_t);
+	m_Pools[kIndex16Pool].bindFlags = D3D11_BIND_INDEX_BUFFER;
+
+	m_Pools[kIndex32Pool].bufferCount = 1;
+	m_Pools[kIndex32Pool].strides[0] = sizeof(uint32_t);
+	m_Pools[kIndex32Pool].bindFlags = D3D11_BIND_INDEX_BUFFER;
+
+	for(PoolBuffers& poolBuffers : m_Pools) {
+		poolBuffers.allocator.Reset(0);
+	}
+}
+
+void GeometryArena::Shutdown() {
+	std::lock_guard<std::mutex> lock {m_Mutex};
+	for(PoolBuffers& poolBuffers : m_Pools) {
+		ReleasePoolBuffers(poolBuffers);
+		poolBuffers.allocator.Reset(0);
+		poolBuffers.capacity = 0;
+	}
+	m_Entries.clear();
+	m_FreeHandles.clear();
+	m_PendingHandles.clear();
+}
+
+GeometryArena::Handle GeometryArena::Add(const void* const (&vertexStreams)[Num_VertexStreams], uint32_t vertexCount, const void* indices, uint32_t indexCount, uint32_t indexStride) {
+	if(vertexCount == 0 || indexCount == 0 || (indexStride != sizeof(uint16_t) && indexStride != sizeof(uint32_t))) {
+		return kInvalidHandle;
+	}
+
+	// Copied outside the lock, this is the bulk of the work
+	Entry entry {};
+	entry.vertexCount = vertexCount;
+	entry.indexCount = indexCount;
+	entry.indexStride = indexStride;
+	entry.isUsed = true;
+	for(int i = 0; i < Num_VertexStreams; i++) {
+		const unsigned char* streamData = (const unsigned char*)vertexStreams[i];
+		entry.pendingVertexStreams[i].assign(streamData, streamData + (size_t)m_Pools[kVertexPool].strides[i] * vertexCount);
+	}
+	entry.pendingIndices.assign((const unsigned char*)indices, (const unsigned char*)indices + (size_t)indexStride * indexCount);
+
+	std::lock_guard<std::mutex> lock {m_Mutex};
+	Handle handle {};
+	if(!m_FreeHandles.empty()) {
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+		m_Entries[handle] = std::move(entry);
+	}
+	else {
+		handle = (Handle)m_Entries.size();
+		m_Entries.push_back(std::move(entry));
+	}
+	m_PendingHandles.push_back(handle);
+	return handle;
+}
+
+void GeometryArena::Remove(Handle handle) {
+	std::lock_guard<std::mutex> lock {m_Mutex};
+	if(handle >= m_Entries.size() || !m_Entries[handle].isUsed) {
+		return;
+	}
+
+	Entry& entry = m_Entries[handle];
+	for(int i = 0; i < Num_Pools; i++) {
+		Pool pool = (Pool)i;
+		if(IsInPool(entry, pool) && GetAllocation(entry, pool).offset != OffsetAllocator::kNoSpace) {
+			m_Pools[pool].allocator.Free(GetAllocation(entry, pool));
+			m_Pools[pool].hasFreed = true;
+		}
+	}
+
+	entry = Entry {};
+	m_FreeHandles.push_back(handle);
+}
+
+bool GeometryArena::Flush(ID3D11Device* device, ID3D11DeviceContext* deviceContext) {
+	std::lock_guard<std::mutex> lock {m_Mutex};
+	m_BoundIndexStride = 0;
+	m_BoundStreamCount = 0;
+
+	/// Placement
+	for(int i = 0; i < Num_Pools; i++) {
+		Pool pool = (Pool)i;
+		PoolBuffers& poolBuffers = m_Pools[pool];
+
+		// Freed ranges merge with their free neighbours, but live ranges in between can still leave the free space in pieces too small to use
+		bool b_NeedsCompaction = false;
+		if(poolBuffers.hasFreed) {
+			OffsetAllocator::StorageReport storage = poolBuffers.allocator.GetStorageReport();
+			b_NeedsCompaction = storage.freeRegionCount > 1 && OffsetAllocator::GetFragmentation(storage) > s_MaxFragmentation;
+			poolBuffers.hasFreed = false;
+		}
+
+		// Pending meshes go into free ranges until one does not fit, compaction places the rest
+		for(size_t j = 0; j < m_PendingHandles.size() && !b_NeedsCompaction; j++) {
+			Entry& entry = m_Entries[m_PendingHandles[j]];
+			if(!entry.isUsed || entry.isResident || !IsInPool(entry, pool) || GetAllocation(entry, pool).offset != OffsetAllocator::kNoSpace) {
+				continue;
+			}
+			GetAllocation(entry, pool) = poolBuffers.allocator.Allocate(GetAllocationSize(entry, pool));
+			b_NeedsCompaction = GetAllocation(entry, pool).offset == OffsetAllocator::kNoSpace;
+		}
+
+		if(b_NeedsCompaction && !CompactPool(device, deviceContext, pool)) {
+			std::cout << "GeometryArena: could not grow pool " << i << " to fit " << m_PendingHandles.size() << " pending meshes\n";
+			return false;
+		}
+	}
+
+	/// Upload
+	for(Handle handle : m_PendingHandles) {
+		Entry& entry = m_Entries[handle];
+		if(!entry.isUsed || entry.isResident) {
+			continue;
+		}
+
+		const PoolBuffers& vertexPool = m_Pools[kVertexPool];
+		for(int i = 0; i < Num_VertexStreams; i++) {
+			D3D11_BOX destinationBox {};
+			destinationBox.left = entry.vertexAllocation.offset * vertexPool.strides[i];
+			destinationBox.right = destinationBox.left + entry.vertexCount * vertexPool.strides[i];
+			destinationBox.bottom = 1;
+			destinationBox.back = 1;
+			deviceContext->UpdateSubresource(vertexPool.buffers[i], 0, &destinationBox, entry.pendingVertexStreams[i].data(), 0, 0);
+			std::vector<unsigned char>().swap(entry.pendingVertexStreams[i]);
+		}
+
+		const PoolBuffers& indexPool = m_Pools[GetIndexPool(entry.indexStride)];
+		D3D11_BOX destinationBox {};
+		destinationBox.left = entry.indexAllocation.offset * entry.indexStride;
+		destinationBox.right = destinationBox.left + entry.indexCount * entry.indexStride;
+		destinationBox.bottom = 1;
+		destinationBox.back = 1;
+		deviceContext->UpdateSubresource(indexPool.buffers[0], 0, &destinationBox, entry.pendingIndices.data(), 0, 0);
+		std::vector<unsigned char>().swap(entry.pendingIndices);
+
+		entry.isResident = true;
+	}
+	m_PendingHandles.clear();
+
+	return true;
+}
+
+GeometryArena::Range GeometryArena::GetRange(Handle handle) const {
+	std::lock_guard<std::mutex> lock {m_Mutex};
+	Range range {};
+	if(handle < m_Entries.size() && m_Entries[handle].isUsed) {
+		const Entry& entry = m_Entries[handle];
+		range.baseVertex = entry.vertexAllocation.offset;
+		range.firstIndex = entry.indexAllocation.offset;
+		range.indexStride = entry.indexStride;
+		range.isResident = entry.isResident;
+	}
+	return range;
+}
+
+void GeometryArena::Bind(ID3D11DeviceContext* deviceContext, uint32_t indexStride, bool isDepthOnly) {
+	// The depth pass only reads the geometry stream, a bound tangent stream does not hurt it
+	unsigned int streamCount = isDepthOnly ? 1 : Num_VertexStreams;
+	if(streamCount > m_BoundStreamCount) {
+		const PoolBuffers& vertexPool = m_Pools[kVertexPool];
+		unsigned int offsets[Num_VertexStreams] {};
+		deviceContext->IASetVertexBuffers(0, streamCount, vertexPool.buffers, vertexPool.strides, offsets);
+		m_BoundStreamCount = streamCount;
+	}
+
+	if(indexStride != m_BoundIndexStride) {
+		DXGI_FORMAT indexFormat = indexStride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		deviceContext->IASetIndexBuffer(m_Pools[GetIndexPool(indexStride)].buffers[0], indexFormat, 0);
+		m_BoundIndexStride = indexStride;
+	}
+}
+
+GeometryArena::ArenaStats GeometryArena::GetStats() const {
+	std::lock_guard<std::mutex> lock {m_Mutex};
+	ArenaStats stats {};
+	for(int i = 0; i < Num_Pools; i++) {
+		const PoolBuffers& poolBuffers = m_Pools[i];
+		stats.pools[i].capacity = poolBuffers.capacity;
+		for(int j = 0; j < poolBuffers.bufferCount; j++) {
+			stats.pools[i].byteSize += poolBuffers.capacity * poolBuffers.strides[j];
+		}
+		stats.pools[i].storage = poolBuffers.allocator.GetStorageReport();
+	}
+	stats.compactionCount = m_CompactionCount;
+	return stats;
+}
+
+bool GeometryArena::CompactPool(ID3D11Device* device, ID3D11DeviceContext* deviceContext, Pool pool) {
+	PoolBuffers& poolBuffers = m_Pools[pool];
+
+	// Resident ranges keep their address order, pending ones go after them
+	std::vector<Handle> handles {};
+	uint64_t requiredCapacity = 0;
+	for(Handle handle = 0; handle < (Handle)m_Entries.size(); handle++) {
+		const Entry& entry = m_Entries[handle];
+		if(entry.isUsed && IsInPool(entry, pool)) {
+			handles.push_back(handle);
+			requiredCapacity += GetAllocationSize(entry, pool);
+		}
+	}
+	std::sort(handles.begin(), handles.end(), [&](Handle a, Handle b) {
+		uint32_t offsetA = m_Entries[a].isResident ? GetAllocation(m_Entries[a], pool).offset : UINT32_MAX;
+		uint32_t offsetB = m_Entries[b].isResident ? GetAllocation(m_Entries[b], pool).offset : UINT32_MAX;
+		return offsetA != offsetB ? offsetA < offsetB : a < b;
+	});
+
+	uint32_t maxStride = *std::max_element(poolBuffers.strides, poolBuffers.strides + poolBuffers.bufferCount);
+	uint64_t maxCapacity = s_MaxPoolBufferSize / maxStride;
+	uint64_t capacity = std::max(poolBuffers.capacity, s_MinPoolCapacities[pool]);
+	while(capacity < requiredCapacity) {
+		capacity *= 2;
+	}
+
+	// Ranges allocated one after another from an empty allocator are packed back to back
+	// Note: the last one can still fail when the space left is in a lower size bin than the request (see OffsetAllocator::Allocate), the capacity is doubled then
+	OffsetAllocator allocator {};
+	std::vector<OffsetAllocator::Allocation> allocations(handles.size());
+	for(;;) {
+		if(capacity > maxCapacity) {
+			return false;
+		}
+		allocator.Reset((uint32_t)capacity);
+		bool b_AllPlaced = true;
+		for(size_t i = 0; i < handles.size() && b_AllPlaced; i++) {
+			allocations[i] = allocator.Allocate(GetAllocationSize(m_Entries[handles[i]], pool));
+			b_AllPlaced = allocations[i].offset != OffsetAllocator::kNoSpace;
+		}
+		if(b_AllPlaced) {
+			break;
+		}
+		capacity *= 2;
+	}
+
+	// Resident ranges are copied on the GPU, pending ones are uploaded by Flush afterwards
+	ID3D11Buffer* buffers[Num_VertexStreams] {};
+	if(!CreatePoolBuffers(device, poolBuffers, (uint32_t)capacity, buffers)) {
+		return false;
+	}
+	for(size_t i = 0; i < handles.size(); i++) {
+		Entry& entry = m_Entries[handles[i]];
+		if(entry.isResident) {
+			uint32_t sourceOffset = GetAllocation(entry, pool).offset;
+			uint32_t size = GetAllocationSize(entry, pool);
+			for(int j = 0; j < poolBuffers.bufferCount; j++) {
+				D3D11_BOX sourceBox {};
+				sourceBox.left = sourceOffset * poolBuffers.strides[j];
+				sourceBox.right = sourceBox.left + size * poolBuffers.strides[j];
+				sourceBox.bottom = 1;
+				sourceBox.back = 1;
+				deviceContext->CopySubresourceRegion(buffers[j], 0, allocations[i].offset * poolBuffers.strides[j], 0, 0, poolBuffers.buffers[j], 0, &sourceBox);
+			}
+		}
+		GetAllocation(entry, pool) = allocations[i];
+	}
+
+	ReleasePoolBuffers(poolBuffers);
+	std::copy(buffers, buffers + Num_VertexStreams, poolBuffers.buffers);
+	poolBuffers.allocator = std::move(allocator);
+	poolBuffers.capacity = (uint32_t)capacity;
+	m_CompactionCount++;
+
+	return true;
+}
+
+bool GeometryArena::CreatePoolBuffers(ID3D11Device* device, const PoolBuffers& poolBuffers, uint32_t capacity, ID3D11Buffer* (&buffers)[Num_VertexStreams]) const {
+	for(int i = 0; i < poolBuffers.bufferCount; i++) {
+		D3D11_BUFFER_DESC bufferDesc {};
+		bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		bufferDesc.ByteWidth = capacity * poolBuffers.strides[i];
+		bufferDesc.BindFlags = poolBuffers.bindFlags;
+		bufferDesc.CPUAccessFlags = 0;
+		bufferDesc.MiscFlags = 0;
+		bufferDesc.StructureByteStride = 0;
+
+		HRESULT result = device->CreateBuffer(&bufferDesc, nullptr, &buffers[i]);
+		if(FAILED(result)) {
+			for(int j = 0; j < i; j++) {
+				buffers[j]->Release();
+				buffers[j] = nullptr;
+			}
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void GeometryArena::ReleasePoolBuffers(PoolBuffers& poolBuffers) {
+	for(ID3D11Buffer*& buffer : poolBuffers.buffers) {
+		if(buffer) {
+			buffer->Release();
+			buffer = nullptr;
+		}
+	}
+}
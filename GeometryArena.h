@@ -0,0 +1,126 @@
+#pragma once
+#include <d3d11.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "MeshData.h"
+#include "OffsetAllocator.h"
+
+// Shared vertex and index buffers that every mesh is sub-allocated from (see OffsetAllocator), so consecutive draws of different models keep the same IA buffers bound
+// One buffer per VertexStream, indexed in vertices, and one index buffer per index stride (16 and 32 bit), indexed in indices
+// Meshes draw with their range's base vertex and first index (see Range), index values stay relative to the mesh
+// Add copies the data and is thread safe (models are loaded on worker threads), the GPU side is only touched by Flush on the main thread
+// Flush grows a pool by compacting it into a larger buffer when a mesh does not fit, and compacts it in place when freed ranges leave it too fragmented
+class GeometryArena {
+public:
+	using Handle = uint32_t;
+	static constexpr Handle kInvalidHandle = UINT32_MAX;
+
+	// Where a mesh lives in the shared buffers, offsets can change with every Flush (compaction), so they are looked up per draw
+	struct Range {
+		uint32_t baseVertex;
+		uint32_t firstIndex;
+		uint32_t indexStride;
+		// False until the Flush after Add, nothing may be drawn from the range before that
+		bool isResident;
+	};
+
+	enum Pool {
+		kVertexPool,
+		kIndex16Pool,
+		kIndex32Pool,
+		Num_Pools
+	};
+
+	struct PoolStats {
+		// In vertices or indices
+		uint32_t capacity;
+		uint32_t byteSize;
+		OffsetAllocator::StorageReport storage;
+	};
+
+	struct ArenaStats {
+		PoolStats pools[Num_Pools];
+		int compactionCount;
+	};
+
+public:
+	GeometryArena() {}
+	GeometryArena(const GeometryArena&) {}
+	~GeometryArena() {}
+
+	// Buffers are created by the first Flush, sized to what was added by then
+	void Initialize(VertexFormat vertexFormat);
+	void Shutdown();
+
+	// vertexStreams in the arena's vertex format (see SplitVertexStreams), indexStride is 2 or 4 bytes
+	Handle Add(const void* const (&vertexStreams)[Num_VertexStreams], uint32_t vertexCount, const void* indices, uint32_t indexCount, uint32_t indexStride);
+	void Remove(Handle handle);
+
+	// Places and uploads everything added since the last call, compacting pools as needed
+	// Also forgets what Bind last set, call it at the start of every pass that draws from the arena
+	bool Flush(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
+
+	Range GetRange(Handle handle) const;
+	// Sets the IA vertex and index buffers, skipped when the same buffers are still bound since the last Flush
+	// isDepthOnly binds the geometry stream only (see VertexStream)
+	void Bind(ID3D11DeviceContext* deviceContext, uint32_t indexStride, bool isDepthOnly);
+
+	VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+	ArenaStats GetStats() const;
+
+private:
+	struct Entry {
+		OffsetAllocator::Allocation vertexAllocation {};
+		OffsetAllocator::Allocation indexAllocation {};
+		uint32_t vertexCount {};
+		uint32_t indexCount {};
+		uint32_t indexStride {};
+		bool isUsed {};
+		bool isResident {};
+
+		// CPU copy until Flush uploads it
+		std::vector<unsigned char> pendingVertexStreams[Num_VertexStreams] {};
+		std::vector<unsigned char> pendingIndices {};
+	};
+
+	struct PoolBuffers {
+		OffsetAllocator allocator {};
+		uint32_t capacity {};
+		// Bytes per vertex or index, one per buffer (only the vertex pool has more than one buffer)
+		uint32_t strides[Num_VertexStreams] {};
+		int bufferCount {};
+		ID3D11Buffer* buffers[Num_VertexStreams] {};
+		UINT bindFlags {};
+		// Set by Remove, fragmentation is only checked after something was freed
+		bool hasFreed {};
+	};
+
+	static Pool GetIndexPool(uint32_t indexStride) { return indexStride == sizeof(uint16_t) ? kIndex16Pool : kIndex32Pool; }
+	bool IsInPool(const Entry& entry, Pool pool) const { return pool == kVertexPool || pool == GetIndexPool(entry.indexStride); }
+	static OffsetAllocator::Allocation& GetAllocation(Entry& entry, Pool pool) { return pool == kVertexPool ? entry.vertexAllocation : entry.indexAllocation; }
+	static uint32_t GetAllocationSize(const Entry& entry, Pool pool) { return pool == kVertexPool ? entry.vertexCount : entry.indexCount; }
+
+	// Moves every live range of the pool to the front of new buffers (grown if needed) and places the pending ones after them
+	bool CompactPool(ID3D11Device* device, ID3D11DeviceContext* deviceContext, Pool pool);
+	bool CreatePoolBuffers(ID3D11Device* device, const PoolBuffers& poolBuffers, uint32_t capacity, ID3D11Buffer* (&buffers)[Num_VertexStreams]) const;
+	static void ReleasePoolBuffers(PoolBuffers& poolBuffers);
+
+private:
+	VertexFormat m_VertexFormat {kFullVertexFormat};
+	PoolBuffers m_Pools[Num_Pools] {};
+
+	std::vector<Entry> m_Entries {};
+	std::vector<Handle> m_FreeHandles {};
+	// Added since the last Flush, may contain removed or duplicate handles
+	std::vector<Handle> m_PendingHandles {};
+	int m_CompactionCount {};
+
+	// Note: Add and Remove come from loader threads, GetRange reads m_Entries during rendering
+	mutable std::mutex m_Mutex {};
+
+	// What Bind last set, reset by Flush
+	uint32_t m_BoundIndexStride {};
+	unsigned int m_BoundStreamCount {};
+};
@@ -0,0 +1,674 @@
+#include "GltfImporter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string_view>
+
+namespace {
+	// Bytes read from a buffer at a time
+	constexpr size_t s_StreamChunkSize = 1024 * 1024;
+
+	enum ComponentType {
+		kByteComponent          = 5120,
+		kUnsignedByteComponent  = 5121,
+		kShortComponent         = 5122,
+		kUnsignedShortComponent = 5123,
+		kUnsignedIntComponent   = 5125,
+		kFloatComponent         = 5126,
+	};
+
+	constexpr int s_TrianglesMode = 4;
+	constexpr int s_InvalidId = -1;
+
+	// Binary glTF (.glb) files start with this magic ("glTF" in little endian)
+	constexpr uint32_t s_BinaryGltfMagic = 0x46546C67;
+
+	// Node transform components closer than this to the identity count as no transform
+	constexpr double s_IdentityTolerance = 1e-6;
+
+	struct Buffer {
+		std::string uri {};
+		uint64_t byteLength {};
+	};
+
+	struct BufferView {
+		int buffer {s_InvalidId};
+		uint64_t byteOffset {};
+		uint64_t byteLength {};
+		uint32_t byteStride {};
+	};
+
+	struct Accessor {
+		int bufferView {s_InvalidId};
+		uint64_t byteOffset {};
+		int componentType {};
+		bool normalized {};
+		uint32_t count {};
+		int componentCount {};
+		bool sparse {};
+	};
+
+	struct Node {
+		std::string name {};
+		int mesh {s_InvalidId};
+		std::vector<int> children {};
+		bool hasTransform {};
+	};
+
+	struct Primitive {
+		std::string name {};
+		int position {s_InvalidId};
+		int normal {s_InvalidId};
+		int textureCoord {s_InvalidId};
+		int indices {s_InvalidId};
+		int mode {s_TrianglesMode};
+	};
+
+	// Pull parser over JSON text, the caller walks the structure and reads values straight into its own structs
+	// Objects: BeginObject, then NextKey until it returns false, every value must be read or skipped. Arrays work the same with NextElement
+	// Any error moves to the end of the text, so all loops terminate and Failed() reports it
+	class JsonReader {
+	public:
+		JsonReader(const char* begin, const char* end) : m_Current(begin), m_End(end) {}
+
+		bool Failed() const { return mb_Failed; }
+
+		bool BeginObject() { return Expect('{'); }
+		bool BeginArray() { return Expect('['); }
+
+		bool NextKey(std::string& key) {
+			if(!NextItem('}')) {
+				return false;
+			}
+			return ReadString(key) && Expect(':');
+		}
+
+		bool NextElement() { return NextItem(']'); }
+
+		bool ReadString(std::string& value) {
+			if(!Expect('"')) {
+				return false;
+			}
+
+			value.clear();
+			while(m_Current != m_End && *m_Current != '"') {
+				char character = *m_Current++;
+				if(character == '\\' && m_Current != m_End) {
+					char escaped = *m_Current++;
+					switch(escaped) {
+					case 'n': character = '\n'; break;
+					case 't': character = '\t'; break;
+					case 'r': character = '\r'; break;
+					case 'b': character = '\b'; break;
+					case 'f': character = '\f'; break;
+					case 'u':
+						// Only needed for names, non ASCII code points are replaced
+						m_Current += std::min<ptrdiff_t>(4, m_End - m_Current);
+						character = '?';
+						break;
+					default: character = escaped; break;
+					}
+				}
+				value.push_back(character);
+			}
+			return Expect('"');
+		}
+
+		bool ReadNumber(double& value) {
+			SkipWhitespace();
+			std::from_chars_result result = std::from_chars(m_Current, m_End, value);
+			if(result.ec != std::errc()) {
+				return Fail();
+			}
+			m_Current = result.ptr;
+			return true;
+		}
+
+		template<typename T>
+		bool ReadInteger(T& value) {
+			double number {};
+			if(!ReadNumber(number) || number < 0.0) {
+				return Fail();
+			}
+			value = (T)number;
+			return true;
+		}
+
+		bool ReadBool(bool& value) {
+			SkipWhitespace();
+			if(m_End - m_Current >= 4 && std::memcmp(m_Current, "true", 4) == 0) {
+				m_Current += 4;
+				value = true;
+				return true;
+			}
+			if(m_End - m_Current >= 5 && std::memcmp(m_Current, "false", 5) == 0) {
+				m_Current += 5;
+				value = false;
+				return true;
+			}
+			return Fail();
+		}
+
+		void Skip() {
+			SkipWhitespace();
+			if(m_Current == m_End) {
+				Fail();
+				return;
+			}
+
+			std::string key {};
+			switch(*m_Current) {
+			case '{':
+				BeginObject();
+				while(NextKey(key)) {
+					Skip();
+				}
+				break;
+			case '[':
+				BeginArray();
+				while(NextElement()) {
+					Skip();
+				}
+				break;
+			case '"':
+				ReadString(key);
+				break;
+			default:
+				// Number, true, false or null
+				while(m_Current != m_End && !std::strchr(",}] \t\r\n", *m_Current)) {
+					m_Current++;
+				}
+				break;
+			}
+		}
+
+	private:
+		void SkipWhitespace() {
+			while(m_Current != m_End && (*m_Current == ' ' || *m_Current == '\t' || *m_Current == '\r' || *m_Current == '\n')) {
+				m_Current++;
+			}
+		}
+
+		bool Expect(char character) {
+			SkipWhitespace();
+			if(m_Current == m_End || *m_Current != character) {
+				return Fail();
+			}
+			m_Current++;
+			return true;
+		}
+
+		// Consumes the separator before the next item, false at the closing character
+		bool NextItem(char closing) {
+			SkipWhitespace();
+			if(m_Current == m_End) {
+				return Fail();
+			}
+			if(*m_Current == closing) {
+				m_Current++;
+				return false;
+			}
+			if(*m_Current == ',') {
+				m_Current++;
+			}
+			return true;
+		}
+
+		bool Fail() {
+			mb_Failed = true;
+			m_Current = m_End;
+			return false;
+		}
+
+	private:
+		const char* m_Current {};
+		const char* m_End {};
+		bool mb_Failed {};
+	};
+
+	int GetComponentSize(int componentType) {
+		switch(componentType) {
+		case kByteComponent:
+		case kUnsignedByteComponent: return 1;
+		case kShortComponent:
+		case kUnsignedShortComponent: return 2;
+		case kUnsignedIntComponent:
+		case kFloatComponent: return 4;
+		default: return 0;
+		}
+	}
+
+	int GetComponentCount(const std::string& type) {
+		if(type == "SCALAR") return 1;
+		if(type == "VEC2") return 2;
+		if(type == "VEC3") return 3;
+		if(type == "VEC4") return 4;
+		return 0;
+	}
+
+	// Float value of one component, normalized integers map to [0, 1] / [-1, 1]
+	float DecodeFloat(const unsigned char* data, int componentType, bool normalized) {
+		switch(componentType) {
+		case kFloatComponent: { float value; std::memcpy(&value, data, 4); return value; }
+		case kUnsignedByteComponent: return normalized ? data[0] / 255.0f : (float)data[0];
+		case kByteComponent: { int8_t value = (int8_t)data[0]; return normalized ? std::max(value / 127.0f, -1.0f) : (float)value; }
+		case kUnsignedShortComponent: { uint16_t value; std::memcpy(&value, data, 2); return normalized ? value / 65535.0f : (float)value; }
+		case kShortComponent: { int16_t value; std::memcpy(&value, data, 2); return normalized ? std::max(value / 32767.0f, -1.0f) : (float)value; }
+		default: return 0.0f;
+		}
+	}
+
+	uint32_t DecodeIndex(const unsigned char* data, int componentType) {
+		switch(componentType) {
+		case kUnsignedByteComponent: return data[0];
+		case kUnsignedShortComponent: { uint16_t value; std::memcpy(&value, data, 2); return value; }
+		case kUnsignedIntComponent: { uint32_t value; std::memcpy(&value, data, 4); return value; }
+		default: return UINT32_MAX;
+		}
+	}
+
+	/// Parsing of the top level arrays we use
+	void ParseBuffers(JsonReader& reader, std::vector<Buffer>& buffers) {
+		std::string key {};
+		reader.BeginArray();
+		while(reader.NextElement()) {
+			Buffer& buffer = buffers.emplace_back();
+			reader.BeginObject();
+			while(reader.NextKey(key)) {
+				if(key == "uri") reader.ReadString(buffer.uri);
+				else if(key == "byteLength") reader.ReadInteger(buffer.byteLength);
+				else reader.Skip();
+			}
+		}
+	}
+
+	void ParseBufferViews(JsonReader& reader, std::vector<BufferView>& bufferViews) {
+		std::string key {};
+		reader.BeginArray();
+		while(reader.NextElement()) {
+			BufferView& bufferView = bufferViews.emplace_back();
+			reader.BeginObject();
+			while(reader.NextKey(key)) {
+				if(key == "buffer") reader.ReadInteger(bufferView.buffer);
+				else if(key == "byteOffset") reader.ReadInteger(bufferView.byteOffset);
+				else if(key == "byteLength") reader.ReadInteger(bufferView.byteLength);
+				else if(key == "byteStride") reader.ReadInteger(bufferView.byteStride);
+				else reader.Skip();
+			}
+		}
+	}
+
+	void ParseAccessors(JsonReader& reader, std::vector<Accessor>& accessors) {
+		std::string key {};
+		std::string type {};
+		reader.BeginArray();
+		while(reader.NextElement()) {
+			Accessor& accessor = accessors.emplace_back();
+			reader.BeginObject();
+			while(reader.NextKey(key)) {
+				if(key == "bufferView") reader.ReadInteger(accessor.bufferView);
+				else if(key == "byteOffset") reader.ReadInteger(accessor.byteOffset);
+				else if(key == "componentType") reader.ReadInteger(accessor.componentType);
+				else if(key == "normalized") reader.ReadBool(accessor.normalized);
+				else if(key == "count") reader.ReadInteger(accessor.count);
+				else if(key == "type") {
+					reader.ReadString(type);
+					accessor.componentCount = GetComponentCount(type);
+				}
+				else if(key == "sparse") {
+					accessor.sparse = true;
+					reader.Skip();
+				}
+				else reader.Skip();
+			}
+		}
+	}
+
+	// True if the number array holds anything but identityValues, i.e. a transform component that is not the default
+	bool ParseTransformComponent(JsonReader& reader, const std::vector<double>& identityValues) {
+		bool b_IsIdentity = true;
+		size_t index = 0;
+		reader.BeginArray();
+		while(reader.NextElement()) {
+			double value {};
+			reader.ReadNumber(value);
+			b_IsIdentity &= index < identityValues.size() && std::abs(value - identityValues[index]) <= s_IdentityTolerance;
+			index++;
+		}
+		return !b_IsIdentity || index != identityValues.size();
+	}
+
+	void ParseNodes(JsonReader& reader, std::vector<Node>& nodes) {
+		static const std::vector<double> s_IdentityMatrix {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+		std::string key {};
+		reader.BeginArray();
+		while(reader.NextElement()) {
+			Node& node = nodes.emplace_back();
+			reader.BeginObject();
+			while(reader.NextKey(key)) {
+				if(key == "name") reader.ReadString(node.name);
+				else if(key == "mesh") reader.ReadInteger(node.mesh);
+				else if(key == "children") {
+					reader.BeginArray();
+					while(reader.NextElement()) {
+						reader.ReadInteger(node.children.emplace_back());
+					}
+				}
+				else if(key == "matrix") node.hasTransform |= ParseTransformComponent(reader, s_IdentityMatrix);
+				else if(key == "translation") node.hasTransform |= ParseTransformComponent(reader, {0, 0, 0});
+				else if(key == "rotation") node.hasTransform |= ParseTransformComponent(reader, {0, 0, 0, 1});
+				else if(key == "scale") node.hasTransform |= ParseTransformComponent(reader, {1, 1, 1});
+				else reader.Skip();
+			}
+		}
+	}
+
+	// Name of the first node with a transform that applies to a mesh (its own or an ancestor's), empty if there is none
+	std::string FindTransformedMeshNode(const std::vector<Node>& nodes) {
+		std::vector<int> parents(nodes.size(), s_InvalidId);
+		for(size_t i = 0; i < nodes.size(); i++) {
+			for(int child : nodes[i].children) {
+				if(child >= 0 && child < (int)nodes.size()) {
+					parents[child] = (int)i;
+				}
+			}
+		}
+
+		for(size_t i = 0; i < nodes.size(); i++) {
+			if(nodes[i].mesh == s_InvalidId) {
+				continue;
+			}
+			// Bounded by the node count, so a malformed file with a cycle cannot loop forever
+			int current = (int)i;
+			for(size_t depth = 0; current != s_InvalidId && depth < nodes.size(); depth++) {
+				if(nodes[current].hasTransform) {
+					return nodes[current].name.empty() ? "#" + std::to_string(current) : nodes[current].name;
+				}
+				current = parents[current];
+			}
+		}
+		return "";
+	}
+
+	void ParseMeshes(JsonReader& reader, std::vector<Primitive>& primitives) {
+		std::string key {};
+		std::string attributeKey {};
+		reader.BeginArray();
+		while(reader.NextElement()) {
+			std::string meshName {};
+			size_t firstPrimitive = primitives.size();
+
+			reader.BeginObject();
+			while(reader.NextKey(key)) {
+				if(key == "name") {
+					reader.ReadString(meshName);
+				}
+				else if(key == "primitives") {
+					reader.BeginArray();
+					while(reader.NextElement()) {
+						Primitive& primitive = primitives.emplace_back();
+						reader.BeginObject();
+						while(reader.NextKey(key)) {
+							if(key == "attributes") {
+								reader.BeginObject();
+								while(reader.NextKey(attributeKey)) {
+									if(attributeKey == "POSITION") reader.ReadInteger(primitive.position);
+									else if(attributeKey == "NORMAL") reader.ReadInteger(primitive.normal);
+									else if(attributeKey == "TEXCOORD_0") reader.ReadInteger(primitive.textureCoord);
+									else reader.Skip();
+								}
+							}
+							else if(key == "indices") reader.ReadInteger(primitive.indices);
+							else if(key == "mode") reader.ReadInteger(primitive.mode);
+							else reader.Skip();
+						}
+					}
+				}
+				else {
+					reader.Skip();
+				}
+			}
+
+			// The name may come after the primitives
+			for(size_t i = firstPrimitive; i < primitives.size(); i++) {
+				primitives[i].name = meshName + "[" + std::to_string(i - firstPrimitive) + "]";
+			}
+		}
+	}
+
+	/// Streams glTF buffers from disk, one open file per buffer
+	class BufferStreamer {
+	public:
+		BufferStreamer(const std::filesystem::path& directory, const std::vector<Buffer>& buffers, const std::vector<BufferView>& bufferViews, const std::vector<Accessor>& accessors)
+			: m_Directory(directory), m_Buffers(buffers), m_BufferViews(bufferViews), m_Accessors(accessors), m_Files(buffers.size()) {}
+
+		// Calls visitor(elementIndex, elementData) for every element of the accessor, reading at most s_StreamChunkSize bytes at a time
+		template<typename Visitor>
+		bool ReadAccessor(int accessorId, int expectedComponentCount, Visitor visitor) {
+			if(accessorId < 0 || accessorId >= (int)m_Accessors.size()) {
+				return false;
+			}
+			const Accessor& accessor = m_Accessors[accessorId];
+			if(accessor.sparse || accessor.componentCount != expectedComponentCount || accessor.bufferView < 0 || accessor.bufferView >= (int)m_BufferViews.size()) {
+				return false;
+			}
+			const BufferView& bufferView = m_BufferViews[accessor.bufferView];
+			if(bufferView.buffer < 0 || bufferView.buffer >= (int)m_Buffers.size()) {
+				return false;
+			}
+			const Buffer& buffer = m_Buffers[bufferView.buffer];
+
+			int componentSize = GetComponentSize(accessor.componentType);
+			uint64_t elementSize = (uint64_t)componentSize * accessor.componentCount;
+			uint64_t stride = bufferView.byteStride > 0 ? bufferView.byteStride : elementSize;
+			if(componentSize == 0 || stride < elementSize || accessor.count == 0) {
+				return accessor.count == 0 && componentSize != 0;
+			}
+
+			// The accessor must lie inside its view, and the view inside its buffer
+			uint64_t accessorSize = (accessor.count - 1) * stride + elementSize;
+			if(accessor.byteOffset + accessorSize > bufferView.byteLength || bufferView.byteOffset + bufferView.byteLength > buffer.byteLength) {
+				return false;
+			}
+
+			std::ifstream* file = OpenBuffer(bufferView.buffer);
+			if(!file) {
+				return false;
+			}
+
+			uint64_t accessorStart = bufferView.byteOffset + accessor.byteOffset;
+			uint32_t elementsPerChunk = (uint32_t)std::max<uint64_t>(1, s_StreamChunkSize / stride);
+			for(uint32_t firstElement = 0; firstElement < accessor.count; firstElement += elementsPerChunk) {
+				uint32_t chunkElementCount = std::min(elementsPerChunk, accessor.count - firstElement);
+				uint64_t chunkSize = (chunkElementCount - 1) * stride + elementSize;
+				m_Chunk.resize(chunkSize);
+
+				file->seekg((std::streamoff)(accessorStart + firstElement * stride));
+				file->read((char*)m_Chunk.data(), (std::streamsize)chunkSize);
+				if(file->fail()) {
+					return false;
+				}
+
+				for(uint32_t i = 0; i < chunkElementCount; i++) {
+					visitor(firstElement + i, m_Chunk.data() + i * stride);
+				}
+			}
+			return true;
+		}
+
+		// Invalid ids give an empty accessor, ReadAccessor then fails on it
+		const Accessor& GetAccessor(int accessorId) const {
+			static const Accessor s_EmptyAccessor {};
+			return accessorId >= 0 && accessorId < (int)m_Accessors.size() ? m_Accessors[accessorId] : s_EmptyAccessor;
+		}
+
+	private:
+		std::ifstream* OpenBuffer(int bufferId) {
+			std::unique_ptr<std::ifstream>& file = m_Files[bufferId];
+			if(!file) {
+				// Embedded (data:) buffers are not supported, they would have to be base64 decoded into memory
+				const std::string& uri = m_Buffers[bufferId].uri;
+				if(uri.empty() || uri.rfind("data:", 0) == 0) {
+					return nullptr;
+				}
+				file = std::make_unique<std::ifstream>(m_Directory / std::filesystem::u8path(uri), std::ios::binary);
+			}
+			return file->fail() ? nullptr : file.get();
+		}
+
+	private:
+		std::filesystem::path m_Directory {};
+		const std::vector<Buffer>& m_Buffers;
+		const std::vector<BufferView>& m_BufferViews;
+		const std::vector<Accessor>& m_Accessors;
+
+		std::vector<std::unique_ptr<std::ifstream>> m_Files {};
+		std::vector<unsigned char> m_Chunk {};
+	};
+}
+
+bool GltfImporter::Import(const std::string& filePath, MeshData& meshData, std::vector<std::string>& bufferFilePaths) {
+	meshData = MeshData {};
+	bufferFilePaths.clear();
+
+	/// JSON part: only the arrays describing mesh data are kept
+	std::string json {};
+	{
+		std::ifstream fin {filePath, std::ios::binary};
+		if(fin.fail()) {
+			return false;
+		}
+		json.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+	}
+
+	uint32_t magic {};
+	if(json.size() >= sizeof(magic)) {
+		std::memcpy(&magic, json.data(), sizeof(magic));
+	}
+	if(magic == s_BinaryGltfMagic) {
+		std::cout << filePath << ": binary glTF (.glb) is not supported, export as .gltf with external .bin buffers\n";
+		return false;
+	}
+
+	std::vector<Buffer> buffers {};
+	std::vector<BufferView> bufferViews {};
+	std::vector<Accessor> accessors {};
+	std::vector<Primitive> primitives {};
+	std::vector<Node> nodes {};
+
+	JsonReader reader {json.data(), json.data() + json.size()};
+	std::string key {};
+	reader.BeginObject();
+	while(reader.NextKey(key)) {
+		if(key == "buffers") ParseBuffers(reader, buffers);
+		else if(key == "bufferViews") ParseBufferViews(reader, bufferViews);
+		else if(key == "accessors") ParseAccessors(reader, accessors);
+		else if(key == "meshes") ParseMeshes(reader, primitives);
+		else if(key == "nodes") ParseNodes(reader, nodes);
+		else reader.Skip();
+	}
+	if(reader.Failed()) {
+		std::cout << filePath << ": invalid JSON\n";
+		return false;
+	}
+
+	// Meshes are imported in their own space, a transformed node would silently come out in the wrong place
+	std::string transformedNode = FindTransformedMeshNode(nodes);
+	if(!transformedNode.empty()) {
+		std::cout << filePath << ": node \"" << transformedNode << "\" has a transform, node transforms are not supported (apply them to the mesh data before exporting)\n";
+		return false;
+	}
+
+	// Embedded buffers are part of the .gltf itself
+	for(const Buffer& buffer : buffers) {
+		if(!buffer.uri.empty() && buffer.uri.rfind("data:", 0) != 0) {
+			bufferFilePaths.push_back(buffer.uri);
+		}
+	}
+
+	// The JSON text is no longer needed, free it before streaming the buffers
+	std::string().swap(json);
+
+	/// Buffer part: every triangle primitive is appended as a sub-mesh
+	BufferStreamer streamer {std::filesystem::u8path(filePath).parent_path(), buffers, bufferViews, accessors};
+	for(const Primitive& primitive : primitives) {
+		// Points, lines and strips are not used by the engine
+		if(primitive.mode != s_TrianglesMode || primitive.position == s_InvalidId) {
+			continue;
+		}
+
+		uint32_t firstVertex = (uint32_t)meshData.vertices.size();
+		uint32_t vertexCount = streamer.GetAccessor(primitive.position).count;
+		meshData.vertices.resize(firstVertex + vertexCount, MeshVertex {});
+		MeshVertex* vertices = meshData.vertices.data() + firstVertex;
+
+		const Accessor& positionAccessor = streamer.GetAccessor(primitive.position);
+		if(positionAccessor.componentType != kFloatComponent || !streamer.ReadAccessor(primitive.position, 3, [&](uint32_t i, const unsigned char* data) {
+			vertices[i].position = XMFLOAT3(DecodeFloat(data, kFloatComponent, false), DecodeFloat(data + 4, kFloatComponent, false), -DecodeFloat(data + 8, kFloatComponent, false));
+		})) {
+			return false;
+		}
+
+		if(primitive.normal != s_InvalidId) {
+			const Accessor& normalAccessor = streamer.GetAccessor(primitive.normal);
+			if(normalAccessor.count != vertexCount || normalAccessor.componentType != kFloatComponent || !streamer.ReadAccessor(primitive.normal, 3, [&](uint32_t i, const unsigned char* data) {
+				vertices[i].normal = XMFLOAT3(DecodeFloat(data, kFloatComponent, false), DecodeFloat(data + 4, kFloatComponent, false), -DecodeFloat(data + 8, kFloatComponent, false));
+			})) {
+				return false;
+			}
+		}
+
+		if(primitive.textureCoord != s_InvalidId) {
+			// glTF uvs already have their origin at the top left, like D3D
+			const Accessor& uvAccessor = streamer.GetAccessor(primitive.textureCoord);
+			int componentSize = GetComponentSize(uvAccessor.componentType);
+			if(uvAccessor.count != vertexCount || !streamer.ReadAccessor(primitive.textureCoord, 2, [&](uint32_t i, const unsigned char* data) {
+				vertices[i].texture = XMFLOAT2(DecodeFloat(data, uvAccessor.componentType, uvAccessor.normalized), DecodeFloat(data + componentSize, uvAccessor.componentType, uvAccessor.normalized));
+			})) {
+				return false;
+			}
+		}
+
+		// Source index buffer, non indexed primitives get sequential indices
+		SubMesh subMesh {primitive.name, (uint32_t)meshData.indices.size(), 0};
+		if(primitive.indices != s_InvalidId) {
+			const Accessor& indexAccessor = streamer.GetAccessor(primitive.indices);
+			bool b_IndicesValid = true;
+			meshData.indices.reserve(meshData.indices.size() + indexAccessor.count);
+			if(!streamer.ReadAccessor(primitive.indices, 1, [&](uint32_t, const unsigned char* data) {
+				uint32_t index = DecodeIndex(data, indexAccessor.componentType);
+				b_IndicesValid &= index < vertexCount;
+				meshData.indices.push_back(firstVertex + std::min(index, vertexCount - 1));
+			}) || !b_IndicesValid) {
+				return false;
+			}
+		}
+		else {
+			for(uint32_t i = 0; i < vertexCount; i++) {
+				meshData.indices.push_back(firstVertex + i);
+			}
+		}
+
+		size_t indexCount = meshData.indices.size() - subMesh.firstIndex;
+		if(indexCount % 3 != 0) {
+			return false;
+		}
+
+		// Reversed winding for the left handed clockwise convention
+		for(size_t i = subMesh.firstIndex; i < meshData.indices.size(); i += 3) {
+			std::swap(meshData.indices[i + 1], meshData.indices[i + 2]);
+		}
+
+		subMesh.indexCount = (uint32_t)indexCount;
+		meshData.subMeshes.push_back(subMesh);
+	}
+
+	return !meshData.indices.empty();
+}
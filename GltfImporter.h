@@ -0,0 +1,17 @@
+#pragma once
+#include "MeshData.h"
+
+#include <string>
+#include <vector>
+
+// glTF 2.0 reader (.gltf with external .bin buffers), output feeds the same cook pipeline as the text models
+// The JSON is read with a pull parser straight into the few fields we need (no document tree), buffers are streamed from disk in fixed size chunks
+// Converted to the engine's left handed, clockwise convention: z is mirrored and winding reversed
+class GltfImporter {
+public:
+	// Every triangle primitive of every mesh becomes one SubMesh, with its source index buffer kept
+	// Supports POSITION, NORMAL and TEXCOORD_0 (float or normalized integer uvs), 8/16/32 bit indices
+	// bufferFilePaths receives the external buffer files relative to filePath's directory, they are part of the mesh cache key (see MeshCache::Write)
+	// Fails with an error on binary glTF (.glb) and on meshes under a node transform: meshes are imported in their own space (the engine places models through GameObject)
+	static bool Import(const std::string& filePath, MeshData& meshData, std::vector<std::string>& bufferFilePaths);
+};
@@ -0,0 +1,304 @@
+#include "HDRDecoder.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <emmintrin.h>
+#if defined(__F16C__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+	// Fewer scanlines are decoded on a single thread, thread startup would cost more than the work
+	constexpr size_t s_MinRowsPerTask = 16;
+
+	// New style run length encoded scanlines start with 2, 2 and the width (big endian), every channel is then encoded on its own
+	// Older files and widths outside this range store plain 4 byte RGBE texels
+	constexpr int s_MinRLEWidth = 8;
+	constexpr int s_MaxRLEWidth = 0x7FFF;
+
+	constexpr float s_MaxHalf = 65504.0f;
+
+	// Calls function(begin, end) on subranges of [0, count), one task per thread at most
+	template<typename Function>
+	void ParallelFor(size_t count, size_t minCountPerTask, size_t maxTaskCount, const Function& function) {
+		size_t taskCount = std::clamp<size_t>(count / minCountPerTask, 1, maxTaskCount);
+		if(taskCount == 1) {
+			function(0, count);
+			return;
+		}
+
+		std::vector<std::future<void>> futures(taskCount);
+		for(size_t i = 0; i < taskCount; i++) {
+			futures[i] = std::async(std::launch::async, function, count * i / taskCount, count * (i + 1) / taskCount);
+		}
+		for(std::future<void>& future : futures) {
+			future.get();
+		}
+	}
+
+	// Next header line without its newline, false at the end of the file
+	bool ReadLine(const unsigned char*& data, const unsigned char* dataEnd, std::string_view& line) {
+		if(data >= dataEnd) {
+			return false;
+		}
+		const unsigned char* lineEnd = std::find(data, dataEnd, '\n');
+		line = std::string_view {(const char*)data, (size_t)(lineEnd - data)};
+		data = lineEnd == dataEnd ? dataEnd : lineEnd + 1;
+		return true;
+	}
+
+	// "-Y height +X width", the only orientation stb_image reads too (rows top to bottom, texels left to right)
+	bool ParseResolution(std::string_view line, int& width, int& height) {
+		std::string text {line};
+		const char* s = text.c_str();
+		if(strncmp(s, "-Y ", 3) != 0) {
+			return false;
+		}
+		char* end = nullptr;
+		long h = strtol(s + 3, &end, 10);
+		if(strncmp(end, " +X ", 4) != 0) {
+			return false;
+		}
+		long w = strtol(end + 4, &end, 10);
+		if(w <= 0 || h <= 0 || w > (1 << 24) || h > (1 << 24)) {
+			return false;
+		}
+		width = (int)w;
+		height = (int)h;
+		return true;
+	}
+
+	// Checks a run length encoded scanline and returns where the next one starts, null if it is broken
+	const unsigned char* SkipRLEScanline(const unsigned char* data, const unsigned char* dataEnd, int width) {
+		if(dataEnd - data < 4 || data[0] != 2 || data[1] != 2 || (data[2] << 8 | data[3]) != width) {
+			return nullptr;
+		}
+		data += 4;
+
+		for(int channel = 0; channel < 4; channel++) {
+			for(int x = 0; x < width;) {
+				if(data >= dataEnd) {
+					return nullptr;
+				}
+				// Above 128: the next byte repeated count - 128 times, otherwise count literal bytes
+				int count = *data++;
+				bool b_IsRun = count > 128;
+				if(b_IsRun) {
+					count -= 128;
+				}
+				if(count == 0 || count > width - x || dataEnd - data < (b_IsRun ? 1 : count)) {
+					return nullptr;
+				}
+				data += b_IsRun ? 1 : count;
+				x += count;
+			}
+		}
+		return data;
+	}
+
+	// Into 4 planes (r, g, b, e) of planeStride bytes
+	void DecodeRLEScanline(const unsigned char* data, int width, unsigned char* planes, int planeStride) {
+		data += 4;
+		for(int channel = 0; channel < 4; channel++) {
+			unsigned char* plane = planes + (size_t)channel * planeStride;
+			for(int x = 0; x < width;) {
+				int count = *data++;
+				if(count > 128) {
+					count -= 128;
+					memset(plane + x, *data++, count);
+				}
+				else {
+					memcpy(plane + x, data, count);
+					data += count;
+				}
+				x += count;
+			}
+		}
+	}
+
+	void DecodeFlatScanline(const unsigned char* data, int width, unsigned char* planes, int planeStride) {
+		for(int x = 0; x < width; x++) {
+			for(int channel = 0; channel < 4; channel++) {
+				planes[(size_t)channel * planeStride + x] = data[x * 4 + channel];
+			}
+		}
+	}
+
+	/// Packing, 4 texels at a time from the planes
+	// 4 bytes of a plane to 4 int lanes
+	__m128i LoadPlane(const unsigned char* plane) {
+		int bytes;
+		memcpy(&bytes, plane, sizeof(bytes));
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+	}
+
+	// m * 2^(e - 136) like stb_image: m / 256 is exact, then 2^(e - 128) built in the float's exponent bits, so the only rounding is the product's
+	// e = 0 is black, e = 1 (values around 2^-128) is flushed to black as well
+	void DecodeRGBE(const unsigned char* const planes[4], int x, __m128 rgb[3]) {
+		__m128i exponent = LoadPlane(planes[3] + x);
+		__m128i scaleBits = _mm_and_si128(_mm_slli_epi32(_mm_sub_epi32(exponent, _mm_set1_epi32(1)), 23), _mm_cmpgt_epi32(exponent, _mm_setzero_si128()));
+		__m128 scale = _mm_castsi128_ps(scaleBits);
+		for(int channel = 0; channel < 3; channel++) {
+			__m128 mantissa = _mm_mul_ps(_mm_cvtepi32_ps(LoadPlane(planes[channel] + x)), _mm_set1_ps(1.0f / 256.0f));
+			rgb[channel] = _mm_mul_ps(mantissa, scale);
+		}
+	}
+
+	void PackFloat(const unsigned char* const planes[4], int x, unsigned char* texels) {
+		__m128 rgba[4] {};
+		DecodeRGBE(planes, x, rgba);
+		rgba[3] = _mm_set1_ps(1.0f);
+		_MM_TRANSPOSE4_PS(rgba[0], rgba[1], rgba[2], rgba[3]);
+		for(int i = 0; i < 4; i++) {
+			_mm_storeu_ps((float*)texels + i * 4, rgba[i]);
+		}
+	}
+
+	// Round to nearest even, for finite non negative values below 65520 (everything is clamped to s_MaxHalf first)
+	// Halves end up in the low 16 bits of each lane
+	__m128i ConvertToHalf(__m128 value) {
+#if defined(__F16C__) || defined(__AVX2__)
+		return _mm_unpacklo_epi16(_mm_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT), _mm_setzero_si128());
+#else
+		// Below the smallest normal half, adding the magic float lines the half's subnormal mantissa up with the float's low bits and rounds it
+		const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+		__m128i bits = _mm_castps_si128(value);
+		__m128i b_IsSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), bits);
+		__m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(value, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+		// Rebias the exponent and round the 13 dropped mantissa bits, ties towards the even half
+		__m128i oddBit = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+		__m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, _mm_set1_epi32(0xFFF - ((127 - 15) << 23))), oddBit), 13);
+
+		return _mm_or_si128(_mm_and_si128(b_IsSubnormal, subnormal), _mm_andnot_si128(b_IsSubnormal, normal));
+#endif
+	}
+
+	void PackHalf(const unsigned char* const planes[4], int x, unsigned char* texels) {
+		__m128 rgb[3] {};
+		DecodeRGBE(planes, x, rgb);
+		__m128i halves[4] {};
+		for(int channel = 0; channel < 3; channel++) {
+			halves[channel] = ConvertToHalf(_mm_min_ps(rgb[channel], _mm_set1_ps(s_MaxHalf)));
+		}
+		halves[3] = _mm_set1_epi32(0x3C00); // 1.0
+
+		// Lanes hold values below 0x8000, so the signed pack keeps them as they are
+		__m128i rg = _mm_unpacklo_epi16(_mm_packs_epi32(halves[0], halves[0]), _mm_packs_epi32(halves[1], halves[1]));
+		__m128i ba = _mm_unpacklo_epi16(_mm_packs_epi32(halves[2], halves[2]), _mm_packs_epi32(halves[3], halves[3]));
+		_mm_storeu_si128((__m128i*)texels, _mm_unpacklo_epi32(rg, ba));
+		_mm_storeu_si128((__m128i*)(texels + 16), _mm_unpackhi_epi32(rg, ba));
+	}
+
+	// RGBE is already a shared exponent format: mantissas are doubled into 9 bits and the exponent rebiased (e - 113), no rounding in range
+	// Below range the mantissas are shifted down (rounded), above it they saturate at 511
+	void PackSharedExponent(const unsigned char* const planes[4], int x, unsigned char* texels) {
+		__m128i exponent = _mm_sub_epi32(LoadPlane(planes[3] + x), _mm_set1_epi32(113));
+		// Lanes fit in 16 bits and the clamp is to positive values, so the 16 bit min/max do the 32 bit clamp
+		__m128i sharedExponent = _mm_min_epi16(_mm_max_epi16(exponent, _mm_setzero_si128()), _mm_set1_epi32(31));
+		__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_sub_epi32(exponent, sharedExponent), _mm_set1_epi32(127 + 1)), 23));
+
+		__m128i packed = _mm_slli_epi32(sharedExponent, 27);
+		for(int channel = 0; channel < 3; channel++) {
+			__m128 mantissa = _mm_min_ps(_mm_mul_ps(_mm_cvtepi32_ps(LoadPlane(planes[channel] + x)), scale), _mm_set1_ps(511.0f));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_cvtps_epi32(mantissa), channel * 9));
+		}
+		_mm_storeu_si128((__m128i*)texels, packed);
+	}
+
+	void PackScanline(HDRDecoder::OutputFormat format, const unsigned char* planes, int planeStride, int width, unsigned char* texels) {
+		const unsigned char* const planePointers[4] {planes, planes + planeStride, planes + (size_t)planeStride * 2, planes + (size_t)planeStride * 3};
+		int texelSize = HDRDecoder::GetTexelSize(format);
+		auto Pack = [format, &planePointers](int x, unsigned char* groupTexels) {
+			switch(format) {
+				case HDRDecoder::kFloat:
+					PackFloat(planePointers, x, groupTexels);
+					break;
+				case HDRDecoder::kHalf:
+					PackHalf(planePointers, x, groupTexels);
+					break;
+				default:
+					PackSharedExponent(planePointers, x, groupTexels);
+					break;
+			}
+		};
+
+		// Planes are padded to whole groups, a last partial group goes through a buffer
+		int x = 0;
+		for(; x + 4 <= width; x += 4) {
+			Pack(x, texels + (size_t)x * texelSize);
+		}
+		if(x < width) {
+			unsigned char groupTexels[4 * 16];
+			Pack(x, groupTexels);
+			memcpy(texels + (size_t)x * texelSize, groupTexels, (size_t)(width - x) * texelSize);
+		}
+	}
+}
+
+bool HDRDecoder::Decode(const char* filename, OutputFormat format, int threadCount, unsigned char** pData, int& width, int& height) {
+	*pData = nullptr;
+	MappedFile file {};
+	if(!file.Initialize(filename)) {
+		return false;
+	}
+	const unsigned char* data = file.GetData();
+	const unsigned char* dataEnd = data + file.GetSize();
+
+	/// Header: magic, variables up to an empty line, then the resolution
+	std::string_view line {};
+	bool b_IsValid = ReadLine(data, dataEnd, line) && (line == "#?RADIANCE" || line == "#?RGBE");
+	bool b_IsRGBE = false;
+	while(b_IsValid && ReadLine(data, dataEnd, line) && !line.empty()) {
+		if(line == "FORMAT=32-bit_rle_rgbe") {
+			b_IsRGBE = true;
+		}
+	}
+	b_IsValid = b_IsValid && b_IsRGBE && ReadLine(data, dataEnd, line) && ParseResolution(line, width, height);
+	if(!b_IsValid) {
+		file.Shutdown();
+		return false;
+	}
+
+	/// Where every scanline starts, the only part that has to run in order
+	bool b_IsRLE = width >= s_MinRLEWidth && width <= s_MaxRLEWidth && dataEnd - data >= 4 && data[0] == 2 && data[1] == 2 && !(data[2] & 0x80);
+	std::vector<const unsigned char*> scanlines(height);
+	for(int y = 0; y < height; y++) {
+		scanlines[y] = data;
+		data = b_IsRLE ? SkipRLEScanline(data, dataEnd, width) : ((size_t)(dataEnd - data) >= (size_t)width * 4 ? data + (size_t)width * 4 : nullptr);
+		if(!data) {
+			file.Shutdown();
+			return false;
+		}
+	}
+
+	/// Decode and pack scanlines in parallel, each task through its own planes
+	int texelSize = GetTexelSize(format);
+	*pData = new unsigned char[(size_t)width * height * texelSize];
+	size_t maxTaskCount = threadCount > 0 ? (size_t)threadCount : std::max(1u, std::thread::hardware_concurrency());
+	int planeStride = (width + 3) & ~3;
+	ParallelFor((size_t)height, s_MinRowsPerTask, maxTaskCount, [&](size_t begin, size_t end) {
+		std::vector<unsigned char> planes((size_t)planeStride * 4);
+		for(size_t y = begin; y < end; y++) {
+			if(b_IsRLE) {
+				DecodeRLEScanline(scanlines[y], width, planes.data(), planeStride);
+			}
+			else {
+				DecodeFlatScanline(scanlines[y], width, planes.data(), planeStride);
+			}
+			PackScanline(format, planes.data(), planeStride, width, *pData + y * width * texelSize);
+		}
+	});
+
+	file.Shutdown();
+	return true;
+}
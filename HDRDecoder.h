@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+
+// Radiance .hdr (RGBE) decoder that writes texels straight in a GPU float format, so no 16 byte per texel float copy is ever made
+// The file is mapped and its run length encoded scanlines are located in one quick pass, then decoded and packed with SSE and spread over threads by scanlines
+// Values match stb_image's stbi_loadf (m * 2^(e - 136) per channel) up to the output format's precision
+class HDRDecoder {
+public:
+	enum OutputFormat {
+		// R32G32B32A32_FLOAT, alpha 1
+		kFloat = 0,
+		// R16G16B16A16_FLOAT, alpha 1, F16C where enabled
+		// Note: channels are clamped to 65504 (the largest half), the sun in some maps is brighter
+		kHalf = 1,
+		// R9G9B9E5_SHAREDEXP, RGBE's own shared exponent layout with a 9 bit mantissa, so values in range (2^-15 to 65408) are kept exactly
+		// Note: can't be a render target, so textures in it can't get GenerateMips
+		kSharedExponent = 2,
+		Num_OutputFormats
+	};
+
+	static int GetTexelSize(OutputFormat format) { return format == kFloat ? 16 : format == kHalf ? 8 : 4; }
+
+	// Decodes filename into width x height texels of format, top row first, allocated with new[]
+	// threadCount 0 uses one thread per hardware thread
+	// Only the standard -Y height +X width orientation and 32-bit_rle_rgbe files are read (like stb_image)
+	static bool Decode(const char* filename, OutputFormat format, int threadCount, unsigned char** pData, int& width, int& height);
+};
@@ -0,0 +1,54 @@
+#include "MappedFile.h"
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+bool MappedFile::Initialize(const std::string& filePath) {
+	HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	m_FileHandle = fileHandle;
+
+	LARGE_INTEGER fileSize {};
+	if(!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+		Shutdown();
+		return false;
+	}
+	m_Size = (size_t)fileSize.QuadPart;
+
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!mappingHandle) {
+		Shutdown();
+		return false;
+	}
+	m_MappingHandle = mappingHandle;
+
+	m_Data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if(!m_Data) {
+		Shutdown();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Shutdown() {
+	if(m_Data) {
+		UnmapViewOfFile(m_Data);
+		m_Data = nullptr;
+	}
+
+	if(m_MappingHandle) {
+		CloseHandle((HANDLE)m_MappingHandle);
+		m_MappingHandle = nullptr;
+	}
+
+	if(m_FileHandle) {
+		CloseHandle((HANDLE)m_FileHandle);
+		m_FileHandle = nullptr;
+	}
+
+	m_Size = 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapped view of a file on disk
+// Pages are only read from disk when touched, so data can be handed straight to the GPU without an intermediate copy
+class MappedFile {
+public:
+	MappedFile() {}
+	MappedFile(const MappedFile&) {}
+	~MappedFile() {}
+
+	bool Initialize(const std::string& filePath);
+	void Shutdown();
+
+	const unsigned char* GetData() const { return m_Data; }
+	size_t GetSize() const { return m_Size; }
+	bool IsOpen() const { return m_Data != nullptr; }
+
+private:
+	// Win32 handles stored as void* to keep windows.h out of this header
+	void* m_FileHandle {};
+	void* m_MappingHandle {};
+
+	const unsigned char* m_Data {};
+	size_t m_Size {};
+};
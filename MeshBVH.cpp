@@ -0,0 +1,448 @@
+#include "MeshBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace {
+	// Centroid bins per axis for the SAH split search
+	constexpr int s_SAHBinCount = 16;
+	// SAH costs of visiting a node and of intersecting a triangle
+	constexpr float s_TraversalCost = 1.0f;
+	constexpr float s_IntersectionCost = 1.0f;
+
+	// Below this depth splits fall back to object medians, which bound the tree depth and with it the traversal stack
+	// Depth <= s_MaxSAHDepth + 32, a 4-wide node pushes at most 3 entries more than it pops
+	constexpr int s_MaxSAHDepth = 40;
+	constexpr int s_TraversalStackSize = 256;
+
+	// Zero direction components are nudged to this so slab distances stay finite (inf * 0 would be NaN)
+	constexpr float s_MinRayDirection = 1e-20f;
+
+	struct AABB {
+		float min[3] {FLT_MAX, FLT_MAX, FLT_MAX};
+		float max[3] {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+		void Grow(const float point[3]) {
+			for(int i = 0; i < 3; i++) {
+				min[i] = std::min(min[i], point[i]);
+				max[i] = std::max(max[i], point[i]);
+			}
+		}
+
+		void Grow(const AABB& other) {
+			for(int i = 0; i < 3; i++) {
+				min[i] = std::min(min[i], other.min[i]);
+				max[i] = std::max(max[i], other.max[i]);
+			}
+		}
+
+		// Half the surface area, SAH only compares ratios
+		float GetArea() const {
+			if(min[0] > max[0]) {
+				return 0.0f;
+			}
+			float size[3] {max[0] - min[0], max[1] - min[1], max[2] - min[2]};
+			return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+		}
+	};
+
+	// Node of the intermediate binary tree, count > 0 for leaves
+	struct BinaryNode {
+		AABB bounds {};
+		uint32_t left {};
+		uint32_t right {};
+		uint32_t first {};
+		uint32_t count {};
+	};
+
+	BVHNode MakeEmptyNode() {
+		BVHNode node {};
+		for(int axis = 0; axis < 3; axis++) {
+			for(int i = 0; i < 4; i++) {
+				node.aabbMin[axis][i] = FLT_MAX;
+				node.aabbMax[axis][i] = -FLT_MAX;
+			}
+		}
+		return node;
+	}
+
+	void SetNodeChild(BVHNode& node, int slot, const AABB& bounds, uint32_t child, uint32_t triangleCount) {
+		for(int axis = 0; axis < 3; axis++) {
+			node.aabbMin[axis][slot] = bounds.min[axis];
+			node.aabbMax[axis][slot] = bounds.max[axis];
+		}
+		node.children[slot] = child;
+		node.triangleCounts[slot] = triangleCount;
+	}
+
+	// Moller-Trumbore, both sides of the triangle count
+	bool IntersectTriangle(const BVHTriangle& triangle, const float origin[3], const float direction[3], float maxDistance, float& distance, float& u, float& v) {
+		const float* edge1 = &triangle.edge1.x;
+		const float* edge2 = &triangle.edge2.x;
+		float p[3] {direction[1] * edge2[2] - direction[2] * edge2[1], direction[2] * edge2[0] - direction[0] * edge2[2], direction[0] * edge2[1] - direction[1] * edge2[0]};
+		float determinant = edge1[0] * p[0] + edge1[1] * p[1] + edge1[2] * p[2];
+		if(determinant == 0.0f) {
+			return false;
+		}
+		float inverseDeterminant = 1.0f / determinant;
+
+		float t[3] {origin[0] - triangle.vertex0.x, origin[1] - triangle.vertex0.y, origin[2] - triangle.vertex0.z};
+		u = (t[0] * p[0] + t[1] * p[1] + t[2] * p[2]) * inverseDeterminant;
+		if(u < 0.0f || u > 1.0f) {
+			return false;
+		}
+
+		float q[3] {t[1] * edge1[2] - t[2] * edge1[1], t[2] * edge1[0] - t[0] * edge1[2], t[0] * edge1[1] - t[1] * edge1[0]};
+		v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverseDeterminant;
+		if(v < 0.0f || u + v > 1.0f) {
+			return false;
+		}
+
+		distance = (edge2[0] * q[0] + edge2[1] * q[1] + edge2[2] * q[2]) * inverseDeterminant;
+		return distance >= 0.0f && distance <= maxDistance;
+	}
+}
+
+void MeshBVH::BuildBVH(MeshData& meshData) {
+	meshData.bvhNodes.clear();
+	meshData.bvhTriangles.clear();
+
+	uint32_t triangleCount = meshData.lods.empty() ? (uint32_t)meshData.indices.size() / 3 : meshData.lods[0].indexCount / 3;
+	uint32_t firstIndex = meshData.lods.empty() ? 0 : meshData.lods[0].firstIndex;
+	if(triangleCount == 0) {
+		return;
+	}
+
+	/// Triangle bounds and centroids
+	std::vector<AABB> triangleBounds(triangleCount);
+	std::vector<XMFLOAT3> centroids(triangleCount);
+	for(uint32_t i = 0; i < triangleCount; i++) {
+		for(int corner = 0; corner < 3; corner++) {
+			triangleBounds[i].Grow(&meshData.vertices[meshData.indices[firstIndex + i * 3 + corner]].position.x);
+		}
+		centroids[i] = XMFLOAT3(
+			(triangleBounds[i].min[0] + triangleBounds[i].max[0]) * 0.5f,
+			(triangleBounds[i].min[1] + triangleBounds[i].max[1]) * 0.5f,
+			(triangleBounds[i].min[2] + triangleBounds[i].max[2]) * 0.5f);
+	}
+
+	// Triangles are partitioned in place, every node owns a contiguous range of triangleOrder
+	std::vector<uint32_t> triangleOrder(triangleCount);
+	for(uint32_t i = 0; i < triangleCount; i++) {
+		triangleOrder[i] = i;
+	}
+
+	/// Binary tree with binned SAH splits (Wald 2007)
+	struct BuildTask {
+		uint32_t node;
+		int depth;
+	};
+
+	std::vector<BinaryNode> binaryNodes {};
+	binaryNodes.reserve(triangleCount * 2 / kMaxLeafTriangles + 1);
+	binaryNodes.push_back(BinaryNode {});
+	binaryNodes[0].first = 0;
+	binaryNodes[0].count = triangleCount;
+
+	std::vector<BuildTask> buildStack {};
+	buildStack.push_back(BuildTask {0, 0});
+	while(!buildStack.empty()) {
+		BuildTask task = buildStack.back();
+		buildStack.pop_back();
+
+		uint32_t first = binaryNodes[task.node].first;
+		uint32_t count = binaryNodes[task.node].count;
+		uint32_t* rangeBegin = triangleOrder.data() + first;
+		uint32_t* rangeEnd = rangeBegin + count;
+
+		AABB bounds {};
+		AABB centroidBounds {};
+		for(uint32_t* it = rangeBegin; it != rangeEnd; it++) {
+			bounds.Grow(triangleBounds[*it]);
+			centroidBounds.Grow(&centroids[*it].x);
+		}
+		binaryNodes[task.node].bounds = bounds;
+
+		if(count == 1) {
+			continue;
+		}
+
+		// Cheapest split between two bins along any axis
+		int bestAxis = -1;
+		int bestSplit = 0;
+		float bestCost = FLT_MAX;
+		for(int axis = 0; axis < 3 && task.depth < s_MaxSAHDepth; axis++) {
+			float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+			if(extent <= 0.0f) {
+				continue;
+			}
+			float binScale = s_SAHBinCount / extent;
+
+			AABB binBounds[s_SAHBinCount] {};
+			uint32_t binCounts[s_SAHBinCount] {};
+			for(uint32_t* it = rangeBegin; it != rangeEnd; it++) {
+				int bin = std::min((int)(((&centroids[*it].x)[axis] - centroidBounds.min[axis]) * binScale), s_SAHBinCount - 1);
+				binBounds[bin].Grow(triangleBounds[*it]);
+				binCounts[bin]++;
+			}
+
+			// Sweep from the right for the right side areas, then from the left
+			float rightAreas[s_SAHBinCount] {};
+			AABB rightBounds {};
+			for(int i = s_SAHBinCount - 1; i > 0; i--) {
+				rightBounds.Grow(binBounds[i]);
+				rightAreas[i] = rightBounds.GetArea();
+			}
+
+			AABB leftBounds {};
+			uint32_t leftCount = 0;
+			for(int i = 0; i < s_SAHBinCount - 1; i++) {
+				leftBounds.Grow(binBounds[i]);
+				leftCount += binCounts[i];
+				uint32_t rightCount = count - leftCount;
+				if(leftCount == 0 || rightCount == 0) {
+					continue;
+				}
+				float cost = leftBounds.GetArea() * leftCount + rightAreas[i + 1] * rightCount;
+				if(cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = i;
+				}
+			}
+		}
+
+		float parentArea = bounds.GetArea();
+		float splitCost = parentArea > 0.0f ? s_TraversalCost + s_IntersectionCost * bestCost / parentArea : s_TraversalCost + s_IntersectionCost * count;
+		float leafCost = s_IntersectionCost * count;
+		if(count <= kMaxLeafTriangles && (bestAxis < 0 || leafCost <= splitCost)) {
+			continue;
+		}
+
+		uint32_t* rangeMiddle = rangeBegin;
+		if(bestAxis >= 0) {
+			float binScale = s_SAHBinCount / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+			rangeMiddle = std::partition(rangeBegin, rangeEnd, [&](uint32_t triangle) {
+				int bin = std::min((int)(((&centroids[triangle].x)[bestAxis] - centroidBounds.min[bestAxis]) * binScale), s_SAHBinCount - 1);
+				return bin <= bestSplit;
+			});
+		}
+
+		// Object median along the widest centroid axis: too deep, no usable split, or all centroids in one place
+		if(rangeMiddle == rangeBegin || rangeMiddle == rangeEnd) {
+			int axis = 0;
+			for(int i = 1; i < 3; i++) {
+				if(centroidBounds.max[i] - centroidBounds.min[i] > centroidBounds.max[axis] - centroidBounds.min[axis]) {
+					axis = i;
+				}
+			}
+			rangeMiddle = rangeBegin + count / 2;
+			std::nth_element(rangeBegin, rangeMiddle, rangeEnd, [&](uint32_t a, uint32_t b) {
+				return (&centroids[a].x)[axis] < (&centroids[b].x)[axis];
+			});
+		}
+
+		uint32_t leftCount = (uint32_t)(rangeMiddle - rangeBegin);
+		BinaryNode leftNode {};
+		leftNode.first = first;
+		leftNode.count = leftCount;
+		BinaryNode rightNode {};
+		rightNode.first = first + leftCount;
+		rightNode.count = count - leftCount;
+
+		binaryNodes[task.node].left = (uint32_t)binaryNodes.size();
+		binaryNodes[task.node].right = (uint32_t)binaryNodes.size() + 1;
+		binaryNodes[task.node].count = 0;
+		binaryNodes.push_back(leftNode);
+		binaryNodes.push_back(rightNode);
+
+		buildStack.push_back(BuildTask {binaryNodes[task.node].left, task.depth + 1});
+		buildStack.push_back(BuildTask {binaryNodes[task.node].right, task.depth + 1});
+	}
+
+	/// Collapse to 4-wide nodes
+	// Each node takes the two binary children and keeps opening the internal child with the largest area until it has 4 (Wald et al. 2008)
+	struct CollapseTask {
+		uint32_t binaryNode;
+		uint32_t node;
+	};
+
+	std::vector<BVHNode>& nodes = meshData.bvhNodes;
+	nodes.push_back(MakeEmptyNode());
+	if(binaryNodes[0].count > 0) {
+		SetNodeChild(nodes[0], 0, binaryNodes[0].bounds, binaryNodes[0].first, binaryNodes[0].count);
+	}
+	else {
+		std::vector<CollapseTask> collapseStack {};
+		collapseStack.push_back(CollapseTask {0, 0});
+		while(!collapseStack.empty()) {
+			CollapseTask task = collapseStack.back();
+			collapseStack.pop_back();
+
+			uint32_t children[4] {binaryNodes[task.binaryNode].left, binaryNodes[task.binaryNode].right};
+			int childCount = 2;
+			while(childCount < 4) {
+				int largestChild = -1;
+				float largestArea = -1.0f;
+				for(int i = 0; i < childCount; i++) {
+					const BinaryNode& child = binaryNodes[children[i]];
+					if(child.count == 0 && child.bounds.GetArea() > largestArea) {
+						largestArea = child.bounds.GetArea();
+						largestChild = i;
+					}
+				}
+				if(largestChild < 0) {
+					break;
+				}
+				const BinaryNode& opened = binaryNodes[children[largestChild]];
+				children[largestChild] = opened.left;
+				children[childCount++] = opened.right;
+			}
+
+			for(int i = 0; i < childCount; i++) {
+				const BinaryNode& child = binaryNodes[children[i]];
+				if(child.count > 0) {
+					SetNodeChild(nodes[task.node], i, child.bounds, child.first, child.count);
+				}
+				else {
+					uint32_t childNode = (uint32_t)nodes.size();
+					nodes.push_back(MakeEmptyNode());
+					SetNodeChild(nodes[task.node], i, child.bounds, childNode, 0);
+					collapseStack.push_back(CollapseTask {children[i], childNode});
+				}
+			}
+		}
+	}
+
+	/// Triangles in leaf order
+	meshData.bvhTriangles.resize(triangleCount);
+	for(uint32_t i = 0; i < triangleCount; i++) {
+		uint32_t triangle = triangleOrder[i];
+		const uint32_t* corners = meshData.indices.data() + firstIndex + triangle * 3;
+		XMVECTOR vertex0 = XMLoadFloat3(&meshData.vertices[corners[0]].position);
+		XMVECTOR vertex1 = XMLoadFloat3(&meshData.vertices[corners[1]].position);
+		XMVECTOR vertex2 = XMLoadFloat3(&meshData.vertices[corners[2]].position);
+
+		BVHTriangle& output = meshData.bvhTriangles[i];
+		XMStoreFloat3(&output.vertex0, vertex0);
+		XMStoreFloat3(&output.edge1, XMVectorSubtract(vertex1, vertex0));
+		XMStoreFloat3(&output.edge2, XMVectorSubtract(vertex2, vertex0));
+		output.primitiveIndex = triangle;
+	}
+}
+
+bool MeshBVH::RayCast(const BVHNode* nodes, size_t nodeCount, const BVHTriangle* triangles, XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, RayHit& hit) {
+	if(nodeCount == 0) {
+		return false;
+	}
+
+	const float rayOrigin[3] {origin.x, origin.y, origin.z};
+	const float rayDirection[3] {direction.x, direction.y, direction.z};
+
+	// The near slab of each axis is the box min for positive directions and the box max for negative ones
+	// Note: with this ordering an inverted (empty) box always gives near > far, so empty slots never hit
+	bool b_IsPositive[3] {};
+	__m128 originX4[3] {};
+	__m128 inverseDirection4[3] {};
+	for(int axis = 0; axis < 3; axis++) {
+		float component = rayDirection[axis];
+		if(std::fabs(component) < s_MinRayDirection) {
+			component = std::signbit(component) ? -s_MinRayDirection : s_MinRayDirection;
+		}
+		b_IsPositive[axis] = component > 0.0f;
+		originX4[axis] = _mm_set1_ps(rayOrigin[axis]);
+		inverseDirection4[axis] = _mm_set1_ps(1.0f / component);
+	}
+
+	struct StackEntry {
+		uint32_t child;
+		uint32_t triangleCount;
+		float distance;
+	};
+	StackEntry stack[s_TraversalStackSize];
+	int stackSize = 0;
+	stack[stackSize++] = StackEntry {0, 0, 0.0f};
+
+	float closestDistance = maxDistance;
+	bool b_Hit = false;
+	while(stackSize > 0) {
+		StackEntry entry = stack[--stackSize];
+		// A closer hit was found after this entry was pushed
+		if(entry.distance > closestDistance) {
+			continue;
+		}
+
+		/// Leaf
+		if(entry.triangleCount > 0) {
+			for(uint32_t i = entry.child; i < entry.child + entry.triangleCount; i++) {
+				float distance, u, v;
+				if(IntersectTriangle(triangles[i], rayOrigin, rayDirection, closestDistance, distance, u, v)) {
+					closestDistance = distance;
+					hit = RayHit {distance, triangles[i].primitiveIndex, u, v};
+					b_Hit = true;
+				}
+			}
+			continue;
+		}
+
+		/// Slab test against the 4 child boxes
+		const BVHNode& node = nodes[entry.child];
+		__m128 nearDistance = _mm_setzero_ps();
+		__m128 farDistance = _mm_set1_ps(closestDistance);
+		for(int axis = 0; axis < 3; axis++) {
+			const float* nearPlanes = b_IsPositive[axis] ? node.aabbMin[axis] : node.aabbMax[axis];
+			const float* farPlanes = b_IsPositive[axis] ? node.aabbMax[axis] : node.aabbMin[axis];
+			nearDistance = _mm_max_ps(nearDistance, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(nearPlanes), originX4[axis]), inverseDirection4[axis]));
+			farDistance = _mm_min_ps(farDistance, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(farPlanes), originX4[axis]), inverseDirection4[axis]));
+		}
+		int hitMask = _mm_movemask_ps(_mm_cmple_ps(nearDistance, farDistance));
+		if(hitMask == 0) {
+			continue;
+		}
+
+		float nearDistances[4];
+		_mm_storeu_ps(nearDistances, nearDistance);
+
+		// Sorted farthest first, so the closest child is pushed last and popped next
+		StackEntry hitChildren[4];
+		int hitCount = 0;
+		for(int i = 0; i < 4; i++) {
+			if(!(hitMask & (1 << i))) {
+				continue;
+			}
+			StackEntry child {node.children[i], node.triangleCounts[i], nearDistances[i]};
+			int position = hitCount++;
+			while(position > 0 && hitChildren[position - 1].distance < child.distance) {
+				hitChildren[position] = hitChildren[position - 1];
+				position--;
+			}
+			hitChildren[position] = child;
+		}
+
+		// Note: cannot overflow for trees built by BuildBVH (see s_MaxSAHDepth), only guards against a corrupt cache
+		for(int i = 0; i < hitCount && stackSize < s_TraversalStackSize; i++) {
+			stack[stackSize++] = hitChildren[i];
+		}
+	}
+
+	return b_Hit;
+}
+
+bool MeshBVH::RayCastBruteForce(const BVHTriangle* triangles, size_t triangleCount, XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, RayHit& hit) {
+	const float rayOrigin[3] {origin.x, origin.y, origin.z};
+	const float rayDirection[3] {direction.x, direction.y, direction.z};
+
+	float closestDistance = maxDistance;
+	bool b_Hit = false;
+	for(size_t i = 0; i < triangleCount; i++) {
+		float distance, u, v;
+		if(IntersectTriangle(triangles[i], rayOrigin, rayDirection, closestDistance, distance, u, v)) {
+			closestDistance = distance;
+			hit = RayHit {distance, triangles[i].primitiveIndex, u, v};
+			b_Hit = true;
+		}
+	}
+	return b_Hit;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "MeshData.h"
+
+// Bounding volume hierarchy over a mesh's LOD 0 triangles, built at cook time and stored in MeshCache, used for ray queries (object picking)
+// A binary tree is built with binned SAH splits and then collapsed into 4-wide nodes, traversal tests the 4 child boxes of a node at once with SSE
+class MeshBVH {
+public:
+	// A leaf holds at most this many triangles, fewer if the SAH finds splitting cheaper
+	static constexpr uint32_t kMaxLeafTriangles = 4;
+
+	struct RayHit {
+		// Ray parameter of the hit, i.e. hit point = origin + distance * direction (a world distance only if direction is normalized)
+		float distance;
+		uint32_t primitiveIndex;
+		// Barycentrics of the hit point (weights of vertex 1 and 2)
+		float u, v;
+	};
+
+public:
+	// Fills meshData.bvhNodes and meshData.bvhTriangles from LOD 0, run after the index buffer reached its final order (i.e. after MeshletBuilder)
+	static void BuildBVH(MeshData& meshData);
+
+	// Closest hit with distance in [0, maxDistance], both triangle sides count
+	// Stack based traversal, children are visited closest first and skipped once they lie behind the closest hit so far
+	static bool RayCast(const BVHNode* nodes, size_t nodeCount, const BVHTriangle* triangles, XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, RayHit& hit);
+
+	// Same result as RayCast by testing every triangle, reference for validating and benchmarking the tree
+	static bool RayCastBruteForce(const BVHTriangle* triangles, size_t triangleCount, XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, RayHit& hit);
+};
@@ -0,0 +1,295 @@
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace {
+	constexpr uint64_t s_SectionAlignment = 16;
+
+	uint64_t AlignSectionOffset(uint64_t offset) {
+		return (offset + s_SectionAlignment - 1) & ~(s_SectionAlignment - 1);
+	}
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourceFilePath) {
+	return std::filesystem::path(sourceFilePath).replace_extension(".mesh").string();
+}
+
+bool MeshCache::GetSourceFileStamp(const std::string& sourceFilePath, uint64_t& fileSize, int64_t& writeTime) {
+	std::error_code errorCode {};
+	fileSize = std::filesystem::file_size(sourceFilePath, errorCode);
+	if(errorCode) {
+		return false;
+	}
+
+	std::filesystem::file_time_type fileTime = std::filesystem::last_write_time(sourceFilePath, errorCode);
+	if(errorCode) {
+		return false;
+	}
+	writeTime = (int64_t)fileTime.time_since_epoch().count();
+
+	return true;
+}
+
+bool MeshCache::Initialize(const std::string& sourceFilePath, VertexFormat vertexFormat) {
+	uint64_t sourceFileSize {};
+	int64_t sourceWriteTime {};
+	if(!GetSourceFileStamp(sourceFilePath, sourceFileSize, sourceWriteTime)) {
+		return false;
+	}
+
+	if(!m_File.Initialize(GetCachePath(sourceFilePath))) {
+		return false;
+	}
+
+	if(m_File.GetSize() < sizeof(Header)) {
+		Shutdown();
+		return false;
+	}
+
+	m_Header = (const Header*)m_File.GetData();
+	if(!ValidateHeader(sourceFileSize, sourceWriteTime, vertexFormat) || !ValidateDependencies(sourceFilePath)) {
+		Shutdown();
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCache::ValidateHeader(uint64_t sourceFileSize, int64_t sourceWriteTime, VertexFormat vertexFormat) const {
+	if(m_Header->magic != kMagic || m_Header->version != kVersion) {
+		return false;
+	}
+
+	if(m_Header->sourceFileSize != sourceFileSize || m_Header->sourceWriteTime != sourceWriteTime) {
+		return false;
+	}
+
+	if(m_Header->vertexFormat != (uint32_t)vertexFormat) {
+		return false;
+	}
+
+	for(int i = 0; i < Num_VertexStreams; i++) {
+		if(m_Header->vertexStreamStrides[i] != GetVertexStreamStride(vertexFormat, (VertexStream)i)) {
+			return false;
+		}
+	}
+
+	if(m_Header->indexStride != GetIndexStride(m_Header->vertexCount)) {
+		return false;
+	}
+
+	// All sections must lie inside the mapped file
+	for(int i = 0; i < Num_SectionTypes; i++) {
+		const SectionEntry& section = m_Header->sections[i];
+		if(section.offset < sizeof(Header) || section.offset > m_File.GetSize() || section.size > m_File.GetSize() - section.offset) {
+			return false;
+		}
+	}
+
+	if(m_Header->sections[kGeometryVertexSection].size != (uint64_t)m_Header->vertexCount * m_Header->vertexStreamStrides[kGeometryVertexStream]) {
+		return false;
+	}
+
+	if(m_Header->sections[kTangentVertexSection].size != (uint64_t)m_Header->vertexCount * m_Header->vertexStreamStrides[kTangentVertexStream]) {
+		return false;
+	}
+
+	if(m_Header->sections[kIndexSection].size != (uint64_t)m_Header->indexCount * m_Header->indexStride) {
+		return false;
+	}
+
+	if(m_Header->sections[kMeshletSection].size != (uint64_t)m_Header->meshletCount * sizeof(Meshlet)) {
+		return false;
+	}
+
+	// Meshlets are drawn as index ranges, every range must lie inside the index buffer
+	const Meshlet* meshlets = (const Meshlet*)GetSectionData(kMeshletSection);
+	for(uint32_t i = 0; i < m_Header->meshletCount; i++) {
+		if(meshlets[i].firstIndex > m_Header->indexCount || (uint64_t)meshlets[i].triangleCount * 3 > m_Header->indexCount - meshlets[i].firstIndex) {
+			return false;
+		}
+	}
+
+	if(m_Header->sections[kLODSection].size != (uint64_t)m_Header->lodCount * sizeof(MeshLOD)) {
+		return false;
+	}
+
+	// LODs are drawn by index range and culled by meshlet range
+	const MeshLOD* lods = (const MeshLOD*)GetSectionData(kLODSection);
+	for(uint32_t i = 0; i < m_Header->lodCount; i++) {
+		if(lods[i].firstIndex > m_Header->indexCount || lods[i].indexCount > m_Header->indexCount - lods[i].firstIndex) {
+			return false;
+		}
+		if(lods[i].firstMeshlet > m_Header->meshletCount || lods[i].meshletCount > m_Header->meshletCount - lods[i].firstMeshlet) {
+			return false;
+		}
+	}
+
+	if(m_Header->subMeshCount == 0 || m_Header->sections[kSubMeshLODSection].size != (uint64_t)m_Header->lodCount * m_Header->subMeshCount * sizeof(MeshLOD)) {
+		return false;
+	}
+
+	// Sub-meshes are drawn and culled by their own ranges, which must lie inside their LOD's
+	const MeshLOD* subMeshLODs = (const MeshLOD*)GetSectionData(kSubMeshLODSection);
+	for(uint64_t i = 0; i < (uint64_t)m_Header->lodCount * m_Header->subMeshCount; i++) {
+		const MeshLOD& lod = lods[i / m_Header->subMeshCount];
+		const MeshLOD& subMeshLOD = subMeshLODs[i];
+		if(subMeshLOD.firstIndex < lod.firstIndex || subMeshLOD.firstIndex > lod.firstIndex + lod.indexCount || subMeshLOD.indexCount > lod.firstIndex + lod.indexCount - subMeshLOD.firstIndex) {
+			return false;
+		}
+		if(subMeshLOD.firstMeshlet < lod.firstMeshlet || subMeshLOD.firstMeshlet > lod.firstMeshlet + lod.meshletCount || subMeshLOD.meshletCount > lod.firstMeshlet + lod.meshletCount - subMeshLOD.firstMeshlet) {
+			return false;
+		}
+	}
+
+	if(m_Header->sections[kDependencySection].size != (uint64_t)m_Header->dependencyCount * sizeof(DependencyEntry)) {
+		return false;
+	}
+
+	if(m_Header->sections[kBVHNodeSection].size != (uint64_t)m_Header->bvhNodeCount * sizeof(BVHNode)) {
+		return false;
+	}
+
+	if(m_Header->sections[kBVHTriangleSection].size != (uint64_t)m_Header->bvhTriangleCount * sizeof(BVHTriangle)) {
+		return false;
+	}
+
+	// Ray queries walk the tree without checks, so children must point forward (no cycles) and leaves must stay inside the triangles
+	const BVHNode* bvhNodes = (const BVHNode*)GetSectionData(kBVHNodeSection);
+	for(uint32_t i = 0; i < m_Header->bvhNodeCount; i++) {
+		for(int slot = 0; slot < 4; slot++) {
+			uint32_t child = bvhNodes[i].children[slot];
+			uint32_t triangleCount = bvhNodes[i].triangleCounts[slot];
+			if(triangleCount > 0 && (child > m_Header->bvhTriangleCount || triangleCount > m_Header->bvhTriangleCount - child)) {
+				return false;
+			}
+			if(triangleCount == 0 && child != 0 && (child <= i || child >= m_Header->bvhNodeCount)) {
+				return false;
+			}
+		}
+	}
+
+	return m_Header->vertexCount > 0 && m_Header->lodCount > 0 && m_Header->indexCount > 0;
+}
+
+bool MeshCache::ValidateDependencies(const std::string& sourceFilePath) const {
+	std::filesystem::path sourceDirectory = std::filesystem::u8path(sourceFilePath).parent_path();
+	const DependencyEntry* dependencies = (const DependencyEntry*)GetSectionData(kDependencySection);
+	for(uint32_t i = 0; i < m_Header->dependencyCount; i++) {
+		const DependencyEntry& dependency = dependencies[i];
+		if(dependency.filePath[kMaxDependencyPathLength - 1] != '\0') {
+			return false;
+		}
+
+		uint64_t fileSize {};
+		int64_t writeTime {};
+		if(!GetSourceFileStamp((sourceDirectory / std::filesystem::u8path(dependency.filePath)).string(), fileSize, writeTime)) {
+			return false;
+		}
+		if(dependency.fileSize != fileSize || dependency.writeTime != writeTime) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void MeshCache::Shutdown() {
+	m_Header = nullptr;
+	m_File.Shutdown();
+}
+
+bool MeshCache::Write(const std::string& sourceFilePath, const std::vector<std::string>& dependencyFilePaths, const MeshData& meshData, VertexFormat vertexFormat, const void* const (&vertexStreams)[Num_VertexStreams], const VertexDecodeParams& decodeParams) {
+	Header header {};
+	header.magic = kMagic;
+	header.version = kVersion;
+	if(!GetSourceFileStamp(sourceFilePath, header.sourceFileSize, header.sourceWriteTime)) {
+		return false;
+	}
+
+	header.vertexCount = (uint32_t)meshData.vertices.size();
+	for(int i = 0; i < Num_VertexStreams; i++) {
+		header.vertexStreamStrides[i] = GetVertexStreamStride(vertexFormat, (VertexStream)i);
+	}
+	header.indexCount = (uint32_t)meshData.indices.size();
+	header.indexStride = GetIndexStride(meshData.vertices.size());
+	header.meshletCount = (uint32_t)meshData.meshlets.size();
+	header.lodCount = (uint32_t)meshData.lods.size();
+	header.bvhNodeCount = (uint32_t)meshData.bvhNodes.size();
+	header.bvhTriangleCount = (uint32_t)meshData.bvhTriangles.size();
+	header.subMeshCount = (uint32_t)(meshData.subMeshLODs.size() / std::max<size_t>(meshData.lods.size(), 1));
+	header.dependencyCount = (uint32_t)dependencyFilePaths.size();
+	header.bounds = meshData.bounds;
+	header.vertexFormat = (uint32_t)vertexFormat;
+	header.decodeParams = decodeParams;
+
+	std::vector<unsigned char> packedIndices = PackIndices(meshData.indices, header.indexStride);
+
+	std::filesystem::path sourceDirectory = std::filesystem::u8path(sourceFilePath).parent_path();
+	std::vector<DependencyEntry> dependencies(dependencyFilePaths.size(), DependencyEntry {});
+	for(size_t i = 0; i < dependencyFilePaths.size(); i++) {
+		// Longer paths are not cached, the mesh is imported again on every load
+		if(dependencyFilePaths[i].size() >= kMaxDependencyPathLength) {
+			return false;
+		}
+		if(!GetSourceFileStamp((sourceDirectory / std::filesystem::u8path(dependencyFilePaths[i])).string(), dependencies[i].fileSize, dependencies[i].writeTime)) {
+			return false;
+		}
+		dependencyFilePaths[i].copy(dependencies[i].filePath, dependencyFilePaths[i].size());
+	}
+
+	// Section data to be written, in SectionType order
+	const void* sectionData[Num_SectionTypes] {vertexStreams[kGeometryVertexStream], vertexStreams[kTangentVertexStream], packedIndices.data(), meshData.meshlets.data(), meshData.lods.data(), meshData.bvhNodes.data(), meshData.bvhTriangles.data(), meshData.subMeshLODs.data(), dependencies.data()};
+	header.sections[kGeometryVertexSection].size = (uint64_t)header.vertexCount * header.vertexStreamStrides[kGeometryVertexStream];
+	header.sections[kTangentVertexSection].size = (uint64_t)header.vertexCount * header.vertexStreamStrides[kTangentVertexStream];
+	header.sections[kIndexSection].size = (uint64_t)header.indexCount * header.indexStride;
+	header.sections[kMeshletSection].size = (uint64_t)header.meshletCount * sizeof(Meshlet);
+	header.sections[kLODSection].size = (uint64_t)header.lodCount * sizeof(MeshLOD);
+	header.sections[kBVHNodeSection].size = (uint64_t)header.bvhNodeCount * sizeof(BVHNode);
+	header.sections[kBVHTriangleSection].size = (uint64_t)header.bvhTriangleCount * sizeof(BVHTriangle);
+	header.sections[kSubMeshLODSection].size = (uint64_t)header.lodCount * header.subMeshCount * sizeof(MeshLOD);
+	header.sections[kDependencySection].size = (uint64_t)header.dependencyCount * sizeof(DependencyEntry);
+
+	uint64_t currentOffset = sizeof(Header);
+	for(int i = 0; i < Num_SectionTypes; i++) {
+		currentOffset = AlignSectionOffset(currentOffset);
+		header.sections[i].offset = currentOffset;
+		currentOffset += header.sections[i].size;
+	}
+
+	std::string cacheFilePath = GetCachePath(sourceFilePath);
+	std::string tempFilePath = cacheFilePath + ".tmp";
+	{
+		std::ofstream fout {tempFilePath, std::ios::binary | std::ios::trunc};
+		if(fout.fail()) {
+			return false;
+		}
+
+		fout.write((const char*)&header, sizeof(Header));
+
+		static const char zeroPadding[s_SectionAlignment] {};
+		uint64_t writtenBytes = sizeof(Header);
+		for(int i = 0; i < Num_SectionTypes; i++) {
+			fout.write(zeroPadding, header.sections[i].offset - writtenBytes);
+			fout.write((const char*)sectionData[i], header.sections[i].size);
+			writtenBytes = header.sections[i].offset + header.sections[i].size;
+		}
+
+		if(fout.fail()) {
+			fout.close();
+			std::filesystem::remove(tempFilePath);
+			return false;
+		}
+	}
+
+	std::error_code errorCode {};
+	std::filesystem::rename(tempFilePath, cacheFilePath, errorCode);
+	if(errorCode) {
+		std::filesystem::remove(tempFilePath, errorCode);
+		return false;
+	}
+
+	return true;
+}
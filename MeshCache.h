@@ -0,0 +1,100 @@
+#pragma once
+#include "MeshData.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Versioned binary mesh format ("cooked" mesh), stored next to the source file with a .mesh extension
+// Layout: Header | section table | 16 byte aligned section data
+// Sections are stored in their final GPU layout, so a mapped cache can be passed straight to CreateBuffer
+class MeshCache {
+public:
+	// Bump when the layout or the content of any section changes, old caches are then re-cooked
+	static constexpr uint32_t kVersion = 12;
+	static constexpr uint32_t kMagic = 0x4853454D; // "MESH"
+
+	enum SectionType {
+		kGeometryVertexSection = 0,
+		kTangentVertexSection  = 1,
+		kIndexSection          = 2,
+		kMeshletSection        = 3,
+		kLODSection            = 4,
+		kBVHNodeSection        = 5,
+		kBVHTriangleSection    = 6,
+		kSubMeshLODSection     = 7,
+		kDependencySection     = 8,
+		Num_SectionTypes
+	};
+
+	struct SectionEntry {
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	static constexpr size_t kMaxDependencyPathLength = 240;
+
+	// Other file the mesh was imported from (e.g. a glTF buffer), the cache is stale if its stamp changes like the source file's
+	struct DependencyEntry {
+		uint64_t fileSize;
+		int64_t writeTime;
+		// Relative to the source file's directory, null terminated
+		char filePath[kMaxDependencyPathLength];
+	};
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+
+		// Source file stamp, cache is considered stale if either changes
+		uint64_t sourceFileSize;
+		int64_t sourceWriteTime;
+
+		uint32_t vertexCount;
+		// Per VertexStream, each stream is its own section
+		uint32_t vertexStreamStrides[Num_VertexStreams];
+		uint32_t indexCount;
+		uint32_t indexStride;
+		uint32_t meshletCount;
+		uint32_t lodCount;
+		uint32_t bvhNodeCount;
+		uint32_t bvhTriangleCount;
+		// MeshData::subMeshLODs holds lodCount * subMeshCount entries
+		uint32_t subMeshCount;
+		uint32_t dependencyCount;
+
+		MeshBounds bounds;
+		uint32_t vertexFormat; // VertexFormat
+		VertexDecodeParams decodeParams;
+
+		SectionEntry sections[Num_SectionTypes];
+	};
+
+public:
+	MeshCache() {}
+	MeshCache(const MeshCache&) {}
+	~MeshCache() {}
+
+	// Maps cooked mesh of sourceFilePath, fails if it does not exist, is invalid, is out of date or was cooked with another vertex format
+	bool Initialize(const std::string& sourceFilePath, VertexFormat vertexFormat);
+	void Shutdown();
+
+	const Header& GetHeader() const { return *m_Header; }
+	const void* GetSectionData(SectionType section) const { return m_File.GetData() + m_Header->sections[section].offset; }
+
+	// Cook mesh to disk, written to a temp file first so a partially written cache is never picked up
+	// dependencyFilePaths: other files the mesh was imported from, relative to sourceFilePath's directory (see GltfImporter::Import)
+	// vertexStreams hold meshData's vertices encoded in vertexFormat and split into streams (see SplitVertexStreams)
+	static bool Write(const std::string& sourceFilePath, const std::vector<std::string>& dependencyFilePaths, const MeshData& meshData, VertexFormat vertexFormat, const void* const (&vertexStreams)[Num_VertexStreams], const VertexDecodeParams& decodeParams);
+	static std::string GetCachePath(const std::string& sourceFilePath);
+
+private:
+	static bool GetSourceFileStamp(const std::string& sourceFilePath, uint64_t& fileSize, int64_t& writeTime);
+	bool ValidateHeader(uint64_t sourceFileSize, int64_t sourceWriteTime, VertexFormat vertexFormat) const;
+	bool ValidateDependencies(const std::string& sourceFilePath) const;
+
+private:
+	MappedFile m_File {};
+	const Header* m_Header {};
+};
@@ -0,0 +1,216 @@
+#pragma once
+#include <directxmath.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+// Vertex layout uploaded to the GPU
+// Needs to match the input layouts in PBRShader and DepthShader
+struct MeshVertex {
+	XMFLOAT3 position;
+	XMFLOAT2 texture;
+	XMFLOAT3 normal;
+	XMFLOAT3 tangent;
+	XMFLOAT3 binormal;
+};
+
+// Compact vertex layout (20 bytes), decoded in the vertex shaders when compiled with PACKED_VERTEX
+// See VertexPacker for the encoding
+struct PackedMeshVertex {
+	// unorm16 xyz quantized to the mesh AABB (see VertexDecodeParams), w is always 1
+	uint16_t position[4];
+	// half float
+	uint16_t texture[2];
+	// Octahedral encoded, snorm16
+	int16_t normal[2];
+	// Tangent frame quaternion, snorm8, sign of w is the binormal handedness
+	int8_t qtangent[4];
+};
+
+// Decoded position = unorm position * positionScale + positionBias
+// Layout matches VertexDecodeBuffer in PBR.vs and Depth.vs
+struct VertexDecodeParams {
+	XMFLOAT3 positionScale {1.0f, 1.0f, 1.0f};
+	float padding0 {};
+	XMFLOAT3 positionBias {};
+	float padding1 {};
+};
+
+enum VertexFormat {
+	kFullVertexFormat   = 0,
+	kPackedVertexFormat = 1,
+	Num_VertexFormats
+};
+
+inline uint32_t GetVertexStride(VertexFormat vertexFormat) {
+	return vertexFormat == kPackedVertexFormat ? sizeof(PackedMeshVertex) : sizeof(MeshVertex);
+}
+
+// On the GPU the vertices are split into two buffers so the depth pass only fetches what it reads
+// Geometry stream: position, uv and normal (all the depth pass needs, uv and normal for displacement)
+// Tangent stream: tangent and binormal (full) or qtangent (packed), main pass only
+enum VertexStream {
+	kGeometryVertexStream = 0,
+	kTangentVertexStream  = 1,
+	Num_VertexStreams
+};
+
+// Note: relies on MeshVertex and PackedMeshVertex starting with position, uv and normal
+inline uint32_t GetVertexStreamStride(VertexFormat vertexFormat, VertexStream vertexStream) {
+	uint32_t geometryStride = vertexFormat == kPackedVertexFormat ? offsetof(PackedMeshVertex, qtangent) : offsetof(MeshVertex, tangent);
+	return vertexStream == kGeometryVertexStream ? geometryStride : GetVertexStride(vertexFormat) - geometryStride;
+}
+
+// Splits interleaved vertices (MeshVertex or PackedMeshVertex) into their stream layouts (see VertexStream)
+inline void SplitVertexStreams(const void* vertices, size_t vertexCount, VertexFormat vertexFormat, std::vector<unsigned char> (&vertexStreams)[Num_VertexStreams]) {
+	const unsigned char* input = (const unsigned char*)vertices;
+	uint32_t vertexStride = GetVertexStride(vertexFormat);
+	uint32_t streamOffset = 0;
+	for(int stream = 0; stream < Num_VertexStreams; stream++) {
+		uint32_t streamStride = GetVertexStreamStride(vertexFormat, (VertexStream)stream);
+		vertexStreams[stream].resize(vertexCount * streamStride);
+		for(size_t i = 0; i < vertexCount; i++) {
+			std::memcpy(vertexStreams[stream].data() + i * streamStride, input + i * vertexStride + streamOffset, streamStride);
+		}
+		streamOffset += streamStride;
+	}
+}
+
+// Inverse of SplitVertexStreams, vertices receives vertexCount interleaved MeshVertex or PackedMeshVertex
+inline void InterleaveVertexStreams(const void* const (&vertexStreams)[Num_VertexStreams], size_t vertexCount, VertexFormat vertexFormat, void* vertices) {
+	unsigned char* output = (unsigned char*)vertices;
+	uint32_t vertexStride = GetVertexStride(vertexFormat);
+	uint32_t streamOffset = 0;
+	for(int stream = 0; stream < Num_VertexStreams; stream++) {
+		const unsigned char* input = (const unsigned char*)vertexStreams[stream];
+		uint32_t streamStride = GetVertexStreamStride(vertexFormat, (VertexStream)stream);
+		for(size_t i = 0; i < vertexCount; i++) {
+			std::memcpy(output + i * vertexStride + streamOffset, input + i * streamStride, streamStride);
+		}
+		streamOffset += streamStride;
+	}
+}
+
+// Cluster of triangles stored as one contiguous range of the index buffer, culled as a whole on the CPU (see MeshletCuller)
+// Bounds are in model space
+struct Meshlet {
+	XMFLOAT3 center;
+	float radius;
+
+	XMFLOAT3 aabbMin;
+	uint32_t firstIndex;
+	XMFLOAT3 aabbMax;
+	uint32_t triangleCount;
+
+	// Normal cone: every triangle normal lies within the cone around coneAxis, coneCutoff = sin(cone half angle)
+	// coneCutoff = 1 when the cone is too wide for the cluster to ever be entirely backfacing
+	XMFLOAT3 coneAxis;
+	float coneCutoff;
+};
+
+// Cluster size limits, small enough that a partially visible mesh can drop most of its invisible triangles
+constexpr uint32_t kMaxMeshletVertices  = 64;
+constexpr uint32_t kMaxMeshletTriangles = 124;
+
+// Level of detail, an index range into the shared index buffer plus its meshlets (see MeshSimplifier)
+// All LODs index the same vertex buffer
+struct MeshLOD {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	uint32_t firstMeshlet;
+	uint32_t meshletCount;
+
+	// Geometric error against LOD 0 in model units, used to pick a LOD by its projected size on screen
+	float error;
+};
+
+// Model space bounding volumes of a mesh, see BoundingVolumes
+struct MeshBounds {
+	XMFLOAT3 aabbMin {};
+	XMFLOAT3 aabbMax {};
+
+	XMFLOAT3 sphereCenter {};
+	float sphereRadius {};
+
+	// Oriented box: obbCenter + sum of t_i * obbExtents[i] * obbAxes[i] with t_i in [-1, 1], axes are orthonormal
+	// Equals the AABB (identity axes) when the fitted box is not tighter
+	XMFLOAT3 obbCenter {};
+	XMFLOAT3 obbExtents {};
+	XMFLOAT3 obbAxes[3] {};
+
+	// UV units per model space unit over the whole surface, for texture mip selection (see GameObject::RequestTextureMips)
+	float uvDensity {};
+};
+
+// Node of a 4-wide bounding volume hierarchy over LOD 0's triangles (see MeshBVH), bounds are in model space
+// Children are stored as structure of arrays so a ray is tested against all four boxes at once
+struct BVHNode {
+	float aabbMin[3][4];
+	float aabbMax[3][4];
+	// triangleCounts[i] > 0: leaf, children[i] is its first BVHTriangle
+	// triangleCounts[i] == 0: children[i] is a node index, 0 (the root) marks an empty slot whose box is inverted so rays never hit it
+	uint32_t children[4];
+	uint32_t triangleCounts[4];
+};
+
+// Triangle in BVH leaf order, stored as a vertex and two edges for the ray intersection
+struct BVHTriangle {
+	XMFLOAT3 vertex0;
+	XMFLOAT3 edge1;
+	XMFLOAT3 edge2;
+	// Triangle index within LOD 0's index range
+	uint32_t primitiveIndex;
+};
+
+// Primitive of an imported file (glTF mesh primitive, OBJ group/object), as its LOD 0 index range
+// Every cook stage keeps a sub-mesh's triangles together, so each one is culled and drawn on its own (see MeshData::subMeshLODs)
+struct SubMesh {
+	std::string name {};
+	uint32_t firstIndex {};
+	uint32_t indexCount {};
+};
+
+// CPU side mesh used by the cook pipeline (text parse -> processing -> MeshCache)
+struct MeshData {
+	std::vector<MeshVertex> vertices {};
+	std::vector<uint32_t> indices {};
+	std::vector<Meshlet> meshlets {};
+	// LOD 0 first, empty until MeshSimplifier::GenerateLODs ran
+	std::vector<MeshLOD> lods {};
+
+	MeshBounds bounds {};
+
+	// Ray query tree over LOD 0, filled by MeshBVH::BuildBVH
+	std::vector<BVHNode> bvhNodes {};
+	std::vector<BVHTriangle> bvhTriangles {};
+
+	// Filled by the importers (ObjImporter, GltfImporter), MeshSimplifier::GenerateLODs adds a single one covering LOD 0 when empty
+	std::vector<SubMesh> subMeshes {};
+	// Each LOD split by sub-mesh, in sub-mesh order and contiguous: sub-mesh s of LOD l is subMeshLODs[l * subMeshes.size() + s]
+	// Index ranges filled by MeshSimplifier::GenerateLODs, meshlet ranges by MeshletBuilder
+	std::vector<MeshLOD> subMeshLODs {};
+};
+
+// Index buffers use 16 bit indices whenever every vertex can be addressed with them
+inline uint32_t GetIndexStride(size_t vertexCount) {
+	return vertexCount <= 0xFFFF ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+// Index data in its GPU layout (see GetIndexStride)
+inline std::vector<unsigned char> PackIndices(const std::vector<uint32_t>& indices, uint32_t indexStride) {
+	std::vector<unsigned char> packedIndices(indices.size() * indexStride);
+	if(indexStride == sizeof(uint16_t)) {
+		uint16_t* output = (uint16_t*)packedIndices.data();
+		for(size_t i = 0; i < indices.size(); i++) {
+			output[i] = (uint16_t)indices[i];
+		}
+	}
+	else {
+		std::memcpy(packedIndices.data(), indices.data(), packedIndices.size());
+	}
+	return packedIndices;
+}
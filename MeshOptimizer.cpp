@@ -0,0 +1,349 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Triangles using each vertex, CSR layout: triangles of vertex v are triangles[offsets[v], offsets[v + 1])
+	struct VertexTriangleAdjacency {
+		std::vector<uint32_t> offsets {};
+		std::vector<uint32_t> triangles {};
+	};
+
+	void BuildVertexTriangleAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount, VertexTriangleAdjacency& adjacency) {
+		adjacency.offsets.assign(vertexCount + 1, 0);
+		for(uint32_t index : indices) {
+			adjacency.offsets[index + 1]++;
+		}
+		for(size_t i = 0; i < vertexCount; i++) {
+			adjacency.offsets[i + 1] += adjacency.offsets[i];
+		}
+
+		std::vector<uint32_t> fillCursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		adjacency.triangles.resize(indices.size());
+		for(size_t i = 0; i < indices.size(); i++) {
+			adjacency.triangles[fillCursor[indices[i]]++] = (uint32_t)(i / 3);
+		}
+	}
+
+	// FIFO cache, a vertex is cached if fewer than cacheSize misses happened since it was last loaded
+	// Returns number of misses for the triangle
+	int SimulateTriangle(const uint32_t* triangle, std::vector<uint32_t>& cacheTimestamps, uint32_t& timestamp, int cacheSize) {
+		int misses = 0;
+		for(int i = 0; i < 3; i++) {
+			uint32_t vertex = triangle[i];
+			if(timestamp - cacheTimestamps[vertex] > (uint32_t)cacheSize) {
+				cacheTimestamps[vertex] = timestamp++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+}
+
+void MeshOptimizer::OptimizeMesh(MeshData& meshData) {
+	std::vector<uint32_t> clusterStarts {};
+	if(meshData.subMeshes.size() <= 1) {
+		OptimizeVertexCache(meshData.indices, meshData.vertices.size(), &clusterStarts);
+		OptimizeOverdraw(meshData.indices, meshData.vertices, clusterStarts, kOverdrawThreshold);
+		OptimizeVertexFetch(meshData);
+		return;
+	}
+
+	// Sub-meshes are drawn separately, so triangles are only reordered within their own sub-mesh
+	// Each one is optimized over a compact copy of the vertices it uses, a file with many small sub-meshes does not pay for the whole vertex buffer every time
+	const uint32_t unassigned = 0xFFFFFFFF;
+	std::vector<uint32_t> localVertexIds(meshData.vertices.size(), unassigned);
+	std::vector<uint32_t> globalVertexIds {};
+	std::vector<MeshVertex> localVertices {};
+	std::vector<uint32_t> localIndices {};
+	for(const SubMesh& subMesh : meshData.subMeshes) {
+		uint32_t* indices = meshData.indices.data() + subMesh.firstIndex;
+		globalVertexIds.clear();
+		localVertices.clear();
+		localIndices.resize(subMesh.indexCount);
+		for(uint32_t i = 0; i < subMesh.indexCount; i++) {
+			uint32_t& localVertexId = localVertexIds[indices[i]];
+			if(localVertexId == unassigned) {
+				localVertexId = (uint32_t)localVertices.size();
+				globalVertexIds.push_back(indices[i]);
+				localVertices.push_back(meshData.vertices[indices[i]]);
+			}
+			localIndices[i] = localVertexId;
+		}
+
+		clusterStarts.clear();
+		OptimizeVertexCache(localIndices, localVertices.size(), &clusterStarts);
+		OptimizeOverdraw(localIndices, localVertices, clusterStarts, kOverdrawThreshold);
+
+		for(uint32_t i = 0; i < subMesh.indexCount; i++) {
+			indices[i] = globalVertexIds[localIndices[i]];
+		}
+		for(uint32_t vertex : globalVertexIds) {
+			localVertexIds[vertex] = unassigned;
+		}
+	}
+	OptimizeVertexFetch(meshData);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusterStarts) {
+	size_t triangleCount = indices.size() / 3;
+	if(triangleCount == 0) {
+		return;
+	}
+
+	VertexTriangleAdjacency adjacency {};
+	BuildVertexTriangleAdjacency(indices, vertexCount, adjacency);
+
+	// Number of not yet emitted triangles using each vertex
+	std::vector<uint32_t> liveTriangles(vertexCount);
+	for(size_t i = 0; i < vertexCount; i++) {
+		liveTriangles[i] = adjacency.offsets[i + 1] - adjacency.offsets[i];
+	}
+
+	// Timestamps start far enough in the past that every vertex begins outside the cache
+	const uint32_t cacheSize = kVertexCacheSize;
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEndStack {};
+	std::vector<uint32_t> candidates {};
+	std::vector<uint32_t> output {};
+	output.reserve(indices.size());
+
+	if(clusterStarts) {
+		clusterStarts->clear();
+		clusterStarts->push_back(0);
+	}
+
+	int fanningVertex = indices[0];
+	size_t scanCursor = 0;
+	while(fanningVertex >= 0) {
+		candidates.clear();
+
+		// Emit all remaining triangles around the fanning vertex
+		for(uint32_t a = adjacency.offsets[fanningVertex]; a < adjacency.offsets[fanningVertex + 1]; a++) {
+			uint32_t triangle = adjacency.triangles[a];
+			if(emitted[triangle]) {
+				continue;
+			}
+
+			for(int i = 0; i < 3; i++) {
+				uint32_t vertex = indices[triangle * 3 + i];
+				output.push_back(vertex);
+				deadEndStack.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+
+				if(timestamp - cacheTimestamps[vertex] > cacheSize) {
+					cacheTimestamps[vertex] = timestamp++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// Next fanning vertex: the candidate that stays in cache longest while its remaining triangles are emitted
+		int bestVertex = -1;
+		int bestPriority = -1;
+		for(uint32_t vertex : candidates) {
+			if(liveTriangles[vertex] == 0) {
+				continue;
+			}
+
+			int priority = 0;
+			if(timestamp - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+				priority = timestamp - cacheTimestamps[vertex];
+			}
+
+			if(priority > bestPriority) {
+				bestPriority = priority;
+				bestVertex = vertex;
+			}
+		}
+
+		if(bestVertex >= 0) {
+			fanningVertex = bestVertex;
+			continue;
+		}
+
+		/// Dead end, restart from a recently used vertex or scan for any vertex with live triangles
+		fanningVertex = -1;
+		while(!deadEndStack.empty()) {
+			uint32_t vertex = deadEndStack.back();
+			deadEndStack.pop_back();
+			if(liveTriangles[vertex] > 0) {
+				fanningVertex = vertex;
+				break;
+			}
+		}
+
+		while(fanningVertex < 0 && scanCursor < vertexCount) {
+			if(liveTriangles[scanCursor] > 0) {
+				fanningVertex = (int)scanCursor;
+			}
+			scanCursor++;
+		}
+
+		if(fanningVertex >= 0 && clusterStarts) {
+			clusterStarts->push_back((uint32_t)(output.size() / 3));
+		}
+	}
+
+	indices = std::move(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& clusterStarts, float threshold) {
+	size_t triangleCount = indices.size() / 3;
+	if(triangleCount == 0 || clusterStarts.empty()) {
+		return;
+	}
+
+	/// Split hard clusters (dead ends) further wherever the running ACMR drops to the cluster's ACMR * threshold
+	std::vector<uint32_t> softClusterStarts {};
+	std::vector<uint32_t> cacheTimestamps(vertices.size(), 0);
+	uint32_t timestamp = kVertexCacheSize + 1;
+
+	for(size_t c = 0; c < clusterStarts.size(); c++) {
+		uint32_t clusterBegin = clusterStarts[c];
+		uint32_t clusterEnd = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : (uint32_t)triangleCount;
+
+		// Flush cache by advancing past the cache size, then measure the whole hard cluster
+		timestamp += kVertexCacheSize + 1;
+		int clusterMisses = 0;
+		for(uint32_t t = clusterBegin; t < clusterEnd; t++) {
+			clusterMisses += SimulateTriangle(&indices[t * 3], cacheTimestamps, timestamp, kVertexCacheSize);
+		}
+		float missThreshold = threshold * (float)clusterMisses / (float)(clusterEnd - clusterBegin);
+
+		timestamp += kVertexCacheSize + 1;
+		softClusterStarts.push_back(clusterBegin);
+		uint32_t softBegin = clusterBegin;
+		int softMisses = 0;
+		for(uint32_t t = clusterBegin; t < clusterEnd; t++) {
+			softMisses += SimulateTriangle(&indices[t * 3], cacheTimestamps, timestamp, kVertexCacheSize);
+
+			if(t + 1 < clusterEnd && (float)softMisses <= missThreshold * (float)(t - softBegin + 1)) {
+				softBegin = t + 1;
+				softMisses = 0;
+				softClusterStarts.push_back(softBegin);
+				timestamp += kVertexCacheSize + 1;
+			}
+		}
+	}
+
+	/// Sort key per cluster: how far the cluster sits out along its own normal, relative to the mesh centroid
+	float meshCentroid[3] {};
+	for(const MeshVertex& vertex : vertices) {
+		meshCentroid[0] += vertex.position.x;
+		meshCentroid[1] += vertex.position.y;
+		meshCentroid[2] += vertex.position.z;
+	}
+	for(int i = 0; i < 3; i++) {
+		meshCentroid[i] /= (float)std::max<size_t>(vertices.size(), 1);
+	}
+
+	size_t clusterCount = softClusterStarts.size();
+	std::vector<float> clusterSortKeys(clusterCount);
+	for(size_t c = 0; c < clusterCount; c++) {
+		uint32_t clusterBegin = softClusterStarts[c];
+		uint32_t clusterEnd = c + 1 < clusterCount ? softClusterStarts[c + 1] : (uint32_t)triangleCount;
+
+		// Area weighted centroid and normal (cross product length is twice the triangle area)
+		float centroid[3] {}, normal[3] {};
+		float totalArea = 0.0f;
+		for(uint32_t t = clusterBegin; t < clusterEnd; t++) {
+			const XMFLOAT3& p0 = vertices[indices[t * 3 + 0]].position;
+			const XMFLOAT3& p1 = vertices[indices[t * 3 + 1]].position;
+			const XMFLOAT3& p2 = vertices[indices[t * 3 + 2]].position;
+
+			float e1[3] {p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+			float e2[3] {p2.x - p0.x, p2.y - p0.y, p2.z - p0.z};
+			float cross[3] {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+			float area = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+			centroid[0] += (p0.x + p1.x + p2.x) * (area / 3.0f);
+			centroid[1] += (p0.y + p1.y + p2.y) * (area / 3.0f);
+			centroid[2] += (p0.z + p1.z + p2.z) * (area / 3.0f);
+			normal[0] += cross[0];
+			normal[1] += cross[1];
+			normal[2] += cross[2];
+			totalArea += area;
+		}
+
+		float inverseArea = totalArea > 0.0f ? 1.0f / totalArea : 0.0f;
+		float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float inverseNormalLength = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+		clusterSortKeys[c] = 0.0f;
+		for(int i = 0; i < 3; i++) {
+			clusterSortKeys[c] += (centroid[i] * inverseArea - meshCentroid[i]) * normal[i] * inverseNormalLength;
+		}
+	}
+
+	// Clusters facing away from the mesh centre occlude the rest, draw them first
+	std::vector<uint32_t> clusterOrder(clusterCount);
+	for(size_t c = 0; c < clusterCount; c++) {
+		clusterOrder[c] = (uint32_t)c;
+	}
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&clusterSortKeys](uint32_t a, uint32_t b) {
+		return clusterSortKeys[a] > clusterSortKeys[b];
+	});
+
+	std::vector<uint32_t> output {};
+	output.reserve(indices.size());
+	for(uint32_t c : clusterOrder) {
+		uint32_t clusterBegin = softClusterStarts[c];
+		uint32_t clusterEnd = c + 1 < clusterCount ? softClusterStarts[c + 1] : (uint32_t)triangleCount;
+		output.insert(output.end(), indices.begin() + clusterBegin * 3, indices.begin() + clusterEnd * 3);
+	}
+
+	indices = std::move(output);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(MeshData& meshData) {
+	const uint32_t unassigned = 0xFFFFFFFF;
+	std::vector<uint32_t> remap(meshData.vertices.size(), unassigned);
+
+	std::vector<MeshVertex> orderedVertices {};
+	orderedVertices.reserve(meshData.vertices.size());
+	for(uint32_t& index : meshData.indices) {
+		if(remap[index] == unassigned) {
+			remap[index] = (uint32_t)orderedVertices.size();
+			orderedVertices.push_back(meshData.vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	meshData.vertices = std::move(orderedVertices);
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize) {
+	VertexCacheStats stats {};
+	size_t triangleCount = indices.size() / 3;
+	if(triangleCount == 0) {
+		return stats;
+	}
+
+	std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t timestamp = cacheSize + 1;
+
+	size_t misses = 0;
+	size_t referencedCount = 0;
+	for(size_t t = 0; t < triangleCount; t++) {
+		misses += SimulateTriangle(&indices[t * 3], cacheTimestamps, timestamp, cacheSize);
+
+		for(int i = 0; i < 3; i++) {
+			uint32_t vertex = indices[t * 3 + i];
+			if(!referenced[vertex]) {
+				referenced[vertex] = true;
+				referencedCount++;
+			}
+		}
+	}
+
+	stats.acmr = (float)misses / (float)triangleCount;
+	stats.atvr = (float)misses / (float)referencedCount;
+	return stats;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "MeshData.h"
+
+// Index/vertex reordering for indexed triangle lists, run by the cook pipeline after welding
+// Order matters: vertex cache -> overdraw -> vertex fetch (OptimizeMesh runs all three)
+class MeshOptimizer {
+public:
+	struct VertexCacheStats {
+		// Average cache miss ratio, vertex shader invocations per triangle (0.5 is ideal for large grids, 3 is worst case)
+		float acmr;
+		// Average transform to vertex ratio, vertex shader invocations per referenced vertex (1 is ideal)
+		float atvr;
+	};
+
+	// Post-transform cache size assumed by the optimizer and the simulator
+	static constexpr int kVertexCacheSize = 16;
+
+	// Overdraw pass may raise ACMR up to this factor to get finer clusters to sort
+	static constexpr float kOverdrawThreshold = 1.05f;
+
+	// Triangles are only reordered within their sub-mesh (see SubMesh)
+	static void OptimizeMesh(MeshData& meshData);
+
+	// Tipsify (Sander et al. 2007) triangle reordering
+	// If clusterStarts is not null it receives the first triangle of every cluster started at a dead end
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusterStarts = nullptr);
+
+	// Splits the vertex cache optimized order into clusters and sorts them so outward facing clusters on the hull draw first
+	static void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& clusterStarts, float threshold);
+
+	// Renumbers vertices in order of first use so vertex fetch walks memory linearly, unreferenced vertices are removed
+	static void OptimizeVertexFetch(MeshData& meshData);
+
+	// FIFO post-transform cache simulation
+	static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize = kVertexCacheSize);
+};
@@ -0,0 +1,842 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+	constexpr uint32_t s_InvalidIndex = UINT32_MAX;
+
+	// A level must have at most this fraction of the previous level's triangles, otherwise the chain ends
+	constexpr float s_MinLODReduction = 0.85f;
+
+	// Border and seam edges get a plane quadric perpendicular to the surface so they keep their shape
+	constexpr float s_BorderEdgeWeight = 10.0f;
+
+	// Attribute error weights, positions are normalized to the unit cube so these are relative to the mesh size
+	constexpr float s_UVWeight = 1.0f;
+	constexpr float s_NormalWeight = 0.5f;
+	constexpr int s_AttributeCount = 5; // u, v, nx, ny, nz
+
+	// Collapses that turn a triangle's normal by more than ~75 degrees are rejected
+	constexpr float s_MinFlipCosine = 0.25f;
+
+	enum VertexKind {
+		kManifoldVertex = 0, // single wedge, no open edges: collapses onto any neighbour
+		kBorderVertex   = 1, // single wedge on a mesh border: collapses along the border
+		kSeamVertex     = 2, // two wedges on an attribute seam: both wedges collapse along the seam
+		kLockedVertex   = 3, // everything else (corners, seam ends, poles with many wedges): never moves
+		Num_VertexKinds
+	};
+
+	// Sum of weighted squared distances to planes, q(p) = p^T A p + 2 b.p + c
+	struct Quadric {
+		float a00, a11, a22, a01, a02, a12;
+		float b0, b1, b2;
+		float c;
+		float weight;
+	};
+
+	// Squared error of a linear attribute function over the original triangles, q(p, s) = sum w (g.p + d - s)^2
+	struct AttributeQuadric {
+		float a00, a11, a22, a01, a02, a12; // sum w g g^T
+		float b0, b1, b2;                   // sum w g d
+		float c;                            // sum w d^2
+		float g0, g1, g2;                   // sum w g
+		float d;                            // sum w d
+		float weight;
+	};
+
+	void AddPlane(Quadric& quadric, const float normal[3], float distance, float weight) {
+		quadric.a00 += weight * normal[0] * normal[0];
+		quadric.a11 += weight * normal[1] * normal[1];
+		quadric.a22 += weight * normal[2] * normal[2];
+		quadric.a01 += weight * normal[0] * normal[1];
+		quadric.a02 += weight * normal[0] * normal[2];
+		quadric.a12 += weight * normal[1] * normal[2];
+		quadric.b0 += weight * normal[0] * distance;
+		quadric.b1 += weight * normal[1] * distance;
+		quadric.b2 += weight * normal[2] * distance;
+		quadric.c += weight * distance * distance;
+		quadric.weight += weight;
+	}
+
+	void AddQuadric(Quadric& target, const Quadric& source) {
+		const float* from = &source.a00;
+		float* to = &target.a00;
+		for(size_t i = 0; i < sizeof(Quadric) / sizeof(float); i++) {
+			to[i] += from[i];
+		}
+	}
+
+	void AddQuadric(AttributeQuadric& target, const AttributeQuadric& source) {
+		const float* from = &source.a00;
+		float* to = &target.a00;
+		for(size_t i = 0; i < sizeof(AttributeQuadric) / sizeof(float); i++) {
+			to[i] += from[i];
+		}
+	}
+
+	// Mean squared distance of p to the quadric's planes
+	float EvaluateQuadric(const Quadric& q, const float p[3]) {
+		float result =
+			q.a00 * p[0] * p[0] + q.a11 * p[1] * p[1] + q.a22 * p[2] * p[2] +
+			2.0f * (q.a01 * p[0] * p[1] + q.a02 * p[0] * p[2] + q.a12 * p[1] * p[2]) +
+			2.0f * (q.b0 * p[0] + q.b1 * p[1] + q.b2 * p[2]) + q.c;
+		return q.weight > 0.0f ? std::abs(result) / q.weight : 0.0f;
+	}
+
+	// Mean squared attribute error when the attribute is s at position p
+	float EvaluateQuadric(const AttributeQuadric& q, const float p[3], float s) {
+		float linear = q.g0 * p[0] + q.g1 * p[1] + q.g2 * p[2] + q.d;
+		float result =
+			q.a00 * p[0] * p[0] + q.a11 * p[1] * p[1] + q.a22 * p[2] * p[2] +
+			2.0f * (q.a01 * p[0] * p[1] + q.a02 * p[0] * p[2] + q.a12 * p[1] * p[2]) +
+			2.0f * (q.b0 * p[0] + q.b1 * p[1] + q.b2 * p[2]) + q.c -
+			2.0f * s * linear + s * s * q.weight;
+		return q.weight > 0.0f ? std::abs(result) / q.weight : 0.0f;
+	}
+
+	float Dot(const float a[3], const float b[3]) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+	void Cross(const float a[3], const float b[3], float result[3]) {
+		result[0] = a[1] * b[2] - a[2] * b[1];
+		result[1] = a[2] * b[0] - a[0] * b[2];
+		result[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	// Half-edges leaving each vertex, CSR layout: targets of vertex v are targets[offsets[v], offsets[v + 1])
+	struct EdgeAdjacency {
+		std::vector<uint32_t> offsets {};
+		std::vector<uint32_t> targets {};
+	};
+
+	void BuildEdgeAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount, EdgeAdjacency& adjacency) {
+		adjacency.offsets.assign(vertexCount + 1, 0);
+		for(uint32_t index : indices) {
+			adjacency.offsets[index + 1]++;
+		}
+		for(size_t i = 0; i < vertexCount; i++) {
+			adjacency.offsets[i + 1] += adjacency.offsets[i];
+		}
+
+		std::vector<uint32_t> fillCursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		adjacency.targets.resize(indices.size());
+		for(size_t i = 0; i < indices.size(); i++) {
+			size_t next = i % 3 == 2 ? i - 2 : i + 1;
+			adjacency.targets[fillCursor[indices[i]]++] = indices[next];
+		}
+	}
+
+	bool HasEdge(const EdgeAdjacency& adjacency, uint32_t from, uint32_t to) {
+		for(uint32_t i = adjacency.offsets[from]; i < adjacency.offsets[from + 1]; i++) {
+			if(adjacency.targets[i] == to) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Triangles using each vertex, CSR layout
+	void BuildVertexTriangles(const std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& offsets, std::vector<uint32_t>& triangles) {
+		offsets.assign(vertexCount + 1, 0);
+		for(uint32_t index : indices) {
+			offsets[index + 1]++;
+		}
+		for(size_t i = 0; i < vertexCount; i++) {
+			offsets[i + 1] += offsets[i];
+		}
+
+		std::vector<uint32_t> fillCursor(offsets.begin(), offsets.end() - 1);
+		triangles.resize(indices.size());
+		for(size_t i = 0; i < indices.size(); i++) {
+			triangles[fillCursor[indices[i]]++] = (uint32_t)(i / 3);
+		}
+	}
+
+	struct PositionKey {
+		uint32_t bits[3];
+		bool operator==(const PositionKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+	};
+
+	struct PositionKeyHash {
+		size_t operator()(const PositionKey& key) const {
+			return (size_t)key.bits[0] * 73856093u ^ (size_t)key.bits[1] * 19349663u ^ (size_t)key.bits[2] * 83492791u;
+		}
+	};
+
+	struct Collapse {
+		uint32_t source;
+		uint32_t target;
+		float error;           // position + attribute error, used for ordering
+		float positionError;   // position only, reported as the LOD error
+	};
+
+	/// Closest point queries for the Hausdorff measurement, triangles are bucketed in a uniform grid
+	struct TriangleGrid {
+		float origin[3];
+		float cellSize;
+		int dimensions[3];
+		std::vector<uint32_t> cellOffsets {};
+		std::vector<uint32_t> cellTriangles {};
+	};
+
+	void ClosestPointOnTriangle(const float p[3], const float a[3], const float b[3], const float c[3], float result[3]) {
+		// Ericson, Real-Time Collision Detection 5.1.5
+		float ab[3] {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+		float ac[3] {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+		float ap[3] {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+		float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+		if(d1 <= 0.0f && d2 <= 0.0f) {
+			std::memcpy(result, a, sizeof(float) * 3);
+			return;
+		}
+
+		float bp[3] {p[0] - b[0], p[1] - b[1], p[2] - b[2]};
+		float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+		if(d3 >= 0.0f && d4 <= d3) {
+			std::memcpy(result, b, sizeof(float) * 3);
+			return;
+		}
+
+		float vc = d1 * d4 - d3 * d2;
+		if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+			float v = d1 / (d1 - d3);
+			for(int i = 0; i < 3; i++) result[i] = a[i] + v * ab[i];
+			return;
+		}
+
+		float cp[3] {p[0] - c[0], p[1] - c[1], p[2] - c[2]};
+		float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+		if(d6 >= 0.0f && d5 <= d6) {
+			std::memcpy(result, c, sizeof(float) * 3);
+			return;
+		}
+
+		float vb = d5 * d2 - d1 * d6;
+		if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+			float w = d2 / (d2 - d6);
+			for(int i = 0; i < 3; i++) result[i] = a[i] + w * ac[i];
+			return;
+		}
+
+		float va = d3 * d6 - d5 * d4;
+		if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+			float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			for(int i = 0; i < 3; i++) result[i] = b[i] + w * (c[i] - b[i]);
+			return;
+		}
+
+		float denominator = 1.0f / (va + vb + vc);
+		float v = vb * denominator, w = vc * denominator;
+		for(int i = 0; i < 3; i++) result[i] = a[i] + ab[i] * v + ac[i] * w;
+	}
+
+	void BuildTriangleGrid(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, TriangleGrid& grid) {
+		float boundsMin[3] {FLT_MAX, FLT_MAX, FLT_MAX}, boundsMax[3] {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+		for(uint32_t index : indices) {
+			const float* p = &vertices[index].position.x;
+			for(int i = 0; i < 3; i++) {
+				boundsMin[i] = std::min(boundsMin[i], p[i]);
+				boundsMax[i] = std::max(boundsMax[i], p[i]);
+			}
+		}
+
+		// Triangles lie on a surface, so about sqrt(triangle count) cells per axis puts a few triangles into each non-empty cell
+		float extent = std::max({boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2], FLT_MIN});
+		float cellsPerAxis = std::clamp(std::sqrt((float)(indices.size() / 3)) * 0.5f, 1.0f, 128.0f);
+		grid.cellSize = extent / cellsPerAxis;
+		for(int i = 0; i < 3; i++) {
+			grid.origin[i] = boundsMin[i];
+			grid.dimensions[i] = std::max(1, (int)std::ceil((boundsMax[i] - boundsMin[i]) / grid.cellSize));
+		}
+
+		auto CellRange = [&grid](const float* a, const float* b, const float* c, int cellMin[3], int cellMax[3]) {
+			for(int i = 0; i < 3; i++) {
+				float low = std::min({a[i], b[i], c[i]}), high = std::max({a[i], b[i], c[i]});
+				cellMin[i] = std::clamp((int)((low - grid.origin[i]) / grid.cellSize), 0, grid.dimensions[i] - 1);
+				cellMax[i] = std::clamp((int)((high - grid.origin[i]) / grid.cellSize), 0, grid.dimensions[i] - 1);
+			}
+		};
+
+		// Two passes over the triangles: count per cell, then fill (CSR layout)
+		size_t cellCount = (size_t)grid.dimensions[0] * grid.dimensions[1] * grid.dimensions[2];
+		grid.cellOffsets.assign(cellCount + 1, 0);
+		for(int pass = 0; pass < 2; pass++) {
+			std::vector<uint32_t> fillCursor {};
+			if(pass == 1) {
+				for(size_t i = 0; i < cellCount; i++) {
+					grid.cellOffsets[i + 1] += grid.cellOffsets[i];
+				}
+				fillCursor.assign(grid.cellOffsets.begin(), grid.cellOffsets.end() - 1);
+				grid.cellTriangles.resize(grid.cellOffsets[cellCount]);
+			}
+
+			for(size_t t = 0; t < indices.size() / 3; t++) {
+				int cellMin[3], cellMax[3];
+				CellRange(&vertices[indices[t * 3]].position.x, &vertices[indices[t * 3 + 1]].position.x, &vertices[indices[t * 3 + 2]].position.x, cellMin, cellMax);
+				for(int z = cellMin[2]; z <= cellMax[2]; z++) {
+					for(int y = cellMin[1]; y <= cellMax[1]; y++) {
+						for(int x = cellMin[0]; x <= cellMax[0]; x++) {
+							size_t cell = ((size_t)z * grid.dimensions[1] + y) * grid.dimensions[0] + x;
+							if(pass == 0) {
+								grid.cellOffsets[cell + 1]++;
+							}
+							else {
+								grid.cellTriangles[fillCursor[cell]++] = (uint32_t)t;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Distance from p to the closest triangle in the grid, searched in growing shells of cells around p
+	float DistanceToTriangles(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, const TriangleGrid& grid, const float p[3]) {
+		int center[3];
+		for(int i = 0; i < 3; i++) {
+			center[i] = std::clamp((int)std::floor((p[i] - grid.origin[i]) / grid.cellSize), 0, grid.dimensions[i] - 1);
+		}
+
+		float bestDistanceSquared = FLT_MAX;
+		int maxShell = std::max({grid.dimensions[0], grid.dimensions[1], grid.dimensions[2]});
+		for(int shell = 0; shell <= maxShell; shell++) {
+			// Cells not searched yet lie outside the box of shells 0..shell-1, stop once p is closer to a triangle than to that box
+			if(shell > 0) {
+				float boxDistance = FLT_MAX;
+				for(int i = 0; i < 3; i++) {
+					if(center[i] - shell >= 0) {
+						boxDistance = std::min(boxDistance, p[i] - (grid.origin[i] + (center[i] - shell + 1) * grid.cellSize));
+					}
+					if(center[i] + shell < grid.dimensions[i]) {
+						boxDistance = std::min(boxDistance, grid.origin[i] + (center[i] + shell) * grid.cellSize - p[i]);
+					}
+				}
+				boxDistance = std::max(boxDistance, 0.0f);
+				if(boxDistance != FLT_MAX && boxDistance * boxDistance >= bestDistanceSquared) {
+					break;
+				}
+			}
+
+			for(int z = center[2] - shell; z <= center[2] + shell; z++) {
+				for(int y = center[1] - shell; y <= center[1] + shell; y++) {
+					for(int x = center[0] - shell; x <= center[0] + shell; x++) {
+						bool b_OnShell = std::abs(x - center[0]) == shell || std::abs(y - center[1]) == shell || std::abs(z - center[2]) == shell;
+						if(!b_OnShell || x < 0 || y < 0 || z < 0 || x >= grid.dimensions[0] || y >= grid.dimensions[1] || z >= grid.dimensions[2]) {
+							continue;
+						}
+
+						size_t cell = ((size_t)z * grid.dimensions[1] + y) * grid.dimensions[0] + x;
+						for(uint32_t i = grid.cellOffsets[cell]; i < grid.cellOffsets[cell + 1]; i++) {
+							uint32_t t = grid.cellTriangles[i];
+							float closest[3];
+							ClosestPointOnTriangle(p, &vertices[indices[t * 3]].position.x, &vertices[indices[t * 3 + 1]].position.x, &vertices[indices[t * 3 + 2]].position.x, closest);
+							float offset[3] {closest[0] - p[0], closest[1] - p[1], closest[2] - p[2]};
+							bestDistanceSquared = std::min(bestDistanceSquared, Dot(offset, offset));
+						}
+					}
+				}
+			}
+		}
+		return std::sqrt(bestDistanceSquared);
+	}
+
+	// One-sided Hausdorff distance from surface A to surface B, A is sampled at vertices, edge midpoints and interior points
+	float DirectedHausdorffError(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indicesA, const std::vector<uint32_t>& indicesB) {
+		if(indicesB.empty()) {
+			return indicesA.empty() ? 0.0f : FLT_MAX;
+		}
+
+		TriangleGrid grid {};
+		BuildTriangleGrid(vertices, indicesB, grid);
+
+		static const float s_SampleWeights[][3] {
+			{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
+			{0.5f, 0.5f, 0.0f}, {0.0f, 0.5f, 0.5f}, {0.5f, 0.0f, 0.5f},
+			{1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f},
+			{2.0f / 3.0f, 1.0f / 6.0f, 1.0f / 6.0f}, {1.0f / 6.0f, 2.0f / 3.0f, 1.0f / 6.0f}, {1.0f / 6.0f, 1.0f / 6.0f, 2.0f / 3.0f},
+		};
+
+		float maxDistance = 0.0f;
+		for(size_t t = 0; t < indicesA.size() / 3; t++) {
+			const XMFLOAT3& a = vertices[indicesA[t * 3]].position;
+			const XMFLOAT3& b = vertices[indicesA[t * 3 + 1]].position;
+			const XMFLOAT3& c = vertices[indicesA[t * 3 + 2]].position;
+			for(const float* weights : s_SampleWeights) {
+				float p[3] {
+					a.x * weights[0] + b.x * weights[1] + c.x * weights[2],
+					a.y * weights[0] + b.y * weights[1] + c.y * weights[2],
+					a.z * weights[0] + b.z * weights[1] + c.z * weights[2]};
+				maxDistance = std::max(maxDistance, DistanceToTriangles(vertices, indicesB, grid, p));
+			}
+		}
+		return maxDistance;
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::SimplifyMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float& resultError) {
+	size_t vertexCount = vertices.size();
+	std::vector<uint32_t> result = indices;
+	resultError = 0.0f;
+	if(indices.size() <= targetIndexCount || vertexCount == 0) {
+		return result;
+	}
+
+	/// Positions normalized to the unit cube, so error weights and thresholds do not depend on the mesh scale
+	float boundsMin[3] {FLT_MAX, FLT_MAX, FLT_MAX}, boundsMax[3] {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for(const MeshVertex& vertex : vertices) {
+		const float* p = &vertex.position.x;
+		for(int i = 0; i < 3; i++) {
+			boundsMin[i] = std::min(boundsMin[i], p[i]);
+			boundsMax[i] = std::max(boundsMax[i], p[i]);
+		}
+	}
+	float meshScale = std::max({boundsMax[0] - boundsMin[0], boundsMax[1] - boundsMin[1], boundsMax[2] - boundsMin[2], FLT_MIN});
+
+	std::vector<float> positions(vertexCount * 3);
+	std::vector<float> attributes(vertexCount * s_AttributeCount);
+	for(size_t v = 0; v < vertexCount; v++) {
+		const MeshVertex& vertex = vertices[v];
+		const float* p = &vertex.position.x;
+		for(int i = 0; i < 3; i++) {
+			positions[v * 3 + i] = (p[i] - boundsMin[i]) / meshScale;
+		}
+		float* attribute = &attributes[v * s_AttributeCount];
+		attribute[0] = vertex.texture.x * s_UVWeight;
+		attribute[1] = vertex.texture.y * s_UVWeight;
+		attribute[2] = vertex.normal.x * s_NormalWeight;
+		attribute[3] = vertex.normal.y * s_NormalWeight;
+		attribute[4] = vertex.normal.z * s_NormalWeight;
+	}
+	float maxNormalizedError = maxError / meshScale;
+
+	/// Wedges: vertices sharing a position (split by uv or normal seams), remap points to the first one, wedge links them in a ring
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint32_t> wedge(vertexCount);
+	{
+		std::unordered_map<PositionKey, uint32_t, PositionKeyHash> firstVertex {};
+		firstVertex.reserve(vertexCount);
+		for(uint32_t v = 0; v < vertexCount; v++) {
+			PositionKey key {};
+			std::memcpy(key.bits, &vertices[v].position, sizeof(key.bits));
+			auto [it, b_Inserted] = firstVertex.emplace(key, v);
+			remap[v] = it->second;
+			if(b_Inserted) {
+				wedge[v] = v;
+			}
+			else {
+				wedge[v] = wedge[it->second];
+				wedge[it->second] = v;
+			}
+		}
+	}
+
+	/// Classify vertices from their open (unpaired) half-edges
+	EdgeAdjacency adjacency {};
+	BuildEdgeAdjacency(indices, vertexCount, adjacency);
+
+	// Open edge into / out of every vertex, s_InvalidIndex if none, the vertex itself if there are several
+	std::vector<uint32_t> openIncoming(vertexCount, s_InvalidIndex);
+	std::vector<uint32_t> openOutgoing(vertexCount, s_InvalidIndex);
+	for(uint32_t v = 0; v < vertexCount; v++) {
+		for(uint32_t i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; i++) {
+			uint32_t target = adjacency.targets[i];
+			if(HasEdge(adjacency, target, v)) {
+				continue;
+			}
+			openOutgoing[v] = openOutgoing[v] == s_InvalidIndex ? target : v;
+			openIncoming[target] = openIncoming[target] == s_InvalidIndex ? v : target;
+		}
+	}
+
+	auto IsSingleOpenEdge = [](uint32_t openVertex, uint32_t v) { return openVertex != s_InvalidIndex && openVertex != v; };
+
+	// An edge exists in position space if any wedge of from has an edge to any wedge of to
+	auto HasPositionEdge = [&](uint32_t from, uint32_t to) {
+		uint32_t w = from;
+		do {
+			for(uint32_t i = adjacency.offsets[w]; i < adjacency.offsets[w + 1]; i++) {
+				if(remap[adjacency.targets[i]] == remap[to]) {
+					return true;
+				}
+			}
+			w = wedge[w];
+		} while(w != from);
+		return false;
+	};
+
+	std::vector<unsigned char> kinds(vertexCount, kLockedVertex);
+	for(uint32_t v = 0; v < vertexCount; v++) {
+		if(remap[v] != v) {
+			kinds[v] = kinds[remap[v]];
+			continue;
+		}
+
+		if(wedge[v] == v) {
+			if(openIncoming[v] == s_InvalidIndex && openOutgoing[v] == s_InvalidIndex) {
+				kinds[v] = kManifoldVertex;
+			}
+			else if(IsSingleOpenEdge(openIncoming[v], v) && IsSingleOpenEdge(openOutgoing[v], v)) {
+				// Open in index space but closed in position space means a seam ends here
+				bool b_IsBorder = !HasPositionEdge(openOutgoing[v], v) && !HasPositionEdge(v, openIncoming[v]);
+				kinds[v] = b_IsBorder ? kBorderVertex : kLockedVertex;
+			}
+		}
+		else if(wedge[wedge[v]] == v) {
+			// Two wedges whose open edges run along the same seam in opposite directions
+			uint32_t w = wedge[v];
+			if(IsSingleOpenEdge(openIncoming[v], v) && IsSingleOpenEdge(openOutgoing[v], v) && IsSingleOpenEdge(openIncoming[w], w) && IsSingleOpenEdge(openOutgoing[w], w) &&
+				remap[openOutgoing[v]] == remap[openIncoming[w]] && remap[openIncoming[v]] == remap[openOutgoing[w]]) {
+				kinds[v] = kSeamVertex;
+			}
+		}
+	}
+	// Vertices seen before their first wedge was classified
+	for(uint32_t v = 0; v < vertexCount; v++) {
+		kinds[v] = kinds[remap[v]];
+	}
+
+	/// Quadrics: plane quadrics per position, attribute quadrics per wedge
+	std::vector<Quadric> quadrics(vertexCount, Quadric {});
+	std::vector<AttributeQuadric> attributeQuadrics(vertexCount * s_AttributeCount, AttributeQuadric {});
+	for(size_t t = 0; t < indices.size() / 3; t++) {
+		uint32_t corners[3] {indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]};
+		const float* p0 = &positions[corners[0] * 3];
+		const float* p1 = &positions[corners[1] * 3];
+		const float* p2 = &positions[corners[2] * 3];
+		float e1[3] {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+		float e2[3] {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+		float normal[3];
+		Cross(e1, e2, normal);
+		float length = std::sqrt(Dot(normal, normal));
+		if(length <= 0.0f) {
+			continue;
+		}
+		float area = length * 0.5f;
+		for(int i = 0; i < 3; i++) {
+			normal[i] /= length;
+		}
+
+		for(uint32_t corner : corners) {
+			AddPlane(quadrics[remap[corner]], normal, -Dot(normal, p0), area);
+		}
+
+		// Border and seam edges: plane through the edge, perpendicular to the triangle
+		for(int e = 0; e < 3; e++) {
+			uint32_t from = corners[e], to = corners[(e + 1) % 3];
+			if(HasEdge(adjacency, to, from)) {
+				continue;
+			}
+			const float* a = &positions[from * 3];
+			const float* b = &positions[to * 3];
+			float edge[3] {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+			float edgeLength = std::sqrt(Dot(edge, edge));
+			float edgeNormal[3];
+			Cross(edge, normal, edgeNormal);
+			float edgeNormalLength = std::sqrt(Dot(edgeNormal, edgeNormal));
+			if(edgeNormalLength <= 0.0f) {
+				continue;
+			}
+			for(int i = 0; i < 3; i++) {
+				edgeNormal[i] /= edgeNormalLength;
+			}
+			float weight = edgeLength * edgeLength * s_BorderEdgeWeight;
+			AddPlane(quadrics[remap[from]], edgeNormal, -Dot(edgeNormal, a), weight);
+			AddPlane(quadrics[remap[to]], edgeNormal, -Dot(edgeNormal, a), weight);
+		}
+
+		// Attribute gradient g and offset d such that g.p + d interpolates the attribute over the triangle
+		float e11 = Dot(e1, e1), e12 = Dot(e1, e2), e22 = Dot(e2, e2);
+		float determinant = e11 * e22 - e12 * e12;
+		if(std::abs(determinant) <= FLT_MIN) {
+			continue;
+		}
+		for(int k = 0; k < s_AttributeCount; k++) {
+			float s0 = attributes[corners[0] * s_AttributeCount + k];
+			float ds1 = attributes[corners[1] * s_AttributeCount + k] - s0;
+			float ds2 = attributes[corners[2] * s_AttributeCount + k] - s0;
+			float alpha = (e22 * ds1 - e12 * ds2) / determinant;
+			float beta = (e11 * ds2 - e12 * ds1) / determinant;
+			float g[3] {alpha * e1[0] + beta * e2[0], alpha * e1[1] + beta * e2[1], alpha * e1[2] + beta * e2[2]};
+			float d = s0 - Dot(g, p0);
+
+			AttributeQuadric quadric {};
+			quadric.a00 = area * g[0] * g[0]; quadric.a11 = area * g[1] * g[1]; quadric.a22 = area * g[2] * g[2];
+			quadric.a01 = area * g[0] * g[1]; quadric.a02 = area * g[0] * g[2]; quadric.a12 = area * g[1] * g[2];
+			quadric.b0 = area * g[0] * d; quadric.b1 = area * g[1] * d; quadric.b2 = area * g[2] * d;
+			quadric.c = area * d * d;
+			quadric.g0 = area * g[0]; quadric.g1 = area * g[1]; quadric.g2 = area * g[2];
+			quadric.d = area * d;
+			quadric.weight = area;
+			for(uint32_t corner : corners) {
+				AddQuadric(attributeQuadrics[corner * s_AttributeCount + k], quadric);
+			}
+		}
+	}
+
+	/// Target wedge when the position of source collapses onto the position of target
+	// Manifold/border vertices have one wedge, seam vertices map each wedge along its own open edge
+	auto WedgeTarget = [&](uint32_t sourceWedge, uint32_t target) {
+		if(kinds[sourceWedge] == kSeamVertex) {
+			if(remap[openOutgoing[sourceWedge]] == remap[target]) return openOutgoing[sourceWedge];
+			if(remap[openIncoming[sourceWedge]] == remap[target]) return openIncoming[sourceWedge];
+			return s_InvalidIndex;
+		}
+		return target;
+	};
+
+	auto CanCollapse = [&](uint32_t source, uint32_t target) {
+		switch(kinds[source]) {
+		case kManifoldVertex:
+			return true;
+		case kBorderVertex:
+		case kSeamVertex:
+			// Only along the border/seam, onto a vertex that is on it too
+			if(kinds[target] == kManifoldVertex) {
+				return false;
+			}
+			return remap[openOutgoing[source]] == remap[target] || remap[openIncoming[source]] == remap[target];
+		default:
+			return false;
+		}
+	};
+
+	auto EvaluateCollapse = [&](uint32_t source, uint32_t target, Collapse& collapse) {
+		const float* p = &positions[target * 3];
+		collapse.source = source;
+		collapse.target = target;
+		collapse.positionError = EvaluateQuadric(quadrics[remap[source]], p);
+		collapse.error = collapse.positionError;
+
+		uint32_t w = source;
+		do {
+			uint32_t wedgeTarget = WedgeTarget(w, target);
+			if(wedgeTarget == s_InvalidIndex) {
+				return false;
+			}
+			for(int k = 0; k < s_AttributeCount; k++) {
+				collapse.error += EvaluateQuadric(attributeQuadrics[w * s_AttributeCount + k], p, attributes[wedgeTarget * s_AttributeCount + k]);
+			}
+			w = wedge[w];
+		} while(w != source);
+		return true;
+	};
+
+	std::vector<uint32_t> triangleOffsets {};
+	std::vector<uint32_t> vertexTriangles {};
+
+	// True if moving source to target turns any remaining triangle around source too far (or folds it over)
+	auto HasTriangleFlip = [&](uint32_t source, uint32_t target) {
+		const float* newPosition = &positions[target * 3];
+		uint32_t w = source;
+		do {
+			for(uint32_t i = triangleOffsets[w]; i < triangleOffsets[w + 1]; i++) {
+				const uint32_t* triangle = &result[vertexTriangles[i] * 3];
+				// Triangles on the collapsed edge degenerate and are removed
+				if(remap[triangle[0]] == remap[target] || remap[triangle[1]] == remap[target] || remap[triangle[2]] == remap[target]) {
+					continue;
+				}
+
+				const float* corners[3];
+				const float* movedCorners[3];
+				for(int c = 0; c < 3; c++) {
+					corners[c] = &positions[triangle[c] * 3];
+					movedCorners[c] = remap[triangle[c]] == remap[source] ? newPosition : corners[c];
+				}
+
+				float e1[3] {corners[1][0] - corners[0][0], corners[1][1] - corners[0][1], corners[1][2] - corners[0][2]};
+				float e2[3] {corners[2][0] - corners[0][0], corners[2][1] - corners[0][1], corners[2][2] - corners[0][2]};
+				float m1[3] {movedCorners[1][0] - movedCorners[0][0], movedCorners[1][1] - movedCorners[0][1], movedCorners[1][2] - movedCorners[0][2]};
+				float m2[3] {movedCorners[2][0] - movedCorners[0][0], movedCorners[2][1] - movedCorners[0][1], movedCorners[2][2] - movedCorners[0][2]};
+				float oldNormal[3], newNormal[3];
+				Cross(e1, e2, oldNormal);
+				Cross(m1, m2, newNormal);
+				if(Dot(oldNormal, newNormal) <= s_MinFlipCosine * std::sqrt(Dot(oldNormal, oldNormal) * Dot(newNormal, newNormal))) {
+					return true;
+				}
+			}
+			w = wedge[w];
+		} while(w != source);
+		return false;
+	};
+
+	/// Collapse passes: collect candidate edges, apply the cheapest non-conflicting ones, repeat
+	std::vector<Collapse> collapses {};
+	std::vector<bool> positionLocked(vertexCount, false);
+	std::vector<uint32_t> collapseRemap(vertexCount);
+	float maxPositionError = 0.0f;
+
+	while(result.size() > targetIndexCount) {
+		collapses.clear();
+		for(size_t i = 0; i < result.size(); i++) {
+			uint32_t a = result[i];
+			uint32_t b = result[i % 3 == 2 ? i - 2 : i + 1];
+			if(remap[a] == remap[b]) {
+				continue;
+			}
+
+			Collapse best {s_InvalidIndex, s_InvalidIndex, FLT_MAX, FLT_MAX};
+			Collapse candidate {};
+			if(CanCollapse(a, b) && EvaluateCollapse(a, b, candidate) && candidate.error < best.error) {
+				best = candidate;
+			}
+			if(CanCollapse(b, a) && EvaluateCollapse(b, a, candidate) && candidate.error < best.error) {
+				best = candidate;
+			}
+			if(best.source != s_InvalidIndex && best.positionError <= maxNormalizedError * maxNormalizedError) {
+				collapses.push_back(best);
+			}
+		}
+		if(collapses.empty()) {
+			break;
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+			return a.error < b.error;
+		});
+
+		BuildVertexTriangles(result, vertexCount, triangleOffsets, vertexTriangles);
+		std::fill(positionLocked.begin(), positionLocked.end(), false);
+		for(uint32_t v = 0; v < vertexCount; v++) {
+			collapseRemap[v] = v;
+		}
+
+		// A manifold collapse removes two triangles, a border collapse one
+		size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+		size_t removedTriangles = 0;
+		size_t appliedCollapses = 0;
+		for(const Collapse& collapse : collapses) {
+			if(removedTriangles >= trianglesToRemove) {
+				break;
+			}
+
+			uint32_t sourcePosition = remap[collapse.source];
+			uint32_t targetPosition = remap[collapse.target];
+			if(positionLocked[sourcePosition] || positionLocked[targetPosition]) {
+				continue;
+			}
+			if(HasTriangleFlip(collapse.source, collapse.target)) {
+				continue;
+			}
+
+			uint32_t w = collapse.source;
+			do {
+				uint32_t wedgeTarget = WedgeTarget(w, collapse.target);
+				collapseRemap[w] = wedgeTarget;
+				for(int k = 0; k < s_AttributeCount; k++) {
+					AddQuadric(attributeQuadrics[wedgeTarget * s_AttributeCount + k], attributeQuadrics[w * s_AttributeCount + k]);
+				}
+				w = wedge[w];
+			} while(w != collapse.source);
+			AddQuadric(quadrics[targetPosition], quadrics[sourcePosition]);
+
+			// Neighbourhoods of both ends changed, their collapse errors are re-evaluated next pass
+			positionLocked[sourcePosition] = true;
+			positionLocked[targetPosition] = true;
+
+			removedTriangles += kinds[collapse.source] == kManifoldVertex ? 2 : 1;
+			maxPositionError = std::max(maxPositionError, collapse.positionError);
+			appliedCollapses++;
+		}
+		if(appliedCollapses == 0) {
+			break;
+		}
+
+		// Remap indices and drop triangles that became degenerate
+		size_t writeIndex = 0;
+		for(size_t i = 0; i < result.size(); i += 3) {
+			uint32_t a = collapseRemap[result[i]], b = collapseRemap[result[i + 1]], c = collapseRemap[result[i + 2]];
+			if(remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c]) {
+				continue;
+			}
+			result[writeIndex++] = a;
+			result[writeIndex++] = b;
+			result[writeIndex++] = c;
+		}
+		result.resize(writeIndex);
+	}
+
+	resultError = std::sqrt(maxPositionError) * meshScale;
+	return result;
+}
+
+void MeshSimplifier::GenerateLODs(MeshData& meshData) {
+	if(meshData.subMeshes.empty()) {
+		meshData.subMeshes.push_back(SubMesh {"", 0, (uint32_t)meshData.indices.size()});
+	}
+
+	meshData.lods.clear();
+	meshData.lods.push_back(MeshLOD {0, (uint32_t)meshData.indices.size(), 0, 0, 0.0f});
+	meshData.subMeshLODs.clear();
+	for(const SubMesh& subMesh : meshData.subMeshes) {
+		meshData.subMeshLODs.push_back(MeshLOD {subMesh.firstIndex, subMesh.indexCount, 0, 0, 0.0f});
+	}
+
+	const MeshBounds& bounds = meshData.bounds;
+	float meshScale = std::max({bounds.aabbMax.x - bounds.aabbMin.x, bounds.aabbMax.y - bounds.aabbMin.y, bounds.aabbMax.z - bounds.aabbMin.z});
+	float maxError = kMaxRelativeLODError * meshScale;
+
+	// Every level is simplified from LOD 0, so its error is measured against the original surface
+	// Sub-meshes are simplified one by one, over a compact copy of the vertices they use, so their triangles stay together and a sub-mesh only costs its own size
+	// Note: vertices shared with another sub-mesh are on a border of both, borders only collapse along themselves but the two sides may pick different collapses
+	const uint32_t unassigned = 0xFFFFFFFF;
+	std::vector<uint32_t> localVertexIds(meshData.vertices.size(), unassigned);
+	std::vector<uint32_t> globalVertexIds {};
+	std::vector<MeshVertex> localVertices {};
+	std::vector<uint32_t> localIndices {};
+
+	float targetTriangleRatio = 1.0f;
+	for(int lod = 1; lod < kMaxLODCount; lod++) {
+		targetTriangleRatio *= kLODTriangleRatio;
+
+		MeshLOD lodRange {(uint32_t)meshData.indices.size(), 0, 0, 0, 0.0f};
+		std::vector<uint32_t> lodIndices {};
+		std::vector<MeshLOD> subMeshLODRanges {};
+		for(const SubMesh& subMesh : meshData.subMeshes) {
+			const uint32_t* sourceIndices = meshData.indices.data() + subMesh.firstIndex;
+			globalVertexIds.clear();
+			localVertices.clear();
+			localIndices.resize(subMesh.indexCount);
+			for(uint32_t i = 0; i < subMesh.indexCount; i++) {
+				uint32_t& localVertexId = localVertexIds[sourceIndices[i]];
+				if(localVertexId == unassigned) {
+					localVertexId = (uint32_t)localVertices.size();
+					globalVertexIds.push_back(sourceIndices[i]);
+					localVertices.push_back(meshData.vertices[sourceIndices[i]]);
+				}
+				localIndices[i] = localVertexId;
+			}
+			for(uint32_t vertex : globalVertexIds) {
+				localVertexIds[vertex] = unassigned;
+			}
+
+			float error = 0.0f;
+			size_t targetTriangleCount = (size_t)(subMesh.indexCount / 3 * targetTriangleRatio);
+			std::vector<uint32_t> subMeshIndices = SimplifyMesh(localVertices, localIndices, targetTriangleCount * 3, maxError, error);
+			MeshOptimizer::OptimizeVertexCache(subMeshIndices, localVertices.size());
+
+			subMeshLODRanges.push_back(MeshLOD {lodRange.firstIndex + (uint32_t)lodIndices.size(), (uint32_t)subMeshIndices.size(), 0, 0, error});
+			for(uint32_t index : subMeshIndices) {
+				lodIndices.push_back(globalVertexIds[index]);
+			}
+			lodRange.error = std::max(lodRange.error, error);
+		}
+
+		if(lodIndices.empty() || lodIndices.size() > meshData.lods.back().indexCount * s_MinLODReduction) {
+			break;
+		}
+
+		lodRange.indexCount = (uint32_t)lodIndices.size();
+		meshData.lods.push_back(lodRange);
+		meshData.subMeshLODs.insert(meshData.subMeshLODs.end(), subMeshLODRanges.begin(), subMeshLODRanges.end());
+		meshData.indices.insert(meshData.indices.end(), lodIndices.begin(), lodIndices.end());
+	}
+}
+
+float MeshSimplifier::MeasureHausdorffError(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indicesA, const std::vector<uint32_t>& indicesB) {
+	return std::max(DirectedHausdorffError(vertices, indicesA, indicesB), DirectedHausdorffError(vertices, indicesB, indicesA));
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "MeshData.h"
+
+// Edge collapse simplification with quadric error metrics (Garland & Heckbert 1997)
+// Vertices only ever collapse onto existing vertices, so every LOD indexes the same vertex buffer
+// Collapse error includes uv and normal quadrics (Hoppe 1999), uv/normal seams and mesh borders only collapse along themselves
+class MeshSimplifier {
+public:
+	// LOD n targets kLODTriangleRatio^n of the LOD 0 triangle count, the chain stops early once a level no longer reduces enough
+	static constexpr int kMaxLODCount = 5;
+	static constexpr float kLODTriangleRatio = 0.5f;
+
+	// Largest geometric error a LOD may have, relative to the mesh size (largest AABB dimension)
+	static constexpr float kMaxRelativeLODError = 0.05f;
+
+	// Appends LOD 1..n index ranges to meshData.indices and fills meshData.lods (LOD 0 is the current index buffer)
+	// Each sub-mesh is simplified on its own and fills its part of every LOD in meshData.subMeshLODs, a LOD's error is the largest of its parts
+	// Each LOD's triangles are vertex cache optimized, errors are relative to meshData.bounds (see BoundingVolumes)
+	static void GenerateLODs(MeshData& meshData);
+
+	// Simplified copy of indices with at most targetIndexCount indices, unless that would take the error above maxError (model units)
+	// resultError receives the geometric error of the result in model units
+	static std::vector<uint32_t> SimplifyMesh(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float& resultError);
+
+	// Symmetric Hausdorff distance between two triangle lists over the same vertices, approximated by sampling both surfaces
+	static float MeasureHausdorffError(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indicesA, const std::vector<uint32_t>& indicesB);
+};
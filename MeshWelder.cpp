@@ -0,0 +1,106 @@
+#include "MeshWelder.h"
+
+#include <array>
+#include <cmath>
+
+namespace {
+	constexpr int s_VertexComponentCount = sizeof(MeshVertex) / sizeof(float);
+	constexpr uint32_t s_EmptySlot = 0xFFFFFFFF;
+
+	using VertexKey = std::array<int32_t, s_VertexComponentCount>;
+
+	VertexKey QuantizeVertex(const MeshVertex& vertex, float inverseEpsilon) {
+		const float* components = (const float*)&vertex;
+
+		VertexKey key {};
+		for(int i = 0; i < s_VertexComponentCount; i++) {
+			key[i] = (int32_t)std::lround(components[i] * inverseEpsilon);
+		}
+		return key;
+	}
+
+	// FNV-1a over the quantized components
+	uint32_t HashVertexKey(const VertexKey& key) {
+		uint32_t hash = 2166136261u;
+		for(int32_t component : key) {
+			hash = (hash ^ (uint32_t)component) * 16777619u;
+		}
+		return hash;
+	}
+}
+
+float MeshWelder::WeldVertices(MeshData& meshData, float epsilon) {
+	const std::vector<MeshVertex>& sourceVertices = meshData.vertices;
+	size_t sourceVertexCount = sourceVertices.size();
+	if(sourceVertexCount == 0) {
+		return 1.0f;
+	}
+
+	// Open addressing hash table (linear probing), sized to a power of two with load factor <= 0.5
+	size_t tableSize = 1;
+	while(tableSize < sourceVertexCount * 2) {
+		tableSize *= 2;
+	}
+	std::vector<uint32_t> hashTable(tableSize, s_EmptySlot);
+
+	std::vector<MeshVertex> uniqueVertices {};
+	std::vector<VertexKey> uniqueKeys {};
+	uniqueVertices.reserve(sourceVertexCount);
+	uniqueKeys.reserve(sourceVertexCount);
+
+	// Maps source vertex index to welded vertex index
+	std::vector<uint32_t> remap(sourceVertexCount);
+
+	float inverseEpsilon = 1.0f / epsilon;
+	for(size_t i = 0; i < sourceVertexCount; i++) {
+		VertexKey key = QuantizeVertex(sourceVertices[i], inverseEpsilon);
+
+		size_t slot = HashVertexKey(key) & (tableSize - 1);
+		while(hashTable[slot] != s_EmptySlot && uniqueKeys[hashTable[slot]] != key) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+
+		if(hashTable[slot] == s_EmptySlot) {
+			hashTable[slot] = (uint32_t)uniqueVertices.size();
+			uniqueVertices.push_back(sourceVertices[i]);
+			uniqueKeys.push_back(key);
+		}
+
+		remap[i] = hashTable[slot];
+	}
+
+	// Rebuild index buffer, dropping triangles that became degenerate
+	// Sub-mesh ranges are in index order, each one starts where the welded indices are when its first triangle comes up
+	std::vector<uint32_t> weldedIndices {};
+	weldedIndices.reserve(meshData.indices.size());
+	size_t nextSubMesh = 0;
+	for(size_t i = 0; i + 2 < meshData.indices.size(); i += 3) {
+		while(nextSubMesh < meshData.subMeshes.size() && meshData.subMeshes[nextSubMesh].firstIndex <= i) {
+			meshData.subMeshes[nextSubMesh++].firstIndex = (uint32_t)weldedIndices.size();
+		}
+
+		uint32_t i0 = remap[meshData.indices[i + 0]];
+		uint32_t i1 = remap[meshData.indices[i + 1]];
+		uint32_t i2 = remap[meshData.indices[i + 2]];
+		if(i0 == i1 || i1 == i2 || i0 == i2) {
+			continue;
+		}
+
+		weldedIndices.push_back(i0);
+		weldedIndices.push_back(i1);
+		weldedIndices.push_back(i2);
+	}
+
+	for(; nextSubMesh < meshData.subMeshes.size(); nextSubMesh++) {
+		meshData.subMeshes[nextSubMesh].firstIndex = (uint32_t)weldedIndices.size();
+	}
+	for(size_t i = 0; i < meshData.subMeshes.size(); i++) {
+		uint32_t endIndex = i + 1 < meshData.subMeshes.size() ? meshData.subMeshes[i + 1].firstIndex : (uint32_t)weldedIndices.size();
+		meshData.subMeshes[i].indexCount = endIndex - meshData.subMeshes[i].firstIndex;
+	}
+
+	meshData.vertices = std::move(uniqueVertices);
+	meshData.indices = std::move(weldedIndices);
+
+	return (float)sourceVertexCount / (float)meshData.vertices.size();
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "MeshData.h"
+
+// Merges duplicate vertices of a triangle soup into a unique vertex array plus index buffer
+class MeshWelder {
+public:
+	// Vertices whose attributes (position, uv, normal, tangent, binormal) all land in the same epsilon sized grid cell are merged
+	// Triangles that collapse are removed
+	// Returns the vertex reduction ratio (source vertex count / welded vertex count)
+	static float WeldVertices(MeshData& meshData, float epsilon);
+};
@@ -0,0 +1,278 @@
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+	constexpr uint32_t s_InvalidIndex = UINT32_MAX;
+
+	// Normal cones wider than this (cosine of the half angle) are not worth culling against, they are almost never entirely backfacing
+	constexpr float s_MinConeCosine = 0.1f;
+
+	// Triangles using each vertex, CSR layout: triangles of vertex v are triangles[offsets[v], offsets[v + 1])
+	void BuildVertexTriangles(const std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>& offsets, std::vector<uint32_t>& triangles) {
+		offsets.assign(vertexCount + 1, 0);
+		for(uint32_t index : indices) {
+			offsets[index + 1]++;
+		}
+		for(size_t i = 0; i < vertexCount; i++) {
+			offsets[i + 1] += offsets[i];
+		}
+
+		std::vector<uint32_t> fillCursor(offsets.begin(), offsets.end() - 1);
+		triangles.resize(indices.size());
+		for(size_t i = 0; i < indices.size(); i++) {
+			triangles[fillCursor[indices[i]]++] = (uint32_t)(i / 3);
+		}
+	}
+}
+
+void MeshletBuilder::BuildMeshlets(MeshData& meshData) {
+	const std::vector<uint32_t>& indices = meshData.indices;
+	size_t triangleCount = indices.size() / 3;
+	size_t vertexCount = meshData.vertices.size();
+
+	meshData.meshlets.clear();
+	if(triangleCount == 0) {
+		return;
+	}
+
+	// Without a LOD chain the whole index buffer is LOD 0, without sub-mesh ranges every LOD is a single part
+	if(meshData.lods.empty()) {
+		meshData.lods.push_back(MeshLOD {0, (uint32_t)indices.size(), 0, 0, 0.0f});
+	}
+	if(meshData.subMeshLODs.empty()) {
+		meshData.subMeshLODs = meshData.lods;
+	}
+	size_t subMeshCount = meshData.subMeshLODs.size() / meshData.lods.size();
+
+	std::vector<uint32_t> vertexTriangleOffsets {};
+	std::vector<uint32_t> vertexTriangles {};
+	BuildVertexTriangles(indices, vertexCount, vertexTriangleOffsets, vertexTriangles);
+
+	std::vector<bool> triangleEmitted(triangleCount, false);
+	// Meshlet that last referenced each vertex, tells whether a vertex is already part of the current meshlet
+	std::vector<uint32_t> vertexMeshlet(vertexCount, s_InvalidIndex);
+
+	std::vector<uint32_t> output {};
+	output.reserve(indices.size());
+
+	// Unemitted triangles sharing a vertex with the current meshlet (may hold duplicates and emitted triangles)
+	std::vector<uint32_t> candidates {};
+	std::vector<uint32_t> meshletVertices {};
+	std::vector<uint32_t> localIndices {};
+
+	Meshlet meshlet {};
+	float meshletPositionSum[3] {};
+	uint32_t meshletIndex = 0;
+
+	auto FinishMeshlet = [&]() {
+		// Local vertex cache order inside the meshlet, meshlets are small enough that this is cheap
+		localIndices.clear();
+		for(size_t i = meshlet.firstIndex; i < output.size(); i++) {
+			localIndices.push_back((uint32_t)(std::find(meshletVertices.begin(), meshletVertices.end(), output[i]) - meshletVertices.begin()));
+		}
+		MeshOptimizer::OptimizeVertexCache(localIndices, meshletVertices.size());
+		for(size_t i = 0; i < localIndices.size(); i++) {
+			output[meshlet.firstIndex + i] = meshletVertices[localIndices[i]];
+		}
+
+		meshData.meshlets.push_back(meshlet);
+		meshletIndex++;
+
+		meshlet = Meshlet {};
+		meshlet.firstIndex = (uint32_t)output.size();
+		meshletVertices.clear();
+		meshletPositionSum[0] = meshletPositionSum[1] = meshletPositionSum[2] = 0.0f;
+		candidates.clear();
+	};
+
+	// Every LOD gets its own meshlets, so a LOD can be culled and drawn without touching the others
+	// Within a LOD every sub-mesh gets its own meshlets too, so sub-meshes are culled and drawn separately
+	for(size_t lodIndex = 0; lodIndex < meshData.lods.size(); lodIndex++) {
+		MeshLOD& lod = meshData.lods[lodIndex];
+		lod.firstMeshlet = (uint32_t)meshData.meshlets.size();
+
+		for(size_t subMeshIndex = 0; subMeshIndex < subMeshCount; subMeshIndex++) {
+			MeshLOD& subMeshLOD = meshData.subMeshLODs[lodIndex * subMeshCount + subMeshIndex];
+			size_t firstTriangle = subMeshLOD.firstIndex / 3;
+			size_t endTriangle = firstTriangle + subMeshLOD.indexCount / 3;
+			size_t seedCursor = firstTriangle;
+
+			subMeshLOD.firstMeshlet = (uint32_t)meshData.meshlets.size();
+			meshlet.firstIndex = (uint32_t)output.size();
+
+			for(size_t emittedCount = firstTriangle; emittedCount < endTriangle; emittedCount++) {
+				/// Next triangle: the adjacent one adding the fewest new vertices, ties go to the one closest to the meshlet centroid
+				// Compact meshlets get tighter spheres and narrower normal cones, both cull better
+				float centroid[3] {};
+				if(!meshletVertices.empty()) {
+					for(int i = 0; i < 3; i++) {
+						centroid[i] = meshletPositionSum[i] / (float)meshletVertices.size();
+					}
+				}
+
+				uint32_t bestTriangle = s_InvalidIndex;
+				uint32_t bestNewVertexCount = 4;
+				float bestDistance = FLT_MAX;
+				size_t liveCandidateCount = 0;
+				for(uint32_t triangle : candidates) {
+					if(triangleEmitted[triangle]) {
+						continue;
+					}
+					candidates[liveCandidateCount++] = triangle;
+
+					uint32_t newVertexCount = 0;
+					for(int corner = 0; corner < 3; corner++) {
+						newVertexCount += vertexMeshlet[indices[triangle * 3 + corner]] != meshletIndex;
+					}
+					if(newVertexCount > bestNewVertexCount) {
+						continue;
+					}
+
+					float distance = 0.0f;
+					for(int corner = 0; corner < 3; corner++) {
+						const XMFLOAT3& position = meshData.vertices[indices[triangle * 3 + corner]].position;
+						float offset[3] {position.x - centroid[0], position.y - centroid[1], position.z - centroid[2]};
+						distance += offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+					}
+					if(newVertexCount < bestNewVertexCount || distance < bestDistance) {
+						bestTriangle = triangle;
+						bestNewVertexCount = newVertexCount;
+						bestDistance = distance;
+					}
+				}
+				candidates.resize(liveCandidateCount);
+
+				// Nothing adjacent fits: start a new meshlet at the first triangle not emitted yet
+				bool b_MeshletIsFull = meshlet.triangleCount == kMaxMeshletTriangles || meshletVertices.size() + bestNewVertexCount > kMaxMeshletVertices;
+				if(bestTriangle == s_InvalidIndex || b_MeshletIsFull) {
+					if(meshlet.triangleCount > 0) {
+						FinishMeshlet();
+					}
+
+					while(triangleEmitted[seedCursor]) {
+						seedCursor++;
+					}
+					bestTriangle = (uint32_t)seedCursor;
+				}
+
+				/// Add triangle
+				triangleEmitted[bestTriangle] = true;
+				meshlet.triangleCount++;
+				for(int corner = 0; corner < 3; corner++) {
+					uint32_t vertex = indices[bestTriangle * 3 + corner];
+					output.push_back(vertex);
+
+					if(vertexMeshlet[vertex] != meshletIndex) {
+						vertexMeshlet[vertex] = meshletIndex;
+						meshletVertices.push_back(vertex);
+						meshletPositionSum[0] += meshData.vertices[vertex].position.x;
+						meshletPositionSum[1] += meshData.vertices[vertex].position.y;
+						meshletPositionSum[2] += meshData.vertices[vertex].position.z;
+						for(uint32_t i = vertexTriangleOffsets[vertex]; i < vertexTriangleOffsets[vertex + 1]; i++) {
+							// LODs share vertices, only triangles of the current LOD and sub-mesh are candidates
+							uint32_t triangle = vertexTriangles[i];
+							if(!triangleEmitted[triangle] && triangle >= firstTriangle && triangle < endTriangle) {
+								candidates.push_back(triangle);
+							}
+						}
+					}
+				}
+			}
+			if(meshlet.triangleCount > 0) {
+				FinishMeshlet();
+			}
+
+			subMeshLOD.meshletCount = (uint32_t)meshData.meshlets.size() - subMeshLOD.firstMeshlet;
+		}
+
+		lod.meshletCount = (uint32_t)meshData.meshlets.size() - lod.firstMeshlet;
+	}
+
+	meshData.indices.swap(output);
+
+	// Vertices in meshlet order, so every meshlet reads a mostly contiguous block of the vertex buffer
+	// Note: LOD 0 comes first and uses every vertex, coarser LODs read a subset of the same order
+	MeshOptimizer::OptimizeVertexFetch(meshData);
+
+	for(Meshlet& builtMeshlet : meshData.meshlets) {
+		ComputeMeshletBounds(meshData, builtMeshlet);
+	}
+}
+
+void MeshletBuilder::ComputeMeshletBounds(const MeshData& meshData, Meshlet& meshlet) {
+	const uint32_t* indices = meshData.indices.data() + meshlet.firstIndex;
+	uint32_t indexCount = meshlet.triangleCount * 3;
+
+	/// AABB
+	float aabbMin[3] {FLT_MAX, FLT_MAX, FLT_MAX};
+	float aabbMax[3] {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for(uint32_t i = 0; i < indexCount; i++) {
+		const XMFLOAT3& position = meshData.vertices[indices[i]].position;
+		aabbMin[0] = std::min(aabbMin[0], position.x); aabbMax[0] = std::max(aabbMax[0], position.x);
+		aabbMin[1] = std::min(aabbMin[1], position.y); aabbMax[1] = std::max(aabbMax[1], position.y);
+		aabbMin[2] = std::min(aabbMin[2], position.z); aabbMax[2] = std::max(aabbMax[2], position.z);
+	}
+	meshlet.aabbMin = XMFLOAT3(aabbMin[0], aabbMin[1], aabbMin[2]);
+	meshlet.aabbMax = XMFLOAT3(aabbMax[0], aabbMax[1], aabbMax[2]);
+
+	/// Sphere around the AABB centre, tighter than the AABB's circumsphere since it only has to reach actual vertices
+	float center[3] {(aabbMin[0] + aabbMax[0]) * 0.5f, (aabbMin[1] + aabbMax[1]) * 0.5f, (aabbMin[2] + aabbMax[2]) * 0.5f};
+	float radiusSquared = 0.0f;
+	for(uint32_t i = 0; i < indexCount; i++) {
+		const XMFLOAT3& position = meshData.vertices[indices[i]].position;
+		float offset[3] {position.x - center[0], position.y - center[1], position.z - center[2]};
+		radiusSquared = std::max(radiusSquared, offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+	}
+	meshlet.center = XMFLOAT3(center[0], center[1], center[2]);
+	meshlet.radius = std::sqrt(radiusSquared);
+
+	/// Normal cone from the geometric triangle normals (these decide rasterizer backface culling, not the vertex normals)
+	// Note: front faces are clockwise in a left handed system, so cross(p1 - p0, p2 - p0) points out of the front face
+	std::vector<XMFLOAT3> triangleNormals {};
+	triangleNormals.reserve(meshlet.triangleCount);
+	float axis[3] {};
+	for(uint32_t t = 0; t < meshlet.triangleCount; t++) {
+		const XMFLOAT3& p0 = meshData.vertices[indices[t * 3 + 0]].position;
+		const XMFLOAT3& p1 = meshData.vertices[indices[t * 3 + 1]].position;
+		const XMFLOAT3& p2 = meshData.vertices[indices[t * 3 + 2]].position;
+
+		float e1[3] {p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+		float e2[3] {p2.x - p0.x, p2.y - p0.y, p2.z - p0.z};
+		float cross[3] {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+		float length = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+		if(length <= 0.0f) {
+			continue;
+		}
+
+		XMFLOAT3 normal(cross[0] / length, cross[1] / length, cross[2] / length);
+		triangleNormals.push_back(normal);
+		axis[0] += normal.x;
+		axis[1] += normal.y;
+		axis[2] += normal.z;
+	}
+
+	meshlet.coneAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	meshlet.coneCutoff = 1.0f;
+
+	float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	if(axisLength <= 0.0f) {
+		return;
+	}
+	axis[0] /= axisLength;
+	axis[1] /= axisLength;
+	axis[2] /= axisLength;
+
+	float minCosine = 1.0f;
+	for(const XMFLOAT3& normal : triangleNormals) {
+		minCosine = std::min(minCosine, normal.x * axis[0] + normal.y * axis[1] + normal.z * axis[2]);
+	}
+
+	meshlet.coneAxis = XMFLOAT3(axis[0], axis[1], axis[2]);
+	if(minCosine > s_MinConeCosine) {
+		meshlet.coneCutoff = std::sqrt(1.0f - minCosine * minCosine);
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "MeshData.h"
+
+// Splits an indexed mesh into meshlets (clusters of at most kMaxMeshletVertices vertices / kMaxMeshletTriangles triangles)
+// Run by the cook pipeline after MeshOptimizer, the index buffer is reordered so every meshlet is a contiguous index range
+class MeshletBuilder {
+public:
+	// Fills meshData.meshlets and the meshlet ranges of meshData.lods, triangles are regrouped within their LOD but each one keeps its winding
+	// Meshlets are grown over shared vertices and seeded in the existing triangle order, so the optimized draw order is mostly kept
+	static void BuildMeshlets(MeshData& meshData);
+
+	// Bounding sphere, AABB and normal cone of the triangles in meshlet's index range
+	static void ComputeMeshletBounds(const MeshData& meshData, Meshlet& meshlet);
+};
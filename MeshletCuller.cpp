@@ -0,0 +1,64 @@
+#include "MeshletCuller.h"
+
+#include <cmath>
+
+MeshletCuller::CullStats MeshletCuller::CullMeshlets(const Meshlet* meshlets, size_t meshletCount, XMMATRIX worldMatrix, const std::array<XMFLOAT4, 6>& frustumPlanes, XMFLOAT3 cameraPosition, float displacementBias, std::vector<DrawRange>& drawRanges) {
+	CullStats stats {};
+	stats.meshletCount = (int)meshletCount;
+	drawRanges.clear();
+
+	/// Frustum planes in model space
+	// dot(plane, x * world) = dot(plane * transpose(world), x), normalized again so sphere radii stay in model units
+	XMMATRIX worldTranspose = XMMatrixTranspose(worldMatrix);
+	std::array<XMFLOAT4, 6> modelPlanes {};
+	for(size_t i = 0; i < frustumPlanes.size(); i++) {
+		XMVECTOR plane = XMVector4Transform(XMLoadFloat4(&frustumPlanes[i]), worldTranspose);
+		XMStoreFloat4(&modelPlanes[i], XMPlaneNormalize(plane));
+	}
+
+	/// Camera position in model space
+	// Note: a backface test only depends on the sign of dot(normal, position - camera), which any affine transform with positive determinant keeps
+	XMFLOAT3 modelCamera {};
+	XMStoreFloat3(&modelCamera, XMVector3TransformCoord(XMLoadFloat3(&cameraPosition), XMMatrixInverse(nullptr, worldMatrix)));
+
+	bool b_CullBackfaces = displacementBias <= 0.0f;
+
+	for(size_t i = 0; i < meshletCount; i++) {
+		const Meshlet& meshlet = meshlets[i];
+		/// Frustum (planes face inwards, see Camera::UpdateFrustum)
+		bool b_IsVisible = true;
+		for(const XMFLOAT4& plane : modelPlanes) {
+			float distance = plane.x * meshlet.center.x + plane.y * meshlet.center.y + plane.z * meshlet.center.z + plane.w;
+			if(distance < -(meshlet.radius + displacementBias)) {
+				b_IsVisible = false;
+				break;
+			}
+		}
+		if(!b_IsVisible) {
+			stats.frustumCulledCount++;
+			continue;
+		}
+
+		/// Normal cone, culled if the camera is inside the region from which every triangle is seen from behind
+		if(b_CullBackfaces) {
+			float toCenter[3] {meshlet.center.x - modelCamera.x, meshlet.center.y - modelCamera.y, meshlet.center.z - modelCamera.z};
+			float distance = std::sqrt(toCenter[0] * toCenter[0] + toCenter[1] * toCenter[1] + toCenter[2] * toCenter[2]);
+			float axisDistance = toCenter[0] * meshlet.coneAxis.x + toCenter[1] * meshlet.coneAxis.y + toCenter[2] * meshlet.coneAxis.z;
+			if(axisDistance >= meshlet.coneCutoff * distance + meshlet.radius) {
+				stats.backfaceCulledCount++;
+				continue;
+			}
+		}
+
+		// Meshlets are contiguous in the index buffer, neighbouring visible meshlets share one draw
+		if(!drawRanges.empty() && drawRanges.back().firstIndex + drawRanges.back().indexCount == meshlet.firstIndex) {
+			drawRanges.back().indexCount += meshlet.triangleCount * 3;
+		}
+		else {
+			drawRanges.push_back(DrawRange {meshlet.firstIndex, meshlet.triangleCount * 3});
+		}
+	}
+
+	stats.drawRangeCount = (int)drawRanges.size();
+	return stats;
+}
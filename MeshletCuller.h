@@ -0,0 +1,28 @@
+#pragma once
+#include <array>
+#include <vector>
+
+#include "MeshData.h"
+
+// Per frame CPU culling of meshlets, surviving meshlets are drawn as merged index ranges
+// Culling runs in model space: frustum planes and camera position are brought into model space instead of transforming every meshlet
+class MeshletCuller {
+public:
+	// Contiguous part of the index buffer, i.e. DrawIndexed(indexCount, firstIndex, 0)
+	struct DrawRange {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+
+	struct CullStats {
+		int meshletCount;
+		int frustumCulledCount;
+		int backfaceCulledCount;
+		int drawRangeCount;
+	};
+
+	// displacementBias: max distance vertices are pushed along their (model space) normal by the domain shader
+	// Backface culling is skipped when displacementBias > 0, displaced triangles no longer face the way the cone says
+	// meshlets: meshletCount meshlets, usually the meshlet range of one MeshLOD
+	static CullStats CullMeshlets(const Meshlet* meshlets, size_t meshletCount, XMMATRIX worldMatrix, const std::array<XMFLOAT4, 6>& frustumPlanes, XMFLOAT3 cameraPosition, float displacementBias, std::vector<DrawRange>& drawRanges);
+};
@@ -0,0 +1,339 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <emmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+namespace {
+	// Mip rows filtered per step of a task, source rows of a step are filtered horizontally once into a buffer of about twice as many rows
+	// Steps overlap by the filter's source rows, so larger steps waste less work and use more memory
+	constexpr int s_RowsPerStep = 32;
+	// Smaller mips are filtered on a single thread, thread startup would cost more than the work
+	constexpr size_t s_MinRowsPerTask = s_RowsPerStep;
+
+	// In mip texels, how far each filter reaches from a mip texel center
+	constexpr float s_FilterRadii[MipGenerator::Num_Filters] = {0.5f, 3.0f, 3.0f};
+	constexpr float s_KaiserAlpha = 4.0f;
+	constexpr float s_Pi = 3.14159265358979f;
+
+	// Calls function(begin, end) on subranges of [0, count), one task per hardware thread at most
+	template<typename Function>
+	void ParallelFor(size_t count, size_t minCountPerTask, const Function& function) {
+		size_t taskCount = std::clamp<size_t>(count / minCountPerTask, 1, std::max(1u, std::thread::hardware_concurrency()));
+		if(taskCount == 1) {
+			function(0, count);
+			return;
+		}
+
+		std::vector<std::future<void>> futures(taskCount);
+		for(size_t i = 0; i < taskCount; i++) {
+			futures[i] = std::async(std::launch::async, function, count * i / taskCount, count * (i + 1) / taskCount);
+		}
+		for(std::future<void>& future : futures) {
+			future.get();
+		}
+	}
+
+	float Sinc(float x) {
+		return std::abs(x) < 1e-5f ? 1.0f : sinf(s_Pi * x) / (s_Pi * x);
+	}
+
+	// Zeroth order modified Bessel function of the first kind (power series)
+	float BesselI0(float x) {
+		float sum = 1.0f;
+		float term = 1.0f;
+		for(int k = 1; k < 32 && term > sum * 1e-7f; k++) {
+			term *= (x * 0.5f / k) * (x * 0.5f / k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	// Windowed sinc filters, t is the distance from the mip texel center in mip texels
+	// Note: the box filter is the area of the mip texel a source texel covers instead (see ComputeAxisWeights), so odd sizes have no ties
+	float EvaluateFilter(MipGenerator::Filter filter, float t) {
+		float radius = s_FilterRadii[filter];
+		if(std::abs(t) > radius) {
+			return 0.0f;
+		}
+
+		if(filter == MipGenerator::kKaiserFilter) {
+			float x = t / radius;
+			return Sinc(t) * BesselI0(s_KaiserAlpha * sqrtf(std::max(0.0f, 1.0f - x * x))) / BesselI0(s_KaiserAlpha);
+		}
+		return Sinc(t) * Sinc(t / radius);
+	}
+
+	// Source texels and normalized weights every mip texel of one axis is filtered from
+	// Note: taps past the edge are clamped to it, so edge texels take their weight
+	struct AxisWeights {
+		std::vector<int> firstTaps;
+		std::vector<int> tapCounts;
+		std::vector<int> indices;
+		std::vector<float> weights;
+	};
+
+	void ComputeAxisWeights(MipGenerator::Filter filter, int size, int mipSize, AxisWeights& axisWeights) {
+		axisWeights = AxisWeights {};
+		float scale = (float)size / mipSize;
+		float radius = s_FilterRadii[filter] * scale;
+		for(int i = 0; i < mipSize; i++) {
+			float center = (i + 0.5f) * scale;
+			int firstTap = (int)axisWeights.indices.size();
+			float weightSum = 0.0f;
+			for(int source = (int)floorf(center - radius); source <= (int)ceilf(center + radius); source++) {
+				float weight = 0.0f;
+				if(filter == MipGenerator::kBoxFilter) {
+					weight = std::max(0.0f, std::min(source + 1.0f, center + radius) - std::max((float)source, center - radius));
+				}
+				else {
+					weight = EvaluateFilter(filter, (source + 0.5f - center) / scale);
+				}
+				if(weight == 0.0f) {
+					continue;
+				}
+
+				int index = std::clamp(source, 0, size - 1);
+				if((int)axisWeights.indices.size() > firstTap && axisWeights.indices.back() == index) {
+					axisWeights.weights.back() += weight;
+				}
+				else {
+					axisWeights.indices.push_back(index);
+					axisWeights.weights.push_back(weight);
+				}
+				weightSum += weight;
+			}
+
+			for(size_t tap = firstTap; tap < axisWeights.weights.size(); tap++) {
+				axisWeights.weights[tap] /= weightSum;
+			}
+			axisWeights.firstTaps.push_back(firstTap);
+			axisWeights.tapCounts.push_back((int)axisWeights.indices.size() - firstTap);
+		}
+	}
+
+	float SRGBToLinear(float value) {
+		return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	// 8 bit sRGB <-> linear float, encoding rounds to the nearest 8 bit value exactly
+	struct SRGBTables {
+		static constexpr int kEncodeBucketCount = 4096;
+
+		float decode[256];
+		// Linear value where encoding switches from i to i + 1, past 1 for 255
+		float thresholds[256];
+		// Encoded value at the start of each of kEncodeBucketCount linear buckets
+		// Note: sRGB is steepest near 0 at 12.92 * 255 / kEncodeBucketCount < 1 values per bucket, so no bucket holds more than one threshold
+		unsigned char encodeBuckets[kEncodeBucketCount];
+
+		SRGBTables() {
+			for(int i = 0; i < 256; i++) {
+				decode[i] = SRGBToLinear(i / 255.0f);
+			}
+			for(int i = 0; i < 255; i++) {
+				thresholds[i] = SRGBToLinear((i + 0.5f) / 255.0f);
+			}
+			thresholds[255] = 2.0f;
+			int encoded = 0;
+			for(int bucket = 0; bucket < kEncodeBucketCount; bucket++) {
+				while(encoded < 255 && (float)bucket / kEncodeBucketCount >= thresholds[encoded]) {
+					encoded++;
+				}
+				encodeBuckets[bucket] = (unsigned char)encoded;
+			}
+		}
+
+		unsigned char Encode(float value) const {
+			value = std::clamp(value, 0.0f, 1.0f);
+			int encoded = encodeBuckets[std::min((int)(value * kEncodeBucketCount), kEncodeBucketCount - 1)];
+			return (unsigned char)(encoded + (value >= thresholds[encoded]));
+		}
+	};
+
+	const SRGBTables& GetSRGBTables() {
+		static const SRGBTables s_SRGBTables {};
+		return s_SRGBTables;
+	}
+
+	// 8 bit texels to float, rgb decoded to linear if sRGB
+	void DecodeRow(const unsigned char* texels, int width, bool b_IsSRGB, float* row) {
+		if(b_IsSRGB) {
+			const SRGBTables& srgbTables = GetSRGBTables();
+			for(int x = 0; x < width; x++) {
+				row[x * 4 + 0] = srgbTables.decode[texels[x * 4 + 0]];
+				row[x * 4 + 1] = srgbTables.decode[texels[x * 4 + 1]];
+				row[x * 4 + 2] = srgbTables.decode[texels[x * 4 + 2]];
+				row[x * 4 + 3] = texels[x * 4 + 3] * (1.0f / 255.0f);
+			}
+			return;
+		}
+
+		const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+		const __m128i zero = _mm_setzero_si128();
+		for(int x = 0; x < width; x++) {
+			int packedTexel {};
+			memcpy(&packedTexel, texels + x * 4, sizeof(packedTexel));
+			__m128i texel = _mm_cvtsi32_si128(packedTexel);
+			texel = _mm_unpacklo_epi16(_mm_unpacklo_epi8(texel, zero), zero);
+			_mm_storeu_ps(row + x * 4, _mm_mul_ps(_mm_cvtepi32_ps(texel), scale));
+		}
+	}
+
+	// Float texels back to 8 bit, clamped to [0, 1]
+	void EncodeRow(const float* row, int width, const MipGenerator::Settings& settings, unsigned char* texels) {
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+		for(int x = 0; x < width; x++) {
+			__m128 texel = _mm_loadu_ps(row + x * 4);
+
+			if(settings.isNormalMap) {
+				// [0, 1] -> [-1, 1], unit length, back to [0, 1]; alpha as is
+				alignas(16) float values[4];
+				_mm_store_ps(values, texel);
+				float normal[3] = {values[0] * 2.0f - 1.0f, values[1] * 2.0f - 1.0f, values[2] * 2.0f - 1.0f};
+				float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				if(length > 1e-6f) {
+					for(int channel = 0; channel < 3; channel++) {
+						values[channel] = normal[channel] / length * 0.5f + 0.5f;
+					}
+				}
+				else {
+					values[0] = 0.5f;
+					values[1] = 0.5f;
+					values[2] = 1.0f;
+				}
+				texel = _mm_load_ps(values);
+			}
+
+			__m128i encoded = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(texel, zero), one), scale));
+			encoded = _mm_packs_epi32(encoded, encoded);
+			int packedTexel = _mm_cvtsi128_si32(_mm_packus_epi16(encoded, encoded));
+			memcpy(texels + x * 4, &packedTexel, sizeof(packedTexel));
+		}
+
+		if(settings.isSRGB && !settings.isNormalMap) {
+			const SRGBTables& srgbTables = GetSRGBTables();
+			for(int x = 0; x < width; x++) {
+				for(int channel = 0; channel < 3; channel++) {
+					texels[x * 4 + channel] = srgbTables.Encode(row[x * 4 + channel]);
+				}
+			}
+		}
+	}
+
+	void FilterRowHorizontal(const float* row, const AxisWeights& axisWeights, int mipWidth, float* mipRow) {
+		for(int x = 0; x < mipWidth; x++) {
+			const int* indices = axisWeights.indices.data() + axisWeights.firstTaps[x];
+			const float* weights = axisWeights.weights.data() + axisWeights.firstTaps[x];
+			__m128 sum = _mm_setzero_ps();
+			for(int tap = 0; tap < axisWeights.tapCounts[x]; tap++) {
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[tap]), _mm_loadu_ps(row + indices[tap] * 4)));
+			}
+			_mm_storeu_ps(mipRow + x * 4, sum);
+		}
+	}
+
+	// mipRow = sum of weights[tap] * rows[tap], floatCount floats (a multiple of 4)
+	void FilterRowVertical(const float* const* rows, const float* weights, int tapCount, int floatCount, float* mipRow) {
+		int i = 0;
+#ifdef __AVX__
+		for(; i + 8 <= floatCount; i += 8) {
+			__m256 sum = _mm256_setzero_ps();
+			for(int tap = 0; tap < tapCount; tap++) {
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[tap]), _mm256_loadu_ps(rows[tap] + i)));
+			}
+			_mm256_storeu_ps(mipRow + i, sum);
+		}
+#endif
+		for(; i < floatCount; i += 4) {
+			__m128 sum = _mm_setzero_ps();
+			for(int tap = 0; tap < tapCount; tap++) {
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[tap]), _mm_loadu_ps(rows[tap] + i)));
+			}
+			_mm_storeu_ps(mipRow + i, sum);
+		}
+	}
+}
+
+int MipGenerator::GetMipCount(int width, int height) {
+	int mipCount = 1;
+	while(width > 1 || height > 1) {
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		mipCount++;
+	}
+	return mipCount;
+}
+
+void MipGenerator::GenerateMips(const unsigned char* texels, int width, int height, int mipCount, const Settings& settings, std::vector<std::vector<unsigned char>>& mips) {
+	if(mipCount <= 0 || mipCount > GetMipCount(width, height)) {
+		mipCount = GetMipCount(width, height);
+	}
+	mips.resize(mipCount - 1);
+
+	// Previous mip in float (linear for sRGB), mip 0 is decoded from texels as it is read instead
+	std::vector<float> floatTexels {};
+	std::vector<float> mipFloatTexels {};
+	AxisWeights weightsX {};
+	AxisWeights weightsY {};
+	for(int mip = 1; mip < mipCount; mip++) {
+		int mipWidth = std::max(1, width / 2);
+		int mipHeight = std::max(1, height / 2);
+		ComputeAxisWeights(settings.filter, width, mipWidth, weightsX);
+		ComputeAxisWeights(settings.filter, height, mipHeight, weightsY);
+		mips[mip - 1].resize((size_t)mipWidth * mipHeight * 4);
+		mipFloatTexels.resize((size_t)mipWidth * mipHeight * 4);
+
+		ParallelFor((size_t)mipHeight, s_MinRowsPerTask, [&](size_t firstMipRow, size_t endMipRow) {
+			std::vector<float> decodedRow {};
+			std::vector<float> filteredRows {};
+			std::vector<const float*> tapRows {};
+			for(int stepRow = (int)firstMipRow; stepRow < (int)endMipRow; stepRow += s_RowsPerStep) {
+				int stepEndRow = std::min(stepRow + s_RowsPerStep, (int)endMipRow);
+
+				// Horizontal pass over every source row the step's mip rows read (taps are sorted, so the first and last tap bound them)
+				int firstRow = weightsY.indices[weightsY.firstTaps[stepRow]];
+				int endRow = weightsY.indices[weightsY.firstTaps[stepEndRow - 1] + weightsY.tapCounts[stepEndRow - 1] - 1] + 1;
+				filteredRows.resize((size_t)(endRow - firstRow) * mipWidth * 4);
+				for(int y = firstRow; y < endRow; y++) {
+					const float* row = nullptr;
+					if(mip == 1) {
+						decodedRow.resize((size_t)width * 4);
+						DecodeRow(texels + (size_t)y * width * 4, width, settings.isSRGB && !settings.isNormalMap, decodedRow.data());
+						row = decodedRow.data();
+					}
+					else {
+						row = floatTexels.data() + (size_t)y * width * 4;
+					}
+					FilterRowHorizontal(row, weightsX, mipWidth, filteredRows.data() + (size_t)(y - firstRow) * mipWidth * 4);
+				}
+
+				// Vertical pass, kept in float for the next mip
+				for(int y = stepRow; y < stepEndRow; y++) {
+					int tapCount = weightsY.tapCounts[y];
+					const int* indices = weightsY.indices.data() + weightsY.firstTaps[y];
+					tapRows.resize(tapCount);
+					for(int tap = 0; tap < tapCount; tap++) {
+						tapRows[tap] = filteredRows.data() + (size_t)(indices[tap] - firstRow) * mipWidth * 4;
+					}
+
+					float* mipRow = mipFloatTexels.data() + (size_t)y * mipWidth * 4;
+					FilterRowVertical(tapRows.data(), weightsY.weights.data() + weightsY.firstTaps[y], tapCount, mipWidth * 4, mipRow);
+					EncodeRow(mipRow, mipWidth, settings, mips[mip - 1].data() + (size_t)y * mipWidth * 4);
+				}
+			}
+		});
+
+		floatTexels.swap(mipFloatTexels);
+		width = mipWidth;
+		height = mipHeight;
+	}
+}
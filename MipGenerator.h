@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+
+// CPU mip chain builder for 4 channel 8 bit texels (like Texture::ImageData), so textures can be created with every mip as initial data
+// Every mip is filtered from the previous one kept in float, in linear space for sRGB data, so nothing is lost to requantizing between mips
+// Separable: a horizontal pass over source rows and a vertical pass over mip rows, both SSE (AVX for the vertical pass where enabled) and spread over threads by rows
+class MipGenerator {
+public:
+	enum Filter {
+		// 2x2 average, what ID3D11DeviceContext::GenerateMips does
+		kBoxFilter = 0,
+		// Kaiser windowed sinc, sharp with little ringing, the default for textures
+		kKaiserFilter = 1,
+		// Lanczos 3, sharper than Kaiser, rings more on hard edges
+		kLanczosFilter = 2,
+		Num_Filters
+	};
+
+	struct Settings {
+		Filter filter;
+		// rgb is sRGB encoded (albedo), filtered after decoding to linear and encoded again, alpha is always linear
+		bool isSRGB;
+		// rgb is a tangent space normal (x, y, z mapped from [-1, 1]), renormalized after filtering
+		bool isNormalMap;
+	};
+
+public:
+	// max(1, size >> n) down to 1x1
+	static int GetMipCount(int width, int height);
+
+	// Fills mips with mips 1 to mipCount - 1 of width x height texels, mip n is max(1, size >> n) texels
+	// mipCount 0 (or anything above GetMipCount) builds the full chain
+	// Note: the image edges are clamped, so tiling textures may show a faint seam in small mips
+	static void GenerateMips(const unsigned char* texels, int width, int height, int mipCount, const Settings& settings, std::vector<std::vector<unsigned char>>& mips);
+};
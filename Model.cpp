@@ -1,17 +1,258 @@
 #include "Model.h"
-#include <fstream>
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "MeshWelder.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+#include "MeshBVH.h"
+#include "BoundingVolumes.h"
+#include "VertexPacker.h"
+#include "TangentGenerator.h"
+#include "ObjImporter.h"
+#include "GltfImporter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <charconv>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <thread>
+
+namespace {
+	// Smaller files are parsed on a single thread, thread startup would cost more than the parse
+	constexpr size_t s_MinParseChunkSize = 256 * 1024;
+
+	// Text meshes are written with 6 decimals, anything closer than this is considered the same vertex
+	constexpr float s_WeldEpsilon = 1e-5f;
+
+	// Frames the resident LODs must go unrequested before they are evicted, so objects moving in and out of range do not stream every frame
+	constexpr int s_EvictionFrameCount = 240;
+
+	const char* SkipWhitespace(const char* current, const char* end) {
+		while(current != end && (*current == ' ' || *current == '\t' || *current == '\r' || *current == '\n')) {
+			current++;
+		}
+		return current;
+	}
 
-bool Model::Initialize(ID3D11Device* device, const std::string& modelFilePath) {
-	// Load in the model data.
-	bool result = LoadModel(modelFilePath);
-	if(!result) {
+	// Number of lines that contain data (i.e. vertices) in [begin, end)
+	int CountDataLines(const char* begin, const char* end) {
+		int lineCount = 0;
+		bool b_LineHasData = false;
+		for(const char* current = begin; current != end; current++) {
+			if(*current == '\n') {
+				lineCount += b_LineHasData;
+				b_LineHasData = false;
+			}
+			else if(*current != ' ' && *current != '\t' && *current != '\r') {
+				b_LineHasData = true;
+			}
+		}
+		return lineCount + b_LineHasData;
+	}
+}
+
+bool Model::Initialize(ID3D11Device* device, GeometryArena* geometryArena, const std::string& modelFilePath, VertexFormat vertexFormat) {
+	bool result = InitializeFromFile(device, geometryArena, modelFilePath, vertexFormat);
+	m_LoadState = result ? kLoaded : kLoadFailed;
+	return result;
+}
+
+bool Model::Initialize(ID3D11Device* device, GeometryArena* geometryArena, MeshData& meshData, const std::string& name, VertexFormat vertexFormat) {
+	bool result = InitializeFromMeshData(device, geometryArena, meshData, name, vertexFormat);
+	m_LoadState = result ? kLoaded : kLoadFailed;
+	return result;
+}
+
+void Model::InitializeAsync(ID3D11Device* device, GeometryArena* geometryArena, const std::string& modelFilePath, VertexFormat vertexFormat) {
+	m_LoadState = kLoading;
+	m_LoadJob = std::async(std::launch::async, &Model::InitializeFromFile, this, device, geometryArena, modelFilePath, vertexFormat);
+}
+
+void Model::InitializeAsync(ID3D11Device* device, GeometryArena* geometryArena, MeshData&& meshData, const std::string& name, VertexFormat vertexFormat) {
+	m_LoadState = kLoading;
+	m_LoadJob = std::async(std::launch::async, [this, device, geometryArena, meshData = std::move(meshData), name, vertexFormat]() mutable {
+		return InitializeFromMeshData(device, geometryArena, meshData, name, vertexFormat);
+	});
+}
+
+bool Model::InitializeFromFile(ID3D11Device* device, GeometryArena* geometryArena, const std::string& modelFilePath, VertexFormat vertexFormat) {
+	m_VertexFormat = vertexFormat;
+	if(geometryArena->GetVertexFormat() != vertexFormat) {
+		return false;
+	}
+
+	// Use the cooked binary mesh if it is up to date, vertex and index data is read straight from the mapped file
+	MeshCache meshCache {};
+	if(meshCache.Initialize(modelFilePath, vertexFormat)) {
+		const MeshCache::Header& header = meshCache.GetHeader();
+		m_VertexCount = (int)header.vertexCount;
+		m_IndexCount = (int)header.indexCount;
+		m_Bounds = header.bounds;
+
+		const Meshlet* meshlets = (const Meshlet*)meshCache.GetSectionData(MeshCache::kMeshletSection);
+		m_Meshlets.assign(meshlets, meshlets + header.meshletCount);
+		const MeshLOD* lods = (const MeshLOD*)meshCache.GetSectionData(MeshCache::kLODSection);
+		m_LODs.assign(lods, lods + header.lodCount);
+		const MeshLOD* subMeshLODs = (const MeshLOD*)meshCache.GetSectionData(MeshCache::kSubMeshLODSection);
+		m_SubMeshLODs.assign(subMeshLODs, subMeshLODs + header.lodCount * header.subMeshCount);
+		m_SubMeshCount = (int)header.subMeshCount;
+		const BVHNode* bvhNodes = (const BVHNode*)meshCache.GetSectionData(MeshCache::kBVHNodeSection);
+		m_BVHNodes.assign(bvhNodes, bvhNodes + header.bvhNodeCount);
+		const BVHTriangle* bvhTriangles = (const BVHTriangle*)meshCache.GetSectionData(MeshCache::kBVHTriangleSection);
+		m_BVHTriangles.assign(bvhTriangles, bvhTriangles + header.bvhTriangleCount);
+
+		const void* const vertexStreams[Num_VertexStreams] {meshCache.GetSectionData(MeshCache::kGeometryVertexSection), meshCache.GetSectionData(MeshCache::kTangentVertexSection)};
+		bool result = InitializeBuffers(device, geometryArena, vertexStreams, meshCache.GetSectionData(MeshCache::kIndexSection), header.indexStride, header.decodeParams);
+
+		meshCache.Shutdown();
+		return result;
+	}
+
+	// Load in the model data, glTF and OBJ files are imported as indexed meshes, everything else is a rastertek text model
+	// Note: .glb goes to the glTF importer too, which rejects it with an error instead of it being parsed as a text model
+	MeshData meshData {};
+	std::vector<std::string> dependencyFilePaths {};
+	std::string extension = std::filesystem::path(modelFilePath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+	if(extension == ".gltf" || extension == ".glb" || extension == ".obj") {
+		bool result = extension == ".obj" ? ObjImporter::Import(modelFilePath, meshData) : GltfImporter::Import(modelFilePath, meshData, dependencyFilePaths);
+		if(!result) {
+			return false;
+		}
+#ifdef _DEBUG
+		std::cout << modelFilePath << ": imported " << meshData.subMeshes.size() << " sub-meshes, " << meshData.vertices.size() << " vertices, " << meshData.indices.size() / 3 << " triangles\n";
+#endif
+
+		m_VertexCount = (int)meshData.vertices.size();
+		TangentGenerator::GenerateMissingNormals(meshData);
+	}
+	else {
+		if(!LoadModel(modelFilePath)) {
+			return false;
+		}
+		BuildMeshData(meshData);
+
+		// Parsed model data is no longer needed
+		delete[] m_Model;
+		m_Model = nullptr;
+	}
+
+	// Text models are triangle soups, merge shared vertices into an indexed mesh (imported meshes only lose exact duplicates here)
+	// Note: tangents are still zero here, so vertices are welded on position, uv and normal only
+	float weldRatio = MeshWelder::WeldVertices(meshData, s_WeldEpsilon);
+#ifdef _DEBUG
+	std::cout << modelFilePath << ": welded " << m_VertexCount << " -> " << meshData.vertices.size() << " vertices (" << weldRatio << "x reduction)\n";
+#endif
+
+	// Tangent frames are accumulated over the welded vertices so they are smooth across shared triangles
+	TangentGenerator::GenerateTangents(meshData);
+
+	return CookMesh(device, geometryArena, meshData, modelFilePath, dependencyFilePaths, true);
+}
+
+bool Model::InitializeFromMeshData(ID3D11Device* device, GeometryArena* geometryArena, MeshData& meshData, const std::string& name, VertexFormat vertexFormat) {
+	m_VertexFormat = vertexFormat;
+	if(meshData.vertices.empty() || meshData.indices.empty() || geometryArena->GetVertexFormat() != vertexFormat) {
 		return false;
 	}
 
-	CalculateModelVectors();
+	return CookMesh(device, geometryArena, meshData, name, {}, false);
+}
+
+bool Model::CookMesh(ID3D11Device* device, GeometryArena* geometryArena, MeshData& meshData, const std::string& modelFilePath, const std::vector<std::string>& dependencyFilePaths, bool writeMeshCache) {
+	// Bounds for object culling and LOD selection, positions do not change after welding
+	BoundingVolumes::ComputeBounds(meshData);
+	m_Bounds = meshData.bounds;
+
+	// Reorder for post-transform cache, overdraw and vertex fetch
+	// Note: the tessellation path runs the HS per control point, so vertex cache hits save HS invocations too
+	// Note: the per mesh stats (and the measurements behind them) are printed in debug builds only
+#ifdef _DEBUG
+	MeshOptimizer::VertexCacheStats statsBefore = MeshOptimizer::AnalyzeVertexCache(meshData.indices, meshData.vertices.size());
+#endif
+	MeshOptimizer::OptimizeMesh(meshData);
+#ifdef _DEBUG
+	MeshOptimizer::VertexCacheStats statsAfter = MeshOptimizer::AnalyzeVertexCache(meshData.indices, meshData.vertices.size());
+	std::cout << modelFilePath << ": ACMR " << statsBefore.acmr << " -> " << statsAfter.acmr << ", ATVR " << statsBefore.atvr << " -> " << statsAfter.atvr << "\n";
+#endif
+
+	// Coarser LODs are appended to the index buffer, they reuse LOD 0's vertices
+#ifdef _DEBUG
+	std::vector<uint32_t> lod0Indices = meshData.indices;
+#endif
+	MeshSimplifier::GenerateLODs(meshData);
+#ifdef _DEBUG
+	for(size_t i = 1; i < meshData.lods.size(); i++) {
+		const MeshLOD& lod = meshData.lods[i];
+		std::vector<uint32_t> lodIndices(meshData.indices.begin() + lod.firstIndex, meshData.indices.begin() + lod.firstIndex + lod.indexCount);
+		float hausdorffError = MeshSimplifier::MeasureHausdorffError(meshData.vertices, lod0Indices, lodIndices);
+		std::cout << modelFilePath << ": LOD " << i << " " << lod.indexCount / 3 << " triangles, error " << lod.error << ", Hausdorff " << hausdorffError << "\n";
+	}
+#endif
+
+	// Split into meshlets for per frame cluster culling, regroups triangles so the vertex cache stats are measured again
+	MeshletBuilder::BuildMeshlets(meshData);
+#ifdef _DEBUG
+	const MeshLOD& lod0 = meshData.lods[0];
+	std::vector<uint32_t> meshletIndices(meshData.indices.begin(), meshData.indices.begin() + lod0.indexCount);
+	MeshOptimizer::VertexCacheStats meshletStats = MeshOptimizer::AnalyzeVertexCache(meshletIndices, meshData.vertices.size());
+	std::cout << modelFilePath << ": " << meshData.meshlets.size() << " meshlets (" << lod0.meshletCount << " in LOD 0), ACMR " << meshletStats.acmr << ", ATVR " << meshletStats.atvr << "\n";
+#endif
+	m_Meshlets = meshData.meshlets;
+	m_LODs = meshData.lods;
+	m_SubMeshLODs = meshData.subMeshLODs;
+	m_SubMeshCount = (int)(meshData.subMeshLODs.size() / meshData.lods.size());
+
+	// Ray query tree over LOD 0's final triangle order, positions are taken before packing so picking is not affected by quantization
+	MeshBVH::BuildBVH(meshData);
+#ifdef _DEBUG
+	std::cout << modelFilePath << ": BVH " << meshData.bvhNodes.size() << " nodes over " << meshData.bvhTriangles.size() << " triangles\n";
+#endif
+	m_BVHNodes = meshData.bvhNodes;
+	m_BVHTriangles = meshData.bvhTriangles;
+
+	m_VertexCount = (int)meshData.vertices.size();
+	m_IndexCount = (int)meshData.indices.size();
+
+	// Encode vertices in the requested GPU format
+	const void* vertexData = meshData.vertices.data();
+	VertexDecodeParams decodeParams {};
+	std::vector<PackedMeshVertex> packedVertices {};
+	if(m_VertexFormat == kPackedVertexFormat) {
+		VertexPacker::PackVertices(meshData.vertices, packedVertices, decodeParams);
+		vertexData = packedVertices.data();
+
+#ifdef _DEBUG
+		// Debug builds check every cooked mesh against what the formats' precision allows
+		VertexPacker::PackingError packingError = VertexPacker::MeasurePackingError(meshData.vertices, packedVertices, decodeParams);
+		std::cout << modelFilePath << ": packed vertices " << sizeof(MeshVertex) << " -> " << sizeof(PackedMeshVertex) << " bytes, max error position " << packingError.maxPositionError
+			<< ", uv " << packingError.maxUVError << ", normal " << packingError.maxNormalAngle << " deg, tangent " << packingError.maxTangentAngle << " deg, binormal " << packingError.maxBinormalAngle << " deg\n";
+		bool b_IsWithinLimits = VertexPacker::IsWithinLimits(packingError, VertexPacker::GetPackingErrorLimits(meshData.vertices, decodeParams));
+		if(!b_IsWithinLimits) {
+			std::cout << modelFilePath << ": packed vertex error over the format limits\n";
+		}
+		assert(b_IsWithinLimits);
+#endif
+	}
+
+	// Geometry and tangent streams go to separate buffers
+	std::vector<unsigned char> splitStreams[Num_VertexStreams] {};
+	SplitVertexStreams(vertexData, meshData.vertices.size(), m_VertexFormat, splitStreams);
+	const void* const vertexStreams[Num_VertexStreams] {splitStreams[kGeometryVertexStream].data(), splitStreams[kTangentVertexStream].data()};
+
+	// Cook mesh for the next load, not fatal if this fails (e.g. read only data folder)
+	if(writeMeshCache) {
+		MeshCache::Write(modelFilePath, dependencyFilePaths, meshData, m_VertexFormat, vertexStreams, decodeParams);
+	}
 
 	// Initialize the vertex and index buffers.
-	result = InitializeBuffers(device);
+	uint32_t indexStride = GetIndexStride(meshData.vertices.size());
+	std::vector<unsigned char> packedIndices = PackIndices(meshData.indices, indexStride);
+	bool result = InitializeBuffers(device, geometryArena, vertexStreams, packedIndices.data(), indexStride, decodeParams);
 	if(!result) {
 		return false;
 	}
@@ -19,17 +260,14 @@ bool Model::Initialize(ID3D11Device* device, const std::string& modelFilePath) {
 	return true;
 }
 
-void Model::Render(ID3D11DeviceContext* deviceContext, bool isPatchList) {
-	// Put the vertex and index buffers on the graphics pipeline to prepare them for drawing.
-	// Set vertex buffer stride and offset.
-	unsigned int stride {sizeof(VertexType)};
-	unsigned int offset {0};
+void Model::Render(ID3D11DeviceContext* deviceContext, bool isPatchList, bool isDepthOnly) {
+	// Shared vertex and index buffers, only set if another index width or stream count was bound last
+	m_GeometryArena->Bind(deviceContext, m_GeometryArena->GetRange(m_ArenaHandle).indexStride, isDepthOnly);
 
-	// Set the vertex buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetVertexBuffers(0, 1, &m_VertexBuffer, &stride, &offset);
-
-	// Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(m_IndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	// Packed positions are dequantized in the vertex shader
+	if(m_VertexFormat == kPackedVertexFormat) {
+		deviceContext->VSSetConstantBuffers(0, 1, &m_VertexDecodeBuffer);
+	}
 
 	// Using patch list topology (Tessellation) is hard coded to triangles only
 	if(isPatchList) {
@@ -40,242 +278,320 @@ void Model::Render(ID3D11DeviceContext* deviceContext, bool isPatchList) {
 	}
 }
 
-bool Model::InitializeBuffers(ID3D11Device* device) {
-	HRESULT result;
+bool Model::UpdateResidency() {
+	/// Load
+	if(m_LoadState == kLoading) {
+		if(m_LoadJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return true;
+		}
+		if(!m_LoadJob.get()) {
+			m_LoadState = kLoadFailed;
+			return false;
+		}
+		m_LoadState = kLoaded;
+	}
+	if(m_LoadState != kLoaded) {
+		return true;
+	}
 
-	// Create the vertex array.
-	VertexType* vertices = new VertexType[m_VertexCount];
+	/// Swap in the streamed range, at most once per frame so every pass of a frame draws the same LODs
+	if(m_StreamingJob.valid() && m_StreamingJob.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		m_StreamingHandle = m_StreamingJob.get();
+		if(m_StreamingHandle == GeometryArena::kInvalidHandle) {
+			m_StreamingLOD = -1;
+		}
+	}
+	if(m_StreamingHandle != GeometryArena::kInvalidHandle && m_GeometryArena->GetRange(m_StreamingHandle).isResident) {
+		m_GeometryArena->Remove(m_ArenaHandle);
+		m_ArenaHandle = m_StreamingHandle;
+		m_ResidentLOD = m_StreamingLOD;
+		m_StreamingHandle = GeometryArena::kInvalidHandle;
+		m_StreamingLOD = -1;
+	}
 
-	// Create the index array.
-	unsigned long* indices = new unsigned long[m_IndexCount];
+	/// Next stream, from the LODs objects picked since the last call
+	int coarsestLOD = (int)m_LODs.size() - 1;
+	int requestedLOD = std::min(m_RequestedLOD, coarsestLOD);
+	m_RequestedLOD = INT_MAX;
+	if(m_ResidentLOD < 0 || m_StreamingJob.valid() || m_StreamingHandle != GeometryArena::kInvalidHandle) {
+		return true;
+	}
 
-	// Load the vertex array and index array with data.
+	// Finer LODs are streamed in right away, unused ones are only evicted after s_EvictionFrameCount frames
+	int targetLOD = m_ResidentLOD;
+	if(requestedLOD <= m_ResidentLOD) {
+		targetLOD = requestedLOD;
+		m_UnusedFrameCount = 0;
+		m_FinestUnusedRequest = INT_MAX;
+	}
+	else {
+		m_FinestUnusedRequest = std::min(m_FinestUnusedRequest, requestedLOD);
+		if(++m_UnusedFrameCount >= s_EvictionFrameCount) {
+			targetLOD = m_FinestUnusedRequest;
+			m_UnusedFrameCount = 0;
+			m_FinestUnusedRequest = INT_MAX;
+		}
+	}
+
+	if(targetLOD != m_ResidentLOD) {
+		m_StreamingLOD = targetLOD;
+		m_StreamingJob = std::async(std::launch::async, &Model::AddLODRange, this, targetLOD);
+	}
+
+	return true;
+}
+
+GeometryArena::Range Model::GetArenaRange() const {
+	GeometryArena::Range range = m_GeometryArena->GetRange(m_ArenaHandle);
+	// The resident indices start at the resident LOD's, the unsigned wrap around cancels out once a first index counted from LOD 0 is added
+	range.firstIndex -= m_LODs[m_ResidentLOD].firstIndex;
+	return range;
+}
+
+GeometryArena::Handle Model::AddLODRange(int firstLOD) const {
+	const void* const fullVertexStreams[Num_VertexStreams] {m_CPUVertexStreams[kGeometryVertexStream].data(), m_CPUVertexStreams[kTangentVertexStream].data()};
+	if(firstLOD == 0) {
+		return m_GeometryArena->Add(fullVertexStreams, (uint32_t)m_VertexCount, m_CPUIndices.data(), (uint32_t)m_IndexCount, m_IndexStride);
+	}
+
+	// Coarser LODs come after finer ones in the index buffer, so LODs firstLOD and coarser are its tail
+	std::vector<uint32_t> allIndices {};
+	GetIndices(allIndices);
+	std::vector<uint32_t> indices(allIndices.begin() + m_LODs[firstLOD].firstIndex, allIndices.end());
+
+	// Vertices in first use order, coarse LODs use a fraction of LOD 0's
+	std::vector<uint32_t> remap(m_VertexCount, UINT32_MAX);
+	std::vector<uint32_t> usedVertices {};
+	for(uint32_t& index : indices) {
+		if(remap[index] == UINT32_MAX) {
+			remap[index] = (uint32_t)usedVertices.size();
+			usedVertices.push_back(index);
+		}
+		index = remap[index];
+	}
+
+	std::vector<unsigned char> vertexStreams[Num_VertexStreams] {};
+	for(int i = 0; i < Num_VertexStreams; i++) {
+		size_t stride = GetVertexStreamStride(m_VertexFormat, (VertexStream)i);
+		vertexStreams[i].resize(stride * usedVertices.size());
+		for(size_t j = 0; j < usedVertices.size(); j++) {
+			std::memcpy(vertexStreams[i].data() + j * stride, m_CPUVertexStreams[i].data() + usedVertices[j] * stride, stride);
+		}
+	}
+
+	const void* const streamData[Num_VertexStreams] {vertexStreams[kGeometryVertexStream].data(), vertexStreams[kTangentVertexStream].data()};
+	uint32_t indexStride = GetIndexStride(usedVertices.size());
+	std::vector<unsigned char> packedIndices = PackIndices(indices, indexStride);
+	return m_GeometryArena->Add(streamData, (uint32_t)usedVertices.size(), packedIndices.data(), (uint32_t)indices.size(), indexStride);
+}
+
+void Model::GetMeshVertices(std::vector<MeshVertex>& vertices) const {
+	vertices.resize(m_VertexCount);
+	const void* const vertexStreams[Num_VertexStreams] {m_CPUVertexStreams[kGeometryVertexStream].data(), m_CPUVertexStreams[kTangentVertexStream].data()};
+	if(m_VertexFormat != kPackedVertexFormat) {
+		InterleaveVertexStreams(vertexStreams, m_VertexCount, m_VertexFormat, vertices.data());
+		return;
+	}
+
+	std::vector<PackedMeshVertex> packedVertices(m_VertexCount);
+	InterleaveVertexStreams(vertexStreams, m_VertexCount, m_VertexFormat, packedVertices.data());
 	for(int i = 0; i < m_VertexCount; i++) {
-		vertices[i].position = XMFLOAT3(m_Model[i].x, m_Model[i].y, m_Model[i].z);
-		vertices[i].texture  = XMFLOAT2(m_Model[i].tu, m_Model[i].tv);
-		vertices[i].normal   = XMFLOAT3(m_Model[i].nx, m_Model[i].ny, m_Model[i].nz);
-		vertices[i].tangent  = XMFLOAT3(m_Model[i].tx, m_Model[i].ty, m_Model[i].tz);
-		vertices[i].binormal = XMFLOAT3(m_Model[i].bx, m_Model[i].by, m_Model[i].bz);
-		
-		indices[i] = i;
-	}
-
-	// Set up the description of the static vertex buffer.
-	D3D11_BUFFER_DESC vertexBufferDesc {};
-	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	vertexBufferDesc.ByteWidth = sizeof(VertexType) * m_VertexCount;
-	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vertexBufferDesc.CPUAccessFlags = 0;
-	vertexBufferDesc.MiscFlags = 0;
-	vertexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the vertex data.
-	D3D11_SUBRESOURCE_DATA vertexData {};
-	vertexData.pSysMem = vertices;
-	vertexData.SysMemPitch = 0;
-	vertexData.SysMemSlicePitch = 0;
-
-	// Now create the vertex buffer.
-	result = device->CreateBuffer(&vertexBufferDesc, &vertexData, &m_VertexBuffer);
-	if(FAILED(result)) {
-		return false;
+		vertices[i] = VertexPacker::UnpackVertex(packedVertices[i], m_DecodeParams);
 	}
+}
 
-	// Set up the description of the static index buffer.
-	D3D11_BUFFER_DESC indexBufferDesc {};
-	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_IndexCount;
-	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	indexBufferDesc.CPUAccessFlags = 0;
-	indexBufferDesc.MiscFlags = 0;
-	indexBufferDesc.StructureByteStride = 0;
-
-	// Give the subresource structure a pointer to the index data.
-	D3D11_SUBRESOURCE_DATA indexData {};
-	indexData.pSysMem = indices;
-	indexData.SysMemPitch = 0;
-	indexData.SysMemSlicePitch = 0;
-
-	// Create the index buffer.
-	result = device->CreateBuffer(&indexBufferDesc, &indexData, &m_IndexBuffer);
-	if(FAILED(result)) {
-		return false;
+void Model::GetIndices(std::vector<uint32_t>& indices) const {
+	indices.resize(m_IndexCount);
+	if(m_IndexStride == sizeof(uint16_t)) {
+		const uint16_t* input = (const uint16_t*)m_CPUIndices.data();
+		std::copy(input, input + m_IndexCount, indices.begin());
+	}
+	else {
+		std::memcpy(indices.data(), m_CPUIndices.data(), m_CPUIndices.size());
 	}
+}
 
-	// Release the arrays now that the vertex and index buffers have been created and loaded.
-	delete[] vertices;
-	vertices = nullptr;
+void Model::BuildMeshData(MeshData& meshData) const {
+	meshData.vertices.resize(m_VertexCount);
+	meshData.indices.resize(m_IndexCount);
 
-	delete[] indices;
-	indices = nullptr;
+	// Load the vertex array and index array with data.
+	for(int i = 0; i < m_VertexCount; i++) {
+		meshData.vertices[i].position = XMFLOAT3(m_Model[i].x, m_Model[i].y, m_Model[i].z);
+		meshData.vertices[i].texture  = XMFLOAT2(m_Model[i].tu, m_Model[i].tv);
+		meshData.vertices[i].normal   = XMFLOAT3(m_Model[i].nx, m_Model[i].ny, m_Model[i].nz);
 
-	return true;
+		meshData.indices[i] = i;
+	}
 }
 
-bool Model::LoadModel(std::string filename) {
-	std::ifstream fin {};
+bool Model::InitializeBuffers(ID3D11Device* device, GeometryArena* geometryArena, const void* const (&vertexStreams)[Num_VertexStreams], const void* indices, uint32_t indexStride, const VertexDecodeParams& decodeParams) {
+	HRESULT result;
+
+	// Kept for static batching and LOD streaming, the cache path's section pointers are unmapped after this returns
+	for(int i = 0; i < Num_VertexStreams; i++) {
+		const unsigned char* streamData = (const unsigned char*)vertexStreams[i];
+		m_CPUVertexStreams[i].assign(streamData, streamData + (size_t)GetVertexStreamStride(m_VertexFormat, (VertexStream)i) * m_VertexCount);
+	}
+	m_CPUIndices.assign((const unsigned char*)indices, (const unsigned char*)indices + (size_t)indexStride * m_IndexCount);
+	m_IndexStride = indexStride;
+	m_DecodeParams = decodeParams;
+
+	// Coarsest LOD first, it is small and makes the model drawable after the arena's next Flush
+	m_GeometryArena = geometryArena;
+	m_StreamingLOD = (int)m_LODs.size() - 1;
+	m_StreamingHandle = AddLODRange(m_StreamingLOD);
+	if(m_StreamingHandle == GeometryArena::kInvalidHandle) {
+		return false;
+	}
+
+	// Decode params never change, so the constant buffer is immutable
+	if(m_VertexFormat == kPackedVertexFormat) {
+		D3D11_BUFFER_DESC decodeBufferDesc {};
+		decodeBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		decodeBufferDesc.ByteWidth = sizeof(VertexDecodeParams);
+		decodeBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		decodeBufferDesc.CPUAccessFlags = 0;
+		decodeBufferDesc.MiscFlags = 0;
+		decodeBufferDesc.StructureByteStride = 0;
+
+		D3D11_SUBRESOURCE_DATA decodeData {};
+		decodeData.pSysMem = &decodeParams;
+
+		result = device->CreateBuffer(&decodeBufferDesc, &decodeData, &m_VertexDecodeBuffer);
+		if(FAILED(result)) {
+			return false;
+		}
+	}
 
-	// Open the model file.
-	fin.open(filename);
+	return true;
+}
 
-	// If it could not open the file then exit.
-	if(fin.fail()) {
+bool Model::LoadModel(const std::string& filename) {
+	// Map the whole file, all parsing below reads directly from the mapped view
+	MappedFile modelFile {};
+	if(!modelFile.Initialize(filename)) {
 		return false;
 	}
 
+	const char* fileBegin = (const char*)modelFile.GetData();
+	const char* fileEnd = fileBegin + modelFile.GetSize();
+
 	// Read up to the value of vertex count.
-	char input {};
-	while(input != ':') {
-		fin.get(input);
+	const char* current = std::find(fileBegin, fileEnd, ':');
+	if(current == fileEnd) {
+		modelFile.Shutdown();
+		return false;
 	}
 
 	// Read in the vertex count.
-	fin >> m_VertexCount;
+	current = SkipWhitespace(current + 1, fileEnd);
+	std::from_chars_result countResult = std::from_chars(current, fileEnd, m_VertexCount);
+	if(countResult.ec != std::errc() || m_VertexCount <= 0) {
+		modelFile.Shutdown();
+		return false;
+	}
 
 	// Set the number of indices to be the same as the vertex count.
 	m_IndexCount = m_VertexCount;
 
+	// Read up to the beginning of the data.
+	const char* dataBegin = std::find(countResult.ptr, fileEnd, ':');
+	if(dataBegin == fileEnd) {
+		modelFile.Shutdown();
+		return false;
+	}
+	dataBegin++;
+
 	// Create the model using the vertex count that was read in.
 	m_Model = new ModelType[m_VertexCount];
 
-	// Read up to the beginning of the data.
-	input = {};
-	while(input != ':') {
-		fin.get(input);
+	/// Split data into line aligned chunks, one per thread
+	size_t dataSize = fileEnd - dataBegin;
+	size_t chunkCount = std::clamp<size_t>(dataSize / s_MinParseChunkSize, 1, std::max(1u, std::thread::hardware_concurrency()));
+
+	std::vector<const char*> chunkBounds(chunkCount + 1);
+	chunkBounds[0] = dataBegin;
+	chunkBounds[chunkCount] = fileEnd;
+	for(size_t i = 1; i < chunkCount; i++) {
+		const char* chunkStart = std::max(chunkBounds[i - 1], dataBegin + dataSize * i / chunkCount);
+		chunkStart = std::find(chunkStart, fileEnd, '\n');
+		chunkBounds[i] = chunkStart == fileEnd ? fileEnd : chunkStart + 1;
 	}
 
-	// Read in the vertex data.
-	for(int i = 0; i < m_VertexCount; i++) {
-		fin >> m_Model[i].x  >> m_Model[i].y  >> m_Model[i].z;
-		fin >> m_Model[i].tu >> m_Model[i].tv;
-		fin >> m_Model[i].nx >> m_Model[i].ny >> m_Model[i].nz;
-		
-		if(m_Model[i].x > m_Extents.x) {
-			m_Extents.x = m_Model[i].x;
-		}
-		if(m_Model[i].y > m_Extents.y) {
-			m_Extents.y = m_Model[i].y;
+	// Every line holds one vertex, so the first vertex index of each chunk is the prefix sum of data lines before it
+	std::vector<int> chunkFirstVertex(chunkCount + 1);
+	{
+		std::vector<std::future<int>> lineCountFutures(chunkCount);
+		for(size_t i = 0; i < chunkCount; i++) {
+			lineCountFutures[i] = std::async(std::launch::async, CountDataLines, chunkBounds[i], chunkBounds[i + 1]);
 		}
-		if(m_Model[i].z > m_Extents.z) {
-			m_Extents.z = m_Model[i].z;
+		for(size_t i = 0; i < chunkCount; i++) {
+			chunkFirstVertex[i + 1] = chunkFirstVertex[i] + lineCountFutures[i].get();
 		}
 	}
 
-	// Close the model file.
-	fin.close();
-
-	return true;
-}
-
-void Model::CalculateModelVectors() {
-	TempVertexType vertex1 {}, vertex2 {}, vertex3 {};
-	VectorType tangent {}, binormal {};
-
-	// Calculate the number of faces in the model.
-	int faceCount = m_VertexCount / 3;
-
-	// Initialize the index to the model data.
-	int index = 0;
-
-	// Go through all the faces and calculate the the tangent and binormal vectors.
-	for(int i = 0; i < faceCount; i++) {
-		// Get the three vertices for this face from the model.
-		vertex1.x = m_Model[index].x;
-		vertex1.y = m_Model[index].y;
-		vertex1.z = m_Model[index].z;
-		vertex1.tu = m_Model[index].tu;
-		vertex1.tv = m_Model[index].tv;
-		index++;
-
-		vertex2.x = m_Model[index].x;
-		vertex2.y = m_Model[index].y;
-		vertex2.z = m_Model[index].z;
-		vertex2.tu = m_Model[index].tu;
-		vertex2.tv = m_Model[index].tv;
-		index++;
-
-		vertex3.x = m_Model[index].x;
-		vertex3.y = m_Model[index].y;
-		vertex3.z = m_Model[index].z;
-		vertex3.tu = m_Model[index].tu;
-		vertex3.tv = m_Model[index].tv;
-		index++;
-
-		CalculateTangentBinormal(vertex1, vertex2, vertex3, tangent, binormal);
-
-		// Store the tangent and binormal for this face back in the model structure.
-		m_Model[index - 1].tx = tangent.x;
-		m_Model[index - 1].ty = tangent.y;
-		m_Model[index - 1].tz = tangent.z;
-		m_Model[index - 1].bx = binormal.x;
-		m_Model[index - 1].by = binormal.y;
-		m_Model[index - 1].bz = binormal.z;
-
-		m_Model[index - 2].tx = tangent.x;
-		m_Model[index - 2].ty = tangent.y;
-		m_Model[index - 2].tz = tangent.z;
-		m_Model[index - 2].bx = binormal.x;
-		m_Model[index - 2].by = binormal.y;
-		m_Model[index - 2].bz = binormal.z;
-
-		m_Model[index - 3].tx = tangent.x;
-		m_Model[index - 3].ty = tangent.y;
-		m_Model[index - 3].tz = tangent.z;
-		m_Model[index - 3].bx = binormal.x;
-		m_Model[index - 3].by = binormal.y;
-		m_Model[index - 3].bz = binormal.z;
+	if(chunkFirstVertex[chunkCount] < m_VertexCount) {
+		modelFile.Shutdown();
+		return false;
 	}
-}
-
-void Model::CalculateTangentBinormal(TempVertexType vertex1, TempVertexType vertex2, TempVertexType vertex3, VectorType& tangent, VectorType& binormal) {
-	float vector1[3], vector2[3];
-	float tuVector[2], tvVector[2];
-	float den;
-	float length;
-
-	// Calculate the two vectors for this face.
-	vector1[0] = vertex2.x - vertex1.x;
-	vector1[1] = vertex2.y - vertex1.y;
-	vector1[2] = vertex2.z - vertex1.z;
-
-	vector2[0] = vertex3.x - vertex1.x;
-	vector2[1] = vertex3.y - vertex1.y;
-	vector2[2] = vertex3.z - vertex1.z;
 
-	// Calculate the tu and tv texture space vectors.
-	tuVector[0] = vertex2.tu - vertex1.tu;
-	tvVector[0] = vertex2.tv - vertex1.tv;
+	/// Parse chunks in parallel straight into m_Model
+	std::vector<std::future<int>> parseFutures(chunkCount);
+	for(size_t i = 0; i < chunkCount; i++) {
+		int firstVertex = std::min(chunkFirstVertex[i], m_VertexCount);
+		int maxVertexCount = m_VertexCount - firstVertex;
+		parseFutures[i] = std::async(std::launch::async, ParseModelDataChunk, chunkBounds[i], chunkBounds[i + 1], m_Model + firstVertex, maxVertexCount);
+	}
 
-	tuVector[1] = vertex3.tu - vertex1.tu;
-	tvVector[1] = vertex3.tv - vertex1.tv;
+	bool b_ParseSucceeded = true;
+	for(size_t i = 0; i < chunkCount; i++) {
+		int parsedCount = parseFutures[i].get();
+		int expectedCount = std::min(chunkFirstVertex[i + 1], m_VertexCount) - std::min(chunkFirstVertex[i], m_VertexCount);
+		if(parsedCount != expectedCount) {
+			b_ParseSucceeded = false;
+		}
+	}
 
-	// Calculate the denominator of the tangent/binormal equation.
-	den = 1.0f / (tuVector[0] * tvVector[1] - tuVector[1] * tvVector[0]);
+	// Close the model file.
+	modelFile.Shutdown();
 
-	// Calculate the cross products and multiply by the coefficient to get the tangent and binormal.
-	tangent.x = (tvVector[1] * vector1[0] - tvVector[0] * vector2[0]) * den;
-	tangent.y = (tvVector[1] * vector1[1] - tvVector[0] * vector2[1]) * den;
-	tangent.z = (tvVector[1] * vector1[2] - tvVector[0] * vector2[2]) * den;
+	return b_ParseSucceeded;
+}
 
-	binormal.x = (tuVector[0] * vector2[0] - tuVector[1] * vector1[0]) * den;
-	binormal.y = (tuVector[0] * vector2[1] - tuVector[1] * vector1[1]) * den;
-	binormal.z = (tuVector[0] * vector2[2] - tuVector[1] * vector1[2]) * den;
+int Model::ParseTextModel(const std::string& modelFilePath) {
+	Model model {};
+	bool result = model.LoadModel(modelFilePath);
+	delete[] model.m_Model;
+	model.m_Model = nullptr;
+	return result ? model.m_VertexCount : -1;
+}
 
-	// Calculate the length of this normal.
-	length = sqrt((tangent.x * tangent.x) + (tangent.y * tangent.y) + (tangent.z * tangent.z));
+int Model::ParseModelDataChunk(const char* begin, const char* end, ModelType* output, int maxVertexCount) {
+	int vertexCount = 0;
+	const char* current = begin;
+	while(vertexCount < maxVertexCount) {
+		current = SkipWhitespace(current, end);
+		if(current == end) {
+			break;
+		}
 
-	// Normalize the normal and then store it
-	tangent.x = tangent.x / length;
-	tangent.y = tangent.y / length;
-	tangent.z = tangent.z / length;
+		// Read in the vertex data: position, uv, normal
+		ModelType& vertex = output[vertexCount];
+		float* fields[8] {&vertex.x, &vertex.y, &vertex.z, &vertex.tu, &vertex.tv, &vertex.nx, &vertex.ny, &vertex.nz};
+		for(int i = 0; i < 8; i++) {
+			current = SkipWhitespace(current, end);
+			std::from_chars_result result = std::from_chars(current, end, *fields[i]);
+			if(result.ec != std::errc()) {
+				return -1;
+			}
+			current = result.ptr;
+		}
 
-	// Calculate the length of this normal.
-	length = sqrt((binormal.x * binormal.x) + (binormal.y * binormal.y) + (binormal.z * binormal.z));
+		vertexCount++;
+	}
 
-	// Normalize the normal and then store it
-	binormal.x = binormal.x / length;
-	binormal.y = binormal.y / length;
-	binormal.z = binormal.z / length;
+	return vertexCount;
 }
 
 void Model::Shutdown() {
@@ -284,18 +600,34 @@ void Model::Shutdown() {
 	//	tex.Shutdown();
 	//}
 
-	// Shutdown the vertex and index buffers.
-	// Release the index buffer.
-	if(m_IndexBuffer) {
-		m_IndexBuffer->Release();
-		m_IndexBuffer = nullptr;
+	// Worker threads write into the model, let them finish first
+	if(m_LoadJob.valid()) {
+		m_LoadJob.get();
+	}
+	if(m_StreamingJob.valid()) {
+		m_StreamingHandle = m_StreamingJob.get();
 	}
 
-	// Release the vertex buffer.
-	if(m_VertexBuffer) {
-		m_VertexBuffer->Release();
-		m_VertexBuffer = nullptr;
+	// Free the vertex and index ranges, the arena owns the buffers
+	if(m_GeometryArena) {
+		m_GeometryArena->Remove(m_ArenaHandle);
+		m_GeometryArena->Remove(m_StreamingHandle);
+		m_GeometryArena = nullptr;
 	}
+	m_ArenaHandle = GeometryArena::kInvalidHandle;
+	m_StreamingHandle = GeometryArena::kInvalidHandle;
+	m_ResidentLOD = -1;
+	m_LoadState = kNotLoaded;
+
+	if(m_VertexDecodeBuffer) {
+		m_VertexDecodeBuffer->Release();
+		m_VertexDecodeBuffer = nullptr;
+	}
+
+	m_Meshlets.clear();
+	m_LODs.clear();
+	m_BVHNodes.clear();
+	m_BVHTriangles.clear();
 
 	// Release the model data.
 	if(m_Model) {
@@ -1,9 +1,15 @@
 #pragma once
 #include <d3d11.h>
 #include <directxmath.h>
+#include <algorithm>
+#include <climits>
+#include <future>
 #include <vector>
 
 #include "Texture.h"
+#include "MeshData.h"
+#include "MeshBVH.h"
+#include "GeometryArena.h"
 using namespace DirectX;
 
 class Model {
@@ -12,54 +18,135 @@ public:
 	Model(const Model&) {}
 	~Model() {}
 
-	bool Initialize(ID3D11Device*, const std::string& modelFilePath);
+	// Vertices and indices are sub-allocated from geometryArena, whose vertex format must be vertexFormat
+	// Only the coarsest LOD is put in the arena, finer LODs are streamed in on request (see UpdateResidency)
+	bool Initialize(ID3D11Device*, GeometryArena* geometryArena, const std::string& modelFilePath, VertexFormat vertexFormat);
+	// Cooks an indexed mesh built in memory (e.g. by PrimitiveGenerator), meshData must already have tangents
+	// Never touches the disk, name is only used for logging
+	bool Initialize(ID3D11Device*, GeometryArena* geometryArena, MeshData& meshData, const std::string& name, VertexFormat vertexFormat);
+	// Same as Initialize on a worker thread, nothing but IsLoaded and UpdateResidency may be called until IsLoaded
+	void InitializeAsync(ID3D11Device*, GeometryArena* geometryArena, const std::string& modelFilePath, VertexFormat vertexFormat);
+	void InitializeAsync(ID3D11Device*, GeometryArena* geometryArena, MeshData&& meshData, const std::string& name, VertexFormat vertexFormat);
+	// Waits for a running load or stream
 	void Shutdown();
-	void Render(ID3D11DeviceContext* deviceContext, bool isPatchList);
+
+	/// Residency
+	// Main thread, once per frame before the arena's Flush: picks up a finished load, swaps in a streamed LOD range that became resident
+	// and starts streaming towards the LODs requested since the last call (see RequestLOD)
+	// Returns false on the call that finds the load failed
+	bool UpdateResidency();
+	// Finest LOD an object picked this frame from its screen space error, finer LODs are streamed in and unrequested ones evicted
+	void RequestLOD(int lod) { m_RequestedLOD = std::min(m_RequestedLOD, lod); }
+	bool IsLoaded() const { return m_LoadState == kLoaded; }
+	// False until the coarsest LOD is resident, objects skip the model until then
+	bool IsDrawable() const { return m_ResidentLOD >= 0; }
+	// Finest LOD on the GPU, every coarser LOD is resident too, so draws use max(picked LOD, resident LOD)
+	int GetResidentLOD() const { return m_ResidentLOD; }
+	// isDepthOnly binds the geometry stream only (see VertexStream), for input layouts that skip the tangent frame
+	// Note: the arena's buffers stay bound across models, draws must add GetArenaRange's base vertex and first index
+	void Render(ID3D11DeviceContext* deviceContext, bool isPatchList, bool isDepthOnly = false);
+
+	// Where the resident LODs currently live in the arena's buffers, see GeometryArena::Range
+	// firstIndex is rebased so LOD and meshlet first indices (which count from LOD 0) can be added as usual
+	GeometryArena::Range GetArenaRange() const;
 
 	int GetIndexCount() const { return m_IndexCount; }
+	const std::vector<Meshlet>& GetMeshlets() const { return m_Meshlets; }
+	const std::vector<MeshLOD>& GetLODs() const { return m_LODs; }
+	// Imported files keep one sub-mesh per primitive, everything else has a single one covering each LOD
+	int GetSubMeshCount() const { return m_SubMeshCount; }
+	// Part of LOD lod belonging to subMesh, its index and meshlet ranges lie inside the LOD's
+	const MeshLOD& GetSubMeshLOD(int lod, int subMesh) const { return m_SubMeshLODs[lod * m_SubMeshCount + subMesh]; }
+	VertexFormat GetVertexFormat() const { return m_VertexFormat; }
 
-	XMFLOAT3 GetExtents() const { return m_Extents; }
+	const MeshBounds& GetBounds() const { return m_Bounds; }
 
-private:
-	struct VertexType {
-		XMFLOAT3 position;
-		XMFLOAT2 texture;
-		XMFLOAT3 normal;
-		XMFLOAT3 tangent;
-		XMFLOAT3 binormal;
-	};
+	// Model space copy of what was uploaded (decoded when packed), all LODs' indices included, for building world space batches (see StaticBatcher)
+	void GetMeshVertices(std::vector<MeshVertex>& vertices) const;
+	void GetIndices(std::vector<uint32_t>& indices) const;
+
+	// Only parses a rastertek text model (no welding or cooking), returns its vertex count or -1, for the parse benchmark in Scene
+	static int ParseTextModel(const std::string& modelFilePath);
 
+	// Model space ray against LOD 0, see MeshBVH::RayCast
+	bool RayCast(XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, MeshBVH::RayHit& hit) const {
+		return MeshBVH::RayCast(m_BVHNodes.data(), m_BVHNodes.size(), m_BVHTriangles.data(), origin, direction, maxDistance, hit);
+	}
+
+private:
+	// Vertex as stored in the model text file
 	struct ModelType {
 		float x, y, z;
 		float tu, tv;
 		float nx, ny, nz;
-		float tx, ty, tz;
-		float bx, by, bz;
 	};
 
-	struct TempVertexType {
-		float x, y, z;
-		float tu, tv;
-		float nx, ny, nz;
+	enum LoadState {
+		kNotLoaded,
+		kLoading,
+		kLoaded,
+		kLoadFailed
 	};
 
-	struct VectorType {
-		float x, y, z;
-	};
+	// Cook steps after loading: bounds, optimization, LODs, meshlets, BVH, vertex encoding, then GPU buffers
+	// The result is also written to the mesh cache of modelFilePath if writeMeshCache is set, dependencyFilePaths are the other files it was imported from
+	bool InitializeFromFile(ID3D11Device* device, GeometryArena* geometryArena, const std::string& modelFilePath, VertexFormat vertexFormat);
+	bool InitializeFromMeshData(ID3D11Device* device, GeometryArena* geometryArena, MeshData& meshData, const std::string& name, VertexFormat vertexFormat);
+	bool CookMesh(ID3D11Device* device, GeometryArena* geometryArena, MeshData& meshData, const std::string& modelFilePath, const std::vector<std::string>& dependencyFilePaths, bool writeMeshCache);
+	bool InitializeBuffers(ID3D11Device* device, GeometryArena* geometryArena, const void* const (&vertexStreams)[Num_VertexStreams], const void* indices, uint32_t indexStride, const VertexDecodeParams& decodeParams);
+	// Adds LOD firstLOD and every coarser LOD to the arena, with only the vertices they use (all of them for LOD 0)
+	// Only reads the CPU copies, so it runs on a worker thread while the model is drawn
+	GeometryArena::Handle AddLODRange(int firstLOD) const;
+	bool LoadModel(const std::string& filename);
+	static int ParseModelDataChunk(const char* begin, const char* end, ModelType* output, int maxVertexCount);
+	void BuildMeshData(MeshData& meshData) const;
 
-	void CalculateModelVectors();
-	void CalculateTangentBinormal(TempVertexType, TempVertexType, TempVertexType, VectorType&, VectorType&);
+private:
+	// Vertex and index ranges in the shared buffers, holding LODs m_ResidentLOD and coarser
+	GeometryArena* m_GeometryArena {};
+	GeometryArena::Handle m_ArenaHandle {GeometryArena::kInvalidHandle};
+	int m_ResidentLOD {-1};
 
-	bool InitializeBuffers(ID3D11Device*);
-	bool LoadModel(std::string);
+	// Note: the worker threads only write members before their future is ready, the main thread reads them after get()
+	LoadState m_LoadState {kNotLoaded};
+	std::future<bool> m_LoadJob {};
 
-private:
-	ID3D11Buffer* m_VertexBuffer {};
-	ID3D11Buffer* m_IndexBuffer  {};
+	// Range being streamed in, it replaces m_ArenaHandle at the first UpdateResidency after it became resident
+	std::future<GeometryArena::Handle> m_StreamingJob {};
+	GeometryArena::Handle m_StreamingHandle {GeometryArena::kInvalidHandle};
+	int m_StreamingLOD {-1};
+
+	// Finest LOD requested since the last UpdateResidency, and over the frames the resident LOD went unused
+	int m_RequestedLOD {INT_MAX};
+	int m_UnusedFrameCount {};
+	int m_FinestUnusedRequest {INT_MAX};
 	int m_VertexCount {};
 	int m_IndexCount  {};
 
-	XMFLOAT3 m_Extents {};
+	// CPU copy of the meshlet bounds for per frame culling, see MeshletCuller
+	std::vector<Meshlet> m_Meshlets {};
+	// LOD 0 first, each LOD owns a contiguous index and meshlet range
+	std::vector<MeshLOD> m_LODs {};
+	// Every LOD split into its sub-meshes, see MeshData::subMeshLODs
+	std::vector<MeshLOD> m_SubMeshLODs {};
+	int m_SubMeshCount {};
+
+	VertexFormat m_VertexFormat {kFullVertexFormat};
+	// Position dequantization for kPackedVertexFormat, bound to VS slot 0
+	ID3D11Buffer* m_VertexDecodeBuffer {};
+
+	// Model space bounds for object culling and LOD selection
+	MeshBounds m_Bounds {};
+
+	// CPU copy of the GPU buffers in their GPU layout, read back by GetMeshVertices and GetIndices
+	std::vector<unsigned char> m_CPUVertexStreams[Num_VertexStreams] {};
+	std::vector<unsigned char> m_CPUIndices {};
+	uint32_t m_IndexStride {};
+	VertexDecodeParams m_DecodeParams {};
+
+	// CPU side ray query tree, the GPU buffers hold quantized positions only
+	std::vector<BVHNode> m_BVHNodes {};
+	std::vector<BVHTriangle> m_BVHTriangles {};
 
 	ModelType* m_Model {};
 };
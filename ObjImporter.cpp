@@ -0,0 +1,232 @@
+#include "ObjImporter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+	// Bytes read from disk at a time, grows only if a single line is longer
+	constexpr size_t s_ReadChunkSize = 1024 * 1024;
+
+	// Zero based indices of one face corner, s_MissingIndex for an omitted vt/vn
+	constexpr uint32_t s_MissingIndex = UINT32_MAX;
+
+	struct CornerKey {
+		uint32_t position;
+		uint32_t texture;
+		uint32_t normal;
+		bool operator==(const CornerKey& other) const { return position == other.position && texture == other.texture && normal == other.normal; }
+	};
+
+	struct CornerKeyHash {
+		size_t operator()(const CornerKey& key) const {
+			return (size_t)key.position * 73856093u ^ (size_t)key.texture * 19349663u ^ (size_t)key.normal * 83492791u;
+		}
+	};
+
+	const char* SkipSpaces(const char* current, const char* end) {
+		while(current != end && (*current == ' ' || *current == '\t' || *current == '\r')) {
+			current++;
+		}
+		return current;
+	}
+
+	bool ParseFloats(const char* current, const char* end, float* output, int count) {
+		for(int i = 0; i < count; i++) {
+			current = SkipSpaces(current, end);
+			std::from_chars_result result = std::from_chars(current, end, output[i]);
+			if(result.ec != std::errc()) {
+				return false;
+			}
+			current = result.ptr;
+		}
+		return true;
+	}
+
+	// OBJ indices are 1 based, negative ones count back from the last element read so far
+	bool ResolveIndex(const char*& current, const char* end, size_t elementCount, uint32_t& index) {
+		long long value = 0;
+		std::from_chars_result result = std::from_chars(current, end, value);
+		if(result.ec != std::errc() || value == 0) {
+			return false;
+		}
+		current = result.ptr;
+
+		long long resolved = value > 0 ? value - 1 : (long long)elementCount + value;
+		if(resolved < 0 || resolved >= (long long)elementCount) {
+			return false;
+		}
+		index = (uint32_t)resolved;
+		return true;
+	}
+}
+
+bool ObjImporter::Import(const std::string& filePath, MeshData& meshData) {
+	std::ifstream fin {filePath, std::ios::binary};
+	if(fin.fail()) {
+		return false;
+	}
+
+	meshData = MeshData {};
+
+	std::vector<XMFLOAT3> positions {};
+	std::vector<XMFLOAT2> textureCoords {};
+	std::vector<XMFLOAT3> normals {};
+
+	// Corner -> output vertex, keeps the source's sharing so the output is indexed straight away
+	std::unordered_map<CornerKey, uint32_t, CornerKeyHash> cornerVertices {};
+	std::vector<uint32_t> faceVertices {};
+
+	meshData.subMeshes.push_back(SubMesh {});
+
+	auto StartSubMesh = [&meshData](const char* nameBegin, const char* nameEnd) {
+		SubMesh& current = meshData.subMeshes.back();
+		if(current.indexCount > 0) {
+			meshData.subMeshes.push_back(SubMesh {});
+		}
+		SubMesh& subMesh = meshData.subMeshes.back();
+		subMesh.name.assign(nameBegin, nameEnd);
+		subMesh.firstIndex = (uint32_t)meshData.indices.size();
+	};
+
+	auto ParseFace = [&](const char* current, const char* end) {
+		faceVertices.clear();
+		while(true) {
+			current = SkipSpaces(current, end);
+			if(current == end) {
+				break;
+			}
+
+			// v, v/vt, v//vn or v/vt/vn
+			CornerKey key {s_MissingIndex, s_MissingIndex, s_MissingIndex};
+			if(!ResolveIndex(current, end, positions.size(), key.position)) {
+				return false;
+			}
+			if(current != end && *current == '/') {
+				current++;
+				if(current != end && *current != '/' && !ResolveIndex(current, end, textureCoords.size(), key.texture)) {
+					return false;
+				}
+				if(current != end && *current == '/') {
+					current++;
+					if(!ResolveIndex(current, end, normals.size(), key.normal)) {
+						return false;
+					}
+				}
+			}
+
+			auto [it, b_Inserted] = cornerVertices.emplace(key, (uint32_t)meshData.vertices.size());
+			if(b_Inserted) {
+				MeshVertex vertex {};
+				vertex.position = positions[key.position];
+				if(key.texture != s_MissingIndex) {
+					vertex.texture = textureCoords[key.texture];
+				}
+				if(key.normal != s_MissingIndex) {
+					vertex.normal = normals[key.normal];
+				}
+				meshData.vertices.push_back(vertex);
+			}
+			faceVertices.push_back(it->second);
+		}
+
+		// Fan triangulation, reversed winding for the left handed clockwise convention
+		for(size_t i = 2; i < faceVertices.size(); i++) {
+			meshData.indices.push_back(faceVertices[0]);
+			meshData.indices.push_back(faceVertices[i]);
+			meshData.indices.push_back(faceVertices[i - 1]);
+			meshData.subMeshes.back().indexCount += 3;
+		}
+		return true;
+	};
+
+	auto ParseLine = [&](const char* current, const char* end) {
+		current = SkipSpaces(current, end);
+		const char* keywordEnd = current;
+		while(keywordEnd != end && *keywordEnd != ' ' && *keywordEnd != '\t' && *keywordEnd != '\r') {
+			keywordEnd++;
+		}
+		std::string_view keyword(current, keywordEnd - current);
+		current = keywordEnd;
+
+		if(keyword == "v") {
+			float values[3];
+			if(!ParseFloats(current, end, values, 3)) {
+				return false;
+			}
+			positions.push_back(XMFLOAT3(values[0], values[1], -values[2]));
+		}
+		else if(keyword == "vt") {
+			float values[2];
+			if(!ParseFloats(current, end, values, 2)) {
+				return false;
+			}
+			textureCoords.push_back(XMFLOAT2(values[0], 1.0f - values[1]));
+		}
+		else if(keyword == "vn") {
+			float values[3];
+			if(!ParseFloats(current, end, values, 3)) {
+				return false;
+			}
+			normals.push_back(XMFLOAT3(values[0], values[1], -values[2]));
+		}
+		else if(keyword == "f") {
+			return ParseFace(current, end);
+		}
+		else if(keyword == "o" || keyword == "g" || keyword == "usemtl") {
+			current = SkipSpaces(current, end);
+			while(end != current && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+				end--;
+			}
+			StartSubMesh(current, end);
+		}
+		// Everything else (comments, s, mtllib, lines, points) is ignored
+		return true;
+	};
+
+	/// Read chunks, parse the complete lines and carry the partial last line over to the next chunk
+	std::vector<char> buffer(s_ReadChunkSize);
+	size_t filledSize = 0;
+	while(true) {
+		fin.read(buffer.data() + filledSize, buffer.size() - filledSize);
+		size_t readSize = (size_t)fin.gcount();
+		filledSize += readSize;
+		bool b_EndOfFile = readSize == 0 || fin.eof();
+
+		const char* lineStart = buffer.data();
+		const char* bufferEnd = buffer.data() + filledSize;
+		while(true) {
+			const char* lineEnd = std::find(lineStart, bufferEnd, '\n');
+			if(lineEnd == bufferEnd) {
+				break;
+			}
+			if(!ParseLine(lineStart, lineEnd)) {
+				return false;
+			}
+			lineStart = lineEnd + 1;
+		}
+
+		size_t leftoverSize = bufferEnd - lineStart;
+		if(b_EndOfFile) {
+			if(leftoverSize > 0 && !ParseLine(lineStart, bufferEnd)) {
+				return false;
+			}
+			break;
+		}
+
+		// A line longer than the whole buffer
+		if(leftoverSize == buffer.size()) {
+			buffer.resize(buffer.size() * 2);
+		}
+		std::memmove(buffer.data(), lineStart, leftoverSize);
+		filledSize = leftoverSize;
+	}
+
+	if(meshData.subMeshes.back().indexCount == 0) {
+		meshData.subMeshes.pop_back();
+	}
+
+	return !meshData.indices.empty();
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "MeshData.h"
+
+#include <string>
+
+// Streaming Wavefront OBJ reader (v, vt, vn, f, o/g/usemtl), output feeds the same cook pipeline as the text models
+// The file is read in fixed size chunks and parsed line by line, so memory use is the output mesh plus one chunk
+// Converted to the engine's left handed, clockwise convention: z is mirrored, winding reversed and v flipped (as rastertek's converter does)
+class ObjImporter {
+public:
+	// Every distinct v/vt/vn corner becomes one vertex, polygons are fan triangulated
+	// Each o/g/usemtl starts a new SubMesh, missing normals are left zero (see TangentGenerator::GenerateMissingNormals)
+	static bool Import(const std::string& filePath, MeshData& meshData);
+};
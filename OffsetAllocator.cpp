@@ -0,0 +1,303 @@
+#include "OffsetAllocator.h"
+
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+	constexpr uint32_t s_MantissaBits = 3;
+	constexpr uint32_t s_MantissaValue = 1 << s_MantissaBits;
+	constexpr uint32_t s_MantissaMask = s_MantissaValue - 1;
+	constexpr uint32_t s_NoBit = UINT32_MAX;
+
+	uint32_t LowestSetBit(uint32_t mask) {
+#ifdef _MSC_VER
+		unsigned long bit {};
+		return _BitScanForward(&bit, mask) ? (uint32_t)bit : s_NoBit;
+#else
+		return mask != 0 ? (uint32_t)__builtin_ctz(mask) : s_NoBit;
+#endif
+	}
+
+	uint32_t HighestSetBit(uint32_t mask) {
+#ifdef _MSC_VER
+		unsigned long bit {};
+		return _BitScanReverse(&bit, mask) ? (uint32_t)bit : s_NoBit;
+#else
+		return mask != 0 ? 31 - (uint32_t)__builtin_clz(mask) : s_NoBit;
+#endif
+	}
+
+	// Lowest set bit at or above startBit
+	uint32_t LowestSetBitFrom(uint32_t mask, uint32_t startBit) {
+		if(startBit >= 32) {
+			return s_NoBit;
+		}
+		return LowestSetBit(mask & (~0u << startBit));
+	}
+}
+
+/// Size bins
+// A bin is a tiny float: 5 bit exponent, 3 bit mantissa with an implicit leading 1 (sizes below 8 are exact)
+uint32_t OffsetAllocator::SizeToBinRoundDown(uint32_t size) {
+	if(size < s_MantissaValue) {
+		return size;
+	}
+	uint32_t mantissaStartBit = HighestSetBit(size) - s_MantissaBits;
+	uint32_t exponent = mantissaStartBit + 1;
+	uint32_t mantissa = (size >> mantissaStartBit) & s_MantissaMask;
+	return (exponent << s_MantissaBits) | mantissa;
+}
+
+uint32_t OffsetAllocator::SizeToBinRoundUp(uint32_t size) {
+	if(size < s_MantissaValue) {
+		return size;
+	}
+	uint32_t mantissaStartBit = HighestSetBit(size) - s_MantissaBits;
+	uint32_t exponent = mantissaStartBit + 1;
+	uint32_t mantissa = (size >> mantissaStartBit) & s_MantissaMask;
+	uint32_t lowBitsMask = (1u << mantissaStartBit) - 1;
+	// Note: a mantissa overflow carries into the exponent, which is the next bin up
+	return ((exponent << s_MantissaBits) + mantissa) + ((size & lowBitsMask) != 0 ? 1 : 0);
+}
+
+uint32_t OffsetAllocator::BinToSize(uint32_t bin) {
+	uint32_t exponent = bin >> s_MantissaBits;
+	uint32_t mantissa = bin & s_MantissaMask;
+	if(exponent == 0) {
+		return mantissa;
+	}
+	return (mantissa | s_MantissaValue) << (exponent - 1);
+}
+
+/// Allocation
+void OffsetAllocator::Reset(uint32_t size) {
+	m_Size = size;
+	m_FreeStorage = 0;
+	m_FreeRegionCount = 0;
+	m_AllocationCount = 0;
+	m_UsedBinsTop = 0;
+	for(uint32_t i = 0; i < kNumTopBins; i++) {
+		m_UsedBins[i] = 0;
+	}
+	for(uint32_t i = 0; i < kNumLeafBins; i++) {
+		m_BinIndices[i] = kUnused;
+	}
+	m_Nodes.clear();
+	m_FreeNodes.clear();
+
+	if(size > 0) {
+		InsertNodeIntoBin(size, 0);
+	}
+}
+
+OffsetAllocator::Allocation OffsetAllocator::Allocate(uint32_t size) {
+	if(size == 0) {
+		size = 1;
+	}
+
+	// Smallest bin whose every region fits the request, then any larger non empty bin
+	uint32_t minBin = SizeToBinRoundUp(size);
+	uint32_t minTopBin = minBin / kBinsPerLeaf;
+	uint32_t minLeafBin = minBin % kBinsPerLeaf;
+
+	uint32_t topBin = minTopBin;
+	uint32_t leafBin = s_NoBit;
+	if(m_UsedBinsTop & (1u << topBin)) {
+		leafBin = LowestSetBitFrom(m_UsedBins[topBin], minLeafBin);
+	}
+	if(leafBin == s_NoBit) {
+		topBin = LowestSetBitFrom(m_UsedBinsTop, minTopBin + 1);
+		if(topBin == s_NoBit) {
+			return Allocation {};
+		}
+		leafBin = LowestSetBit(m_UsedBins[topBin]);
+	}
+	uint32_t bin = topBin * kBinsPerLeaf + leafBin;
+
+	// Take the head of the bin's free list
+	uint32_t nodeIndex = m_BinIndices[bin];
+	uint32_t regionSize = m_Nodes[nodeIndex].dataSize;
+	uint32_t regionOffset = m_Nodes[nodeIndex].dataOffset;
+	m_BinIndices[bin] = m_Nodes[nodeIndex].binListNext;
+	if(m_BinIndices[bin] != kUnused) {
+		m_Nodes[m_BinIndices[bin]].binListPrev = kUnused;
+	}
+	else {
+		m_UsedBins[topBin] &= (uint8_t)~(1u << leafBin);
+		if(m_UsedBins[topBin] == 0) {
+			m_UsedBinsTop &= ~(1u << topBin);
+		}
+	}
+	m_FreeStorage -= regionSize;
+	m_FreeRegionCount--;
+
+	m_Nodes[nodeIndex].used = true;
+	m_Nodes[nodeIndex].dataSize = size;
+	m_Nodes[nodeIndex].binListPrev = kUnused;
+	m_Nodes[nodeIndex].binListNext = kUnused;
+	m_AllocationCount++;
+
+	// The rest of the region goes back as a free neighbour right after the allocation
+	uint32_t remainder = regionSize - size;
+	if(remainder > 0) {
+		uint32_t remainderIndex = InsertNodeIntoBin(remainder, regionOffset + size);
+		uint32_t neighborNext = m_Nodes[nodeIndex].neighborNext;
+		if(neighborNext != kUnused) {
+			m_Nodes[neighborNext].neighborPrev = remainderIndex;
+		}
+		m_Nodes[remainderIndex].neighborPrev = nodeIndex;
+		m_Nodes[remainderIndex].neighborNext = neighborNext;
+		m_Nodes[nodeIndex].neighborNext = remainderIndex;
+	}
+
+	Allocation allocation {};
+	allocation.offset = regionOffset;
+	allocation.metadata = nodeIndex;
+	return allocation;
+}
+
+void OffsetAllocator::Free(Allocation allocation) {
+	if(allocation.metadata == kNoSpace) {
+		return;
+	}
+	uint32_t nodeIndex = allocation.metadata;
+	assert(nodeIndex < m_Nodes.size() && m_Nodes[nodeIndex].used);
+
+	uint32_t offset = m_Nodes[nodeIndex].dataOffset;
+	uint32_t size = m_Nodes[nodeIndex].dataSize;
+	uint32_t neighborPrev = m_Nodes[nodeIndex].neighborPrev;
+	uint32_t neighborNext = m_Nodes[nodeIndex].neighborNext;
+
+	// Merge with free neighbours, their nodes are released
+	if(neighborPrev != kUnused && !m_Nodes[neighborPrev].used) {
+		offset = m_Nodes[neighborPrev].dataOffset;
+		size += m_Nodes[neighborPrev].dataSize;
+		uint32_t mergedPrev = m_Nodes[neighborPrev].neighborPrev;
+		RemoveNodeFromBin(neighborPrev);
+		neighborPrev = mergedPrev;
+	}
+	if(neighborNext != kUnused && !m_Nodes[neighborNext].used) {
+		size += m_Nodes[neighborNext].dataSize;
+		uint32_t mergedNext = m_Nodes[neighborNext].neighborNext;
+		RemoveNodeFromBin(neighborNext);
+		neighborNext = mergedNext;
+	}
+
+	ReleaseNode(nodeIndex);
+	m_AllocationCount--;
+
+	uint32_t combinedIndex = InsertNodeIntoBin(size, offset);
+	m_Nodes[combinedIndex].neighborPrev = neighborPrev;
+	m_Nodes[combinedIndex].neighborNext = neighborNext;
+	if(neighborPrev != kUnused) {
+		m_Nodes[neighborPrev].neighborNext = combinedIndex;
+	}
+	if(neighborNext != kUnused) {
+		m_Nodes[neighborNext].neighborPrev = combinedIndex;
+	}
+}
+
+uint32_t OffsetAllocator::GetAllocationSize(Allocation allocation) const {
+	if(allocation.metadata == kNoSpace) {
+		return 0;
+	}
+	return m_Nodes[allocation.metadata].dataSize;
+}
+
+OffsetAllocator::StorageReport OffsetAllocator::GetStorageReport() const {
+	StorageReport report {};
+	report.totalFree = m_FreeStorage;
+	report.freeRegionCount = m_FreeRegionCount;
+	report.allocationCount = m_AllocationCount;
+
+	// Every region of the highest non empty bin is at least as large as any region below it, the exact largest is found in that bin
+	uint32_t topBin = HighestSetBit(m_UsedBinsTop);
+	if(topBin != s_NoBit) {
+		uint32_t leafBin = HighestSetBit(m_UsedBins[topBin]);
+		for(uint32_t nodeIndex = m_BinIndices[topBin * kBinsPerLeaf + leafBin]; nodeIndex != kUnused; nodeIndex = m_Nodes[nodeIndex].binListNext) {
+			if(m_Nodes[nodeIndex].dataSize > report.largestFreeRegion) {
+				report.largestFreeRegion = m_Nodes[nodeIndex].dataSize;
+			}
+		}
+	}
+	return report;
+}
+
+/// Bins and nodes
+uint32_t OffsetAllocator::InsertNodeIntoBin(uint32_t size, uint32_t dataOffset) {
+	uint32_t bin = SizeToBinRoundDown(size);
+	uint32_t topBin = bin / kBinsPerLeaf;
+	uint32_t leafBin = bin % kBinsPerLeaf;
+	if(m_BinIndices[bin] == kUnused) {
+		m_UsedBins[topBin] |= (uint8_t)(1u << leafBin);
+		m_UsedBinsTop |= 1u << topBin;
+	}
+
+	// New head of the bin's free list
+	uint32_t headIndex = m_BinIndices[bin];
+	uint32_t nodeIndex = NewNode();
+	Node& node = m_Nodes[nodeIndex];
+	node.dataOffset = dataOffset;
+	node.dataSize = size;
+	node.binListPrev = kUnused;
+	node.binListNext = headIndex;
+	node.neighborPrev = kUnused;
+	node.neighborNext = kUnused;
+	node.used = false;
+	if(headIndex != kUnused) {
+		m_Nodes[headIndex].binListPrev = nodeIndex;
+	}
+	m_BinIndices[bin] = nodeIndex;
+
+	m_FreeStorage += size;
+	m_FreeRegionCount++;
+	return nodeIndex;
+}
+
+void OffsetAllocator::RemoveNodeFromBin(uint32_t nodeIndex) {
+	const Node& node = m_Nodes[nodeIndex];
+	if(node.binListPrev != kUnused) {
+		m_Nodes[node.binListPrev].binListNext = node.binListNext;
+		if(node.binListNext != kUnused) {
+			m_Nodes[node.binListNext].binListPrev = node.binListPrev;
+		}
+	}
+	else {
+		// Head of its bin
+		uint32_t bin = SizeToBinRoundDown(node.dataSize);
+		uint32_t topBin = bin / kBinsPerLeaf;
+		uint32_t leafBin = bin % kBinsPerLeaf;
+		m_BinIndices[bin] = node.binListNext;
+		if(node.binListNext != kUnused) {
+			m_Nodes[node.binListNext].binListPrev = kUnused;
+		}
+		else {
+			m_UsedBins[topBin] &= (uint8_t)~(1u << leafBin);
+			if(m_UsedBins[topBin] == 0) {
+				m_UsedBinsTop &= ~(1u << topBin);
+			}
+		}
+	}
+
+	m_FreeStorage -= node.dataSize;
+	m_FreeRegionCount--;
+	ReleaseNode(nodeIndex);
+}
+
+uint32_t OffsetAllocator::NewNode() {
+	if(!m_FreeNodes.empty()) {
+		uint32_t nodeIndex = m_FreeNodes.back();
+		m_FreeNodes.pop_back();
+		return nodeIndex;
+	}
+	m_Nodes.push_back(Node {});
+	return (uint32_t)m_Nodes.size() - 1;
+}
+
+void OffsetAllocator::ReleaseNode(uint32_t nodeIndex) {
+	m_Nodes[nodeIndex].used = false;
+	m_FreeNodes.push_back(nodeIndex);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Two level segregated fit (TLSF) allocator over an abstract range of units, e.g. the vertices of a shared vertex buffer
+// Only offsets are handed out, the memory itself lives elsewhere (see GeometryArena)
+// Free regions are kept in 256 size bins spaced like a float with a 3 bit mantissa, found with two bit scans, so Allocate and Free are O(1)
+// Free merges a region with its free neighbours, fragmentation only comes from live allocations in between (see GetStorageReport)
+class OffsetAllocator {
+public:
+	static constexpr uint32_t kNoSpace = UINT32_MAX;
+
+	struct Allocation {
+		uint32_t offset = kNoSpace;
+		// Internal node index, needed by Free
+		uint32_t metadata = kNoSpace;
+	};
+
+	struct StorageReport {
+		uint32_t totalFree;
+		uint32_t largestFreeRegion;
+		uint32_t freeRegionCount;
+		uint32_t allocationCount;
+	};
+
+public:
+	OffsetAllocator() {}
+	OffsetAllocator(const OffsetAllocator&) = default;
+	~OffsetAllocator() {}
+
+	// Forgets every allocation, the whole [0, size) range is free again
+	void Reset(uint32_t size);
+
+	// offset is kNoSpace if there is no free region of at least size units (size 0 is treated as 1)
+	// Note: regions are found by size bin, a request up to 12.5% smaller than the largest free region can fail
+	Allocation Allocate(uint32_t size);
+	void Free(Allocation allocation);
+
+	uint32_t GetAllocationSize(Allocation allocation) const;
+	uint32_t GetSize() const { return m_Size; }
+	StorageReport GetStorageReport() const;
+
+	// 0 when all free space is one region, towards 1 as it is split into many small regions
+	static float GetFragmentation(const StorageReport& report) {
+		return report.totalFree > 0 ? 1.0f - (float)report.largestFreeRegion / report.totalFree : 0.0f;
+	}
+
+private:
+	static constexpr uint32_t kNumTopBins = 32;
+	static constexpr uint32_t kBinsPerLeaf = 8;
+	static constexpr uint32_t kNumLeafBins = kNumTopBins * kBinsPerLeaf;
+	static constexpr uint32_t kUnused = UINT32_MAX;
+
+	// Regions in address order are linked through neighborPrev/Next, free regions of a bin through binListPrev/Next
+	struct Node {
+		uint32_t dataOffset;
+		uint32_t dataSize;
+		uint32_t binListPrev;
+		uint32_t binListNext;
+		uint32_t neighborPrev;
+		uint32_t neighborNext;
+		bool used;
+	};
+
+	uint32_t InsertNodeIntoBin(uint32_t size, uint32_t dataOffset);
+	void RemoveNodeFromBin(uint32_t nodeIndex);
+	uint32_t NewNode();
+	void ReleaseNode(uint32_t nodeIndex);
+
+	// Size bin of a region (rounded down, every region in a bin is at least that large) or of a request (rounded up)
+	static uint32_t SizeToBinRoundDown(uint32_t size);
+	static uint32_t SizeToBinRoundUp(uint32_t size);
+	static uint32_t BinToSize(uint32_t bin);
+
+private:
+	uint32_t m_Size {};
+	uint32_t m_FreeStorage {};
+	uint32_t m_FreeRegionCount {};
+	uint32_t m_AllocationCount {};
+
+	uint32_t m_UsedBinsTop {};
+	uint8_t m_UsedBins[kNumTopBins] {};
+	uint32_t m_BinIndices[kNumLeafBins] {};
+
+	std::vector<Node> m_Nodes {};
+	std::vector<uint32_t> m_FreeNodes {};
+};
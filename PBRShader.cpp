@@ -15,22 +15,9 @@ bool PBRShader::Initialize(ID3D11Device* device, HWND hwnd) {
 
     HRESULT result {};
     ID3D10Blob* errorMessage {};
-    ID3D10Blob* vertexShaderBuffer {};
     ID3D10Blob* pixelShaderBuffer {};
     ID3D10Blob* domainShaderBuffer {};
 
-    // Compile vertex shader code
-    result = D3DCompileFromFile(vsFileName.c_str(), NULL, NULL, "PBRVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
-    if(FAILED(result)) {
-        if(errorMessage) {
-            OutputShaderErrorMessage(errorMessage, hwnd, vsFileName.c_str());
-        }
-        else {
-            MessageBox(hwnd, vsFileName.c_str(), L"Missing Shader File", MB_OK);
-        }
-        return false;
-    }
-
     // Compile pixel shader code
     result = D3DCompileFromFile(psFileName.c_str(), NULL, NULL, "PBRPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &pixelShaderBuffer, &errorMessage);
     if(FAILED(result)) {
@@ -55,10 +42,6 @@ bool PBRShader::Initialize(ID3D11Device* device, HWND hwnd) {
         return false;
     }
 
-    // Create vertex shader
-    result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_VertexShader);
-    if(FAILED(result)) return false;
-
     // Create pixel shader
     result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &m_PixelShader);
     if(FAILED(result)) return false;
@@ -67,7 +50,6 @@ bool PBRShader::Initialize(ID3D11Device* device, HWND hwnd) {
     result = device->CreateDomainShader(domainShaderBuffer->GetBufferPointer(), domainShaderBuffer->GetBufferSize(), NULL, &m_DomainShader);
     if(FAILED(result)) return false;
 
-    // Note: vertexShaderBuffer still needed for layout creation below
     pixelShaderBuffer->Release();
     pixelShaderBuffer = nullptr;
 
@@ -101,62 +83,11 @@ bool PBRShader::Initialize(ID3D11Device* device, HWND hwnd) {
         hullShaderBuffer = nullptr;
     }
 
-    // Create the vertex input layout description
-    // Needs to match the VertexType stucture in the Model class and in shader
-    D3D11_INPUT_ELEMENT_DESC polygonLayout[5] {};
-    polygonLayout[0].SemanticName = "POSITION";
-    polygonLayout[0].SemanticIndex = 0;
-    polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-    polygonLayout[0].InputSlot = 0;
-    polygonLayout[0].AlignedByteOffset = 0;
-    polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    polygonLayout[0].InstanceDataStepRate = 0;
-
-    polygonLayout[1].SemanticName = "TEXCOORD";
-    polygonLayout[1].SemanticIndex = 0;
-    polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
-    polygonLayout[1].InputSlot = 0;
-    polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-    polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    polygonLayout[1].InstanceDataStepRate = 0;
-
-    polygonLayout[2].SemanticName = "NORMAL";
-    polygonLayout[2].SemanticIndex = 0;
-    polygonLayout[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-    polygonLayout[2].InputSlot = 0;
-    polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-    polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    polygonLayout[2].InstanceDataStepRate = 0;
-
-    polygonLayout[3].SemanticName = "TANGENT";
-    polygonLayout[3].SemanticIndex = 0;
-    polygonLayout[3].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-    polygonLayout[3].InputSlot = 0;
-    polygonLayout[3].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-    polygonLayout[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    polygonLayout[3].InstanceDataStepRate = 0;
-
-    polygonLayout[4].SemanticName = "BINORMAL";
-    polygonLayout[4].SemanticIndex = 0;
-    polygonLayout[4].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-    polygonLayout[4].InputSlot = 0;
-    polygonLayout[4].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-    polygonLayout[4].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-    polygonLayout[4].InstanceDataStepRate = 0;
-
-    unsigned int numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
-    result =
-        device->CreateInputLayout(
-            polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &m_Layout
-        );
-
-    if(FAILED(result)) {
+    // Initialize vertex shader and input layout for every vertex format
+    if(!InitializeVertexShaders(device, vsFileName, hwnd)) {
         return false;
     }
 
-    vertexShaderBuffer->Release();
-    vertexShaderBuffer = nullptr;
-
     /// Create the texture sampler states
     D3D11_SAMPLER_DESC samplerDesc {};
     samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
@@ -307,6 +238,56 @@ bool PBRShader::Initialize(ID3D11Device* device, HWND hwnd) {
     return true;
 }
 
+bool PBRShader::InitializeVertexShaders(ID3D11Device* device, const std::wstring& vsFileName, HWND hwnd) {
+    // Input layouts need to match MeshVertex and PackedMeshVertex (see MeshData.h) and VertexInputType in PBR.vs
+    // Tangent frame comes from the tangent stream in slot 1 (see VertexStream)
+    const D3D11_INPUT_ELEMENT_DESC fullLayout[5] {
+        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,                            D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TANGENT",  0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0,                            D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"BINORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+    };
+
+    const D3D11_INPUT_ELEMENT_DESC packedLayout[4] {
+        {"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0,                            D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"NORMAL",   0, DXGI_FORMAT_R16G16_SNORM,       0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        {"TANGENT",  0, DXGI_FORMAT_R8G8B8A8_SNORM,     1, 0,                            D3D11_INPUT_PER_VERTEX_DATA, 0},
+    };
+
+    HRESULT result {};
+    ID3D10Blob* errorMessage {};
+    D3D_SHADER_MACRO packedMacros[2] {{"PACKED_VERTEX", "1"}, {NULL, NULL}};
+    for(int i = 0; i < Num_VertexFormats; i++) {
+        ID3D10Blob* vertexShaderBuffer {};
+        const D3D_SHADER_MACRO* macros = i == kPackedVertexFormat ? packedMacros : NULL;
+
+        result = D3DCompileFromFile(vsFileName.c_str(), macros, NULL, "PBRVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
+        if(FAILED(result)) {
+            if(errorMessage) {
+                OutputShaderErrorMessage(errorMessage, hwnd, vsFileName.c_str());
+            }
+            else {
+                MessageBox(hwnd, vsFileName.c_str(), L"Missing Shader File", MB_OK);
+            }
+            return false;
+        }
+
+        result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_VertexShaders[i]);
+        if(FAILED(result)) return false;
+
+        const D3D11_INPUT_ELEMENT_DESC* layout = i == kPackedVertexFormat ? packedLayout : fullLayout;
+        unsigned int numElements = i == kPackedVertexFormat ? 4 : 5;
+        result = device->CreateInputLayout(layout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &m_Layouts[i]);
+        if(FAILED(result)) return false;
+
+        vertexShaderBuffer->Release();
+        vertexShaderBuffer = nullptr;
+    }
+    return true;
+}
+
 bool PBRShader::InitializeHullShaders(ID3D11Device* device, const std::wstring& hsFileName, HWND hwnd) {
     HRESULT result {};
     ID3D10Blob* errorMessage {};
@@ -338,7 +319,7 @@ bool PBRShader::InitializeHullShaders(ID3D11Device* device, const std::wstring&
     return true;
 }
 
-bool PBRShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, XMMATRIX worldMatrix, XMMATRIX projectionMatrix, const std::vector<Texture*> materialTextures, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, const std::array<XMFLOAT4, 6>& cullFrustum, float time, const GameObject::GameObjectData& gameObjectData) {
+bool PBRShader::Render(ID3D11DeviceContext* deviceContext, const std::vector<MeshletCuller::DrawRange>& drawRanges, uint32_t startIndexLocation, int baseVertexLocation, VertexFormat vertexFormat, XMMATRIX worldMatrix, XMMATRIX projectionMatrix, const std::vector<Texture*> materialTextures, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, const std::array<XMFLOAT4, 6>& cullFrustum, float time, const GameObject::GameObjectData& gameObjectData) {
     HRESULT result;
     //LightPositionBufferType* dataPtr2;
     //LightColorBufferType* dataPtr3;
@@ -424,24 +405,24 @@ bool PBRShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, XMMAT
     //deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_lightPositionBuffer);
 
     /// Bind Pixel Shader textures
-    /// Order of materialTextures array: albedoMap, normalMap, metallicMap, roughnessMap, aoMap, heightMap
+    /// Order of materialTextures array: albedoMap, normalMap, packedMap (ao, roughness, metallic, height)
     ID3D11ShaderResourceView* pTempSRV;
-    for(int i = 0; i < 6; i++) {
+    for(int i = 0; i < 3; i++) {
         pTempSRV = materialTextures[i]->GetTextureSRV();
         deviceContext->PSSetShaderResources(i, 1, &pTempSRV);
     }
 
     // for indirect lighting
-    deviceContext->PSSetShaderResources(6, 1, &shadowMap);
+    deviceContext->PSSetShaderResources(3, 1, &shadowMap);
     ID3D11ShaderResourceView* pIrradianceMap = skybox->GetIrradianceMapSRV();
     ID3D11ShaderResourceView* pPrefilteredMap = skybox->GetPrefilteredMapSRV();
     ID3D11ShaderResourceView* pBRDFLut = skybox->GetPrecomputedBRDFSRV();
-    deviceContext->PSSetShaderResources(7, 1, &pIrradianceMap);
-    deviceContext->PSSetShaderResources(8, 1, &pPrefilteredMap);
-    deviceContext->PSSetShaderResources(9, 1, &pBRDFLut);
+    deviceContext->PSSetShaderResources(4, 1, &pIrradianceMap);
+    deviceContext->PSSetShaderResources(5, 1, &pPrefilteredMap);
+    deviceContext->PSSetShaderResources(6, 1, &pBRDFLut);
 
     /// Bind Domain Shader Textures
-    pTempSRV = materialTextures[5]->GetTextureSRV(); // height map
+    pTempSRV = materialTextures[2]->GetTextureSRV(); // packed map, height in a
     deviceContext->DSSetShaderResources(0, 1, &pTempSRV);
 
     /// Pixel Shader Light cbuffer
@@ -539,9 +520,9 @@ bool PBRShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, XMMAT
     //deviceContext->PSSetConstantBuffers(bufferNumber, 1, &m_lightColorBuffer);
 
     /// Render
-    deviceContext->IASetInputLayout(m_Layout);
+    deviceContext->IASetInputLayout(m_Layouts[vertexFormat]);
 
-    deviceContext->VSSetShader(m_VertexShader, NULL, 0);
+    deviceContext->VSSetShader(m_VertexShaders[vertexFormat], NULL, 0);
     deviceContext->HSSetShader(m_HullShaders[gameObjectData.tessellationMode], NULL, 0);
     deviceContext->DSSetShader(m_DomainShader, NULL, 0);
     deviceContext->PSSetShader(m_PixelShader, NULL, 0);
@@ -552,7 +533,10 @@ bool PBRShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, XMMAT
 
     deviceContext->DSSetSamplers(0, 1, &m_SampleStateWrap);
 
-    deviceContext->DrawIndexed(indexCount, 0, 0);
+    // Index ranges of the meshlets that survived culling, relative to the mesh's range in the shared buffers (see GeometryArena)
+    for(const MeshletCuller::DrawRange& drawRange : drawRanges) {
+        deviceContext->DrawIndexed(drawRange.indexCount, startIndexLocation + drawRange.firstIndex, baseVertexLocation);
+    }
 
     return true;
 }
@@ -608,9 +592,11 @@ void PBRShader::Shutdown() {
         m_SampleStateClamp = nullptr;
     }
 
-    if(m_Layout) {
-        m_Layout->Release();
-        m_Layout = nullptr;
+    for(int i = 0; i < m_Layouts.size(); i++) {
+        if(m_Layouts[i]) {
+            m_Layouts[i]->Release();
+            m_Layouts[i] = nullptr;
+        }
     }
 
     if(m_PixelShader) {
@@ -618,9 +604,11 @@ void PBRShader::Shutdown() {
         m_PixelShader = nullptr;
     }
 
-    if(m_VertexShader) {
-        m_VertexShader->Release();
-        m_VertexShader = nullptr;
+    for(int i = 0; i < m_VertexShaders.size(); i++) {
+        if(m_VertexShaders[i]) {
+            m_VertexShaders[i]->Release();
+            m_VertexShaders[i] = nullptr;
+        }
     }
 
     for(int i = 0; i < m_HullShaders.size(); i++) {
@@ -1,5 +1,6 @@
 #pragma once
 #include "GameObject.h"
+#include "MeshData.h"
 
 #include <d3d11.h>
 #include <directxmath.h>
@@ -86,19 +87,21 @@ public:
 
     bool Initialize(ID3D11Device*, HWND);
     void Shutdown();
-    bool Render(ID3D11DeviceContext* deviceContext, int indexCount, XMMATRIX worldMatrix, XMMATRIX projectionMatrix, const std::vector<Texture*> materialTextures, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, const std::array<XMFLOAT4, 6>& cullFrustum, float time, const GameObject::GameObjectData& gameObjectData);
+    bool Render(ID3D11DeviceContext* deviceContext, const std::vector<MeshletCuller::DrawRange>& drawRanges, uint32_t startIndexLocation, int baseVertexLocation, VertexFormat vertexFormat, XMMATRIX worldMatrix, XMMATRIX projectionMatrix, const std::vector<Texture*> materialTextures, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, const std::array<XMFLOAT4, 6>& cullFrustum, float time, const GameObject::GameObjectData& gameObjectData);
 
 private:
+    bool InitializeVertexShaders(ID3D11Device* device, const std::wstring& vsFileName, HWND hwnd);
     bool InitializeHullShaders(ID3D11Device* device, const std::wstring& hsFileName, HWND hwnd);
 
 private:
-    ID3D11VertexShader* m_VertexShader {};
+    // Indexed by VertexFormat enum
+    std::array<ID3D11VertexShader*, Num_VertexFormats> m_VertexShaders {};
     ID3D11PixelShader*  m_PixelShader {};
     ID3D11DomainShader* m_DomainShader {};
     // Indexed by TesselationModes enum
     std::array<ID3D11HullShader*, TessellationMode::Num_TessellationModes> m_HullShaders {};
 
-    ID3D11InputLayout*  m_Layout {};
+    std::array<ID3D11InputLayout*, Num_VertexFormats> m_Layouts {};
     ID3D11SamplerState* m_SampleStateWrap {};
     ID3D11SamplerState* m_SampleStateBorder {};
     ID3D11SamplerState* m_SampleStateClamp {};
@@ -0,0 +1,310 @@
+#include "PrimitiveGenerator.h"
+#include "TangentGenerator.h"
+
+#include <charconv>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+	constexpr float s_Pi = 3.14159265358979f;
+
+	// Defaults for names without parameters, the plane is 10 x 10 with 25 x 25 cells like the original demo plane model
+	constexpr uint32_t s_DefaultSphereSegments = 64;
+	constexpr uint32_t s_DefaultSphereRings = 32;
+	constexpr uint32_t s_DefaultIcosphereSubdivisions = 4;
+	constexpr uint32_t s_DefaultPlaneSegments = 25;
+	constexpr float s_DefaultPlaneSize = 10.0f;
+	constexpr uint32_t s_DefaultCubeSegments = 1;
+
+	// Keeps every generated mesh below 2^32 vertices and indices
+	constexpr uint32_t s_MaxSegments = 8192;
+	constexpr uint32_t s_MaxIcosphereSubdivisions = 10;
+
+	// Parses "<a>" or "<a>x<b>" into values, count is the number of values expected
+	bool ParseParameters(const char* begin, const char* end, uint32_t* values, int count) {
+		for(int i = 0; i < count; i++) {
+			std::from_chars_result result = std::from_chars(begin, end, values[i]);
+			if(result.ec != std::errc()) {
+				return false;
+			}
+			begin = result.ptr;
+			if(i + 1 < count) {
+				if(begin == end || *begin != 'x') {
+					return false;
+				}
+				begin++;
+			}
+		}
+		return begin == end;
+	}
+
+	// Spherical uv of a point on the unit sphere, same mapping as GenerateUVSphere
+	XMFLOAT2 GetSphericalUV(const XMFLOAT3& position) {
+		float u = std::atan2(position.z, position.x) / (2.0f * s_Pi);
+		if(u < 0.0f) {
+			u += 1.0f;
+		}
+		float v = std::acos(std::fmax(-1.0f, std::fmin(1.0f, position.y))) / s_Pi;
+		return XMFLOAT2(u, v);
+	}
+
+	// Grid of (xSegments + 1) x (ySegments + 1) vertices on center + right * [-1, 1] + up * [-1, 1], first row at +up
+	void AppendGrid(MeshData& meshData, XMFLOAT3 center, XMFLOAT3 right, XMFLOAT3 up, XMFLOAT3 normal, uint32_t xSegments, uint32_t ySegments) {
+		uint32_t firstVertex = (uint32_t)meshData.vertices.size();
+		for(uint32_t row = 0; row <= ySegments; row++) {
+			float v = (float)row / ySegments;
+			for(uint32_t column = 0; column <= xSegments; column++) {
+				float u = (float)column / xSegments;
+				float x = u * 2.0f - 1.0f;
+				float y = 1.0f - v * 2.0f;
+
+				MeshVertex vertex {};
+				vertex.position = XMFLOAT3(center.x + right.x * x + up.x * y, center.y + right.y * x + up.y * y, center.z + right.z * x + up.z * y);
+				vertex.texture = XMFLOAT2(u, v);
+				vertex.normal = normal;
+				meshData.vertices.push_back(vertex);
+			}
+		}
+
+		uint32_t rowStride = xSegments + 1;
+		for(uint32_t row = 0; row < ySegments; row++) {
+			for(uint32_t column = 0; column < xSegments; column++) {
+				uint32_t topLeft = firstVertex + row * rowStride + column;
+				const uint32_t corners[4] {topLeft, topLeft + 1, topLeft + rowStride, topLeft + rowStride + 1};
+				for(uint32_t corner : {0, 1, 2, 2, 1, 3}) {
+					meshData.indices.push_back(corners[corner]);
+				}
+			}
+		}
+	}
+}
+
+bool PrimitiveGenerator::IsPrimitiveName(const std::string& name) {
+	std::string type = name.substr(0, name.find(':'));
+	return type == "sphere" || type == "icosphere" || type == "plane" || type == "cube";
+}
+
+bool PrimitiveGenerator::GenerateFromName(const std::string& name, MeshData& meshData) {
+	size_t separator = name.find(':');
+	std::string type = name.substr(0, separator);
+	const char* parametersBegin = separator == std::string::npos ? nullptr : name.c_str() + separator + 1;
+	const char* parametersEnd = name.c_str() + name.size();
+
+	uint32_t parameters[2] {};
+	if(type == "sphere" || type == "plane") {
+		if(!parametersBegin) {
+			parameters[0] = type == "sphere" ? s_DefaultSphereSegments : s_DefaultPlaneSegments;
+			parameters[1] = type == "sphere" ? s_DefaultSphereRings : s_DefaultPlaneSegments;
+		}
+		else if(!ParseParameters(parametersBegin, parametersEnd, parameters, 2)) {
+			return false;
+		}
+
+		// A sphere needs at least 3 segments and 2 rings to enclose any volume
+		uint32_t minSegments = type == "sphere" ? 3 : 1;
+		uint32_t minRings = type == "sphere" ? 2 : 1;
+		if(parameters[0] < minSegments || parameters[1] < minRings || parameters[0] > s_MaxSegments || parameters[1] > s_MaxSegments) {
+			return false;
+		}
+
+		if(type == "sphere") {
+			GenerateUVSphere(parameters[0], parameters[1], meshData);
+		}
+		else {
+			GeneratePlane(s_DefaultPlaneSize, s_DefaultPlaneSize, parameters[0], parameters[1], meshData);
+		}
+		return true;
+	}
+
+	if(type == "icosphere" || type == "cube") {
+		if(!parametersBegin) {
+			parameters[0] = type == "icosphere" ? s_DefaultIcosphereSubdivisions : s_DefaultCubeSegments;
+		}
+		else if(!ParseParameters(parametersBegin, parametersEnd, parameters, 1)) {
+			return false;
+		}
+
+		if(type == "icosphere") {
+			if(parameters[0] > s_MaxIcosphereSubdivisions) {
+				return false;
+			}
+			GenerateIcosphere(parameters[0], meshData);
+		}
+		else {
+			if(parameters[0] < 1 || parameters[0] > s_MaxSegments) {
+				return false;
+			}
+			GenerateCube(parameters[0], meshData);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+void PrimitiveGenerator::GenerateUVSphere(uint32_t segments, uint32_t rings, MeshData& meshData) {
+	meshData = MeshData {};
+	meshData.vertices.reserve((size_t)(segments + 1) * (rings + 1));
+	meshData.indices.reserve((size_t)segments * (rings - 1) * 6);
+
+	// Note: the seam column and the pole rows are duplicated so every vertex gets its own uv
+	for(uint32_t ring = 0; ring <= rings; ring++) {
+		float v = (float)ring / rings;
+		float polar = v * s_Pi;
+		for(uint32_t segment = 0; segment <= segments; segment++) {
+			float u = (float)segment / segments;
+			float azimuth = u * 2.0f * s_Pi;
+
+			MeshVertex vertex {};
+			vertex.normal = XMFLOAT3(std::sin(polar) * std::cos(azimuth), std::cos(polar), std::sin(polar) * std::sin(azimuth));
+			vertex.position = vertex.normal;
+			vertex.texture = XMFLOAT2(u, v);
+			meshData.vertices.push_back(vertex);
+		}
+	}
+
+	// Cells touching a pole collapse to one triangle
+	uint32_t rowStride = segments + 1;
+	for(uint32_t ring = 0; ring < rings; ring++) {
+		for(uint32_t segment = 0; segment < segments; segment++) {
+			uint32_t topLeft = ring * rowStride + segment;
+			const uint32_t corners[4] {topLeft, topLeft + 1, topLeft + rowStride, topLeft + rowStride + 1};
+			if(ring > 0) {
+				meshData.indices.insert(meshData.indices.end(), {corners[0], corners[1], corners[2]});
+			}
+			if(ring + 1 < rings) {
+				meshData.indices.insert(meshData.indices.end(), {corners[2], corners[1], corners[3]});
+			}
+		}
+	}
+
+	TangentGenerator::GenerateTangents(meshData);
+}
+
+void PrimitiveGenerator::GenerateIcosphere(uint32_t subdivisions, MeshData& meshData) {
+	meshData = MeshData {};
+
+	/// Icosahedron
+	// Vertices on three orthogonal golden rectangles
+	const float golden = (1.0f + std::sqrt(5.0f)) * 0.5f;
+	std::vector<XMFLOAT3> positions {
+		{-1.0f, golden, 0.0f}, {1.0f, golden, 0.0f}, {-1.0f, -golden, 0.0f}, {1.0f, -golden, 0.0f},
+		{0.0f, -1.0f, golden}, {0.0f, 1.0f, golden}, {0.0f, -1.0f, -golden}, {0.0f, 1.0f, -golden},
+		{golden, 0.0f, -1.0f}, {golden, 0.0f, 1.0f}, {-golden, 0.0f, -1.0f}, {-golden, 0.0f, 1.0f},
+	};
+	std::vector<uint32_t> triangles {
+		0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+		1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+		3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+		4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1,
+	};
+	for(XMFLOAT3& position : positions) {
+		XMStoreFloat3(&position, XMVector3Normalize(XMLoadFloat3(&position)));
+	}
+
+	// Clockwise seen from outside, i.e. cross(edge1, edge2) points away from the center
+	for(size_t i = 0; i < triangles.size(); i += 3) {
+		XMVECTOR vertex0 = XMLoadFloat3(&positions[triangles[i]]);
+		XMVECTOR faceNormal = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&positions[triangles[i + 1]]), vertex0), XMVectorSubtract(XMLoadFloat3(&positions[triangles[i + 2]]), vertex0));
+		if(XMVectorGetX(XMVector3Dot(faceNormal, vertex0)) < 0.0f) {
+			std::swap(triangles[i + 1], triangles[i + 2]);
+		}
+	}
+
+	/// Subdivide, each edge midpoint is shared by the two triangles on the edge
+	for(uint32_t level = 0; level < subdivisions; level++) {
+		std::unordered_map<uint64_t, uint32_t> midpoints {};
+		midpoints.reserve(triangles.size() / 2);
+		auto GetMidpoint = [&](uint32_t a, uint32_t b) {
+			uint64_t key = a < b ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+			auto [it, b_Inserted] = midpoints.emplace(key, (uint32_t)positions.size());
+			if(b_Inserted) {
+				XMFLOAT3 midpoint {};
+				XMStoreFloat3(&midpoint, XMVector3Normalize(XMVectorAdd(XMLoadFloat3(&positions[a]), XMLoadFloat3(&positions[b]))));
+				positions.push_back(midpoint);
+			}
+			return it->second;
+		};
+
+		std::vector<uint32_t> subdivided {};
+		subdivided.reserve(triangles.size() * 4);
+		for(size_t i = 0; i < triangles.size(); i += 3) {
+			uint32_t a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+			uint32_t ab = GetMidpoint(a, b), bc = GetMidpoint(b, c), ca = GetMidpoint(c, a);
+			subdivided.insert(subdivided.end(), {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca});
+		}
+		triangles.swap(subdivided);
+	}
+
+	/// Vertices with spherical uvs
+	meshData.vertices.resize(positions.size());
+	for(size_t i = 0; i < positions.size(); i++) {
+		meshData.vertices[i].position = positions[i];
+		meshData.vertices[i].normal = positions[i];
+		meshData.vertices[i].texture = GetSphericalUV(positions[i]);
+	}
+
+	// Triangles crossing the u seam get copies of their low u corners with u + 1, so the uvs do not wrap back across the texture
+	// Pole corners take the u of the triangle's other corners, a pole has no u of its own
+	std::unordered_map<uint32_t, uint32_t> seamCopies {};
+	meshData.indices = triangles;
+	for(size_t i = 0; i < meshData.indices.size(); i += 3) {
+		uint32_t* corners = meshData.indices.data() + i;
+		float cornerU[3] {};
+		bool b_IsPole[3] {};
+		float minU = 1.0f, maxU = 0.0f;
+		for(int corner = 0; corner < 3; corner++) {
+			const MeshVertex& vertex = meshData.vertices[corners[corner]];
+			cornerU[corner] = vertex.texture.x;
+			b_IsPole[corner] = std::fabs(vertex.position.y) > 0.99999f;
+			if(!b_IsPole[corner]) {
+				minU = std::fmin(minU, cornerU[corner]);
+				maxU = std::fmax(maxU, cornerU[corner]);
+			}
+		}
+		bool b_CrossesSeam = maxU - minU > 0.5f;
+
+		for(int corner = 0; corner < 3; corner++) {
+			if(b_IsPole[corner]) {
+				// Midpoint of the other two corners' u, a new vertex per triangle
+				float u = 0.0f;
+				for(int other = 0; other < 3; other++) {
+					if(other != corner) {
+						u += (b_CrossesSeam && cornerU[other] < 0.5f ? cornerU[other] + 1.0f : cornerU[other]) * 0.5f;
+					}
+				}
+				MeshVertex poleVertex = meshData.vertices[corners[corner]];
+				poleVertex.texture.x = u;
+				corners[corner] = (uint32_t)meshData.vertices.size();
+				meshData.vertices.push_back(poleVertex);
+			}
+			else if(b_CrossesSeam && cornerU[corner] < 0.5f) {
+				auto [it, b_Inserted] = seamCopies.emplace(corners[corner], (uint32_t)meshData.vertices.size());
+				if(b_Inserted) {
+					MeshVertex seamVertex = meshData.vertices[corners[corner]];
+					seamVertex.texture.x += 1.0f;
+					meshData.vertices.push_back(seamVertex);
+				}
+				corners[corner] = it->second;
+			}
+		}
+	}
+
+	TangentGenerator::GenerateTangents(meshData);
+}
+
+void PrimitiveGenerator::GeneratePlane(float width, float depth, uint32_t xSegments, uint32_t zSegments, MeshData& meshData) {
+	meshData = MeshData {};
+	// Same orientation as the cube's +y face
+	AppendGrid(meshData, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(width * 0.5f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, depth * 0.5f), XMFLOAT3(0.0f, 1.0f, 0.0f), xSegments, zSegments);
+	TangentGenerator::GenerateTangents(meshData);
+}
+
+void PrimitiveGenerator::GenerateCube(uint32_t segments, MeshData& meshData) {
+	meshData = MeshData {};
+	for(const CubeFace& face : kCubeFaces) {
+		XMFLOAT3 normal(face.normal[0], face.normal[1], face.normal[2]);
+		AppendGrid(meshData, normal, XMFLOAT3(face.right[0], face.right[1], face.right[2]), XMFLOAT3(face.up[0], face.up[1], face.up[2]), normal, segments, segments);
+	}
+	TangentGenerator::GenerateTangents(meshData);
+}
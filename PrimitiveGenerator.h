@@ -0,0 +1,97 @@
+#pragma once
+#include "MeshData.h"
+
+#include <array>
+#include <string>
+
+// Parametric meshes built in memory instead of loaded from disk, wound for the engine's left handed, clockwise front face convention
+// Mesh generators output indexed geometry with normals, uvs and tangent frames (see TangentGenerator), ready for the Model cook pipeline
+class PrimitiveGenerator {
+public:
+	// Position and uv only, same layout as the vertex types of Skybox and QuadModel
+	struct SimpleVertex {
+		float position[3];
+		float texture[2];
+	};
+
+	template<size_t VertexCount, size_t IndexCount>
+	struct SimpleMesh {
+		std::array<SimpleVertex, VertexCount> vertices;
+		std::array<uint32_t, IndexCount> indices;
+	};
+
+	// Primitive names accepted by GenerateFromName, parameters after the colon are optional
+	//   "sphere:<segments>x<rings>", "icosphere:<subdivisions>", "plane:<xSegments>x<zSegments>", "cube:<segments per edge>"
+	static bool IsPrimitiveName(const std::string& name);
+	// False if name is not a primitive name or its parameters are out of range
+	static bool GenerateFromName(const std::string& name, MeshData& meshData);
+
+	// Radius 1, poles on the y axis, u wraps around y and v runs from the top pole (0) to the bottom pole (1)
+	static void GenerateUVSphere(uint32_t segments, uint32_t rings, MeshData& meshData);
+	// Radius 1, every subdivision splits each of the icosahedron's 20 triangles into 4, uvs are spherical like GenerateUVSphere
+	static void GenerateIcosphere(uint32_t subdivisions, MeshData& meshData);
+	// width x depth in the xz plane facing +y, centered on the origin, uv [0, 1] over the whole plane
+	static void GeneratePlane(float width, float depth, uint32_t xSegments, uint32_t zSegments, MeshData& meshData);
+	// [-1, 1] cube, each face is a segments x segments grid with its own uv [0, 1]
+	static void GenerateCube(uint32_t segments, MeshData& meshData);
+
+	/// Compile time primitives for tiny fixed meshes
+	// [-1, 1] cube with outward faces, 4 vertices per face
+	static constexpr SimpleMesh<24, 36> MakeUnitCube();
+	// Quad in the xy plane facing -z (towards a camera looking down +z), uv (0, 0) at the top left
+	static constexpr SimpleMesh<4, 6> MakeQuad(float halfWidth, float halfHeight);
+
+private:
+	// Outward normal, then the directions of increasing u and of decreasing v, picked so that cross(right, up) = -normal (clockwise seen from outside)
+	struct CubeFace {
+		float normal[3];
+		float right[3];
+		float up[3];
+	};
+
+	static constexpr std::array<CubeFace, 6> kCubeFaces {{
+		{{ 0.0f,  0.0f, -1.0f}, { 1.0f, 0.0f,  0.0f}, {0.0f, 1.0f,  0.0f}},
+		{{ 1.0f,  0.0f,  0.0f}, { 0.0f, 0.0f,  1.0f}, {0.0f, 1.0f,  0.0f}},
+		{{ 0.0f,  0.0f,  1.0f}, {-1.0f, 0.0f,  0.0f}, {0.0f, 1.0f,  0.0f}},
+		{{-1.0f,  0.0f,  0.0f}, { 0.0f, 0.0f, -1.0f}, {0.0f, 1.0f,  0.0f}},
+		{{ 0.0f,  1.0f,  0.0f}, { 1.0f, 0.0f,  0.0f}, {0.0f, 0.0f,  1.0f}},
+		{{ 0.0f, -1.0f,  0.0f}, { 1.0f, 0.0f,  0.0f}, {0.0f, 0.0f, -1.0f}},
+	}};
+
+	// Two clockwise triangles of a grid cell, corners in reading order (top left, top right, bottom left, bottom right)
+	static constexpr std::array<uint32_t, 6> kQuadCorners {0, 1, 2, 2, 1, 3};
+};
+
+constexpr PrimitiveGenerator::SimpleMesh<24, 36> PrimitiveGenerator::MakeUnitCube() {
+	SimpleMesh<24, 36> mesh {};
+	for(uint32_t face = 0; face < 6; face++) {
+		const CubeFace& cubeFace = kCubeFaces[face];
+		for(uint32_t corner = 0; corner < 4; corner++) {
+			float x = (corner & 1) ? 1.0f : -1.0f;
+			float y = (corner & 2) ? -1.0f : 1.0f;
+			SimpleVertex& vertex = mesh.vertices[face * 4 + corner];
+			for(int axis = 0; axis < 3; axis++) {
+				vertex.position[axis] = cubeFace.normal[axis] + cubeFace.right[axis] * x + cubeFace.up[axis] * y;
+			}
+			vertex.texture[0] = (x + 1.0f) * 0.5f;
+			vertex.texture[1] = (1.0f - y) * 0.5f;
+		}
+		for(uint32_t i = 0; i < 6; i++) {
+			mesh.indices[face * 6 + i] = face * 4 + kQuadCorners[i];
+		}
+	}
+	return mesh;
+}
+
+constexpr PrimitiveGenerator::SimpleMesh<4, 6> PrimitiveGenerator::MakeQuad(float halfWidth, float halfHeight) {
+	SimpleMesh<4, 6> mesh {};
+	for(uint32_t corner = 0; corner < 4; corner++) {
+		float u = (corner & 1) ? 1.0f : 0.0f;
+		float v = (corner & 2) ? 1.0f : 0.0f;
+		mesh.vertices[corner] = SimpleVertex {{(u * 2.0f - 1.0f) * halfWidth, (1.0f - v * 2.0f) * halfHeight, 0.0f}, {u, v}};
+	}
+	for(uint32_t i = 0; i < 6; i++) {
+		mesh.indices[i] = kQuadCorners[i];
+	}
+	return mesh;
+}
@@ -1,39 +1,16 @@
 #include "QuadModel.h"
 #include "D3DInstance.h"
+#include "PrimitiveGenerator.h"
 
 bool QuadModel::Initialize(ID3D11Device* device, float width, float height) {
     HRESULT result;
 
-    m_VertexCount = 6;
-    m_IndexCount = m_VertexCount;
+    // width and height are half extents, the quad is centered on the origin
+    PrimitiveGenerator::SimpleMesh<4, 6> quad = PrimitiveGenerator::MakeQuad(width, height);
+    static_assert(sizeof(VertexType) == sizeof(PrimitiveGenerator::SimpleVertex), "QuadModel vertex layout must match PrimitiveGenerator::SimpleVertex");
 
-    VertexType* vertices = new VertexType[m_VertexCount];
-    unsigned long* indices = new unsigned long[m_IndexCount];
-
-    // First triangle
-    vertices[0].position = XMFLOAT3(-width, height, 0.0f);  // Top left.
-    vertices[0].texture = XMFLOAT2(0.0f, 0.0f);
-
-    vertices[1].position = XMFLOAT3(width, -height, 0.0f);  // Bottom right.
-    vertices[1].texture = XMFLOAT2(1.0f, 1.0f);
-
-    vertices[2].position = XMFLOAT3(-width, -height, 0.0f);  // Bottom left.
-    vertices[2].texture = XMFLOAT2(0.0f, 1.0f);
-
-    // Second triangle
-    vertices[3].position = XMFLOAT3(-width, height, 0.0f);  // Top left.
-    vertices[3].texture = XMFLOAT2(0.0f, 0.0f);
-
-    vertices[4].position = XMFLOAT3(width, height, 0.0f);  // Top right.
-    vertices[4].texture = XMFLOAT2(1.0f, 0.0f);
-
-    vertices[5].position = XMFLOAT3(width, -height, 0.0f);  // Bottom right.
-    vertices[5].texture = XMFLOAT2(1.0f, 1.0f);
-
-    // Load the index array with data.
-    for(int i = 0; i < m_IndexCount; i++) {
-        indices[i] = i;
-    }
+    m_VertexCount = (int)quad.vertices.size();
+    m_IndexCount = (int)quad.indices.size();
 
     // Set up the description of the vertex buffer.
     D3D11_BUFFER_DESC vertexBufferDesc {};
@@ -46,7 +23,7 @@ bool QuadModel::Initialize(ID3D11Device* device, float width, float height) {
 
     // Give the subresource structure a pointer to the vertex data.
     D3D11_SUBRESOURCE_DATA vertexData {};
-    vertexData.pSysMem = vertices;
+    vertexData.pSysMem = quad.vertices.data();
     vertexData.SysMemPitch = 0;
     vertexData.SysMemSlicePitch = 0;
 
@@ -59,7 +36,7 @@ bool QuadModel::Initialize(ID3D11Device* device, float width, float height) {
     // Set up the description of the index buffer.
     D3D11_BUFFER_DESC indexBufferDesc {};
     indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDesc.ByteWidth = sizeof(unsigned long) * m_IndexCount;
+    indexBufferDesc.ByteWidth = sizeof(uint32_t) * m_IndexCount;
     indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
     indexBufferDesc.CPUAccessFlags = 0;
     indexBufferDesc.MiscFlags = 0;
@@ -67,7 +44,7 @@ bool QuadModel::Initialize(ID3D11Device* device, float width, float height) {
 
     // Give the subresource structure a pointer to the index data.
     D3D11_SUBRESOURCE_DATA indexData {};
-    indexData.pSysMem = indices;
+    indexData.pSysMem = quad.indices.data();
     indexData.SysMemPitch = 0;
     indexData.SysMemSlicePitch = 0;
 
@@ -77,13 +54,6 @@ bool QuadModel::Initialize(ID3D11Device* device, float width, float height) {
         return false;
     }
 
-    // Release the arrays now that the vertex and index buffers have been created and loaded.
-    delete[] vertices;
-    vertices = nullptr;
-
-    delete[] indices;
-    indices = nullptr;
-
     return true;
 }
 
@@ -3,10 +3,15 @@
 #include "Application.h"
 #include "Texture.h"
 #include "Model.h"
+#include "PrimitiveGenerator.h"
 #include "D3DInstance.h"
 #include "PBRShader.h"
 #include "DepthShader.h"
 #include "GameObject.h"
+#include "StaticBatcher.h"
+#include "GeometryArena.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
 #include "SkyBox.h"
 #include "RenderTexture.h"
 #include "TextureShader.h"
@@ -15,10 +20,13 @@
 #include "Camera.h"
 #include "Bloom.h"
 #include "Input.h"
+#include "Benchmarks.h"
 
 #include "imgui_impl_dx11.h"
 
 #include <iostream>
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <future>
 #include <string_view>
@@ -28,13 +36,18 @@
 #define USE_MULTITHREAD_INITIALIZE 1
 
 namespace {
-	std::mutex s_DeviceContextMutex {};
+	// Benchmarks::Benchmark flags to run at startup, before the scene loads anything (e.g. Benchmarks::kMeshPick | Benchmarks::kTextureUpload)
+	constexpr uint32_t s_Benchmarks = 0;
 
 	// Resource names (included in demo build) - used for IMGUI, could be built programmatically from files
 	const std::vector<std::string> s_PBRMaterialFileNames {"bog", "brick", "dented", "dirt", "marble", "metal_grid", "rust", "stonewall", "waterworn", "windswept", "oak", "mud", "asphalt", "blocks"};
-	const std::vector<std::string> s_ModelFileNames {"cube", "plane", "sphere"};
+	// "sphere.txt" is the old rastertek sphere, it goes through the text parser and the mesh cache instead of PrimitiveGenerator
+	const std::vector<std::string> s_ModelNames {"cube", "plane", "sphere", "icosphere", "sphere.txt"};
 	const std::vector<std::string> s_HDRSkyboxFileNames {"rural_landscape_4k", "industrial_sunset_puresky_4k", "kloppenheim_03_4k", "schachen_forest_4k", "abandoned_tiled_room_4k"};
 
+	// Packed vertices are 20 bytes instead of 56 (see PackedMeshVertex), the shadow pass fetches only the 16 byte geometry stream (see VertexStream)
+	constexpr VertexFormat s_ModelVertexFormat = kPackedVertexFormat;
+
 	constexpr int s_DefaultSkyboxIndex         = 0;
 	constexpr int s_CubeFaceResolution         = 2048;
 	constexpr int s_CubeMapMipLevels           = 9;
@@ -42,6 +55,27 @@ namespace {
 	constexpr int s_FullPrefilterMapResolution = 512;
 	constexpr int s_PrecomputedBRDFResolution  = 512;
 
+	// Per frame texture upload budget, textures larger than this are uploaded over several frames (see TextureLoader)
+	constexpr int s_TextureUploadBudgetKilobytes       = 4096;
+	constexpr float s_TextureUploadBudgetMilliseconds = 2.0f;
+	// Material textures start with their mips up to this size (a few KB each), TextureStreamer keeps the finer mips objects need under the streaming budget
+	constexpr int s_StreamingMipTailSize              = 64;
+	constexpr int s_TextureStreamingBudgetMegabytes   = 256;
+
+	// 1x1 colors shown until a material's textures are uploaded, in GameObject's material texture order
+	// Flat normal and no height, so neither the surface nor parallax/displacement change
+	constexpr unsigned char s_PlaceholderTextureColors[3][4] {
+		{128, 128, 128, 255}, // albedo
+		{128, 128, 255, 255}, // normal
+		{255, 128, 0,   0},   // ao, roughness, metallic, height
+	};
+	// Albedo is sRGB like the albedo textures, so the placeholder looks the same through either
+	constexpr DXGI_FORMAT s_PlaceholderTextureFormats[3] {
+		DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+		DXGI_FORMAT_R8G8B8A8_UNORM,
+		DXGI_FORMAT_R8G8B8A8_UNORM,
+	};
+
 	/// Demo Scene starting values
 	constexpr float s_StartingDirectionalLightDirX = 50.0f;
 	constexpr float s_StartingDirectionalLightDirY = 230.0f;
@@ -49,6 +83,44 @@ namespace {
 	// sunlight color: 9.0f, 5.0f, 2.0f 
 	//                 29.0f, 18.0f, 11.0f
 	constexpr XMFLOAT3 s_StartingDirectionalLightColor = XMFLOAT3 {9.0f, 8.0f, 7.0f};
+
+	// Model names without an extension are rastertek text models (as are ".txt" ones), others (e.g. "tree.gltf", "rock.obj") go through the importers
+	// Note: primitive names (e.g. "sphere:64x32", see PrimitiveGenerator) are generated instead and never get here
+	std::string GetModelFilePath(const std::string& modelFileName) {
+		bool b_HasExtension = modelFileName.find('.') != std::string::npos;
+		return "./data/" + modelFileName + (b_HasExtension ? "" : ".txt");
+	}
+
+	std::string GetCubemapFilePath(const std::string& hdrFileName) {
+		return "./data/cubemaps/" + hdrFileName + ".hdr";
+	}
+
+	struct PBRTextureFiles {
+		// Names the texture, the source file itself unless it is packed from several (see Texture::DecodeFile)
+		std::string filePath;
+		std::vector<std::string> sourceFilePaths;
+	};
+
+	// In the order GameObject expects its material textures
+	// The single channel maps are packed into one texture: ao, roughness, metallic, height in r, g, b, a (glTF's occlusion/roughness/metallic order, plus height)
+	std::vector<PBRTextureFiles> GetPBRTextureFilePaths(const std::string& textureFileName) {
+		std::string filePathPrefix {"./data/" + textureFileName + "/" + textureFileName};
+		return {
+			{filePathPrefix + "_albedo.tga", {filePathPrefix + "_albedo.tga"}},
+			{filePathPrefix + "_normal.tga", {filePathPrefix + "_normal.tga"}},
+			{filePathPrefix + "_packed", {filePathPrefix + "_ao.tga", filePathPrefix + "_roughness.tga", filePathPrefix + "_metallic.tga", filePathPrefix + "_height.tga"}}
+		};
+	}
+
+	// Per material texture in GetPBRTextureFilePaths order, cooked to block compressed formats on first load (see TextureCache)
+	// sRGB BC7 albedo (mips filtered and sampled in linear space), BC5 normals (PBR.ps reconstructs z)
+	// BC3 for the packed maps: height gets BC3's separate alpha block (as good as BC4, it drives displacement and parallax), roughness the 6 bit green endpoints
+	// Note: BC7 is the same size, but BlockCompressor's BC7 shares one set of endpoints between all 4 uncorrelated channels, which costs height ~15 dB PSNR
+	constexpr DXGI_FORMAT s_PBRTextureFormats[] = {
+		DXGI_FORMAT_BC7_UNORM_SRGB,
+		DXGI_FORMAT_BC5_UNORM,
+		DXGI_FORMAT_BC3_UNORM
+	};
 }
 
 bool Scene::InitializeDemoScene(Application* appInstance, int shadowMapResolution, float shadowMapNearZ, float shadowMapFarZ
@@ -59,6 +131,61 @@ bool Scene::InitializeDemoScene(Application* appInstance, int shadowMapResolutio
 	m_D3DInstance = appInstance->GetD3DInstance();
 	HWND hwnd = appInstance->GetHWND();
 
+	// The benchmarks load the scene's own files under its budgets
+	if(s_Benchmarks != 0) {
+		Benchmarks::SceneData sceneData {};
+		for(const std::string& materialName : s_PBRMaterialFileNames) {
+			std::vector<PBRTextureFiles> materialTextureFiles = GetPBRTextureFilePaths(materialName);
+			sceneData.materialTextureFiles.emplace_back();
+			for(size_t i = 0; i < materialTextureFiles.size(); i++) {
+				sceneData.materialTextureFiles.back().push_back({materialTextureFiles[i].filePath, materialTextureFiles[i].sourceFilePaths, s_PBRTextureFormats[i]});
+			}
+		}
+		for(const std::string& hdrFileName : s_HDRSkyboxFileNames) {
+			sceneData.cubemapFilePaths.push_back(GetCubemapFilePath(hdrFileName));
+		}
+		sceneData.defaultCubemapIndex = s_DefaultSkyboxIndex;
+		sceneData.modelNames = s_ModelNames;
+		sceneData.textModelFilePath = GetModelFilePath("sphere.txt");
+		sceneData.textureUploadBudgetBytes = (uint32_t)s_TextureUploadBudgetKilobytes * 1024;
+		sceneData.textureUploadBudgetMilliseconds = s_TextureUploadBudgetMilliseconds;
+		sceneData.streamingMipTailSize = s_StreamingMipTailSize;
+		sceneData.textureStreamingBudgetBytes = (size_t)s_TextureStreamingBudgetMegabytes * 1024 * 1024;
+		m_D3DInstance->GetProjectionMatrix(sceneData.projectionMatrix);
+		sceneData.screenDepth = m_AppInstance->GetScreenFar();
+		Benchmarks::Run(s_Benchmarks, m_D3DInstance->GetDevice(), m_D3DInstance->GetDeviceContext(), sceneData);
+	}
+
+	/// Start decoding textures first, they are uploaded once everything else is initialized
+	m_TextureLoader = new TextureLoader();
+	m_TextureLoader->Initialize();
+	m_TextureUploadBudgetKilobytes = s_TextureUploadBudgetKilobytes;
+	m_TextureUploadBudgetMilliseconds = s_TextureUploadBudgetMilliseconds;
+	m_TextureStreamer = new TextureStreamer();
+	m_TextureStreamingBudgetMegabytes = s_TextureStreamingBudgetMegabytes;
+
+	for(int i = 0; i < (int)std::size(s_PlaceholderTextureColors); i++) {
+		Texture::ImageData placeholderImage {};
+		placeholderImage.width = 1;
+		placeholderImage.height = 1;
+		placeholderImage.uCharData = const_cast<unsigned char*>(s_PlaceholderTextureColors[i]);
+
+		m_PlaceholderTextures.push_back(new Texture());
+		result = m_PlaceholderTextures.back()->Initialize(m_D3DInstance->GetDevice(), m_D3DInstance->GetDeviceContext(), placeholderImage, s_PlaceholderTextureFormats[i], 1);
+		if(!result) {
+			MessageBox(hwnd, L"Could not initialize placeholder texture.", L"Error", MB_OK);
+			return false;
+		}
+	}
+
+	for(const char* materialName : {"rust", "stonewall", "metal_grid", "marble", "dirt", "bog"}) {
+		LoadPBRTextureResource(materialName);
+	}
+
+	m_CurrentCubemapIndex = s_DefaultSkyboxIndex;
+	m_RequestedCubemapIndex = s_DefaultSkyboxIndex;
+	LoadCubemapResource(s_HDRSkyboxFileNames[m_CurrentCubemapIndex]);
+
 	/// Compile shaders
 	m_DepthShaderInstance = new DepthShader();
 	result = m_DepthShaderInstance->Initialize(m_D3DInstance->GetDevice(), hwnd);
@@ -99,33 +226,24 @@ bool Scene::InitializeDemoScene(Application* appInstance, int shadowMapResolutio
 
 	/// Preload 3D resources
 	/// Note: this should be programmatic in a real scene system
-#if USE_MULTITHREAD_INITIALIZE == 0
+	// Models only copy their geometry into the arena, it is uploaded by the first pass's Flush
+	m_GeometryArena = new GeometryArena();
+	m_GeometryArena->Initialize(s_ModelVertexFormat);
+
+	// Models load on worker threads and are drawn once their coarsest LOD is resident, see Model::UpdateResidency
 	LoadModelResource("sphere");
 	LoadModelResource("plane");
 	LoadModelResource("cube");
-#else
-	// NOTE: very primitive way to do multithreading, need to multithread Texture::Initialize() for real performance gain (Majority of LoadPBRTextureResource() is locked as a critical section currently)
-	auto fm1 = std::async(std::launch::async, &Scene::LoadModelResource, this, "sphere");
-	auto fm2 = std::async(std::launch::async, &Scene::LoadModelResource, this, "plane");
-	auto fm3 = std::async(std::launch::async, &Scene::LoadModelResource, this, "cube");
-#endif
 
-	result = LoadPBRTextureResource("rust");
-	if(!result) { MessageBox(hwnd, L"Could initialize texture resource.", L"Error", MB_OK); return false; };
-	result = LoadPBRTextureResource("stonewall");
-	if(!result) { MessageBox(hwnd, L"Could initialize texture resource.", L"Error", MB_OK); return false; };
-	result = LoadPBRTextureResource("metal_grid");
-	if(!result) { MessageBox(hwnd, L"Could initialize texture resource.", L"Error", MB_OK); return false; };
-	result = LoadPBRTextureResource("marble");
-	if(!result) { MessageBox(hwnd, L"Could initialize texture resource.", L"Error", MB_OK); return false; };
-	result = LoadPBRTextureResource("dirt");
-	if(!result) { MessageBox(hwnd, L"Could initialize texture resource.", L"Error", MB_OK); return false; };
-	result = LoadPBRTextureResource("bog");
+	// Uploads the textures queued at the start as their decodes finish
+	result = m_TextureLoader->WaitAll(m_D3DInstance->GetDevice(), m_D3DInstance->GetDeviceContext());
 	if(!result) { MessageBox(hwnd, L"Could initialize texture resource.", L"Error", MB_OK); return false; };
 
-	/// Load default skybox cubemap
-	m_CurrentCubemapIndex = s_DefaultSkyboxIndex;
-	LoadCubemapResource(s_HDRSkyboxFileNames[m_CurrentCubemapIndex]);
+	/// Build default skybox cubemap
+	if(!FinishCubemapResources() || m_LoadedCubemapResources.find(s_HDRSkyboxFileNames[m_CurrentCubemapIndex]) == m_LoadedCubemapResources.end()) {
+		MessageBox(hwnd, L"Could not initialize cubemap.", L"Error", MB_OK);
+		return false;
+	}
 
 	//struct GameObjectData {
 	//	std::string modelName {};
@@ -155,12 +273,30 @@ bool Scene::InitializeDemoScene(Application* appInstance, int shadowMapResolutio
 		{"plane",  "dirt",  {0.0f, 0.0f, 0.0f},  {5.0f, 1.0f, 5.0f}, 0.0f, 9.0f, 0.0f, 0.025f},
 	};
 
+#if USE_MULTITHREAD_INITIALIZE == 1
+	// Game objects and the batcher keep the shader's pointer, so it must be built before either is created
+	// Note: the resource loads above no longer wait on anything, they can finish before the shader does
+	if(!fs1.get()) {
+		MessageBox(hwnd, L"Could not initialize the PBR shader object.", L"Error", MB_OK);
+		return false;
+	}
+#endif
+
 	m_GameObjects.reserve(sceneObjects.size());
 	for(size_t i = 0; i < sceneObjects.size(); i++) {
 		m_GameObjects.push_back(new GameObject());
 		m_GameObjects[i]->Initialize(m_PBRShaderInstance, m_DepthShaderInstance, m_LoadedTextureResources[sceneObjects[i].materialName], m_LoadedModelResources[sceneObjects[i].modelName], sceneObjects[i]);
 	}
 
+	// Batches are built on the first update, models must be loaded by then
+	// Note: the PBR shader future is joined above, the batcher must not see the shader before that
+	m_StaticBatcher = new StaticBatcher();
+	result = m_StaticBatcher->Initialize(m_PBRShaderInstance, m_DepthShaderInstance, m_GeometryArena);
+	if(!result) {
+		MessageBox(hwnd, L"Could not initialize the static batcher.", L"Error", MB_OK);
+		return false;
+	}
+
 	/// Lighting
 	// Create and initialize the shadow map texture
 	m_DirectionalShadowMapRenderTexture = new RenderTexture();
@@ -198,17 +334,6 @@ bool Scene::InitializeDemoScene(Application* appInstance, int shadowMapResolutio
 	//m_Lights[3].SetDiffuseColor(1.0f, 1.0f, 1.0f, 1.0f);  // White
 	//m_Lights[3].SetPosition(3.0f, 1.0f, -3.0f);
 
-#if USE_MULTITHREAD_INITIALIZE == 1
-	if(!fs1.get()) {
-		MessageBox(hwnd, L"Could not initialize the PBR shader object.", L"Error", MB_OK);
-		return false;
-	}
-	if(!fm1.get() || !fm2.get() || !fm3.get()) {
-		MessageBox(hwnd, L"Could not initialize 3D model.", L"Error", MB_OK);
-		return false;
-	}
-#endif
-
 	return true;
 }
 
@@ -227,16 +352,42 @@ bool Scene::RenderScene(XMMATRIX projectionMatrix, float time) {
 
 	m_WorldCamera->Update();
 	m_WorldCamera->UpdateFrustum(projectionMatrix, m_AppInstance->GetScreenFar());
+	m_LastProjectionMatrix = projectionMatrix;
+	m_LastRenderTime = time;
+
+	// Frame boundary for model streaming: LOD ranges uploaded by last frame's Flush are swapped in, new streams are uploaded by this frame's
+	for(const auto& [modelName, model] : m_LoadedModelResources) {
+		if(!model->UpdateResidency()) {
+			std::cout << modelName << ": could not load model\n";
+		}
+	}
+
+	if(!m_StaticBatcher->Update(m_D3DInstance->GetDevice(), m_GameObjects)) {
+		return false;
+	}
+	if(!m_GeometryArena->Flush(m_D3DInstance->GetDevice(), m_D3DInstance->GetDeviceContext())) {
+		return false;
+	}
+
+	// LODs and texture mips are picked for the screen render texture the world camera is drawn to, whatever the window or monitor size
+	// Note: the depth pass draws the LODs picked here
+	float viewportHeight = (float)m_AppInstance->GetScreenRenderTexture()->GetTextureHeight();
 
 	Skybox* currentCubemap = m_LoadedCubemapResources[s_HDRSkyboxFileNames[m_CurrentCubemapIndex]];
 	for(size_t i = 0; i < m_GameObjects.size(); i++) {
-		if(!m_GameObjects[i]->Render(m_D3DInstance->GetDeviceContext(), projectionMatrix, m_DirectionalShadowMapRenderTexture->GetTextureSRV(), currentCubemap, m_DirectionalLight, m_WorldCamera, m_WorldCamera, time)) {
+		if(m_StaticBatcher->IsBatched(i)) {
+			continue;
+		}
+		if(!m_GameObjects[i]->Render(m_D3DInstance->GetDeviceContext(), projectionMatrix, viewportHeight, m_DirectionalShadowMapRenderTexture->GetTextureSRV(), currentCubemap, m_DirectionalLight, m_WorldCamera, m_WorldCamera, time)) {
 			return false;
 		}
 	}
+	if(!m_StaticBatcher->Render(m_D3DInstance->GetDeviceContext(), m_GameObjects, projectionMatrix, viewportHeight, m_DirectionalShadowMapRenderTexture->GetTextureSRV(), currentCubemap, m_DirectionalLight, m_WorldCamera, m_WorldCamera, time)) {
+		return false;
+	}
 
-	static ID3D11ShaderResourceView* nullSRV[10] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
-	m_D3DInstance->GetDeviceContext()->PSSetShaderResources(0, 10, nullSRV);
+	static ID3D11ShaderResourceView* nullSRV[7] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+	m_D3DInstance->GetDeviceContext()->PSSetShaderResources(0, 7, nullSRV);
 
 	// Render skybox
 	XMMATRIX viewMatrix {};
@@ -258,15 +409,28 @@ bool Scene::RenderScene(XMMATRIX projectionMatrix, float time) {
 }
 
 bool Scene::RenderSceneWithCullDebugCamera(XMMATRIX projectionMatrix, Camera* camera, float time) {
+	if(!m_GeometryArena->Flush(m_D3DInstance->GetDevice(), m_D3DInstance->GetDeviceContext())) {
+		return false;
+	}
+
+	// Culling and LOD selection still follow the world camera, so they keep its viewport instead of the debug render texture's
+	float viewportHeight = (float)m_AppInstance->GetScreenRenderTexture()->GetTextureHeight();
+
 	Skybox* currentCubemap = m_LoadedCubemapResources[s_HDRSkyboxFileNames[m_CurrentCubemapIndex]];
 	for(size_t i = 0; i < m_GameObjects.size(); i++) {
-		if(!m_GameObjects[i]->Render(m_D3DInstance->GetDeviceContext(), projectionMatrix, m_DirectionalShadowMapRenderTexture->GetTextureSRV(), currentCubemap, m_DirectionalLight, camera, m_WorldCamera, time)) {
+		if(m_StaticBatcher->IsBatched(i)) {
+			continue;
+		}
+		if(!m_GameObjects[i]->Render(m_D3DInstance->GetDeviceContext(), projectionMatrix, viewportHeight, m_DirectionalShadowMapRenderTexture->GetTextureSRV(), currentCubemap, m_DirectionalLight, camera, m_WorldCamera, time)) {
 			return false;
 		}
 	}
+	if(!m_StaticBatcher->Render(m_D3DInstance->GetDeviceContext(), m_GameObjects, projectionMatrix, viewportHeight, m_DirectionalShadowMapRenderTexture->GetTextureSRV(), currentCubemap, m_DirectionalLight, camera, m_WorldCamera, time)) {
+		return false;
+	}
 
-	static ID3D11ShaderResourceView* nullSRV[10] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
-	m_D3DInstance->GetDeviceContext()->PSSetShaderResources(0, 10, nullSRV);
+	static ID3D11ShaderResourceView* nullSRV[7] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+	m_D3DInstance->GetDeviceContext()->PSSetShaderResources(0, 7, nullSRV);
 
 	// Render skybox
 	XMMATRIX viewMatrix {};
@@ -288,6 +452,21 @@ bool Scene::RenderSceneWithCullDebugCamera(XMMATRIX projectionMatrix, Camera* ca
 
 
 
+bool Scene::RayCast(XMFLOAT3 origin, XMFLOAT3 direction, int& hitObjectIndex, float& hitDistance) const {
+	bool b_Hit = false;
+	float closestDistance = FLT_MAX;
+	for(size_t i = 0; i < m_GameObjects.size(); i++) {
+		float distance {};
+		if(m_GameObjects[i]->RayCast(origin, direction, m_LastRenderTime, closestDistance, distance)) {
+			closestDistance = distance;
+			hitObjectIndex = (int)i;
+			b_Hit = true;
+		}
+	}
+	hitDistance = closestDistance;
+	return b_Hit;
+}
+
 bool Scene::RenderPostProcess(int indexCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX orthoMatrix, ID3D11ShaderResourceView* textureSRV) {
 	// Note: bloom and post process shader (tonemapping) are separated to keep shaders more readable in this demo
 	if(!m_BloomEffect->RenderEffect(m_D3DInstance, indexCount, worldMatrix, viewMatrix, orthoMatrix, textureSRV)) {
@@ -321,57 +500,67 @@ bool Scene::RenderDirectionalLightSceneDepth(float time) {
 
 	m_D3DInstance->SetToFrontCullRasterState();
 
+	// RenderScene already updated this frame, this only compares every object with its last state
+	if(!m_StaticBatcher->Update(m_D3DInstance->GetDevice(), m_GameObjects)) {
+		return false;
+	}
+	// Uploads models loaded and batches rebuilt since the last pass
+	if(!m_GeometryArena->Flush(m_D3DInstance->GetDevice(), m_D3DInstance->GetDeviceContext())) {
+		return false;
+	}
+
 	for(size_t i = 0; i < m_GameObjects.size(); i++) {
+		if(m_StaticBatcher->IsBatched(i)) {
+			continue;
+		}
 		if(!m_GameObjects[i]->RenderToDepth(m_D3DInstance->GetDeviceContext(), m_DirectionalLight, time)) {
 			return false;
 		}
 	}
+	if(!m_StaticBatcher->RenderToDepth(m_D3DInstance->GetDeviceContext(), m_GameObjects, m_DirectionalLight)) {
+		return false;
+	}
 
 	m_D3DInstance->SetToBackCullRasterState();
 
 	return true;
 }
 
-bool Scene::LoadPBRTextureResource(const std::string& textureFileName) {
+void Scene::LoadPBRTextureResource(const std::string& textureFileName, bool b_IsUrgent) {
 	if(m_LoadedTextureResources.find(textureFileName) == m_LoadedTextureResources.end()) {
-		// Load models and materials to be used in scene
-		std::string filePathPrefix {"./data/" + textureFileName + "/" + textureFileName};
-		const std::vector<std::string> textureFileNames {
-			filePathPrefix + "_albedo.tga",
-			filePathPrefix + "_normal.tga",
-			filePathPrefix + "_metallic.tga",
-			filePathPrefix + "_roughness.tga",
-			filePathPrefix + "_ao.tga",
-			filePathPrefix + "_height.tga"
-		};
+		// Only queued, the textures show placeholder colors until TextureLoader's upload stage finished them
+		const std::vector<PBRTextureFiles> textureFileNames = GetPBRTextureFilePaths(textureFileName);
+		TextureLoader::LoadPriority priority = b_IsUrgent ? TextureLoader::kUrgentPriority : TextureLoader::kDefaultPriority;
 
 		std::vector<Texture*> textureResources;
 		textureResources.reserve(textureFileNames.size());
 		for(size_t i = 0; i < textureFileNames.size(); i++) {
-#if USE_MULTITHREAD_INITIALIZE == 1
-			std::lock_guard<std::mutex> lock {s_DeviceContextMutex};
-#endif
 			textureResources.push_back(new Texture());
-			if(!textureResources[i]->Initialize(
-				m_D3DInstance->GetDevice(), m_D3DInstance->GetDeviceContext(), textureFileNames[i], DXGI_FORMAT_R8G8B8A8_UNORM)
-				) {
-				return false;
-			}
+			textureResources[i]->SetPlaceholder(m_PlaceholderTextures[i]->GetTextureSRV());
+			// Nothing polls material loads, the handle is released right away
+			TextureLoader::Handle loadHandle = m_TextureLoader->Load(textureResources[i], textureFileNames[i].filePath, textureFileNames[i].sourceFilePaths, s_PBRTextureFormats[i], 0, priority, s_StreamingMipTailSize);
+			m_TextureLoader->Release(loadHandle);
+			m_TextureStreamer->Add(textureResources[i]);
 		}
 
 		m_LoadedTextureResources.emplace(textureFileName, textureResources);
 	}
-
-	return true;
 }
 
 bool Scene::LoadModelResource(const std::string& modelFileName) {
 	if(m_LoadedModelResources.find(modelFileName) == m_LoadedModelResources.end()) {
+		// Returns before the model is loaded, objects skip it until it is drawable
 		Model* pModel = new Model();
-		if(!pModel->Initialize(
-			m_D3DInstance->GetDevice(), "./data/" + modelFileName + ".txt")
-			) {
-			return false;
+		if(PrimitiveGenerator::IsPrimitiveName(modelFileName)) {
+			MeshData meshData {};
+			if(!PrimitiveGenerator::GenerateFromName(modelFileName, meshData)) {
+				delete pModel;
+				return false;
+			}
+			pModel->InitializeAsync(m_D3DInstance->GetDevice(), m_GeometryArena, std::move(meshData), modelFileName, s_ModelVertexFormat);
+		}
+		else {
+			pModel->InitializeAsync(m_D3DInstance->GetDevice(), m_GeometryArena, GetModelFilePath(modelFileName), s_ModelVertexFormat);
 		}
 
 		m_LoadedModelResources.emplace(modelFileName, pModel);
@@ -380,24 +569,84 @@ bool Scene::LoadModelResource(const std::string& modelFileName) {
 	return true;
 }
 
-bool Scene::LoadCubemapResource(const std::string& hdrFileName) {
-	if(m_LoadedCubemapResources.find(hdrFileName) == m_LoadedCubemapResources.end()) {
-		XMMATRIX screenOrthoMatrix {}, screenCamViewMatrix {};
-		m_D3DInstance->GetOrthoMatrix(screenOrthoMatrix);
-		m_AppInstance->GetScreenDisplayCamera()->GetViewMatrix(screenCamViewMatrix);
+void Scene::LoadCubemapResource(const std::string& hdrFileName) {
+	if(m_LoadedCubemapResources.find(hdrFileName) == m_LoadedCubemapResources.end() && m_PendingCubemapResources.find(hdrFileName) == m_PendingCubemapResources.end()) {
+		// HDR maps have no mipmaps, the skybox is built by FinishCubemapResources once the map is uploaded
+		// R9G9B9E5 is RGBE's own layout, so the map is kept exactly in a quarter of the float size (32 MB instead of 128 MB at 4K, see HDRDecoder)
+		PendingCubemap pendingCubemap {};
+		pendingCubemap.hdrTexture = new Texture();
+		pendingCubemap.loadHandle = m_TextureLoader->Load(pendingCubemap.hdrTexture, GetCubemapFilePath(hdrFileName), DXGI_FORMAT_R9G9B9E5_SHAREDEXP, 1, TextureLoader::kUrgentPriority);
+		m_PendingCubemapResources.emplace(hdrFileName, pendingCubemap);
+	}
+}
 
-		Skybox* pCubemap = new Skybox();
-		bool result = pCubemap->Initialize(m_D3DInstance, m_AppInstance->GetHWND(), hdrFileName, s_CubeFaceResolution, s_CubeMapMipLevels, s_IrradianceMapResolution, s_FullPrefilterMapResolution, s_PrecomputedBRDFResolution, screenCamViewMatrix, screenOrthoMatrix, m_AppInstance->GetScreenDisplayQuadInstance());
-		if(!result) {
-			MessageBox(m_AppInstance->GetHWND(), L"Could not initialize cubemap.", L"Error", MB_OK);
-			return false;
+bool Scene::FinishCubemapResources() {
+	for(auto it = m_PendingCubemapResources.begin(); it != m_PendingCubemapResources.end();) {
+		TextureLoader::LoadState loadState = m_TextureLoader->GetLoadState(it->second.loadHandle);
+		if(loadState == TextureLoader::kUploaded || loadState == TextureLoader::kLoadFailed) {
+			m_TextureLoader->Release(it->second.loadHandle);
+		}
+		if(loadState == TextureLoader::kUploaded) {
+			XMMATRIX screenOrthoMatrix {}, screenCamViewMatrix {};
+			m_D3DInstance->GetOrthoMatrix(screenOrthoMatrix);
+			m_AppInstance->GetScreenDisplayCamera()->GetViewMatrix(screenCamViewMatrix);
+
+			Skybox* pCubemap = new Skybox();
+			bool result = pCubemap->Initialize(m_D3DInstance, m_AppInstance->GetHWND(), it->second.hdrTexture, s_CubeFaceResolution, s_CubeMapMipLevels, s_IrradianceMapResolution, s_FullPrefilterMapResolution, s_PrecomputedBRDFResolution, screenCamViewMatrix, screenOrthoMatrix, m_AppInstance->GetScreenDisplayQuadInstance());
+			if(!result) {
+				MessageBox(m_AppInstance->GetHWND(), L"Could not initialize cubemap.", L"Error", MB_OK);
+				return false;
+			}
+			m_LoadedCubemapResources.emplace(it->first, pCubemap);
+			it = m_PendingCubemapResources.erase(it);
 		}
-		m_LoadedCubemapResources.emplace(hdrFileName, pCubemap);
+		else if(loadState == TextureLoader::kLoadFailed) {
+			it->second.hdrTexture->Shutdown();
+			delete it->second.hdrTexture;
+			it = m_PendingCubemapResources.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	// The current skybox stays until the requested one is built
+	if(m_LoadedCubemapResources.find(s_HDRSkyboxFileNames[m_RequestedCubemapIndex]) != m_LoadedCubemapResources.end()) {
+		m_CurrentCubemapIndex = m_RequestedCubemapIndex;
+	}
+	else if(m_PendingCubemapResources.find(s_HDRSkyboxFileNames[m_RequestedCubemapIndex]) == m_PendingCubemapResources.end()) {
+		m_RequestedCubemapIndex = m_CurrentCubemapIndex;
 	}
 
 	return true;
 }
 
+bool Scene::UpdateTextureUploads() {
+	TextureLoader::UploadBudget uploadBudget {};
+	uploadBudget.byteCount = (uint32_t)m_TextureUploadBudgetKilobytes * 1024;
+	uploadBudget.milliseconds = m_TextureUploadBudgetMilliseconds;
+
+	// Failed loads are logged and keep their placeholder
+	m_TextureLoader->Upload(m_D3DInstance->GetDevice(), m_D3DInstance->GetDeviceContext(), uploadBudget);
+
+	// Streamed mips get what the loads left of both budgets, requests are the ones of the last frame's objects
+	// Note: 0 is no limit for both, so a used up budget is passed as the smallest one (the streamer still makes progress, like the loader)
+	TextureLoader::UploadStats uploadStats = m_TextureLoader->GetLastUploadStats();
+	TextureStreamer::Budget streamingBudget {};
+	streamingBudget.residentByteCount = (size_t)m_TextureStreamingBudgetMegabytes * 1024 * 1024;
+	if(uploadBudget.byteCount > 0) {
+		streamingBudget.uploadByteCount = std::max(1u, uploadBudget.byteCount - std::min(uploadBudget.byteCount, uploadStats.uploadedBytes));
+	}
+	if(uploadBudget.milliseconds > 0.0f) {
+		streamingBudget.milliseconds = std::max(FLT_MIN, uploadBudget.milliseconds - uploadStats.milliseconds);
+	}
+	if(!m_TextureStreamer->Update(m_D3DInstance->GetDevice(), m_D3DInstance->GetDeviceContext(), streamingBudget)) {
+		std::cout << "Texture streaming: could not reallocate a texture\n";
+	}
+
+	return FinishCubemapResources();
+}
+
 void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, bool& b_ShowImGuiMenu, bool& b_ShowScreenFPS, bool& b_QuitAppFlag, bool& b_ShowDebugQuad1, bool& b_ShowDebugQuad2, bool& b_ShowDebugQuad3, bool& b_ToggleFullScreenFlag) {
 	static auto ImGuiHelpMarker = [](const char* desc, bool b_IsSameLine = true, bool b_IsWarning = false) {
 		if(b_IsSameLine) ImGui::SameLine();
@@ -419,8 +668,8 @@ void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, b
 		return -1;
 	};
 	static auto FindModelIndex = [](std::string_view modelName) {
-		for(int i = 0; i < s_ModelFileNames.size(); i++) {
-			if(s_ModelFileNames[i] == modelName) {
+		for(int i = 0; i < s_ModelNames.size(); i++) {
+			if(s_ModelNames[i] == modelName) {
 				return i;
 			}
 		}
@@ -452,6 +701,47 @@ void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, b
 	if(gpuMemory == -1) m_D3DInstance->GetVideoCardInfo(gpuName, gpuMemory);
 	ImGui::TextDisabled("%s %d MB", gpuName, gpuMemory);
 	ImGui::Text("FPS: %d", (int)currentFPS);
+
+	// Meshlet culling of the last frame, objects culled as a whole count all of their meshlets as frustum culled
+	MeshletCuller::CullStats meshletStats {};
+	for(GameObject* gameObject : m_GameObjects) {
+		const MeshletCuller::CullStats& stats = gameObject->GetMeshletCullStats();
+		meshletStats.meshletCount += stats.meshletCount;
+		meshletStats.frustumCulledCount += stats.frustumCulledCount;
+		meshletStats.backfaceCulledCount += stats.backfaceCulledCount;
+		meshletStats.drawRangeCount += stats.drawRangeCount;
+	}
+	int culledMeshletCount = meshletStats.frustumCulledCount + meshletStats.backfaceCulledCount;
+	ImGui::Text("Meshlets culled: %d / %d (%.1f%%)", culledMeshletCount, meshletStats.meshletCount, meshletStats.meshletCount > 0 ? 100.0f * culledMeshletCount / meshletStats.meshletCount : 0.0f);
+	ImGuiHelpMarker("CPU cluster culling before the hull shader, see MeshletCuller.\nBackface (normal cone) culling is skipped for objects with vertex displacement.");
+	const StaticBatcher::BatchStats& batchStats = m_StaticBatcher->GetStats();
+	ImGui::TextDisabled("frustum %d, backface %d, %d draw calls", meshletStats.frustumCulledCount, meshletStats.backfaceCulledCount, meshletStats.drawRangeCount + batchStats.drawCallCount);
+	bool b_UseStaticBatching = m_StaticBatcher->GetEnabled();
+	if(ImGui::Checkbox("Static Batching", &b_UseStaticBatching)) {
+		m_StaticBatcher->SetEnabled(b_UseStaticBatching);
+	}
+	ImGuiHelpMarker("Objects without rotation that share a material and its parameters are drawn from merged world space buffers, see StaticBatcher.\nBatched objects are culled per object, without meshlet culling.");
+	ImGui::SameLine();
+	ImGui::TextDisabled("%d objects in %d batches, %d draw calls", batchStats.objectCount, batchStats.batchCount, batchStats.drawCallCount);
+	GeometryArena::ArenaStats arenaStats = m_GeometryArena->GetStats();
+	const GeometryArena::PoolStats& vertexPoolStats = arenaStats.pools[GeometryArena::kVertexPool];
+	uint32_t arenaByteSize = 0;
+	for(const GeometryArena::PoolStats& poolStats : arenaStats.pools) {
+		arenaByteSize += poolStats.byteSize;
+	}
+	ImGui::Text("Geometry arena: %.1f MB, %u / %u vertices used", arenaByteSize / (1024.0f * 1024.0f), vertexPoolStats.capacity - vertexPoolStats.storage.totalFree, vertexPoolStats.capacity);
+	ImGuiHelpMarker("Every model and static batch is sub-allocated from shared vertex and index buffers, see GeometryArena.\nFragmentation is the share of free vertices outside the largest free range.");
+	ImGui::TextDisabled("%u free ranges, %.1f%% fragmentation, %d compactions", vertexPoolStats.storage.freeRegionCount, 100.0f * OffsetAllocator::GetFragmentation(vertexPoolStats.storage), arenaStats.compactionCount);
+	TextureLoader::UploadStats uploadStats = m_TextureLoader->GetLastUploadStats();
+	ImGui::Text("Texture uploads: %.2f MB in %.2f ms, %d waiting", uploadStats.uploadedBytes / (1024.0f * 1024.0f), uploadStats.milliseconds, uploadStats.backlogCount);
+	ImGuiHelpMarker("Decoded textures are uploaded a few rows at a time under a per frame budget, see TextureLoader.\nMaterials show placeholder colors and skyboxes keep the previous one until they are fully uploaded.");
+	ImGui::DragInt("Upload Budget (KB)", &m_TextureUploadBudgetKilobytes, 16.0f, 64, 65536, "%d", kSliderFlags);
+	ImGui::DragFloat("Upload Budget (ms)", &m_TextureUploadBudgetMilliseconds, 0.05f, 0.1f, 33.0f, "%.2f", kSliderFlags);
+	TextureStreamer::Stats streamingStats = m_TextureStreamer->GetLastStats();
+	ImGui::Text("Streamed textures: %.1f / %.1f MB requested, %d streaming", streamingStats.residentBytes / (1024.0f * 1024.0f), streamingStats.requestedBytes / (1024.0f * 1024.0f), streamingStats.streamingCount);
+	ImGuiHelpMarker("Material textures start with their smallest mips, finer mips are streamed in by each object's on screen texel density and evicted some seconds after no object needs them, see TextureStreamer.\nOver budget, the largest textures lose their finest mip first.");
+	ImGui::TextDisabled("%.2f MB streamed in %.2f ms, from what the uploads left of their budget", streamingStats.uploadedBytes / (1024.0f * 1024.0f), streamingStats.milliseconds);
+	ImGui::DragInt("Streaming Budget (MB)", &m_TextureStreamingBudgetMegabytes, 1.0f, 16, 4096, "%d", kSliderFlags);
 	ImGui::Spacing();
 
 	if(ImGui::CollapsingHeader("Display")) {
@@ -472,18 +762,21 @@ void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, b
 	}
 	
 	bool b_ShowSkyboxHeader = ImGui::CollapsingHeader("Skybox");
-	ImGuiHelpMarker("Note: Environment maps for IBL are generated in run time, might be slow on first selection of skybox. Results are cached.", true, true);
+	ImGuiHelpMarker("Note: HDR maps are loaded in the background, the current skybox stays until the selected one is ready. Environment maps for IBL are generated in run time, might be slow on first selection of skybox. Results are cached.", true, true);
 	if(b_ShowSkyboxHeader) {
 		if(ImGui::BeginTable("##skybox", 3, kTableFlags)) {
 			for(int i = 0; i < s_HDRSkyboxFileNames.size(); i++) {
 				ImGui::TableNextColumn();
-				if(ImGui::Selectable(s_HDRSkyboxFileNames[i].c_str(), m_CurrentCubemapIndex == i)) {
+				if(ImGui::Selectable(s_HDRSkyboxFileNames[i].c_str(), m_RequestedCubemapIndex == i)) {
 					LoadCubemapResource(s_HDRSkyboxFileNames[i]);
-					m_CurrentCubemapIndex = i;
+					m_RequestedCubemapIndex = i;
 				}
 			}
 			ImGui::EndTable();
 		}
+		if(m_RequestedCubemapIndex != m_CurrentCubemapIndex) {
+			ImGui::TextDisabled("Loading %s...", s_HDRSkyboxFileNames[m_RequestedCubemapIndex].c_str());
+		}
 	}
 
 	/// Directional Light
@@ -546,13 +839,12 @@ void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, b
 	/// Object Material Edit
 	/// NOTE: implementation could be simplified with use of GameObject::GameObjectData struct
 	bool b_ShowSceneObjectHeader = ImGui::CollapsingHeader("Scene Objects");
-	ImGuiHelpMarker("Select a scene object to edit its object and material parameters.");
-	if(b_ShowSceneObjectHeader) {
+	ImGuiHelpMarker("Click a scene object to edit its object and material parameters.");
+	if(b_ShowSceneObjectHeader && !m_GameObjects.empty()) {
 		// Note: Ground object is selected by default
 		static int userSelectedGameObjectIndex = (int)m_GameObjects.size() - 1;
 		// Note: Start true to intialize variables below
 		static bool b_NewSceneObjectSelectedFlag = true;
-		static bool b_UserObjectIsPlane {};
 
 		static bool b_UserObjectEnabled = true;
 		static int userSelectedMaterialIndex {};
@@ -571,30 +863,39 @@ void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, b
 		static float userUniformTessellationFactor {};
 		static float userEdgeTessellationLength {};
 
-		ImGui::SetNextItemOpen(true, ImGuiCond_Once);
-		if(ImGui::TreeNode("Scene Object Select")) {
-			if(ImGui::BeginTable("##GameObjects", 3, kTableFlags)) {
-				for(int i = 0; i < m_GameObjects.size(); i++) {
-					ImGui::TableNextColumn();
-
-					char label[32];
-					if(i == m_GameObjects.size() - 1) {
-						sprintf_s(label, "Ground");
-					}
-					else {
-						sprintf_s(label, "Object %d", i);
-					}
+		// Back to the ground if the selection is out of range (e.g. objects were still loading when the header was first opened)
+		if(userSelectedGameObjectIndex < 0 || userSelectedGameObjectIndex >= (int)m_GameObjects.size()) {
+			userSelectedGameObjectIndex = (int)m_GameObjects.size() - 1;
+			b_NewSceneObjectSelectedFlag = true;
+		}
 
-					if(ImGui::Selectable(label, userSelectedGameObjectIndex == i)) {
-						userSelectedGameObjectIndex = i;
-						b_NewSceneObjectSelectedFlag = true;
-					}
-				}
-				ImGui::EndTable();
+		/// Click to pick, selects the object under the mouse cursor
+		// Note: clicks on IMGUI windows stay with IMGUI
+		ImGuiIO& io = ImGui::GetIO();
+		if(!io.WantCaptureMouse && ImGui::IsMouseClicked(ImGuiMouseButton_Left) && io.DisplaySize.x > 0.0f && io.DisplaySize.y > 0.0f) {
+			float ndcX = io.MousePos.x / io.DisplaySize.x * 2.0f - 1.0f;
+			float ndcY = 1.0f - io.MousePos.y / io.DisplaySize.y * 2.0f;
+			XMFLOAT3 rayOrigin {}, rayDirection {};
+			m_WorldCamera->GetScreenRay(m_LastProjectionMatrix, ndcX, ndcY, rayOrigin, rayDirection);
+
+			int hitObjectIndex {};
+			float hitDistance {};
+			if(RayCast(rayOrigin, rayDirection, hitObjectIndex, hitDistance)) {
+				userSelectedGameObjectIndex = hitObjectIndex;
+				b_NewSceneObjectSelectedFlag = true;
 			}
-			ImGui::TreePop();
 		}
 
+		char selectedLabel[32];
+		if(userSelectedGameObjectIndex == (int)m_GameObjects.size() - 1) {
+			sprintf_s(selectedLabel, "Ground");
+		}
+		else {
+			sprintf_s(selectedLabel, "Object %d", userSelectedGameObjectIndex);
+		}
+		ImGui::Text("Selected: %s (%s)", selectedLabel, std::string(m_GameObjects[userSelectedGameObjectIndex]->GetModelName()).c_str());
+		ImGuiHelpMarker("Click an object in the scene to select it.\nDisabled objects can not be picked, they stay selected until another object is clicked.");
+
 		ImGui::Spacing();
 		ImGui::SeparatorText("Edit Parameters");
 		ImGui::Spacing();
@@ -609,7 +910,6 @@ void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, b
 			b_UserObjectEnabled = pSelectedGO->GetEnabled();
 			userSelectedMaterialIndex = FindPBRMaterialIndex(pSelectedGO->GetPBRMaterialName());
 			userSelectedModelIndex = FindModelIndex(pSelectedGO->GetModelName());
-			b_UserObjectIsPlane = pSelectedGO->GetModelName() == "plane";
 			pSelectedGO->GetPosition(userPosition[0], userPosition[1], userPosition[2]);
 			pSelectedGO->GetScale(userScale[0], userScale[1], userScale[2]);
 			userUVScale = pSelectedGO->GetUVScale();
@@ -636,7 +936,7 @@ void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, b
 					if(ImGui::Selectable(s_PBRMaterialFileNames[i].c_str(), userSelectedMaterialIndex == i)) {
 						userSelectedMaterialIndex = i;
 						std::string matName = s_PBRMaterialFileNames[i % s_PBRMaterialFileNames.size()];
-						LoadPBRTextureResource(matName);
+						LoadPBRTextureResource(matName, true);
 						m_GameObjects[userSelectedGameObjectIndex]->SetPBRMaterialTextures(matName, m_LoadedTextureResources[matName]);
 					}
 				}
@@ -649,11 +949,11 @@ void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, b
 		ImGui::SetNextItemOpen(true, ImGuiCond_Once);
 		if(ImGui::TreeNode("Model Select")) {
 			if(ImGui::BeginTable("##models", 3, kTableFlags)) {
-				for(int i = 0; i < s_ModelFileNames.size(); i++) {
+				for(int i = 0; i < s_ModelNames.size(); i++) {
 					ImGui::TableNextColumn();
-					if(ImGui::Selectable(s_ModelFileNames[i].c_str(), userSelectedModelIndex == i)) {
+					if(ImGui::Selectable(s_ModelNames[i].c_str(), userSelectedModelIndex == i)) {
 						userSelectedModelIndex = i;
-						std::string modelName = s_ModelFileNames[i % s_ModelFileNames.size()];
+						std::string modelName = s_ModelNames[i % s_ModelNames.size()];
 						LoadModelResource(modelName);
 						m_GameObjects[userSelectedGameObjectIndex]->SetModel(modelName, m_LoadedModelResources[modelName]);
 					}
@@ -662,6 +962,16 @@ void Scene::UpdateMainImGuiWindow(float currentFPS, bool& b_IsWireFrameRender, b
 			}
 			ImGui::TreePop();
 		}
+		Model* pSelectedModel = m_LoadedModelResources[std::string(pSelectedGO->GetModelName())];
+		if(pSelectedModel->IsDrawable()) {
+			const std::vector<MeshLOD>& selectedModelLODs = pSelectedModel->GetLODs();
+			const MeshLOD& selectedLOD = selectedModelLODs[pSelectedGO->GetCurrentLOD()];
+			ImGui::Text("LOD: %d / %d (%u triangles), resident from LOD %d", pSelectedGO->GetCurrentLOD(), (int)selectedModelLODs.size() - 1, selectedLOD.indexCount / 3, pSelectedModel->GetResidentLOD());
+			ImGuiHelpMarker("Coarsest LOD whose geometric error stays under a pixel on screen, see MeshSimplifier.\nFiner LODs are streamed in when an object needs them and evicted some seconds after the last one stopped, see Model::UpdateResidency.");
+		}
+		else {
+			ImGui::TextDisabled("LOD: loading");
+		}
 		ImGui::Spacing();
 
 		if(ImGui::DragFloat3("Position", userPosition, 0.01f, -1000.0f, 1000.0f, "%.2f", kSliderFlags)) {
@@ -825,6 +1135,30 @@ void Scene::Shutdown() {
 		kvp.second = nullptr;
 	}
 
+	if(m_TextureLoader) {
+		m_TextureLoader->Shutdown();
+		delete m_TextureLoader;
+		m_TextureLoader = nullptr;
+	}
+
+	if(m_TextureStreamer) {
+		m_TextureStreamer->Shutdown();
+		delete m_TextureStreamer;
+		m_TextureStreamer = nullptr;
+	}
+
+	for(std::pair kvp : m_PendingCubemapResources) {
+		kvp.second.hdrTexture->Shutdown();
+		delete kvp.second.hdrTexture;
+	}
+	m_PendingCubemapResources.clear();
+
+	for(Texture* placeholderTexture : m_PlaceholderTextures) {
+		placeholderTexture->Shutdown();
+		delete placeholderTexture;
+	}
+	m_PlaceholderTextures.clear();
+
 	for(std::pair kvp : m_LoadedTextureResources) {
 		for(size_t i = 0; i < kvp.second.size(); i++) {
 			kvp.second[i]->Shutdown();
@@ -839,6 +1173,19 @@ void Scene::Shutdown() {
 		kvp.second = nullptr;
 	}
 
+	if(m_StaticBatcher) {
+		m_StaticBatcher->Shutdown();
+		delete m_StaticBatcher;
+		m_StaticBatcher = nullptr;
+	}
+
+	// After the models and batches, which free their ranges on shutdown
+	if(m_GeometryArena) {
+		m_GeometryArena->Shutdown();
+		delete m_GeometryArena;
+		m_GeometryArena = nullptr;
+	}
+
 	for(size_t i = 0; i < m_GameObjects.size(); i++) {
 		delete m_GameObjects[i];
 		m_GameObjects[i] = nullptr;
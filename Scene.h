@@ -1,5 +1,6 @@
 #include <windows.h>
 
+#include <cstdint>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -25,6 +26,10 @@ class DirectionalLight;
 class Camera;
 class Bloom;
 class Input;
+class StaticBatcher;
+class GeometryArena;
+class TextureLoader;
+class TextureStreamer;
 
 class Scene {
 public:
@@ -36,12 +41,20 @@ public:
 	void Shutdown();
 	
 	// Render objects to scene quad
+	// Once per frame before rendering: runs the budgeted texture upload stage and swaps in skyboxes whose HDR map finished loading
+	bool UpdateTextureUploads();
+
 	bool RenderScene(XMMATRIX projectionMatrix, float time);
 	bool RenderSceneWithCullDebugCamera(XMMATRIX projectionMatrix, Camera* camera, float time);
 	// Render final output with post processing
 	bool RenderPostProcess(int indexCount, XMMATRIX worldMatrix, XMMATRIX viewMatrix, XMMATRIX orthoMatrix, ID3D11ShaderResourceView* textureSRV);
 
 	bool RenderDirectionalLightSceneDepth(float time);
+
+	// Closest enabled object hit by a world space ray, objects are tested as placed in the last RenderScene call
+	// Culled per object by bounding sphere, then against the model's BVH (see MeshBVH)
+	bool RayCast(XMFLOAT3 origin, XMFLOAT3 direction, int& hitObjectIndex, float& hitDistance) const;
+
 	void ProcessInput(Input* input, float deltaTime);
 
 	bool ResizeWindow(ID3D11Device* device, ID3D11DeviceContext* deviceContext, int screenWidth, int screenHeight, float nearZ, float farZ);
@@ -53,9 +66,12 @@ public:
 	RenderTexture* GetDebugBloomOutput() const;
 
 private:
-	bool LoadPBRTextureResource(const std::string& textureFileName);
+	// b_IsUrgent loads ahead of everything else, for materials picked in the UI
+	void LoadPBRTextureResource(const std::string& textureFileName, bool b_IsUrgent = false);
 	bool LoadModelResource(const std::string& modelFileName);
-	bool LoadCubemapResource(const std::string& hdrFileName);
+	void LoadCubemapResource(const std::string& hdrFileName);
+	// Builds the skyboxes whose HDR map is uploaded, and switches to the requested one once it is built
+	bool FinishCubemapResources();
 	bool LoadPBRShader(ID3D11Device* device, HWND hwnd);
 
 private:
@@ -67,6 +83,8 @@ private:
 	DepthShader* m_DepthShaderInstance {};
 
 	int m_CurrentCubemapIndex {};
+	// Picked in the UI, becomes current once loaded
+	int m_RequestedCubemapIndex {};
 	DirectionalLight* m_DirectionalLight {};
 	RenderTexture* m_DirectionalShadowMapRenderTexture {};
 
@@ -79,6 +97,32 @@ private:
 
 	bool mb_AnimateDirectionalLight {};
 
+	// Last RenderScene call's projection and time, so mouse picking tests what is on screen
+	XMMATRIX m_LastProjectionMatrix {};
+	float m_LastRenderTime {};
+
+	// Shared vertex and index buffers of every model and static batch
+	GeometryArena* m_GeometryArena {};
+	// Static objects sharing a material are drawn from merged world space buffers instead of one by one
+	StaticBatcher* m_StaticBatcher {};
+
+	// Decodes textures on worker threads, uploads them on the main thread
+	TextureLoader* m_TextureLoader {};
+	int m_TextureUploadBudgetKilobytes {};
+	float m_TextureUploadBudgetMilliseconds {};
+	// Material textures load their mip tail only, finer mips are streamed in by the objects' projected texel density under a memory budget
+	TextureStreamer* m_TextureStreamer {};
+	int m_TextureStreamingBudgetMegabytes {};
+	// Shared by every material texture until it is uploaded, in material texture order
+	std::vector<Texture*> m_PlaceholderTextures {};
+
+	struct PendingCubemap {
+		Texture* hdrTexture;
+		// TextureLoader::Handle, released once the load finished
+		uint32_t loadHandle;
+	};
+	std::unordered_map<std::string, PendingCubemap> m_PendingCubemapResources {};
+
 	std::vector<GameObject*> m_GameObjects {};
 	std::unordered_map<std::string, std::vector<Texture*>> m_LoadedTextureResources {};
 	std::unordered_map<std::string, Model*> m_LoadedModelResources {};
@@ -1,8 +1,25 @@
+#ifdef PACKED_VERTEX
+// Matches VertexDecodeParams (MeshData.h), bound by Model::Render
+cbuffer VertexDecodeBuffer : register(b0) {
+    float3 positionScale;
+    float padding0;
+    float3 positionBias;
+    float padding1;
+};
+
+// See PackedMeshVertex (MeshData.h), tangent frame is not needed for depth
+struct VertexInputType {
+    float4 position : POSITION; // unorm16, quantized to mesh AABB
+    float2 uv : TEXCOORD0;      // half
+    float2 normal : NORMAL;     // octahedral, snorm16
+};
+#else
 struct VertexInputType {
     float4 position : POSITION;
     float2 uv : TEXCOORD0;
     float3 normal : NORMAL;
 };
+#endif
 
 struct HullInputType {
     float4 position : POSITION;
@@ -10,10 +27,24 @@ struct HullInputType {
     float3 normal : NORMAL;
 };
 
+#ifdef PACKED_VERTEX
+float3 DecodeOctahedral(float2 e) {
+    float3 n = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    float fold = saturate(-n.z);
+    n.xy += n.xy >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+#endif
+
 HullInputType DepthVertexShader(VertexInputType i) {
     HullInputType o;
+#ifdef PACKED_VERTEX
+    o.position = float4(i.position.xyz * positionScale + positionBias, 1.0);
+    o.normal = DecodeOctahedral(i.normal);
+#else
     o.position = i.position;
-    o.uv = i.uv;
     o.normal = i.normal;
+#endif
+    o.uv = i.uv;
     return o;
 }
\ No newline at end of file
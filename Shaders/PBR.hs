@@ -62,7 +62,7 @@ ConstantOutputType PBRPatchConstantFunction(InputPatch<HullInputType, 3> inputPa
     float3 vertexPosition1 = mul(float4(inputPatch[1].position.xyz, 1.0), modelMatrix).xyz;
     float3 vertexPosition2 = mul(float4(inputPatch[2].position.xyz, 1.0), modelMatrix).xyz;
     
-    // Frustum culling - might not be worth doing when not tessellating (we also have object culling)
+    // Frustum culling - might not be worth doing when not tessellating (we also have object and meshlet culling on the CPU)
     if(TriangleIsCulled(vertexPosition0, vertexPosition1, vertexPosition2)) {
         output.edges[0] = output.edges[1] = output.edges[2] = output.inside = 0;
         return output;
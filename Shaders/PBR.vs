@@ -1,3 +1,20 @@
+#ifdef PACKED_VERTEX
+// Matches VertexDecodeParams (MeshData.h), bound by Model::Render
+cbuffer VertexDecodeBuffer : register(b0) {
+    float3 positionScale;
+    float padding0;
+    float3 positionBias;
+    float padding1;
+};
+
+// See PackedMeshVertex (MeshData.h) and VertexPacker for the encoding
+struct VertexInputType {
+    float4 position : POSITION; // unorm16, quantized to mesh AABB
+    float2 uv : TEXCOORD0;      // half
+    float2 normal : NORMAL;     // octahedral, snorm16
+    float4 qtangent : TANGENT;  // quaternion, snorm8, sign of w is binormal handedness
+};
+#else
 struct VertexInputType {
     float4 position : POSITION;
     float2 uv : TEXCOORD0;
@@ -5,6 +22,7 @@ struct VertexInputType {
     float3 tangent : TANGENT;
     float3 binormal : BINORMAL;
 };
+#endif
 
 struct HullInputType {
     float4 position : POSITION;
@@ -14,12 +32,41 @@ struct HullInputType {
     float3 binormal : BINORMAL;
 };
 
+#ifdef PACKED_VERTEX
+float3 DecodeOctahedral(float2 e) {
+    float3 n = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    float fold = saturate(-n.z);
+    n.xy += n.xy >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+
+// First column of the quaternion's rotation matrix
+float3 QuaternionTangent(float4 q) {
+    return float3(
+        1.0 - 2.0 * (q.y * q.y + q.z * q.z),
+        2.0 * (q.x * q.y + q.w * q.z),
+        2.0 * (q.x * q.z - q.w * q.y));
+}
+#endif
+
 HullInputType PBRVertexShader(VertexInputType i) {
     HullInputType o;
+#ifdef PACKED_VERTEX
+    o.position = float4(i.position.xyz * positionScale + positionBias, 1.0);
+    o.uv = i.uv;
+    o.normal = DecodeOctahedral(i.normal);
+
+    // Re-orthogonalize against the (more precise) octahedral normal, binormal is reconstructed
+    float handedness = i.qtangent.w < 0.0 ? -1.0 : 1.0;
+    float3 tangent = QuaternionTangent(normalize(i.qtangent));
+    o.tangent = normalize(tangent - o.normal * dot(o.normal, tangent));
+    o.binormal = cross(o.normal, o.tangent) * handedness;
+#else
     o.position = i.position;
     o.uv = i.uv;
     o.normal = i.normal;
     o.tangent = i.tangent;
     o.binormal = i.binormal;
+#endif
     return o;
 }
\ No newline at end of file
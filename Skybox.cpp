@@ -2,53 +2,17 @@
 #include "ShaderUtil.h"
 
 #include "QuadModel.h"
+#include "PrimitiveGenerator.h"
 #include "RenderTexture.h"
 #include "Texture.h"
 #include "D3DInstance.h"
 
 namespace {
-	constexpr int s_UnitCubeVertexCount = 36;
-	constexpr int s_UnitCubeIndexCount = 36;
+	// Indexed unit cube built at compile time, 4 vertices per face so each face gets its own uvs
+	constexpr auto s_UnitCube = PrimitiveGenerator::MakeUnitCube();
+	constexpr int s_UnitCubeVertexCount = (int)s_UnitCube.vertices.size();
+	constexpr int s_UnitCubeIndexCount = (int)s_UnitCube.indices.size();
 	constexpr int s_UnitQuadIndexCount = 6;
-	// x, y, z, u, v
-	constexpr float kUnitCubeVertices[] = {
-		-1.0 , 1.0, -1.0, 0.0 , 0.0,
-		 1.0 , 1.0, -1.0, 1.0 , 0.0,
-		-1.0, -1.0, -1.0, 0.0,  1.0,
-		-1.0, -1.0, -1.0, 0.0,  1.0,
-		 1.0 , 1.0, -1.0, 1.0 , 0.0,
-		 1.0 ,-1.0, -1.0, 1.0 , 1.0,
-		 1.0 , 1.0, -1.0, 0.0 , 0.0,
-		 1.0 , 1.0,  1.0, 1.0 , 0.0,
-		 1.0 ,-1.0, -1.0, 0.0 , 1.0,
-		 1.0 ,-1.0, -1.0, 0.0 , 1.0,
-		 1.0 , 1.0,  1.0, 1.0 , 0.0,
-		 1.0 ,-1.0,  1.0, 1.0 , 1.0,
-		 1.0 , 1.0,  1.0, 0.0 , 0.0,
-		-1.0,  1.0,  1.0, 1.0,  0.0,
-		 1.0 ,-1.0,  1.0, 0.0 , 1.0,
-		 1.0 ,-1.0,  1.0, 0.0 , 1.0,
-		-1.0,  1.0,  1.0, 1.0,  0.0,
-		-1.0, -1.0,  1.0, 1.0,  1.0,
-		-1.0,  1.0,  1.0, 0.0,  0.0,
-		-1.0,  1.0, -1.0, 1.0,  0.0,
-		-1.0, -1.0,  1.0, 0.0,  1.0,
-		-1.0, -1.0,  1.0, 0.0,  1.0,
-		-1.0,  1.0, -1.0, 1.0,  0.0,
-		-1.0, -1.0, -1.0, 1.0,  1.0,
-		-1.0,  1.0,  1.0, 0.0,  0.0,
-		 1.0 , 1.0,  1.0, 1.0 , 0.0,
-		-1.0,  1.0, -1.0, 0.0,  1.0,
-		-1.0,  1.0, -1.0, 0.0,  1.0,
-		 1.0 , 1.0,  1.0, 1.0 , 0.0,
-		 1.0 , 1.0, -1.0, 1.0 , 1.0,
-		-1.0, -1.0, -1.0, 0.0,  0.0,
-		 1.0 ,-1.0, -1.0, 1.0 , 0.0,
-		-1.0, -1.0,  1.0, 0.0,  1.0,
-		-1.0, -1.0,  1.0, 0.0,  1.0,
-		 1.0 ,-1.0, -1.0, 1.0 , 0.0,
-		 1.0 ,-1.0,  1.0, 1.0 , 1.0,
-	};
 
 	// View matrices for the 6 different cube directions
 	constexpr XMFLOAT3 float3_000  {0.0f,   0.0f,  0.0f};
@@ -74,7 +38,7 @@ namespace {
 	const std::wstring s_SkyboxRenderShaderName = L"CubeMap";
 }
 
-bool Skybox::Initialize(D3DInstance* d3dInstance, HWND hwnd, const std::string& fileName, int cubeFaceResolution, int cubeMapMipLevels, int irradianceMapResolution, int fullPrefilterMapResolution, int precomputedBRDFResolution, XMMATRIX screenDisplayViewMatrix, XMMATRIX screenOrthoMatrix, QuadModel* screenDisplayQuad) {
+bool Skybox::Initialize(D3DInstance* d3dInstance, HWND hwnd, Texture* hdrTexture, int cubeFaceResolution, int cubeMapMipLevels, int irradianceMapResolution, int fullPrefilterMapResolution, int precomputedBRDFResolution, XMMATRIX screenDisplayViewMatrix, XMMATRIX screenOrthoMatrix, QuadModel* screenDisplayQuad) {
 	bool result;
 
 	ID3D11Device* device = d3dInstance->GetDevice();
@@ -86,15 +50,9 @@ bool Skybox::Initialize(D3DInstance* d3dInstance, HWND hwnd, const std::string&
 
 	d3dInstance->SetToFrontCullRasterState();
 
-	/// Load HDR cubemap texture from disk and render to 6 cubemap textures to build skybox
-	// NOTE: HDRTexture defaults to no mipmaps
-	m_HDRCubeMapTex = new Texture();
-	result = m_HDRCubeMapTex->Initialize(device, deviceContext, "./data/cubemaps/" + fileName + ".hdr", DXGI_FORMAT_R32G32B32A32_FLOAT, 1);
-	if(!result) {
-		return false;
-	}
+	m_HDRCubeMapTex = hdrTexture;
 
-	/// Load HDR cubemap texture from disk and render to 6 cubemap textures to build skybox
+	/// Render HDR texture to 6 cubemap textures to build skybox
 	m_CubeMapTex = new RenderTexture();
 	m_CubeMapTex->Initialize(device, deviceContext, cubeFaceResolution, cubeFaceResolution, 0.1f, 10.0f,
 		DXGI_FORMAT_R32G32B32A32_FLOAT, XMConvertToRadians(90.0f),
@@ -115,6 +73,11 @@ bool Skybox::Initialize(D3DInstance* d3dInstance, HWND hwnd, const std::string&
 		result = Render(deviceContext, kCubeMapCaptureViewMats[i], cubemapCapturecaptureProjectionMatrix, kHDRCaptureRender);
 		if(!result) return false;
 	}
+
+	// The equirectangular map is only sampled by the capture above, so it doesn't stay in memory next to the cubemap
+	m_HDRCubeMapTex->Shutdown();
+	delete m_HDRCubeMapTex;
+	m_HDRCubeMapTex = nullptr;
 	
 	// Generate mipmaps for completed skybox (for prefilter step)
 	deviceContext->GenerateMips(m_CubeMapTex->GetTextureSRV());
@@ -225,15 +188,8 @@ bool Skybox::InitializeStaticResources(D3DInstance* d3dInstance, HWND hwnd, int
 }
 
 bool Skybox::InitializeUnitCubeBuffers(ID3D11Device* device) {
-	VertexType* vertices = new VertexType[s_UnitCubeVertexCount];
-	unsigned long* indices = new unsigned long[s_UnitCubeIndexCount];
-
-	// Load the vertex array and index array with hard coded unit cube data
-	for(int i = 0, j = 0; i < s_UnitCubeVertexCount; i++, j += 5) {
-		vertices[i].position = XMFLOAT3(kUnitCubeVertices[j], kUnitCubeVertices[j + 1], kUnitCubeVertices[j + 2]);
-		vertices[i].uv = XMFLOAT2(kUnitCubeVertices[j + 3], kUnitCubeVertices[j + 4]);
-		indices[i] = i;
-	}
+	// The compile time cube is uploaded as is, its vertices already match VertexType
+	static_assert(sizeof(VertexType) == sizeof(PrimitiveGenerator::SimpleVertex), "Skybox vertex layout must match PrimitiveGenerator::SimpleVertex");
 
 	// Set up the description of the static vertex buffer
 	D3D11_BUFFER_DESC vertexBufferDesc {};
@@ -246,7 +202,7 @@ bool Skybox::InitializeUnitCubeBuffers(ID3D11Device* device) {
 
 	// Give the subresource structure a pointer to the vertex data
 	D3D11_SUBRESOURCE_DATA vertexData {};
-	vertexData.pSysMem = vertices;
+	vertexData.pSysMem = s_UnitCube.vertices.data();
 	vertexData.SysMemPitch = 0;
 	vertexData.SysMemSlicePitch = 0;
 
@@ -259,7 +215,7 @@ bool Skybox::InitializeUnitCubeBuffers(ID3D11Device* device) {
 	// Set up the description of the static index buffer
 	D3D11_BUFFER_DESC indexBufferDesc {};
 	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	indexBufferDesc.ByteWidth = sizeof(unsigned long) * s_UnitCubeIndexCount;
+	indexBufferDesc.ByteWidth = sizeof(uint32_t) * s_UnitCubeIndexCount;
 	indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	indexBufferDesc.CPUAccessFlags = 0;
 	indexBufferDesc.MiscFlags = 0;
@@ -267,7 +223,7 @@ bool Skybox::InitializeUnitCubeBuffers(ID3D11Device* device) {
 
 	// Give the subresource structure a pointer to the index data
 	D3D11_SUBRESOURCE_DATA indexData {};
-	indexData.pSysMem = indices;
+	indexData.pSysMem = s_UnitCube.indices.data();
 	indexData.SysMemPitch = 0;
 	indexData.SysMemSlicePitch = 0;
 
@@ -277,12 +233,6 @@ bool Skybox::InitializeUnitCubeBuffers(ID3D11Device* device) {
 		return false;
 	}
 
-	delete[] vertices;
-	vertices = nullptr;
-
-	delete[] indices;
-	indices = nullptr;
-
 	return true;
 }
 
@@ -568,6 +518,7 @@ void Skybox::Shutdown() {
 	/// Textures
 	if(m_HDRCubeMapTex) {
 		m_HDRCubeMapTex->Shutdown();
+		delete m_HDRCubeMapTex;
 		m_HDRCubeMapTex = nullptr;
 	}
 
@@ -30,7 +30,8 @@ public:
     Skybox(const Skybox&) {}
     ~Skybox() {}
 
-    bool Initialize(D3DInstance* d3dInstance, HWND hwnd, const std::string& fileName, int cubeFaceResolution, int cubeMapMipLevels, int irradianceMapResolution, int fullPrefilterMapResolution, int precomputedBRDFResolution, XMMATRIX screenDisplayViewMatrix, XMMATRIX screenOrthoMatrix, QuadModel* screenDisplayQuad);
+    // Takes ownership of hdrTexture, an equirectangular HDR map loaded without mipmaps (see TextureLoader), and frees it once the cubemap is captured
+    bool Initialize(D3DInstance* d3dInstance, HWND hwnd, Texture* hdrTexture, int cubeFaceResolution, int cubeMapMipLevels, int irradianceMapResolution, int fullPrefilterMapResolution, int precomputedBRDFResolution, XMMATRIX screenDisplayViewMatrix, XMMATRIX screenOrthoMatrix, QuadModel* screenDisplayQuad);
 
     void Shutdown();
     bool Render(ID3D11DeviceContext* deviceContext, XMMATRIX viewMatrix, XMMATRIX projectionMatrix, RenderType renderType, float roughness = 0);
@@ -0,0 +1,412 @@
+#include "StaticBatcher.h"
+
+#include "PBRShader.h"
+#include "DepthShader.h"
+#include "DirectionalLight.h"
+#include "Camera.h"
+#include "Model.h"
+#include "VertexPacker.h"
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+	// A batch of one object saves no draw calls and loses meshlet culling, so such objects are drawn on their own
+	constexpr size_t s_MinBatchObjectCount = 2;
+
+	// Everything the shaders read from GameObjectData, objects must agree on all of it to share a draw
+	bool IsSameShading(const GameObject::GameObjectData& a, const GameObject::GameObjectData& b) {
+		return a.materialName == b.materialName && a.uvScale == b.uvScale && a.vertexDisplacementMapScale == b.vertexDisplacementMapScale
+			&& a.parallaxMapHeightScale == b.parallaxMapHeightScale && a.minRoughness == b.minRoughness && a.useParallaxShadow == b.useParallaxShadow
+			&& a.minParallaxLayers == b.minParallaxLayers && a.maxParallaxLayers == b.maxParallaxLayers && a.tessellationMode == b.tessellationMode
+			&& a.uniformTessellationFactor == b.uniformTessellationFactor && a.edgeTessellationLength == b.edgeTessellationLength;
+	}
+
+	bool IsSamePlacement(const GameObject::GameObjectData& a, const GameObject::GameObjectData& b) {
+		return a.modelName == b.modelName && a.yRotSpeed == b.yRotSpeed
+			&& a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z
+			&& a.scale.x == b.scale.x && a.scale.y == b.scale.y && a.scale.z == b.scale.z;
+	}
+
+	// Note: batched vertices are displaced along their world space normal in world units, the per object path displaces in model space before scaling
+	// The two only match for unscaled objects, so scaled objects with displacement are never batched
+	bool IsStatic(const GameObject::GameObjectData& data) {
+		if(data.yRotSpeed != 0.0f) {
+			return false;
+		}
+		bool b_IsUnscaled = data.scale.x == 1.0f && data.scale.y == 1.0f && data.scale.z == 1.0f;
+		return data.vertexDisplacementMapScale == 0.0f || b_IsUnscaled;
+	}
+
+	bool CreateConstantBuffer(ID3D11Device* device, const void* data, size_t byteWidth, ID3D11Buffer** buffer) {
+		D3D11_BUFFER_DESC bufferDesc {};
+		bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		bufferDesc.ByteWidth = (unsigned int)byteWidth;
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		bufferDesc.CPUAccessFlags = 0;
+		bufferDesc.MiscFlags = 0;
+		bufferDesc.StructureByteStride = 0;
+
+		D3D11_SUBRESOURCE_DATA subresourceData {};
+		subresourceData.pSysMem = data;
+
+		return SUCCEEDED(device->CreateBuffer(&bufferDesc, &subresourceData, buffer));
+	}
+}
+
+bool StaticBatcher::Initialize(PBRShader* pbrShaderInstance, DepthShader* depthShaderInstance, GeometryArena* geometryArena) {
+	if(!pbrShaderInstance || !depthShaderInstance) {
+		return false;
+	}
+
+	m_PBRShaderInstance = pbrShaderInstance;
+	m_DepthShaderInstance = depthShaderInstance;
+	m_GeometryArena = geometryArena;
+	m_VertexFormat = geometryArena->GetVertexFormat();
+	return true;
+}
+
+void StaticBatcher::Shutdown() {
+	for(Batch& batch : m_Batches) {
+		ReleaseBatchBuffers(batch);
+	}
+	m_Batches.clear();
+	m_ObjectStates.clear();
+}
+
+bool StaticBatcher::Update(ID3D11Device* device, const std::vector<GameObject*>& gameObjects) {
+	// Objects are identified by index, start over if the scene's object list changed
+	bool b_IsFirstUpdate = m_ObjectStates.size() != gameObjects.size();
+	if(b_IsFirstUpdate) {
+		Shutdown();
+		m_ObjectStates.resize(gameObjects.size());
+	}
+
+	/// Regroup objects that changed since the last update
+	for(size_t i = 0; i < gameObjects.size(); i++) {
+		const GameObject::GameObjectData& data = gameObjects[i]->GetGameObjectData();
+		ObjectState& state = m_ObjectStates[i];
+		Model* model = gameObjects[i]->GetModel();
+		bool b_IsModelLoaded = model && model->IsLoaded();
+		if(!b_IsFirstUpdate && state.model == model && state.isModelLoaded == b_IsModelLoaded && IsSamePlacement(state.data, data) && IsSameShading(state.data, data)) {
+			continue;
+		}
+
+		if(state.batchIndex >= 0) {
+			m_Batches[state.batchIndex].isDirty = true;
+		}
+		state.data = data;
+		state.model = model;
+		state.isModelLoaded = b_IsModelLoaded;
+		state.batchIndex = -1;
+		if(!b_IsModelLoaded || !IsStatic(data)) {
+			continue;
+		}
+
+		// Join the batch with the same shading, or start a new one
+		for(size_t b = 0; b < m_Batches.size() && state.batchIndex < 0; b++) {
+			if(IsSameShading(m_Batches[b].shadingData, data)) {
+				state.batchIndex = (int)b;
+			}
+		}
+		if(state.batchIndex < 0) {
+			state.batchIndex = (int)m_Batches.size();
+			m_Batches.emplace_back();
+			m_Batches.back().shadingData = data;
+		}
+		m_Batches[state.batchIndex].isDirty = true;
+	}
+
+	/// Rebuild the batches objects left or joined
+	bool result = true;
+	for(size_t b = 0; b < m_Batches.size(); b++) {
+		Batch& batch = m_Batches[b];
+		if(!batch.isDirty) {
+			continue;
+		}
+		batch.isDirty = false;
+
+		batch.objectIndices.clear();
+		for(size_t i = 0; i < m_ObjectStates.size(); i++) {
+			if(m_ObjectStates[i].batchIndex == (int)b) {
+				batch.objectIndices.push_back(i);
+			}
+		}
+		if(!batch.objectIndices.empty() && !RebuildBatch(device, gameObjects, batch)) {
+			result = false;
+		}
+	}
+
+	/// Drop batches that lost all of their objects
+	std::vector<int> batchRemap(m_Batches.size(), -1);
+	size_t keptBatchCount = 0;
+	for(size_t b = 0; b < m_Batches.size(); b++) {
+		if(m_Batches[b].objectIndices.empty()) {
+			ReleaseBatchBuffers(m_Batches[b]);
+			continue;
+		}
+		batchRemap[b] = (int)keptBatchCount;
+		m_Batches[keptBatchCount++] = m_Batches[b];
+	}
+	m_Batches.resize(keptBatchCount);
+	for(ObjectState& state : m_ObjectStates) {
+		if(state.batchIndex >= 0) {
+			state.batchIndex = batchRemap[state.batchIndex];
+		}
+	}
+
+	m_Stats.batchCount = 0;
+	m_Stats.objectCount = 0;
+	for(const Batch& batch : m_Batches) {
+		if(IsActiveBatch(batch)) {
+			m_Stats.batchCount++;
+			m_Stats.objectCount += (int)batch.objectIndices.size();
+		}
+	}
+
+	return result;
+}
+
+bool StaticBatcher::IsBatched(size_t gameObjectIndex) const {
+	if(!mb_IsEnabled || gameObjectIndex >= m_ObjectStates.size() || m_ObjectStates[gameObjectIndex].batchIndex < 0) {
+		return false;
+	}
+	return IsActiveBatch(m_Batches[m_ObjectStates[gameObjectIndex].batchIndex]);
+}
+
+bool StaticBatcher::Render(ID3D11DeviceContext* deviceContext, const std::vector<GameObject*>& gameObjects, XMMATRIX projectionMatrix, float viewportHeight, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, Camera* cullFrustumCamera, float time) {
+	m_Stats.drawCallCount = 0;
+	if(!mb_IsEnabled) {
+		return true;
+	}
+
+	for(const Batch& batch : m_Batches) {
+		if(!IsActiveBatch(batch)) {
+			continue;
+		}
+
+		// Visible objects at their picked LOD
+		m_DrawRanges.clear();
+		for(size_t i = 0; i < batch.objectIndices.size(); i++) {
+			GameObject* gameObject = gameObjects[batch.objectIndices[i]];
+			if(gameObject->CullAndSelectLOD(projectionMatrix, viewportHeight, cullFrustumCamera, time)) {
+				m_DrawRanges.push_back(batch.lodRanges[i][gameObject->GetCurrentLOD()]);
+			}
+		}
+		if(m_DrawRanges.empty()) {
+			continue;
+		}
+		MergeDrawRanges(m_DrawRanges);
+
+		// Vertices are already in world space
+		BindBatch(deviceContext, batch, false);
+		GeometryArena::Range geometryRange = m_GeometryArena->GetRange(batch.arenaHandle);
+		if(!m_PBRShaderInstance->Render(deviceContext, m_DrawRanges, geometryRange.firstIndex, (int)geometryRange.baseVertex, m_VertexFormat, XMMatrixIdentity(), projectionMatrix, batch.materialTextures, shadowMap, skybox, light, camera, cullFrustumCamera->GetFrustumPlanes(), time, batch.shadingData)) {
+			return false;
+		}
+		m_Stats.drawCallCount += (int)m_DrawRanges.size();
+	}
+
+	return true;
+}
+
+bool StaticBatcher::RenderToDepth(ID3D11DeviceContext* deviceContext, const std::vector<GameObject*>& gameObjects, DirectionalLight* light) {
+	if(!mb_IsEnabled) {
+		return true;
+	}
+
+	XMMATRIX lightView {};
+	XMMATRIX lightProjection {};
+	light->GetViewMatrix(lightView);
+	light->GetOrthoMatrix(lightProjection);
+
+	for(const Batch& batch : m_Batches) {
+		if(!IsActiveBatch(batch)) {
+			continue;
+		}
+
+		// Note: the depth pass runs after Render, so these are the LODs it picked
+		m_DrawRanges.clear();
+		for(size_t i = 0; i < batch.objectIndices.size(); i++) {
+			GameObject* gameObject = gameObjects[batch.objectIndices[i]];
+			if(gameObject->GetEnabled()) {
+				m_DrawRanges.push_back(batch.lodRanges[i][gameObject->GetCurrentLOD()]);
+			}
+		}
+		if(m_DrawRanges.empty()) {
+			continue;
+		}
+		MergeDrawRanges(m_DrawRanges);
+
+		BindBatch(deviceContext, batch, true);
+		GeometryArena::Range geometryRange = m_GeometryArena->GetRange(batch.arenaHandle);
+		for(const MeshletCuller::DrawRange& drawRange : m_DrawRanges) {
+			if(!m_DepthShaderInstance->Render(deviceContext, (int)drawRange.indexCount, (int)(geometryRange.firstIndex + drawRange.firstIndex), (int)geometryRange.baseVertex, m_VertexFormat, XMMatrixIdentity(), lightView, lightProjection, batch.materialTextures[2], batch.shadingData)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void StaticBatcher::MergeObjects(const std::vector<BatchSource>& sources, MeshData& mergedMesh, std::vector<std::vector<MeshletCuller::DrawRange>>& lodRanges) {
+	mergedMesh = MeshData {};
+	lodRanges.assign(sources.size(), {});
+
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	size_t maxLODCount = 0;
+	for(const BatchSource& source : sources) {
+		vertexCount += source.vertices->size();
+		for(const MeshLOD& lod : *source.lods) {
+			indexCount += lod.indexCount;
+		}
+		maxLODCount = std::max(maxLODCount, source.lods->size());
+	}
+	mergedMesh.vertices.reserve(vertexCount);
+	mergedMesh.indices.reserve(indexCount);
+
+	/// World space vertices
+	// Tangent frames are transformed by the world matrix and renormalized, same as PBR.ds does for unbatched objects
+	std::vector<uint32_t> baseVertices(sources.size());
+	for(size_t i = 0; i < sources.size(); i++) {
+		XMMATRIX worldMatrix = XMLoadFloat4x4(&sources[i].worldMatrix);
+		baseVertices[i] = (uint32_t)mergedMesh.vertices.size();
+		for(const MeshVertex& vertex : *sources[i].vertices) {
+			MeshVertex worldVertex = vertex;
+			XMStoreFloat3(&worldVertex.position, XMVector3TransformCoord(XMLoadFloat3(&vertex.position), worldMatrix));
+			XMStoreFloat3(&worldVertex.normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.normal), worldMatrix)));
+			XMStoreFloat3(&worldVertex.tangent, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.tangent), worldMatrix)));
+			XMStoreFloat3(&worldVertex.binormal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.binormal), worldMatrix)));
+			mergedMesh.vertices.push_back(worldVertex);
+		}
+	}
+
+	/// Indices, LOD major
+	for(size_t lodIndex = 0; lodIndex < maxLODCount; lodIndex++) {
+		for(size_t i = 0; i < sources.size(); i++) {
+			if(lodIndex >= sources[i].lods->size()) {
+				continue;
+			}
+
+			const MeshLOD& lod = (*sources[i].lods)[lodIndex];
+			lodRanges[i].push_back(MeshletCuller::DrawRange {(uint32_t)mergedMesh.indices.size(), lod.indexCount});
+			for(uint32_t j = 0; j < lod.indexCount; j++) {
+				mergedMesh.indices.push_back((*sources[i].indices)[lod.firstIndex + j] + baseVertices[i]);
+			}
+		}
+	}
+}
+
+void StaticBatcher::MergeDrawRanges(std::vector<MeshletCuller::DrawRange>& drawRanges) {
+	std::sort(drawRanges.begin(), drawRanges.end(), [](const MeshletCuller::DrawRange& a, const MeshletCuller::DrawRange& b) { return a.firstIndex < b.firstIndex; });
+
+	size_t mergedCount = 0;
+	for(size_t i = 0; i < drawRanges.size(); i++) {
+		if(mergedCount > 0) {
+			MeshletCuller::DrawRange& last = drawRanges[mergedCount - 1];
+			uint32_t lastEnd = last.firstIndex + last.indexCount;
+			if(drawRanges[i].firstIndex <= lastEnd) {
+				last.indexCount = std::max(lastEnd, drawRanges[i].firstIndex + drawRanges[i].indexCount) - last.firstIndex;
+				continue;
+			}
+		}
+		drawRanges[mergedCount++] = drawRanges[i];
+	}
+	drawRanges.resize(mergedCount);
+}
+
+bool StaticBatcher::RebuildBatch(ID3D11Device* device, const std::vector<GameObject*>& gameObjects, Batch& batch) {
+	ReleaseBatchBuffers(batch);
+	batch.lodRanges.clear();
+
+	GameObject* firstObject = gameObjects[batch.objectIndices[0]];
+	batch.shadingData = firstObject->GetGameObjectData();
+	batch.materialTextures = firstObject->GetMaterialTextures();
+	if(batch.objectIndices.size() < s_MinBatchObjectCount) {
+		return true;
+	}
+
+	// Models are read back once per batch, objects often share one
+	struct ModelGeometry {
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+	};
+	std::unordered_map<Model*, ModelGeometry> modelGeometries {};
+	std::vector<BatchSource> sources {};
+	sources.reserve(batch.objectIndices.size());
+	for(size_t objectIndex : batch.objectIndices) {
+		GameObject* gameObject = gameObjects[objectIndex];
+		Model* model = gameObject->GetModel();
+		auto [it, b_Inserted] = modelGeometries.try_emplace(model);
+		if(b_Inserted) {
+			model->GetMeshVertices(it->second.vertices);
+			model->GetIndices(it->second.indices);
+		}
+
+		// Static objects have no rotation, any time gives the same matrix
+		BatchSource source {&it->second.vertices, &it->second.indices, &model->GetLODs()};
+		XMStoreFloat4x4(&source.worldMatrix, gameObject->GetWorldMatrix(0.0f));
+		sources.push_back(source);
+	}
+
+	MeshData mergedMesh {};
+	MergeObjects(sources, mergedMesh, batch.lodRanges);
+	std::cout << "Static batch (" << batch.shadingData.materialName << "): " << batch.objectIndices.size() << " objects, " << mergedMesh.vertices.size() << " vertices, " << mergedMesh.indices.size() / 3 << " triangles (all LODs)\n";
+
+	// Encode vertices in the same format as the models, packed positions are quantized to the batch's world space AABB
+	const void* vertexData = mergedMesh.vertices.data();
+	VertexDecodeParams decodeParams {};
+	std::vector<PackedMeshVertex> packedVertices {};
+	if(m_VertexFormat == kPackedVertexFormat) {
+		VertexPacker::PackVertices(mergedMesh.vertices, packedVertices, decodeParams);
+		vertexData = packedVertices.data();
+	}
+
+	if(m_VertexFormat == kPackedVertexFormat && !CreateConstantBuffer(device, &decodeParams, sizeof(VertexDecodeParams), &batch.vertexDecodeBuffer)) {
+		ReleaseBatchBuffers(batch);
+		return false;
+	}
+
+	// Uploaded by the arena's next Flush, the scene flushes after Update
+	std::vector<unsigned char> splitStreams[Num_VertexStreams] {};
+	SplitVertexStreams(vertexData, mergedMesh.vertices.size(), m_VertexFormat, splitStreams);
+	const void* const vertexStreams[Num_VertexStreams] {splitStreams[kGeometryVertexStream].data(), splitStreams[kTangentVertexStream].data()};
+	uint32_t indexStride = GetIndexStride(mergedMesh.vertices.size());
+	std::vector<unsigned char> packedIndices = PackIndices(mergedMesh.indices, indexStride);
+	batch.arenaHandle = m_GeometryArena->Add(vertexStreams, (uint32_t)mergedMesh.vertices.size(), packedIndices.data(), (uint32_t)mergedMesh.indices.size(), indexStride);
+	batch.indexStride = indexStride;
+	if(batch.arenaHandle == GeometryArena::kInvalidHandle) {
+		ReleaseBatchBuffers(batch);
+		return false;
+	}
+
+	return true;
+}
+
+void StaticBatcher::BindBatch(ID3D11DeviceContext* deviceContext, const Batch& batch, bool isDepthOnly) const {
+	// Same bindings as Model::Render
+	m_GeometryArena->Bind(deviceContext, batch.indexStride, isDepthOnly);
+	if(m_VertexFormat == kPackedVertexFormat) {
+		deviceContext->VSSetConstantBuffers(0, 1, &batch.vertexDecodeBuffer);
+	}
+	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
+}
+
+void StaticBatcher::ReleaseBatchBuffers(Batch& batch) const {
+	if(batch.arenaHandle != GeometryArena::kInvalidHandle) {
+		m_GeometryArena->Remove(batch.arenaHandle);
+		batch.arenaHandle = GeometryArena::kInvalidHandle;
+	}
+
+	if(batch.vertexDecodeBuffer) {
+		batch.vertexDecodeBuffer->Release();
+		batch.vertexDecodeBuffer = nullptr;
+	}
+}
+
+bool StaticBatcher::IsActiveBatch(const Batch& batch) {
+	return batch.arenaHandle != GeometryArena::kInvalidHandle;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <d3d11.h>
+#include <directxmath.h>
+#include <vector>
+
+#include "GameObject.h"
+#include "GeometryArena.h"
+#include "MeshData.h"
+#include "MeshletCuller.h"
+
+class PBRShader;
+class DepthShader;
+class DirectionalLight;
+class Camera;
+class Skybox;
+class Texture;
+class Model;
+
+using namespace DirectX;
+
+// Merges static objects (no y rotation) that share a material and all shading parameters into world space vertices and indices, one range of the GeometryArena per batch
+// A batch binds its constant buffers and SRVs once, the visible objects' index ranges are merged into as few DrawIndexed calls as possible
+// Indices are laid out LOD major (every object's LOD 0, then every object's LOD 1, ...) so neighbouring objects at the same LOD merge into one range
+// Culling and LOD selection stay per object (see GameObject::CullAndSelectLOD), meshlet culling is skipped for batched objects
+class StaticBatcher {
+public:
+	struct BatchStats {
+		int batchCount;
+		int objectCount;
+		int drawCallCount;
+	};
+
+	// Source of one object in a batch, see MergeObjects
+	struct BatchSource {
+		const std::vector<MeshVertex>* vertices;
+		const std::vector<uint32_t>* indices;
+		const std::vector<MeshLOD>* lods;
+		XMFLOAT4X4 worldMatrix;
+	};
+
+public:
+	StaticBatcher() {}
+	StaticBatcher(const StaticBatcher&) {}
+	~StaticBatcher() {}
+
+	// Batches are sub-allocated from geometryArena like models, so it must outlive the batcher
+	// The shaders are kept and used as they are, they must be built already (false if either is missing)
+	bool Initialize(PBRShader* pbrShaderInstance, DepthShader* depthShaderInstance, GeometryArena* geometryArena);
+	void Shutdown();
+
+	// Compares every object with its state at the last call, objects that changed (e.g. edited in IMGUI) are regrouped
+	// Only the batches they left or joined are rebuilt
+	bool Update(ID3D11Device* device, const std::vector<GameObject*>& gameObjects);
+
+	// True if the object is drawn by a batch, i.e. the scene must not draw it itself
+	bool IsBatched(size_t gameObjectIndex) const;
+
+	bool Render(ID3D11DeviceContext* deviceContext, const std::vector<GameObject*>& gameObjects, XMMATRIX projectionMatrix, float viewportHeight, ID3D11ShaderResourceView* shadowMap, Skybox* skybox, DirectionalLight* light, Camera* camera, Camera* cullFrustumCamera, float time);
+	// Every enabled batched object at the LOD its last Render picked, like GameObject::RenderToDepth
+	bool RenderToDepth(ID3D11DeviceContext* deviceContext, const std::vector<GameObject*>& gameObjects, DirectionalLight* light);
+
+	// Disabled: every object is reported as not batched and drawn on its own, batches are kept up to date
+	void SetEnabled(bool state) { mb_IsEnabled = state; }
+	bool GetEnabled() const { return mb_IsEnabled; }
+	const BatchStats& GetStats() const { return m_Stats; }
+
+	// Objects' vertices transformed to world space (tangent frames by the same matrix as PBR.ds) and appended into one mesh
+	// lodRanges[object][lod] receives each object's index range per LOD of its own model
+	static void MergeObjects(const std::vector<BatchSource>& sources, MeshData& mergedMesh, std::vector<std::vector<MeshletCuller::DrawRange>>& lodRanges);
+	// Sorts ranges by first index and joins ranges that touch or overlap
+	static void MergeDrawRanges(std::vector<MeshletCuller::DrawRange>& drawRanges);
+
+private:
+	struct Batch {
+		// Shading parameters shared by every object of the batch, taken from its first object
+		GameObject::GameObjectData shadingData {};
+		std::vector<Texture*> materialTextures {};
+
+		// Scene object indices in ascending order, lodRanges is parallel to it
+		std::vector<size_t> objectIndices {};
+		std::vector<std::vector<MeshletCuller::DrawRange>> lodRanges {};
+		bool isDirty {};
+
+		// Only added to the arena for batches of at least s_MinBatchObjectCount objects
+		GeometryArena::Handle arenaHandle {GeometryArena::kInvalidHandle};
+		uint32_t indexStride {};
+		ID3D11Buffer* vertexDecodeBuffer {};
+	};
+
+	// Object state at the last Update, compared to find edits
+	struct ObjectState {
+		GameObject::GameObjectData data {};
+		Model* model {};
+		// Objects join batches once their model finished loading
+		bool isModelLoaded {};
+		// Index into m_Batches, -1 if the object is not static
+		int batchIndex {-1};
+	};
+
+	bool RebuildBatch(ID3D11Device* device, const std::vector<GameObject*>& gameObjects, Batch& batch);
+	void BindBatch(ID3D11DeviceContext* deviceContext, const Batch& batch, bool isDepthOnly) const;
+	void ReleaseBatchBuffers(Batch& batch) const;
+	static bool IsActiveBatch(const Batch& batch);
+
+private:
+	PBRShader* m_PBRShaderInstance {};
+	DepthShader* m_DepthShaderInstance {};
+	GeometryArena* m_GeometryArena {};
+	VertexFormat m_VertexFormat {kFullVertexFormat};
+	bool mb_IsEnabled = true;
+
+	std::vector<Batch> m_Batches {};
+	std::vector<ObjectState> m_ObjectStates {};
+
+	// Reused every frame to avoid allocations
+	std::vector<MeshletCuller::DrawRange> m_DrawRanges {};
+	BatchStats m_Stats {};
+};
@@ -0,0 +1,145 @@
+#include "TangentGenerator.h"
+#include "TangentGeneratorLanes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <intrin.h>
+#include <memory>
+#include <thread>
+
+namespace {
+	// Smaller meshes are processed on a single thread, thread startup would cost more than the work
+	// Note: every vertex task scans the whole index buffer, so tasks are kept large
+	constexpr size_t s_MinTrianglesPerTask = 64 * 1024;
+	constexpr size_t s_MinVerticesPerTask  = 64 * 1024;
+
+	// Calls function(begin, end) on subranges of [0, count), one task per hardware thread at most
+	template<typename Function>
+	void ParallelFor(size_t count, size_t minCountPerTask, const Function& function) {
+		size_t taskCount = std::clamp<size_t>(count / minCountPerTask, 1, std::max(1u, std::thread::hardware_concurrency()));
+		if(taskCount == 1) {
+			function(0, count);
+			return;
+		}
+
+		std::vector<std::future<void>> futures(taskCount);
+		for(size_t i = 0; i < taskCount; i++) {
+			futures[i] = std::async(std::launch::async, function, count * i / taskCount, count * (i + 1) / taskCount);
+		}
+		for(std::future<void>& future : futures) {
+			future.get();
+		}
+	}
+
+	// Counts the corners of vertices [vertexBegin, vertexEnd), the lane kernels count them down as the corners are added
+	void CountCorners(const MeshData& meshData, uint32_t* remainingCorners, size_t vertexBegin, size_t vertexEnd) {
+		std::fill(remainingCorners + vertexBegin, remainingCorners + vertexEnd, 0u);
+		for(size_t i = 0; i < meshData.indices.size() / 3 * 3; i++) {
+			size_t v = meshData.indices[i];
+			if(v - vertexBegin < vertexEnd - vertexBegin) {
+				remainingCorners[v]++;
+			}
+		}
+	}
+
+	// AVX needs the CPU flag and the OS saving the upper halves of the registers on context switches (OSXSAVE and XCR0 bits 1 and 2)
+	bool IsAVXSupported() {
+		int cpuInfo[4];
+		__cpuid(cpuInfo, 1);
+		bool b_AVX = (cpuInfo[2] & (1 << 28)) != 0;
+		bool b_OSXSAVE = (cpuInfo[2] & (1 << 27)) != 0;
+		return b_AVX && b_OSXSAVE && (_xgetbv(0) & 0x6) == 0x6;
+	}
+}
+
+void TangentGenerator::GenerateTangents(MeshData& meshData) {
+	// Note: the project builds for the default arch, the 8 lane kernels of TangentGeneratorAVX.cpp are picked here at run time
+	static const bool b_UseAVX = IsAVXSupported();
+
+	size_t vertexCount = meshData.vertices.size();
+	size_t triangleCount = meshData.indices.size() / 3;
+
+	// Note: every entry is written by CountCorners before it is read, so the array is left uninitialized
+	std::unique_ptr<uint32_t[]> remainingCorners(new uint32_t[vertexCount]);
+
+	size_t taskCount = std::clamp<size_t>(triangleCount / s_MinTrianglesPerTask, 1, std::max(1u, std::thread::hardware_concurrency()));
+	if(taskCount == 1) {
+		/// Single thread: corner frames are added to their vertices as they are computed
+		CountCorners(meshData, remainingCorners.get(), 0, vertexCount);
+		if(b_UseAVX) {
+			TangentLanesAVX::AddTriangles(meshData, remainingCorners.get());
+		} else {
+			TangentLanesSSE::AddTriangles(meshData, remainingCorners.get());
+		}
+		return;
+	}
+
+	ParallelFor(vertexCount, s_MinVerticesPerTask, [&](size_t begin, size_t end) {
+		CountCorners(meshData, remainingCorners.get(), begin, end);
+	});
+
+	/// Corner frames in parallel, corners of shared vertices are stored in the tangent/binormal layout of MeshVertex (6 floats per corner)
+	// Note: corners are written before they are read and finished corners are never read, so the array is left uninitialized
+	std::unique_ptr<float[]> storedCorners(new float[triangleCount * 3 * 6]);
+	ParallelFor(triangleCount, s_MinTrianglesPerTask, [&](size_t begin, size_t end) {
+		if(b_UseAVX) {
+			TangentLanesAVX::StoreCorners(meshData, remainingCorners.get(), begin, end, storedCorners.get());
+		} else {
+			TangentLanesSSE::StoreCorners(meshData, remainingCorners.get(), begin, end, storedCorners.get());
+		}
+	});
+
+	/// Each task owns a vertex range and adds the corners that land in it, so no two tasks write the same vertex (no atomics)
+	ParallelFor(vertexCount, s_MinVerticesPerTask, [&](size_t begin, size_t end) {
+		if(b_UseAVX) {
+			TangentLanesAVX::AddStoredCorners(meshData, remainingCorners.get(), storedCorners.get(), begin, end);
+		} else {
+			TangentLanesSSE::AddStoredCorners(meshData, remainingCorners.get(), storedCorners.get(), begin, end);
+		}
+	});
+}
+
+void TangentGenerator::GenerateMissingNormals(MeshData& meshData) {
+	std::vector<bool> isMissing(meshData.vertices.size());
+	bool b_AnyMissing = false;
+	for(size_t i = 0; i < meshData.vertices.size(); i++) {
+		const XMFLOAT3& normal = meshData.vertices[i].normal;
+		isMissing[i] = normal.x == 0.0f && normal.y == 0.0f && normal.z == 0.0f;
+		b_AnyMissing |= isMissing[i];
+	}
+	if(!b_AnyMissing) {
+		return;
+	}
+
+	// Unnormalized cross product, its length is twice the triangle area
+	// Note: front faces are clockwise in a left handed system, so cross(p1 - p0, p2 - p0) points out of the front face
+	for(size_t t = 0; t + 2 < meshData.indices.size(); t += 3) {
+		const uint32_t* corners = &meshData.indices[t];
+		const XMFLOAT3& p0 = meshData.vertices[corners[0]].position;
+		const XMFLOAT3& p1 = meshData.vertices[corners[1]].position;
+		const XMFLOAT3& p2 = meshData.vertices[corners[2]].position;
+		float e1[3] {p1.x - p0.x, p1.y - p0.y, p1.z - p0.z};
+		float e2[3] {p2.x - p0.x, p2.y - p0.y, p2.z - p0.z};
+		float faceNormal[3] {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+
+		for(int corner = 0; corner < 3; corner++) {
+			if(isMissing[corners[corner]]) {
+				XMFLOAT3& normal = meshData.vertices[corners[corner]].normal;
+				normal.x += faceNormal[0];
+				normal.y += faceNormal[1];
+				normal.z += faceNormal[2];
+			}
+		}
+	}
+
+	for(size_t i = 0; i < meshData.vertices.size(); i++) {
+		if(!isMissing[i]) {
+			continue;
+		}
+
+		XMFLOAT3& normal = meshData.vertices[i].normal;
+		float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+		normal = length > 0.0f ? XMFLOAT3(normal.x / length, normal.y / length, normal.z / length) : XMFLOAT3(0.0f, 1.0f, 0.0f);
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "MeshData.h"
+
+// Per vertex tangent frames for indexed meshes (MikkTSpace style)
+// Each triangle corner contributes its face tangent/bitangent projected onto the vertex normal plane, weighted by the corner angle
+// Contributions are summed per vertex, so the mesh should be welded first for smooth tangents across shared vertices
+class TangentGenerator {
+public:
+	// Writes an orthonormal tangent and binormal to every vertex, binormal = cross(normal, tangent) * handedness
+	// Triangles with degenerate uvs contribute nothing, vertices without any contribution get an arbitrary tangent perpendicular to the normal
+	static void GenerateTangents(MeshData& meshData);
+
+	// Vertices with a zero normal (imported files without normals) get the area weighted average of their triangles' face normals
+	// Run before welding, vertices split by the source are not smoothed across each other
+	static void GenerateMissingNormals(MeshData& meshData);
+};
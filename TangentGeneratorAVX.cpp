@@ -0,0 +1,3 @@
+// TangentGenerator's lane kernels with 8 lanes, this file alone is compiled with /arch:AVX (see DX11Engine.vcxproj)
+// Note: TangentGenerator::GenerateTangents only calls TangentLanesAVX after checking the CPU and OS support AVX
+#include "TangentGeneratorLanes.h"
@@ -0,0 +1,490 @@
+#pragma once
+#include "MeshData.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+#include <emmintrin.h>
+
+// Lane kernels of TangentGenerator::GenerateTangents, included by two files so they are compiled once per instruction set:
+// TangentGenerator.cpp with the project's default arch (4 SSE lanes, TangentLanesSSE) and TangentGeneratorAVX.cpp with /arch:AVX (8 lanes, TangentLanesAVX)
+// Note: corner counting and threading stay in TangentGenerator.cpp, which only calls TangentLanesAVX when the CPU and OS support AVX
+
+/// Entry points, remainingCorners holds the corner count of every vertex (see CountCorners in TangentGenerator.cpp)
+namespace TangentLanesSSE {
+	// Single thread: adds the corner frames of every triangle to its vertices, every vertex is orthonormalized once its last corner is added
+	void AddTriangles(MeshData& meshData, uint32_t* remainingCorners);
+	// Finishes the single corner vertices of triangles [triangleBegin, triangleEnd) and stores the corners of shared vertices, 6 floats per corner
+	void StoreCorners(MeshData& meshData, uint32_t* remainingCorners, size_t triangleBegin, size_t triangleEnd, float* storedCorners);
+	// Adds the stored corners of vertices [vertexBegin, vertexEnd) that StoreCorners did not finish, then orthonormalizes them
+	void AddStoredCorners(MeshData& meshData, uint32_t* remainingCorners, const float* storedCorners, size_t vertexBegin, size_t vertexEnd);
+}
+
+namespace TangentLanesAVX {
+	// As above with 8 lanes, only to be called when the CPU and OS support AVX
+	void AddTriangles(MeshData& meshData, uint32_t* remainingCorners);
+	void StoreCorners(MeshData& meshData, uint32_t* remainingCorners, size_t triangleBegin, size_t triangleEnd, float* storedCorners);
+	void AddStoredCorners(MeshData& meshData, uint32_t* remainingCorners, const float* storedCorners, size_t vertexBegin, size_t vertexEnd);
+}
+
+namespace {
+	// UV area (determinant) below this is treated as degenerate
+	constexpr float s_DegenerateUVEpsilon = 1e-12f;
+
+	/// SoA helpers, one lane per triangle or vertex
+	// 8 lanes when compiled with AVX (TangentGeneratorAVX.cpp), 4 with SSE (TangentGenerator.cpp)
+#ifdef __AVX__
+	constexpr size_t s_LaneCount = 8;
+	using FloatN = __m256;
+
+	FloatN Set(float value) { return _mm256_set1_ps(value); }
+	FloatN Load(const float* values) { return _mm256_loadu_ps(values); }
+	void Store(float* values, FloatN v) { _mm256_storeu_ps(values, v); }
+	FloatN Add(FloatN a, FloatN b) { return _mm256_add_ps(a, b); }
+	FloatN Subtract(FloatN a, FloatN b) { return _mm256_sub_ps(a, b); }
+	FloatN Multiply(FloatN a, FloatN b) { return _mm256_mul_ps(a, b); }
+	FloatN Sqrt(FloatN v) { return _mm256_sqrt_ps(v); }
+	FloatN ReciprocalEstimate(FloatN v) { return _mm256_rcp_ps(v); }
+	FloatN ReciprocalSqrtEstimate(FloatN v) { return _mm256_rsqrt_ps(v); }
+	FloatN Min(FloatN a, FloatN b) { return _mm256_min_ps(a, b); }
+	FloatN And(FloatN a, FloatN b) { return _mm256_and_ps(a, b); }
+	FloatN AndNot(FloatN mask, FloatN b) { return _mm256_andnot_ps(mask, b); }
+	FloatN Xor(FloatN a, FloatN b) { return _mm256_xor_ps(a, b); }
+	FloatN Greater(FloatN a, FloatN b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	FloatN Less(FloatN a, FloatN b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	FloatN Select(FloatN mask, FloatN a, FloatN b) { return _mm256_blendv_ps(b, a, mask); }
+#else
+	constexpr size_t s_LaneCount = 4;
+	using FloatN = __m128;
+
+	FloatN Set(float value) { return _mm_set1_ps(value); }
+	FloatN Load(const float* values) { return _mm_loadu_ps(values); }
+	void Store(float* values, FloatN v) { _mm_storeu_ps(values, v); }
+	FloatN Add(FloatN a, FloatN b) { return _mm_add_ps(a, b); }
+	FloatN Subtract(FloatN a, FloatN b) { return _mm_sub_ps(a, b); }
+	FloatN Multiply(FloatN a, FloatN b) { return _mm_mul_ps(a, b); }
+	FloatN Sqrt(FloatN v) { return _mm_sqrt_ps(v); }
+	FloatN ReciprocalEstimate(FloatN v) { return _mm_rcp_ps(v); }
+	FloatN ReciprocalSqrtEstimate(FloatN v) { return _mm_rsqrt_ps(v); }
+	FloatN Min(FloatN a, FloatN b) { return _mm_min_ps(a, b); }
+	FloatN And(FloatN a, FloatN b) { return _mm_and_ps(a, b); }
+	FloatN AndNot(FloatN mask, FloatN b) { return _mm_andnot_ps(mask, b); }
+	FloatN Xor(FloatN a, FloatN b) { return _mm_xor_ps(a, b); }
+	FloatN Greater(FloatN a, FloatN b) { return _mm_cmpgt_ps(a, b); }
+	FloatN Less(FloatN a, FloatN b) { return _mm_cmplt_ps(a, b); }
+	FloatN Select(FloatN mask, FloatN a, FloatN b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#endif
+
+	struct Vec3N {
+		FloatN x, y, z;
+	};
+
+	Vec3N Subtract(const Vec3N& a, const Vec3N& b) { return Vec3N {Subtract(a.x, b.x), Subtract(a.y, b.y), Subtract(a.z, b.z)}; }
+	Vec3N Scale(const Vec3N& v, FloatN s) { return Vec3N {Multiply(v.x, s), Multiply(v.y, s), Multiply(v.z, s)}; }
+	Vec3N Select(FloatN mask, const Vec3N& a, const Vec3N& b) { return Vec3N {Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z)}; }
+	FloatN Dot(const Vec3N& a, const Vec3N& b) { return Add(Add(Multiply(a.x, b.x), Multiply(a.y, b.y)), Multiply(a.z, b.z)); }
+
+	Vec3N Cross(const Vec3N& a, const Vec3N& b) {
+		return Vec3N {Subtract(Multiply(a.y, b.z), Multiply(a.z, b.y)), Subtract(Multiply(a.z, b.x), Multiply(a.x, b.z)), Subtract(Multiply(a.x, b.y), Multiply(a.y, b.x))};
+	}
+
+	// rsqrt estimate refined with one Newton-Raphson step (~23 bits), zero length vectors stay zero
+	FloatN InverseLength(const Vec3N& v) {
+		FloatN lengthSquared = Dot(v, v);
+		FloatN estimate = ReciprocalSqrtEstimate(lengthSquared);
+		FloatN refined = Multiply(Multiply(Set(0.5f), estimate), Subtract(Set(3.0f), Multiply(lengthSquared, Multiply(estimate, estimate))));
+		return And(refined, Greater(lengthSquared, Set(FLT_MIN)));
+	}
+
+	// Raw rsqrt estimate (~12 bits), zero length vectors stay zero
+	FloatN InverseLengthEstimate(const Vec3N& v) {
+		FloatN lengthSquared = Dot(v, v);
+		return And(ReciprocalSqrtEstimate(lengthSquared), Greater(lengthSquared, Set(FLT_MIN)));
+	}
+
+	// acos with max error ~7e-5 radians (Abramowitz & Stegun 4.4.45), only used as a weight
+	FloatN Acos(FloatN x) {
+		FloatN absX = Min(AndNot(Set(-0.0f), x), Set(1.0f));
+
+		FloatN polynomial = Set(-0.0187293f);
+		polynomial = Add(Multiply(polynomial, absX), Set(0.0742610f));
+		polynomial = Add(Multiply(polynomial, absX), Set(-0.2121144f));
+		polynomial = Add(Multiply(polynomial, absX), Set(1.5707288f));
+		FloatN result = Multiply(polynomial, Sqrt(Subtract(Set(1.0f), absX)));
+
+		// acos(-x) = pi - acos(x)
+		return Select(Less(x, Set(0.0f)), Subtract(Set(3.14159265f), result), result);
+	}
+
+	// Transposes 8 consecutive floats at each row pointer into 8 lane vectors
+	void LoadTransposed(const float* const (&rows)[s_LaneCount], FloatN (&columns)[8]) {
+#ifdef __AVX__
+		__m256 t[8], u[8];
+		for(int i = 0; i < 8; i += 2) {
+			__m256 row0 = _mm256_loadu_ps(rows[i]);
+			__m256 row1 = _mm256_loadu_ps(rows[i + 1]);
+			t[i] = _mm256_unpacklo_ps(row0, row1);
+			t[i + 1] = _mm256_unpackhi_ps(row0, row1);
+		}
+		for(int i = 0; i < 8; i += 4) {
+			u[i] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+			u[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+			u[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+			u[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+		}
+		for(int i = 0; i < 4; i++) {
+			columns[i] = _mm256_permute2f128_ps(u[i], u[i + 4], 0x20);
+			columns[i + 4] = _mm256_permute2f128_ps(u[i], u[i + 4], 0x31);
+		}
+#else
+		for(int half = 0; half < 2; half++) {
+			__m128 row0 = _mm_loadu_ps(rows[0] + half * 4);
+			__m128 row1 = _mm_loadu_ps(rows[1] + half * 4);
+			__m128 row2 = _mm_loadu_ps(rows[2] + half * 4);
+			__m128 row3 = _mm_loadu_ps(rows[3] + half * 4);
+			_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+			columns[half * 4] = row0;
+			columns[half * 4 + 1] = row1;
+			columns[half * 4 + 2] = row2;
+			columns[half * 4 + 3] = row3;
+		}
+#endif
+	}
+
+	// Position, texture and normal are read with one 8 float load per vertex, normal through binormal with one 8 float load and a scalar
+	static_assert(offsetof(MeshVertex, texture) == offsetof(MeshVertex, position) + 3 * sizeof(float) && offsetof(MeshVertex, normal) == offsetof(MeshVertex, position) + 5 * sizeof(float), "MeshVertex layout");
+	static_assert(offsetof(MeshVertex, tangent) == offsetof(MeshVertex, normal) + 3 * sizeof(float) && offsetof(MeshVertex, binormal) == offsetof(MeshVertex, normal) + 6 * sizeof(float), "MeshVertex layout");
+
+	// Attributes of s_LaneCount triangles, lanes past the end repeat the last triangle
+	struct TriangleLanes {
+		// [corner] px, py, pz, u, v, nx, ny, nz
+		FloatN attributes[3][8];
+		// [corner][lane]
+		uint32_t vertexIndices[3][s_LaneCount];
+		// Face tangent (direction of +u) and bitangent (direction of +v), length is arbitrary
+		Vec3N faceTangent, faceBitangent;
+	};
+
+	void LoadTriangles(const MeshData& meshData, size_t first, size_t triangleEnd, TriangleLanes& triangles) {
+		for(int corner = 0; corner < 3; corner++) {
+			const float* rows[s_LaneCount];
+			for(size_t lane = 0; lane < s_LaneCount; lane++) {
+				uint32_t v = meshData.indices[std::min(first + lane, triangleEnd - 1) * 3 + corner];
+				triangles.vertexIndices[corner][lane] = v;
+				rows[lane] = &meshData.vertices[v].position.x;
+			}
+			LoadTransposed(rows, triangles.attributes[corner]);
+		}
+
+		const FloatN (&p0)[8] = triangles.attributes[0];
+		const FloatN (&p1)[8] = triangles.attributes[1];
+		const FloatN (&p2)[8] = triangles.attributes[2];
+		Vec3N edge1 {Subtract(p1[0], p0[0]), Subtract(p1[1], p0[1]), Subtract(p1[2], p0[2])};
+		Vec3N edge2 {Subtract(p2[0], p0[0]), Subtract(p2[1], p0[1]), Subtract(p2[2], p0[2])};
+		FloatN du1 = Subtract(p1[3], p0[3]);
+		FloatN dv1 = Subtract(p1[4], p0[4]);
+		FloatN du2 = Subtract(p2[3], p0[3]);
+		FloatN dv2 = Subtract(p2[4], p0[4]);
+
+		// Only the sign of 1 / determinant matters, the vectors are normalized later
+		// Degenerate uv triangles get 0, i.e. no contribution instead of a division by zero
+		const FloatN signMask = Set(-0.0f);
+		FloatN determinant = Subtract(Multiply(du1, dv2), Multiply(du2, dv1));
+		FloatN validUV = Greater(AndNot(signMask, determinant), Set(s_DegenerateUVEpsilon));
+		FloatN r = And(Xor(Set(1.0f), And(determinant, signMask)), validUV);
+
+		triangles.faceTangent = Scale(Subtract(Scale(edge1, dv2), Scale(edge2, dv1)), r);
+		triangles.faceBitangent = Scale(Subtract(Scale(edge2, du1), Scale(edge1, du2)), r);
+	}
+
+	Vec3N GetNormal(const TriangleLanes& triangles, int corner) {
+		return Vec3N {triangles.attributes[corner][5], triangles.attributes[corner][6], triangles.attributes[corner][7]};
+	}
+
+	// Angle weighted tangent/bitangent contribution of each corner, [corner][tangent xyz, bitangent xyz][lane]
+	using CornerFrames = float[3][6][s_LaneCount];
+
+	void ComputeCornerFrames(const TriangleLanes& triangles, CornerFrames& output) {
+		/// Corner angles, each edge is normalized once and shared by its two corners
+		// Note: acos is steep near +-1, so the edges are normalized more precisely than the corner contributions below
+		Vec3N p[3];
+		for(int corner = 0; corner < 3; corner++) {
+			p[corner] = Vec3N {triangles.attributes[corner][0], triangles.attributes[corner][1], triangles.attributes[corner][2]};
+		}
+		Vec3N edge01 = Subtract(p[1], p[0]);
+		Vec3N edge02 = Subtract(p[2], p[0]);
+		Vec3N edge12 = Subtract(p[2], p[1]);
+		Vec3N direction01 = Scale(edge01, InverseLength(edge01));
+		Vec3N direction02 = Scale(edge02, InverseLength(edge02));
+		Vec3N direction12 = Scale(edge12, InverseLength(edge12));
+		FloatN weights[3] {
+			Acos(Dot(direction01, direction02)),
+			Acos(Subtract(Set(0.0f), Dot(direction01, direction12))),
+			Acos(Dot(direction02, direction12))
+		};
+
+		/// Per corner: project onto the vertex normal plane, normalize and weight by corner angle
+		// Estimates are enough here, the sums are orthonormalized precisely and packed with a 2 degree tangent error budget (see VertexPacker)
+		// Note: v - n * dot(n, v) / dot(n, n) needs no normalized n, zero normals leave v unchanged
+		for(int corner = 0; corner < 3; corner++) {
+			Vec3N normal = GetNormal(triangles, corner);
+			FloatN lengthSquared = Dot(normal, normal);
+			FloatN inverseLengthSquared = And(ReciprocalEstimate(lengthSquared), Greater(lengthSquared, Set(FLT_MIN)));
+
+			const Vec3N& faceTangent = triangles.faceTangent;
+			const Vec3N& faceBitangent = triangles.faceBitangent;
+			Vec3N tangent = Subtract(faceTangent, Scale(normal, Multiply(Dot(normal, faceTangent), inverseLengthSquared)));
+			Vec3N bitangent = Subtract(faceBitangent, Scale(normal, Multiply(Dot(normal, faceBitangent), inverseLengthSquared)));
+			tangent = Scale(tangent, Multiply(InverseLengthEstimate(tangent), weights[corner]));
+			bitangent = Scale(bitangent, Multiply(InverseLengthEstimate(bitangent), weights[corner]));
+
+			Store(output[corner][0], tangent.x);
+			Store(output[corner][1], tangent.y);
+			Store(output[corner][2], tangent.z);
+			Store(output[corner][3], bitangent.x);
+			Store(output[corner][4], bitangent.y);
+			Store(output[corner][5], bitangent.z);
+		}
+	}
+
+	// Orthonormal tangent xyz and binormal xyz from a vertex normal and its tangent/bitangent sums
+	// Note: normalized to ~23 bits (see InverseLength), well below the 16 bit packed tangent precision
+	void Orthonormalize(Vec3N n, const Vec3N& tangentSum, const Vec3N& bitangentSum, float (&frames)[6][s_LaneCount]) {
+		const FloatN zero = Set(0.0f);
+		const FloatN one = Set(1.0f);
+
+		// Zero normals fall back to +y
+		FloatN validNormal = Greater(Dot(n, n), Set(FLT_MIN));
+		n = Select(validNormal, Scale(n, InverseLength(n)), Vec3N {zero, one, zero});
+
+		// Gram-Schmidt, fall back to any perpendicular axis if nothing was accumulated
+		Vec3N t = Subtract(tangentSum, Scale(n, Dot(n, tangentSum)));
+		FloatN validTangent = Greater(Dot(t, t), zero);
+		FloatN useXAxis = Less(AndNot(Set(-0.0f), n.x), Set(0.9f));
+		Vec3N axis {And(useXAxis, one), AndNot(useXAxis, one), zero};
+		t = Select(validTangent, t, Subtract(axis, Scale(n, Dot(n, axis))));
+		t = Scale(t, InverseLength(t));
+
+		// Handedness from the accumulated bitangent, binormal is rebuilt so the frame is orthonormal
+		Vec3N b = Cross(n, t);
+		FloatN flip = And(Less(Dot(b, bitangentSum), zero), Set(-0.0f));
+
+		Store(frames[0], t.x);
+		Store(frames[1], t.y);
+		Store(frames[2], t.z);
+		Store(frames[3], Xor(b.x, flip));
+		Store(frames[4], Xor(b.y, flip));
+		Store(frames[5], Xor(b.z, flip));
+	}
+
+	// Transposes 4 lanes of [tangent xyz, bitangent xyz][lane] to the tangent/binormal layout of MeshVertex
+	// tangentAndBitangentX[lane] is (tx, ty, tz, bx), bitangentYZ[lane] is (by, bz, -, -)
+	void TransposeFrames(const float (&frames)[6][s_LaneCount], size_t first, __m128 (&tangentAndBitangentX)[4], __m128 (&bitangentYZ)[4]) {
+		for(int i = 0; i < 4; i++) {
+			tangentAndBitangentX[i] = _mm_loadu_ps(frames[i] + first);
+		}
+		_MM_TRANSPOSE4_PS(tangentAndBitangentX[0], tangentAndBitangentX[1], tangentAndBitangentX[2], tangentAndBitangentX[3]);
+
+		__m128 bitangentYZ01 = _mm_unpacklo_ps(_mm_loadu_ps(frames[4] + first), _mm_loadu_ps(frames[5] + first));
+		__m128 bitangentYZ23 = _mm_unpackhi_ps(_mm_loadu_ps(frames[4] + first), _mm_loadu_ps(frames[5] + first));
+		bitangentYZ[0] = bitangentYZ01;
+		bitangentYZ[1] = _mm_movehl_ps(bitangentYZ01, bitangentYZ01);
+		bitangentYZ[2] = bitangentYZ23;
+		bitangentYZ[3] = _mm_movehl_ps(bitangentYZ23, bitangentYZ23);
+	}
+
+	// Calls function(lane, tangentAndBitangentX, bitangentYZ) for the first laneCount lanes, see TransposeFrames
+	template<typename Function>
+	void ForEachFrame(const float (&frames)[6][s_LaneCount], size_t laneCount, const Function& function) {
+		for(size_t first = 0; first < laneCount; first += 4) {
+			__m128 tangentAndBitangentX[4], bitangentYZ[4];
+			TransposeFrames(frames, first, tangentAndBitangentX, bitangentYZ);
+			for(size_t lane = first; lane < std::min(first + 4, laneCount); lane++) {
+				function(lane, tangentAndBitangentX[lane - first], bitangentYZ[lane - first]);
+			}
+		}
+	}
+
+	void StoreFrame(float* frame, __m128 tangentAndBitangentX, __m128 bitangentYZ) {
+		_mm_storeu_ps(frame, tangentAndBitangentX);
+		_mm_storel_pi((__m64*)(frame + 4), bitangentYZ);
+	}
+
+	void StoreVertexFrames(MeshData& meshData, const uint32_t* vertexIndices, size_t vertexCount, const float (&frames)[6][s_LaneCount]) {
+		ForEachFrame(frames, vertexCount, [&](size_t lane, __m128 tangentAndBitangentX, __m128 bitangentYZ) {
+			StoreFrame(&meshData.vertices[vertexIndices[lane]].tangent.x, tangentAndBitangentX, bitangentYZ);
+		});
+	}
+
+	// Turns the tangent/bitangent sums of up to s_LaneCount vertices into orthonormal frames
+	void OrthonormalizeVertexFrames(MeshData& meshData, const uint32_t* vertexIndices, size_t vertexCount) {
+		/// Gather nx, ny, nz, tx, ty, tz, bx, by (bz separately), the tail lanes repeat the last vertex and are not stored
+		const float* rows[s_LaneCount];
+		alignas(32) float bitangentZ[s_LaneCount];
+		for(size_t lane = 0; lane < s_LaneCount; lane++) {
+			const MeshVertex& vertex = meshData.vertices[vertexIndices[std::min(lane, vertexCount - 1)]];
+			rows[lane] = &vertex.normal.x;
+			bitangentZ[lane] = vertex.binormal.z;
+		}
+		FloatN attributes[8];
+		LoadTransposed(rows, attributes);
+
+		alignas(32) float frames[6][s_LaneCount];
+		Orthonormalize(Vec3N {attributes[0], attributes[1], attributes[2]}, Vec3N {attributes[3], attributes[4], attributes[5]}, Vec3N {attributes[6], attributes[7], Load(bitangentZ)}, frames);
+		StoreVertexFrames(meshData, vertexIndices, vertexCount, frames);
+	}
+
+	/// Per vertex accumulation in a single pass over the vertices
+	// Each vertex counts its corners still to be added, it is orthonormalized as soon as the last one is added (while it is still in cache)
+	// s_AddedFlag is set by the first corner, which overwrites the tangent/binormal instead of adding, so nothing has to be zeroed first
+	constexpr uint32_t s_AddedFlag = 0x80000000u;
+
+	struct VertexAccumulator {
+		MeshData& meshData;
+		uint32_t* remainingCorners;
+		// Finished vertices waiting to be orthonormalized together
+		uint32_t finished[s_LaneCount] {};
+		size_t finishedCount = 0;
+
+		bool IsFinished(uint32_t v) const {
+			return remainingCorners[v] == s_AddedFlag;
+		}
+
+		// tangentAndBitangentX is (tx, ty, tz, bx), bitangentYZ is (by, bz, -, -), matching the tangent/binormal layout of MeshVertex
+		void Add(uint32_t v, __m128 tangentAndBitangentX, __m128 bitangentYZ) {
+			float* frame = &meshData.vertices[v].tangent.x;
+			// The first corner overwrites the stale tangent/binormal instead of adding to it
+			__m128 keep = _mm_castsi128_ps(_mm_set1_epi32(-(int32_t)(remainingCorners[v] >> 31)));
+			_mm_storeu_ps(frame, _mm_add_ps(_mm_and_ps(_mm_loadu_ps(frame), keep), tangentAndBitangentX));
+			_mm_storel_pi((__m64*)(frame + 4), _mm_add_ps(_mm_and_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(frame + 4)), keep), bitangentYZ));
+
+			remainingCorners[v] = (remainingCorners[v] | s_AddedFlag) - 1;
+			if(remainingCorners[v] == s_AddedFlag) {
+				Finish(v);
+			}
+		}
+
+		// True if every vertex of the lanes is used by that corner only (unwelded meshes)
+		bool AreSingleCorners(const uint32_t (&vertexIndices)[s_LaneCount]) const {
+			for(uint32_t v : vertexIndices) {
+				if(remainingCorners[v] != 1) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// The only contribution of a single corner vertex is its own, so its frame comes straight from the corner's vectors
+		void FinishSingleCorners(const uint32_t (&vertexIndices)[s_LaneCount], const Vec3N& normal, const Vec3N& tangent, const Vec3N& bitangent) {
+			alignas(32) float frames[6][s_LaneCount];
+			Orthonormalize(normal, tangent, bitangent, frames);
+			StoreVertexFrames(meshData, vertexIndices, s_LaneCount, frames);
+			for(uint32_t v : vertexIndices) {
+				remainingCorners[v] = s_AddedFlag;
+			}
+		}
+
+		void Finish(uint32_t v) {
+			finished[finishedCount++] = v;
+			if(finishedCount == s_LaneCount) {
+				OrthonormalizeVertexFrames(meshData, finished, finishedCount);
+				finishedCount = 0;
+			}
+		}
+
+		// Vertices of [vertexBegin, vertexEnd) not used by any triangle get an arbitrary frame, then the last batch is orthonormalized
+		void FinishUnused(size_t vertexBegin, size_t vertexEnd) {
+			for(size_t v = vertexBegin; v < vertexEnd; v++) {
+				if(remainingCorners[v] == 0) {
+					meshData.vertices[v].tangent = XMFLOAT3(0.0f, 0.0f, 0.0f);
+					meshData.vertices[v].binormal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+					Finish((uint32_t)v);
+				}
+			}
+			if(finishedCount > 0) {
+				OrthonormalizeVertexFrames(meshData, finished, finishedCount);
+				finishedCount = 0;
+			}
+		}
+	};
+
+	// Triangles [first, first + s_LaneCount) clamped to triangleEnd: single corner vertices are finished right away
+	// and addCorner(corner, lane, tangentAndBitangentX, bitangentYZ) is called for the corners of shared vertices
+	// Note: a single corner vertex is only touched by its own triangle, so tasks on disjoint triangle ranges can finish them concurrently
+	template<typename AddCorner>
+	void ProcessTriangles(MeshData& meshData, VertexAccumulator& accumulator, size_t first, size_t triangleEnd, const AddCorner& addCorner) {
+		TriangleLanes triangles;
+		LoadTriangles(meshData, first, triangleEnd, triangles);
+		size_t laneCount = std::min(s_LaneCount, triangleEnd - first);
+		bool b_IsFull = laneCount == s_LaneCount;
+
+		// Whole triangles of single corner vertices: angle weights and per corner normalization cancel out, only the face vectors are needed
+		bool b_SingleCorners[3] {};
+		for(int corner = 0; corner < 3; corner++) {
+			b_SingleCorners[corner] = b_IsFull && accumulator.AreSingleCorners(triangles.vertexIndices[corner]);
+		}
+		if(b_SingleCorners[0] && b_SingleCorners[1] && b_SingleCorners[2]) {
+			for(int corner = 0; corner < 3; corner++) {
+				accumulator.FinishSingleCorners(triangles.vertexIndices[corner], GetNormal(triangles, corner), triangles.faceTangent, triangles.faceBitangent);
+			}
+			return;
+		}
+
+		alignas(32) CornerFrames cornerFrames;
+		ComputeCornerFrames(triangles, cornerFrames);
+		for(int corner = 0; corner < 3; corner++) {
+			if(b_SingleCorners[corner]) {
+				accumulator.FinishSingleCorners(triangles.vertexIndices[corner], GetNormal(triangles, corner),
+					Vec3N {Load(cornerFrames[corner][0]), Load(cornerFrames[corner][1]), Load(cornerFrames[corner][2])},
+					Vec3N {Load(cornerFrames[corner][3]), Load(cornerFrames[corner][4]), Load(cornerFrames[corner][5])});
+				continue;
+			}
+
+			ForEachFrame(cornerFrames[corner], laneCount, [&](size_t lane, __m128 tangentAndBitangentX, __m128 bitangentYZ) {
+				addCorner(corner, lane, tangentAndBitangentX, bitangentYZ);
+			});
+		}
+	}
+}
+
+#ifdef __AVX__
+namespace TangentLanesAVX {
+#else
+namespace TangentLanesSSE {
+#endif
+	void AddTriangles(MeshData& meshData, uint32_t* remainingCorners) {
+		size_t triangleCount = meshData.indices.size() / 3;
+		VertexAccumulator accumulator {meshData, remainingCorners};
+		for(size_t first = 0; first < triangleCount; first += s_LaneCount) {
+			ProcessTriangles(meshData, accumulator, first, triangleCount, [&](int corner, size_t lane, __m128 tangentAndBitangentX, __m128 bitangentYZ) {
+				accumulator.Add(meshData.indices[(first + lane) * 3 + corner], tangentAndBitangentX, bitangentYZ);
+			});
+		}
+		accumulator.FinishUnused(0, meshData.vertices.size());
+	}
+
+	void StoreCorners(MeshData& meshData, uint32_t* remainingCorners, size_t triangleBegin, size_t triangleEnd, float* storedCorners) {
+		VertexAccumulator accumulator {meshData, remainingCorners};
+		for(size_t first = triangleBegin; first < triangleEnd; first += s_LaneCount) {
+			ProcessTriangles(meshData, accumulator, first, triangleEnd, [&](int corner, size_t lane, __m128 tangentAndBitangentX, __m128 bitangentYZ) {
+				StoreFrame(&storedCorners[((first + lane) * 3 + corner) * 6], tangentAndBitangentX, bitangentYZ);
+			});
+		}
+	}
+
+	void AddStoredCorners(MeshData& meshData, uint32_t* remainingCorners, const float* storedCorners, size_t vertexBegin, size_t vertexEnd) {
+		VertexAccumulator accumulator {meshData, remainingCorners};
+		for(size_t i = 0; i < meshData.indices.size() / 3 * 3; i++) {
+			uint32_t v = meshData.indices[i];
+			if(v - vertexBegin < vertexEnd - vertexBegin && !accumulator.IsFinished(v)) {
+				const float* storedCorner = &storedCorners[i * 6];
+				accumulator.Add(v, _mm_loadu_ps(storedCorner), _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(storedCorner + 4)));
+			}
+		}
+
+		accumulator.FinishUnused(vertexBegin, vertexEnd);
+	}
+}
@@ -1,194 +1,654 @@
 #include "Texture.h"
+#include "DDSFile.h"
+#include "HDRDecoder.h"
+#include "MipGenerator.h"
+#include "TextureCache.h"
+#include "MappedFile.h"
 #include "stb_image.h"
 
 #include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <tmmintrin.h>
+
+namespace {
+	const char* const s_BlockFormatNames[BlockCompressor::Num_BlockFormats] = {"BC1", "BC3", "BC4", "BC5", "BC7"};
+
+	// Filter of mips built on the CPU, for cooked and uncompressed 8 bit textures alike
+	constexpr MipGenerator::Filter s_MipFilter = MipGenerator::kKaiserFilter;
+
+	// In HDRDecoder::OutputFormat order
+	constexpr DXGI_FORMAT s_HDRFormats[HDRDecoder::Num_OutputFormats] = {DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R9G9B9E5_SHAREDEXP};
+	// Half the size of float and unlike R9G9B9E5 it can be a render target, so GenerateMips works on it
+	constexpr HDRDecoder::OutputFormat s_DefaultHDRFormat = HDRDecoder::kHalf;
+
+	int GetMipSize(int size, int mip) {
+		return std::max(1, size >> mip);
+	}
 
-bool Texture::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& filePath, DXGI_FORMAT format, int mipLevels) {
-	bool b_GenerateMips = mipLevels == 0 || mipLevels > 1;
+	bool IsDDSFilePath(const std::string& filePath) {
+		return filePath.size() >= 4 && filePath.compare(filePath.size() - 4, 4, ".dds") == 0;
+	}
+
+	bool IsSRGBFormat(DXGI_FORMAT format) {
+		switch(format) {
+			case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			case DXGI_FORMAT_BC1_UNORM_SRGB:
+			case DXGI_FORMAT_BC3_UNORM_SRGB:
+			case DXGI_FORMAT_BC7_UNORM_SRGB:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	// sRGB content is filtered in linear space, BC5 only holds tangent space normal maps (see BlockCompressor::kBC5)
+	MipGenerator::Settings GetMipSettings(DXGI_FORMAT format) {
+		MipGenerator::Settings settings {};
+		settings.filter = s_MipFilter;
+		settings.isSRGB = IsSRGBFormat(format);
+		settings.isNormalMap = format == DXGI_FORMAT_BC5_UNORM;
+		return settings;
+	}
+
+	/// Mip layout of an image: a DDS file's mips, or texels (plus the mips built on the CPU, if any)
+	int GetImageMipCount(const Texture::ImageData& image) {
+		if(image.ddsFile) {
+			return image.ddsFile->GetMipCount();
+		}
+		return 1 + (image.mips ? (int)image.mips->size() : 0);
+	}
+
+	// Describes the memory layout only, texels are uploaded to whichever 4 channel format the texture is created in
+	DXGI_FORMAT GetImageDataFormat(const Texture::ImageData& image) {
+		if(image.ddsFile) {
+			return image.ddsFile->GetFormat();
+		}
+		return image.hdrData ? image.hdrFormat : DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+
+	const unsigned char* GetImageMipData(const Texture::ImageData& image, int mip) {
+		if(image.ddsFile) {
+			return image.ddsFile->GetMipData(mip);
+		}
+		if(mip > 0) {
+			return (*image.mips)[mip - 1].data();
+		}
+		return image.uCharData ? image.uCharData : image.hdrData;
+	}
+
+	int GetImageRowPitch(const Texture::ImageData& image, int mip) {
+		return DDSFile::GetRowPitch(GetImageDataFormat(image), GetMipSize(image.width, mip));
+	}
+
+	int GetImageRowCount(const Texture::ImageData& image, int mip) {
+		return DDSFile::GetRowCount(GetImageDataFormat(image), GetMipSize(image.height, mip));
+	}
+
+	// Mip an upload row is in, row becomes the row inside that mip
+	int FindImageMip(const Texture::ImageData& image, int& row) {
+		int mip = 0;
+		while(mip + 1 < GetImageMipCount(image) && row >= GetImageRowCount(image, mip)) {
+			row -= GetImageRowCount(image, mip);
+			mip++;
+		}
+		return mip;
+	}
+
+	/// Targa
+	constexpr unsigned char s_TargaTrueColor = 2;
+	constexpr unsigned char s_TargaRLETrueColor = 10;
+	constexpr unsigned char s_TargaRightToLeft = 0x10;
+	constexpr unsigned char s_TargaTopToBottom = 0x20;
+
+	// BGR(A) texels to RGBA, 4 texels per shuffle, alpha is 255 for 24 bit texels
+	// Note: never reads past count texels, 24 bit shuffles only run while 16 bytes are left
+	void SwizzleTargaTexels(const unsigned char* source, int count, int bytesPerTexel, unsigned char* texels) {
+		int i = 0;
+		if(bytesPerTexel == 4) {
+			const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+			for(; i + 4 <= count; i += 4) {
+				__m128i bgra = _mm_loadu_si128((const __m128i*)(source + i * 4));
+				_mm_storeu_si128((__m128i*)(texels + i * 4), _mm_shuffle_epi8(bgra, shuffle));
+			}
+			for(; i < count; i++) {
+				texels[i * 4 + 0] = source[i * 4 + 2];
+				texels[i * 4 + 1] = source[i * 4 + 1];
+				texels[i * 4 + 2] = source[i * 4 + 0];
+				texels[i * 4 + 3] = source[i * 4 + 3];
+			}
+		}
+		else {
+			const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+			const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+			for(; i + 6 <= count; i += 4) {
+				__m128i bgr = _mm_loadu_si128((const __m128i*)(source + i * 3));
+				_mm_storeu_si128((__m128i*)(texels + i * 4), _mm_or_si128(_mm_shuffle_epi8(bgr, shuffle), alpha));
+			}
+			for(; i < count; i++) {
+				texels[i * 4 + 0] = source[i * 3 + 2];
+				texels[i * 4 + 1] = source[i * 3 + 1];
+				texels[i * 4 + 2] = source[i * 3 + 0];
+				texels[i * 4 + 3] = 255;
+			}
+		}
+	}
+}
+
+bool Texture::DecodeFile(const std::string& filePath, ImageData& image, DXGI_FORMAT format) {
+	image = ImageData {};
 
 	/// Load texture from disk
-	/// NOTE: use rastertek loader if tga file, else, stb_image; because rastertek function seems to be significantly faster
+	/// NOTE: use own targa loader if tga file, else, stb_image; because it maps the file and swizzles with SSSE3, it is significantly faster
 	std::string fileTypeName{ filePath, filePath.length() - 3, 3 };
 	if(fileTypeName == "tga") {
-		m_IsSTBLoad = false;
-		// loads data to m_UCharTexData, m_Width and m_Height
-		bool result = LoadTarga32Bit(filePath.c_str(), &m_TempUCharTexData, m_Width, m_Height);
-		if(!result) {
-			return false;
-		}
+		image.isSTBLoad = false;
+		return LoadTarga(filePath.c_str(), &image.uCharData, image.width, image.height);
 	}
 	else if(fileTypeName == "hdr") {
-		m_IsSTBLoad = true;
-		int nrComponents;
-		m_TempFloatTexData = stbi_loadf(filePath.c_str(), &m_Width, &m_Height, &nrComponents, 4);
-		if(!m_TempFloatTexData) {
+		// Straight to the texture's format, stbi_loadf would make a 16 byte per texel float copy first
+		HDRDecoder::OutputFormat hdrFormat = s_DefaultHDRFormat;
+		for(int i = 0; i < HDRDecoder::Num_OutputFormats; i++) {
+			if(s_HDRFormats[i] == format) {
+				hdrFormat = (HDRDecoder::OutputFormat)i;
+			}
+		}
+		image.hdrFormat = s_HDRFormats[hdrFormat];
+		return HDRDecoder::Decode(filePath.c_str(), hdrFormat, 0, &image.hdrData, image.width, image.height);
+	}
+	else if(fileTypeName == "dds") {
+		image.ddsFile = new DDSFile();
+		if(!image.ddsFile->Initialize(filePath)) {
 			return false;
 		}
+		image.width = image.ddsFile->GetWidth();
+		image.height = image.ddsFile->GetHeight();
+		return true;
 	}
 	else {
-		m_IsSTBLoad = true;
+		image.isSTBLoad = true;
 		int nrComponents;
-		m_TempUCharTexData = stbi_load(filePath.c_str(), &m_Width, &m_Height, &nrComponents, 4);
-		if(!m_TempUCharTexData) {
+		image.uCharData = stbi_load(filePath.c_str(), &image.width, &image.height, &nrComponents, 4);
+		return image.uCharData != nullptr;
+	}
+}
+
+bool Texture::DecodeFile(const std::string& filePath, DXGI_FORMAT format, int mipLevels, ImageData& image) {
+	return DecodeFile(filePath, {filePath}, format, mipLevels, image);
+}
+
+bool Texture::DecodeFile(const std::string& filePath, const std::vector<std::string>& sourceFilePaths, DXGI_FORMAT format, int mipLevels, ImageData& image) {
+	auto DecodeSourceFiles = [&sourceFilePaths, format, &image]() {
+		return sourceFilePaths.size() == 1 ? DecodeFile(sourceFilePaths[0], image, format) : PackChannels(sourceFilePaths, image);
+	};
+
+	BlockCompressor::BlockFormat blockFormat {};
+	if(!TextureCache::GetBlockFormat(format, blockFormat) || (sourceFilePaths.size() == 1 && IsDDSFilePath(sourceFilePaths[0]))) {
+		if(!DecodeSourceFiles()) {
+			return false;
+		}
+		GenerateMips(image, format, mipLevels);
+		return true;
+	}
+
+	image = ImageData {};
+	DDSFile* ddsFile = new DDSFile();
+	if(!TextureCache::Load(filePath, sourceFilePaths, format, *ddsFile)) {
+		if(!DecodeSourceFiles()) {
+			delete ddsFile;
+			return false;
+		}
+
+		if(!CookFile(filePath, sourceFilePaths, image, format) || !TextureCache::Load(filePath, sourceFilePaths, format, *ddsFile)) {
+			std::cout << filePath << ": could not cook texture, uploading it uncompressed\n";
+			delete ddsFile;
+			GenerateMips(image, format, 0);
+			return true;
+		}
+		FreeImageData(image);
+	}
+
+	image.width = ddsFile->GetWidth();
+	image.height = ddsFile->GetHeight();
+	image.ddsFile = ddsFile;
+	return true;
+}
+
+bool Texture::PackChannels(const std::vector<std::string>& sourceFilePaths, ImageData& image) {
+	image = ImageData {};
+	if(sourceFilePaths.empty() || sourceFilePaths.size() > 4) {
+		return false;
+	}
+
+	for(int channel = 0; channel < (int)sourceFilePaths.size(); channel++) {
+		ImageData sourceImage {};
+		bool b_IsDecoded = DecodeFile(sourceFilePaths[channel], sourceImage) && sourceImage.uCharData;
+		if(b_IsDecoded && channel > 0 && (sourceImage.width != image.width || sourceImage.height != image.height)) {
+			std::cout << sourceFilePaths[channel] << ": size differs from " << sourceFilePaths[0] << ", can't be packed with it\n";
+			b_IsDecoded = false;
+		}
+		if(!b_IsDecoded) {
+			FreeImageData(sourceImage);
+			FreeImageData(image);
 			return false;
 		}
+
+		size_t texelCount = (size_t)sourceImage.width * sourceImage.height;
+		if(channel == 0) {
+			image.width = sourceImage.width;
+			image.height = sourceImage.height;
+			image.isSTBLoad = false;
+			image.uCharData = new unsigned char[texelCount * 4];
+			for(size_t i = 0; i < texelCount; i++) {
+				image.uCharData[i * 4 + 0] = 0;
+				image.uCharData[i * 4 + 1] = 0;
+				image.uCharData[i * 4 + 2] = 0;
+				image.uCharData[i * 4 + 3] = 255;
+			}
+		}
+
+		for(size_t i = 0; i < texelCount; i++) {
+			image.uCharData[i * 4 + channel] = sourceImage.uCharData[i * 4];
+		}
+		FreeImageData(sourceImage);
+	}
+
+	return true;
+}
+
+void Texture::GenerateMips(ImageData& image, DXGI_FORMAT format, int mipLevels) {
+	if(!image.uCharData || mipLevels == 1 || MipGenerator::GetMipCount(image.width, image.height) == 1) {
+		return;
+	}
+
+	image.mips = new std::vector<std::vector<unsigned char>>();
+	MipGenerator::GenerateMips(image.uCharData, image.width, image.height, mipLevels, GetMipSettings(format), *image.mips);
+}
+
+bool Texture::CookFile(const std::string& filePath, const std::vector<std::string>& sourceFilePaths, const ImageData& image, DXGI_FORMAT format) {
+	BlockCompressor::BlockFormat blockFormat {};
+	if(!image.uCharData || !TextureCache::GetBlockFormat(format, blockFormat) || image.width % 4 != 0 || image.height % 4 != 0) {
+		return false;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<std::vector<unsigned char>> mipTexels {};
+	MipGenerator::GenerateMips(image.uCharData, image.width, image.height, 0, GetMipSettings(format), mipTexels);
+	float mipTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	std::vector<std::vector<unsigned char>> mips {};
+	size_t uncompressedSize = 0;
+	for(int mip = 0; mip <= (int)mipTexels.size(); mip++) {
+		int mipWidth = GetMipSize(image.width, mip);
+		int mipHeight = GetMipSize(image.height, mip);
+		mips.emplace_back(BlockCompressor::GetCompressedSize(blockFormat, mipWidth, mipHeight));
+		BlockCompressor::Compress(blockFormat, mip == 0 ? image.uCharData : mipTexels[mip - 1].data(), mipWidth, mipHeight, mips.back().data());
+		uncompressedSize += (size_t)mipWidth * mipHeight * 4;
+	}
+	float cookTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	size_t compressedSize = 0;
+	for(const std::vector<unsigned char>& mip : mips) {
+		compressedSize += mip.size();
+	}
+
+	std::vector<unsigned char> decodedTexels((size_t)image.width * image.height * 4);
+	BlockCompressor::Decompress(blockFormat, mips[0].data(), image.width, image.height, decodedTexels.data());
+	float psnr = BlockCompressor::ComputePSNR(blockFormat, image.uCharData, decodedTexels.data(), image.width, image.height);
+	std::cout << filePath << ": cooked " << mips.size() << " mips to " << s_BlockFormatNames[blockFormat] << " in " << cookTime << " ms (mips " << mipTime << " ms), PSNR " << psnr << " dB, "
+		<< uncompressedSize / 1024 << " -> " << compressedSize / 1024 << " KB\n";
+
+	return TextureCache::Write(filePath, sourceFilePaths, format, image.width, image.height, mips);
+}
+
+void Texture::FreeImageData(ImageData& image) {
+	if(image.uCharData) {
+		if(image.isSTBLoad) {
+			stbi_image_free(image.uCharData);
+		}
+		else {
+			delete[] image.uCharData;
+		}
+		image.uCharData = nullptr;
+	}
+
+	if(image.hdrData) {
+		delete[] image.hdrData;
+		image.hdrData = nullptr;
+	}
+
+	if(image.ddsFile) {
+		image.ddsFile->Shutdown();
+		delete image.ddsFile;
+		image.ddsFile = nullptr;
+	}
+
+	if(image.mips) {
+		delete image.mips;
+		image.mips = nullptr;
+	}
+}
+
+bool Texture::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& filePath, DXGI_FORMAT format, int mipLevels) {
+	ImageData image {};
+	bool result = DecodeFile(filePath, format, mipLevels, image) && Initialize(device, deviceContext, image, format, mipLevels);
+	FreeImageData(image);
+	return result;
+}
+
+bool Texture::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const ImageData& image, DXGI_FORMAT format, int mipLevels) {
+	if(HasEveryMip(image, mipLevels)) {
+		// Zero copy from the decoded image (or mapped file), every mip is already in its GPU layout
+		D3D11_SUBRESOURCE_DATA initialData[DDSFile::kMaxMipCount] {};
+		for(int mip = 0; mip < GetImageMipCount(image); mip++) {
+			initialData[mip].pSysMem = GetImageMipData(image, mip);
+			initialData[mip].SysMemPitch = (UINT)GetImageRowPitch(image, mip);
+			initialData[mip].SysMemSlicePitch = (UINT)GetImageRowPitch(image, mip) * GetImageRowCount(image, mip);
+		}
+		return CreateTexture(device, image, format, mipLevels, initialData) && EndUpload(device, deviceContext);
+	}
+
+	if(!BeginUpload(device, image, format, mipLevels)) {
+		return false;
 	}
+	int uploadRowCount = GetUploadRowCount(image);
+	for(int row = 0; row < uploadRowCount;) {
+		row += UploadRows(deviceContext, image, row, uploadRowCount - row);
+	}
+	return EndUpload(device, deviceContext);
+}
+
+bool Texture::HasEveryMip(const ImageData& image, int mipLevels) {
+	return image.ddsFile || image.mips || mipLevels == 1;
+}
+
+bool Texture::BeginUpload(ID3D11Device* device, const ImageData& image, DXGI_FORMAT format, int mipLevels) {
+	return CreateTexture(device, image, format, mipLevels, nullptr);
+}
+
+bool Texture::CreateTexture(ID3D11Device* device, const ImageData& image, DXGI_FORMAT format, int mipLevels, const D3D11_SUBRESOURCE_DATA* initialData) {
+	// Images with their mips come with every mip, so no render target bind is needed for GenerateMips
+	bool b_GenerateMips = !HasEveryMip(image, mipLevels);
+	m_Width = image.width;
+	m_Height = image.height;
 
 	// Setup the description of the texture.
 	D3D11_TEXTURE2D_DESC textureDesc{};
 	textureDesc.Height = m_Height;
 	textureDesc.Width = m_Width;
 	textureDesc.ArraySize = 1;
-	textureDesc.MipLevels = mipLevels;
+	textureDesc.MipLevels = b_GenerateMips ? mipLevels : GetImageMipCount(image);
 	textureDesc.Format = format;
-	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 	textureDesc.MiscFlags = 0;
 	textureDesc.SampleDesc.Count = 1;
 	textureDesc.SampleDesc.Quality = 0;
 	textureDesc.Usage = D3D11_USAGE_DEFAULT;
 	textureDesc.CPUAccessFlags = 0;
 
+	BlockCompressor::BlockFormat blockFormat {};
+	if(image.ddsFile || image.hdrData) {
+		textureDesc.Format = GetImageDataFormat(image);
+	}
+	else if(TextureCache::GetBlockFormat(format, blockFormat)) {
+		// Could not be cooked (see DecodeFile)
+		textureDesc.Format = IsSRGBFormat(format) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+
 	if(b_GenerateMips) {
+		textureDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
 		textureDesc.MiscFlags |= D3D11_RESOURCE_MISC_GENERATE_MIPS;
 	}
 
-	// Create the empty texture.
-	HRESULT hResult = device->CreateTexture2D(&textureDesc, NULL, &m_Texture);
+	// Create the texture, the placeholder view (if any) stays in use until EndUpload
+	HRESULT hResult = device->CreateTexture2D(&textureDesc, initialData, &m_Texture);
 	if(FAILED(hResult)) {
 		return false;
 	}
 
-	// uchar texture load and clean up
-	if(m_TempUCharTexData) {
-		deviceContext->UpdateSubresource(m_Texture, 0, NULL, m_TempUCharTexData, m_Width * 4 * sizeof(unsigned char), 0);
-		if(m_IsSTBLoad) {
-			stbi_image_free(m_TempUCharTexData);
-		}
-		else {
-			delete[] m_TempUCharTexData;
-		}
-		m_TempUCharTexData = nullptr;
+	return true;
+}
+
+int Texture::UploadRows(ID3D11DeviceContext* deviceContext, const ImageData& image, int firstRow, int rowCount) {
+	int mipRow = firstRow;
+	int mip = FindImageMip(image, mipRow);
+	rowCount = std::min(rowCount, GetImageRowCount(image, mip) - mipRow);
+	UploadMipRows(deviceContext, image, mip, mip, mipRow, rowCount);
+	return rowCount;
+}
+
+void Texture::UploadMipRows(ID3D11DeviceContext* deviceContext, const ImageData& image, int mip, int subresource, int firstRow, int rowCount) {
+	int mipHeight = GetMipSize(image.height, mip);
+	int rowPitch = GetImageRowPitch(image, mip);
+	int rowHeight = DDSFile::IsBlockCompressed(GetImageDataFormat(image)) ? 4 : 1;
+
+	// In texels, whole blocks except where a mip ends inside one
+	D3D11_BOX rowBox {};
+	rowBox.left = 0;
+	rowBox.right = (UINT)GetMipSize(image.width, mip);
+	rowBox.top = (UINT)(firstRow * rowHeight);
+	rowBox.bottom = (UINT)std::min((firstRow + rowCount) * rowHeight, mipHeight);
+	rowBox.front = 0;
+	rowBox.back = 1;
+	deviceContext->UpdateSubresource(m_Texture, (UINT)subresource, &rowBox, GetImageMipData(image, mip) + (size_t)firstRow * rowPitch, rowPitch, 0);
+}
+
+int Texture::GetUploadRowCount(const ImageData& image) {
+	int rowCount = 0;
+	for(int mip = 0; mip < GetImageMipCount(image); mip++) {
+		rowCount += GetImageRowCount(image, mip);
+	}
+	return rowCount;
+}
+
+size_t Texture::GetUploadSize(const ImageData& image) {
+	size_t size = 0;
+	for(int mip = 0; mip < GetImageMipCount(image); mip++) {
+		size += (size_t)GetImageRowPitch(image, mip) * GetImageRowCount(image, mip);
+	}
+	return size;
+}
+
+int Texture::GetRowPitch(const ImageData& image, int row) {
+	return GetImageRowPitch(image, FindImageMip(image, row));
+}
+
+bool Texture::EndUpload(ID3D11Device* device, ID3D11DeviceContext* deviceContext) {
+	if(!CreateView(device, 0)) {
+		return false;
 	}
-	// float texture load
-	else if(m_TempFloatTexData){
-		deviceContext->UpdateSubresource(m_Texture, 0, NULL, m_TempFloatTexData, m_Width * 4 * sizeof(float), 0);
-		stbi_image_free(m_TempFloatTexData);
-		m_TempFloatTexData = nullptr;
+
+	D3D11_TEXTURE2D_DESC textureDesc {};
+	m_Texture->GetDesc(&textureDesc);
+	if(textureDesc.MiscFlags & D3D11_RESOURCE_MISC_GENERATE_MIPS) {
+		deviceContext->GenerateMips(m_TextureView);
 	}
 
+	return true;
+}
+
+bool Texture::CreateView(ID3D11Device* device, int mostDetailedMip) {
+	D3D11_TEXTURE2D_DESC textureDesc {};
+	m_Texture->GetDesc(&textureDesc);
+
 	/// Setup the shader resource view description.
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc {};
-	srvDesc.Format = format;
+	srvDesc.Format = textureDesc.Format;
 	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MostDetailedMip = (UINT)mostDetailedMip;
 	srvDesc.Texture2D.MipLevels = -1;
 
 	// Create the shader resource view for the texture.
-	hResult = device->CreateShaderResourceView(m_Texture, &srvDesc, &m_TextureView);
+	ID3D11ShaderResourceView* textureView = nullptr;
+	HRESULT hResult = device->CreateShaderResourceView(m_Texture, &srvDesc, &textureView);
 	if(FAILED(hResult)) {
 		return false;
 	}
 
-	if(b_GenerateMips) {
-		deviceContext->GenerateMips(m_TextureView);
+	// Replaces the placeholder (or the previous view of a streamed texture)
+	if(m_TextureView) {
+		m_TextureView->Release();
 	}
+	m_TextureView = textureView;
 
 	return true;
 }
 
-bool Texture::AsyncInitialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& filePath, DXGI_FORMAT format, int mipLevels, std::mutex deviceContextMutex) {
-	bool b_GenerateMips = mipLevels == 0 || mipLevels > 1;
+void Texture::SetPlaceholder(ID3D11ShaderResourceView* placeholderView) {
+	placeholderView->AddRef();
+	if(m_TextureView) {
+		m_TextureView->Release();
+	}
+	m_TextureView = placeholderView;
+}
 
-	/// Load texture from disk
-	/// NOTE: use rastertek loader if tga file, else, stb_image; because rastertek function seems to be significantly faster
-	std::string fileTypeName {filePath, filePath.length() - 3, 3};
-	if(fileTypeName == "tga") {
-		m_IsSTBLoad = false;
-		// loads data to m_UCharTexData, m_Width and m_Height
-		bool result = LoadTarga32Bit(filePath.c_str(), &m_TempUCharTexData, m_Width, m_Height);
-		if(!result) {
-			return false;
+int Texture::GetMipTailFirstMip(const ImageData& image, int maxSize) {
+	int firstMip = 0;
+	for(int mip = 0; mip < GetImageMipCount(image); mip++) {
+		if(!IsValidFirstMip(image, mip)) {
+			continue;
 		}
-	}
-	else if(fileTypeName == "hdr") {
-		m_IsSTBLoad = true;
-		int nrComponents;
-		m_TempFloatTexData = stbi_loadf(filePath.c_str(), &m_Width, &m_Height, &nrComponents, 4);
-		if(!m_TempFloatTexData) {
-			return false;
+		firstMip = mip;
+		if(std::max(GetMipSize(image.width, mip), GetMipSize(image.height, mip)) <= maxSize) {
+			break;
 		}
 	}
-	else {
-		m_IsSTBLoad = true;
-		int nrComponents;
-		m_TempUCharTexData = stbi_load(filePath.c_str(), &m_Width, &m_Height, &nrComponents, 4);
-		if(!m_TempUCharTexData) {
-			return false;
-		}
+	return firstMip;
+}
+
+bool Texture::IsValidFirstMip(const ImageData& image, int mip) {
+	if(!DDSFile::IsBlockCompressed(GetImageDataFormat(image))) {
+		return true;
 	}
+	return GetMipSize(image.width, mip) % 4 == 0 && GetMipSize(image.height, mip) % 4 == 0;
+}
 
-	// Setup the description of the texture.
-	D3D11_TEXTURE2D_DESC textureDesc {};
-	textureDesc.Height = m_Height;
-	textureDesc.Width = m_Width;
-	textureDesc.ArraySize = 1;
-	textureDesc.MipLevels = mipLevels;
-	textureDesc.Format = format;
-	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
-	textureDesc.MiscFlags = 0;
-	textureDesc.SampleDesc.Count = 1;
-	textureDesc.SampleDesc.Quality = 0;
-	textureDesc.Usage = D3D11_USAGE_DEFAULT;
-	textureDesc.CPUAccessFlags = 0;
+bool Texture::InitializeStreamed(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ImageData& image, int firstMip) {
+	if(!IsStreamable(image) || firstMip < 0 || firstMip >= GetImageMipCount(image) || !IsValidFirstMip(image, firstMip)) {
+		return false;
+	}
 
-	if(b_GenerateMips) {
-		textureDesc.MiscFlags |= D3D11_RESOURCE_MISC_GENERATE_MIPS;
+	// Zero copy from the mapped file, like Initialize
+	D3D11_SUBRESOURCE_DATA initialData[DDSFile::kMaxMipCount] {};
+	for(int mip = firstMip; mip < GetImageMipCount(image); mip++) {
+		initialData[mip - firstMip].pSysMem = GetImageMipData(image, mip);
+		initialData[mip - firstMip].SysMemPitch = (UINT)GetImageRowPitch(image, mip);
+		initialData[mip - firstMip].SysMemSlicePitch = (UINT)GetImageRowPitch(image, mip) * GetImageRowCount(image, mip);
 	}
 
-	// Create the empty texture.
-	HRESULT hResult = device->CreateTexture2D(&textureDesc, NULL, &m_Texture);
-	if(FAILED(hResult)) {
+	m_StreamingImage = image;
+	ID3D11Texture2D* texture = nullptr;
+	if(!CreateMipChainTexture(device, firstMip, initialData, &texture)) {
+		m_StreamingImage = ImageData {};
 		return false;
 	}
+	image = ImageData {};
+
+	m_Texture = texture;
+	m_Width = m_StreamingImage.width;
+	m_Height = m_StreamingImage.height;
+	m_ResidentMip = firstMip;
+	m_ViewMip = firstMip;
+	m_StreamedRowCount = 0;
+	return CreateView(device, 0);
+}
 
-	{
-		std::lock_guard<std::mutex> lock {deviceContextMutex};
-		// uchar texture load and clean up
-		if(m_TempUCharTexData) {
-			deviceContext->UpdateSubresource(m_Texture, 0, NULL, m_TempUCharTexData, m_Width * 4 * sizeof(unsigned char), 0);
-			if(m_IsSTBLoad) {
-				stbi_image_free(m_TempUCharTexData);
-			}
-			else {
-				delete[] m_TempUCharTexData;
+bool Texture::SetResidentMip(ID3D11Device* device, ID3D11DeviceContext* deviceContext, int mip) {
+	if(mip == m_ResidentMip) {
+		return true;
+	}
+	if(!IsStreamed() || mip < 0 || mip >= GetMipCount() || !IsValidFirstMip(m_StreamingImage, mip)) {
+		return false;
+	}
+
+	ID3D11Texture2D* texture = nullptr;
+	if(!CreateMipChainTexture(device, mip, nullptr, &texture)) {
+		return false;
+	}
+
+	// Complete mips move over on the GPU, a partially streamed mip starts over
+	int viewMip = std::max(mip, m_ViewMip);
+	for(int copiedMip = viewMip; copiedMip < GetMipCount(); copiedMip++) {
+		deviceContext->CopySubresourceRegion(texture, (UINT)(copiedMip - mip), 0, 0, 0, m_Texture, (UINT)(copiedMip - m_ResidentMip), nullptr);
+	}
+	m_Texture->Release();
+	m_Texture = texture;
+
+	m_ResidentMip = mip;
+	m_ViewMip = viewMip;
+	m_StreamedRowCount = 0;
+	return CreateView(device, m_ViewMip - m_ResidentMip);
+}
+
+bool Texture::StreamRows(ID3D11Device* device, ID3D11DeviceContext* deviceContext, size_t byteCount, size_t& uploadedBytes) {
+	uploadedBytes = 0;
+	while(m_ViewMip > m_ResidentMip && (uploadedBytes == 0 || uploadedBytes < byteCount)) {
+		int mip = m_ViewMip - 1;
+		int rowPitch = GetImageRowPitch(m_StreamingImage, mip);
+		int budgetRowCount = uploadedBytes < byteCount ? (int)std::min<size_t>((byteCount - uploadedBytes) / rowPitch, INT_MAX) : 0;
+		int rowCount = std::min(GetImageRowCount(m_StreamingImage, mip) - m_StreamedRowCount, std::max(1, budgetRowCount));
+
+		UploadMipRows(deviceContext, m_StreamingImage, mip, mip - m_ResidentMip, m_StreamedRowCount, rowCount);
+		m_StreamedRowCount += rowCount;
+		uploadedBytes += (size_t)rowCount * rowPitch;
+
+		if(m_StreamedRowCount == GetImageRowCount(m_StreamingImage, mip)) {
+			m_ViewMip = mip;
+			m_StreamedRowCount = 0;
+			if(!CreateView(device, m_ViewMip - m_ResidentMip)) {
+				return false;
 			}
-			m_TempUCharTexData = nullptr;
-		}
-		// float texture load
-		else if(m_TempFloatTexData) {
-			deviceContext->UpdateSubresource(m_Texture, 0, NULL, m_TempFloatTexData, m_Width * 4 * sizeof(float), 0);
-			stbi_image_free(m_TempFloatTexData);
-			m_TempFloatTexData = nullptr;
 		}
 	}
+	return true;
+}
 
+int Texture::GetMipForScreenSize(float screenSize) const {
+	int size = std::max(m_Width, m_Height);
+	if(!(screenSize < (float)size)) {
+		return 0;
+	}
+	if(screenSize <= 0.0f) {
+		return GetMipCount() - 1;
+	}
+	return std::clamp((int)std::floor(std::log2((float)size / screenSize)), 0, GetMipCount() - 1);
+}
 
-	/// Setup the shader resource view description.
-	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc {};
-	srvDesc.Format = format;
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.MipLevels = -1;
+int Texture::GetMipCount() const {
+	return GetImageMipCount(m_StreamingImage);
+}
 
-	// Create the shader resource view for the texture.
-	hResult = device->CreateShaderResourceView(m_Texture, &srvDesc, &m_TextureView);
-	if(FAILED(hResult)) {
-		return false;
+size_t Texture::GetMipChainSize(int mip) const {
+	size_t size = 0;
+	for(; mip < GetMipCount(); mip++) {
+		size += (size_t)GetImageRowPitch(m_StreamingImage, mip) * GetImageRowCount(m_StreamingImage, mip);
 	}
+	return size;
+}
 
-	if(b_GenerateMips) {
-		std::lock_guard<std::mutex> lock {deviceContextMutex};
-		deviceContext->GenerateMips(m_TextureView);
+bool Texture::CreateMipChainTexture(ID3D11Device* device, int firstMip, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture) const {
+	D3D11_TEXTURE2D_DESC textureDesc {};
+	textureDesc.Width = (UINT)GetMipSize(m_StreamingImage.width, firstMip);
+	textureDesc.Height = (UINT)GetMipSize(m_StreamingImage.height, firstMip);
+	textureDesc.ArraySize = 1;
+	textureDesc.MipLevels = (UINT)(GetImageMipCount(m_StreamingImage) - firstMip);
+	textureDesc.Format = GetImageDataFormat(m_StreamingImage);
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.MiscFlags = 0;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+	textureDesc.CPUAccessFlags = 0;
+
+	HRESULT hResult = device->CreateTexture2D(&textureDesc, initialData, texture);
+	if(FAILED(hResult)) {
+		return false;
 	}
 
 	return true;
@@ -258,84 +718,116 @@ bool Texture::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContex
 }
 
 
-bool Texture::LoadTarga32Bit(const char* filename, unsigned char** pData, int& width, int& height) {
-	int error {}, bpp {}, imageSize {}, index {}, i {}, j {}, k {};
-	FILE* filePtr {};
-	unsigned int count {};
-	TargaHeader targaFileHeader {};
-	unsigned char* targaImage {};
+bool Texture::LoadTarga(const char* filename, unsigned char** pData, int& width, int& height) {
+	static_assert(sizeof(TargaHeader) == 18, "TargaHeader must match the file layout");
 
-	// Open the targa file for reading in binary.
-	error = fopen_s(&filePtr, filename, "rb");
-	if(error != 0) {
+	// Mapped, so texels are swizzled straight from the file into the RGBA buffer without reading it into memory first
+	MappedFile file {};
+	if(!file.Initialize(filename)) {
 		return false;
 	}
 
-	// Read in the file header.
-	count = (unsigned int)fread(&targaFileHeader, sizeof(TargaHeader), 1, filePtr);
-	if(count != 1) {
+	if(file.GetSize() < sizeof(TargaHeader)) {
+		file.Shutdown();
 		return false;
 	}
-
-	// Get the important information from the header.
-	height = (int)targaFileHeader.height;
-	width = (int)targaFileHeader.width;
-	bpp = (int)targaFileHeader.bpp;
-
-	// Check that it is 32 bit and not 24 bit.
-	if(bpp != 32) {
+	TargaHeader header {};
+	memcpy(&header, file.GetData(), sizeof(TargaHeader));
+
+	width = (int)header.width;
+	height = (int)header.height;
+	int bytesPerTexel = header.bpp / 8;
+	bool b_IsRLE = header.imageType == s_TargaRLETrueColor;
+	bool b_IsSupported = (header.imageType == s_TargaTrueColor || b_IsRLE) && (header.bpp == 24 || header.bpp == 32) && !(header.descriptor & s_TargaRightToLeft);
+	if(!b_IsSupported || width == 0 || height == 0) {
+		file.Shutdown();
 		return false;
 	}
 
-	// Calculate the size of the 32 bit image data.
-	imageSize = width * height * 4;
-
-	// Allocate memory for the targa image data.
-	targaImage = new unsigned char[imageSize];
-
-	// Read in the targa image data.
-	count = (unsigned int)fread(targaImage, 1, imageSize, filePtr);
-	if(count != imageSize) {
-		return false;
+	// Texels follow the image id and the (unused) color map
+	size_t dataOffset = sizeof(TargaHeader) + header.idLength;
+	if(header.colorMapType == 1) {
+		int colorMapLength = header.colorMapSpec[2] | header.colorMapSpec[3] << 8;
+		dataOffset += (size_t)colorMapLength * ((header.colorMapSpec[4] + 7) / 8);
 	}
-
-	// Close the file.
-	error = fclose(filePtr);
-	if(error != 0) {
-		return false;
+	const unsigned char* data = file.GetData() + std::min(dataOffset, file.GetSize());
+	const unsigned char* dataEnd = file.GetData() + file.GetSize();
+
+	// Bottom to top unless the origin bit says otherwise
+	bool b_IsTopToBottom = (header.descriptor & s_TargaTopToBottom) != 0;
+	*pData = new unsigned char[(size_t)width * height * 4];
+	auto GetRow = [&](int y) { return *pData + (size_t)(b_IsTopToBottom ? y : height - 1 - y) * width * 4; };
+
+	bool result = true;
+	if(!b_IsRLE) {
+		size_t rowSize = (size_t)width * bytesPerTexel;
+		result = (size_t)(dataEnd - data) >= rowSize * height;
+		for(int y = 0; result && y < height; y++) {
+			SwizzleTargaTexels(data + rowSize * y, width, bytesPerTexel, GetRow(y));
+		}
 	}
-
-	// Allocate memory for the targa destination data.
-	*pData = new unsigned char[imageSize];
-
-	// Initialize the index into the targa destination data array.
-	index = 0;
-
-	// Initialize the index into the targa image data.
-	k = (width * height * 4) - (width * 4);
-
-	// Now copy the targa image data into the targa destination array in the correct order since the targa format is stored upside down and also is not in RGBA order.
-	for(j = 0; j < height; j++) {
-		for(i = 0; i < width; i++) {
-			(*pData)[index + 0] = targaImage[k + 2];  // Red.
-			(*pData)[index + 1] = targaImage[k + 1];  // Green.
-			(*pData)[index + 2] = targaImage[k + 0];  // Blue
-			(*pData)[index + 3] = targaImage[k + 3];  // Alpha
-
-			// Increment the indexes into the targa data.
-			k += 4;
-			index += 4;
+	else {
+		// Packets: a count byte, then count & 0x7F + 1 texels, or one texel repeated that many times if the high bit is set
+		// Note: packets may run on into the next row, as many writers do
+		int x = 0;
+		int y = 0;
+		while(result && y < height) {
+			if(data >= dataEnd) {
+				result = false;
+				break;
+			}
+			bool b_IsRun = (*data & 0x80) != 0;
+			int packetCount = (*data & 0x7F) + 1;
+			data++;
+
+			if(b_IsRun) {
+				if(dataEnd - data < bytesPerTexel) {
+					result = false;
+					break;
+				}
+				unsigned char texel[4] {};
+				SwizzleTargaTexels(data, 1, bytesPerTexel, texel);
+				data += bytesPerTexel;
+				while(packetCount > 0 && y < height) {
+					int count = std::min(packetCount, width - x);
+					unsigned char* texels = GetRow(y) + x * 4;
+					for(int i = 0; i < count; i++) {
+						memcpy(texels + i * 4, texel, 4);
+					}
+					packetCount -= count;
+					x += count;
+					if(x == width) {
+						x = 0;
+						y++;
+					}
+				}
+			}
+			else {
+				if(dataEnd - data < (ptrdiff_t)packetCount * bytesPerTexel) {
+					result = false;
+					break;
+				}
+				while(packetCount > 0 && y < height) {
+					int count = std::min(packetCount, width - x);
+					SwizzleTargaTexels(data, count, bytesPerTexel, GetRow(y) + x * 4);
+					data += (size_t)count * bytesPerTexel;
+					packetCount -= count;
+					x += count;
+					if(x == width) {
+						x = 0;
+						y++;
+					}
+				}
+			}
 		}
-
-		// Set the targa image data index back to the preceding row at the beginning of the column since its reading it in upside down.
-		k -= (width * 8);
 	}
 
-	// Release the targa image data now that it was copied into the destination array.
-	delete[] targaImage;
-	targaImage = nullptr;
-
-	return true;
+	file.Shutdown();
+	if(!result) {
+		delete[] *pData;
+		*pData = nullptr;
+	}
+	return result;
 }
 
 int Texture::GetWidth() {
@@ -357,20 +849,6 @@ void Texture::Shutdown() {
 		m_Texture = nullptr;
 	}
 
-	// in case of early return
-	if(m_TempUCharTexData) {
-		if(m_IsSTBLoad) {
-			stbi_image_free(m_TempUCharTexData);
-		}
-		else {
-			delete[] m_TempUCharTexData;
-		}
-		m_TempUCharTexData = nullptr;
-	}
-
-	if(m_TempFloatTexData) {
-		stbi_image_free(m_TempFloatTexData);
-		m_TempFloatTexData = nullptr;
-	}
+	FreeImageData(m_StreamingImage);
 }
 
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <d3d11.h>
+#include <algorithm>
 #include <array>
+#include <climits>
 #include <string>
-#include <future>
+#include <vector>
+
+class DDSFile;
 
 class Texture {
 public:
@@ -11,10 +15,89 @@ public:
     Texture(const Texture&) {}
     ~Texture() {}
 
-    // Initialize single texture
+    // Decoded texture file, 4 channels per texel: uCharData for 8 bit formats, hdrData for .hdr, or a mapped .dds file
+    struct ImageData {
+        int width;
+        int height;
+        unsigned char* uCharData;
+        // Already in the texture's float format (see HDRDecoder), allocated with new[]
+        unsigned char* hdrData;
+        DXGI_FORMAT hdrFormat;
+        // stb_image data is freed with stbi_image_free, the targa loader allocates with new[]
+        bool isSTBLoad;
+        // Every mip in its final GPU layout instead of texels (.dds files and cooked textures, see TextureCache), owned by the image
+        DDSFile* ddsFile;
+        // Mips 1 and up of uCharData, built on the CPU (see MipGenerator), owned by the image
+        std::vector<std::vector<unsigned char>>* mips;
+    };
+
+    // Reads and decodes a file without touching the device, so it can run on any thread (see TextureLoader)
+    // .dds files are only mapped and used as they are, in their own format and with the mips they have
+    // .hdr files are decoded straight to format if it is one HDRDecoder writes (R32G32B32A32_FLOAT, R16G16B16A16_FLOAT, R9G9B9E5_SHAREDEXP), to R16G16B16A16_FLOAT otherwise
+    static bool DecodeFile(const std::string& filePath, ImageData& image, DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN);
+    // Block compressed formats (see TextureCache::GetBlockFormat) are read from the cooked cache, the source is cooked on a miss
+    // Falls back to the decoded texels if the source can't be cooked (size not a multiple of 4, cache not writable)
+    // 8 bit texels get mipLevels mips (0 for all) built on the CPU, filtered in linear space for sRGB formats
+    static bool DecodeFile(const std::string& filePath, DXGI_FORMAT format, int mipLevels, ImageData& image);
+    // Same for a texture packed from up to 4 sources, the red channel of each in one channel (e.g. a material's ao, roughness, metallic and height maps)
+    // filePath only names it, it is cooked to TextureCache::GetCachePath(filePath); a single source is decoded as above
+    static bool DecodeFile(const std::string& filePath, const std::vector<std::string>& sourceFilePaths, DXGI_FORMAT format, int mipLevels, ImageData& image);
+    static void FreeImageData(ImageData& image);
+
+    // Initialize single texture, decoded and uploaded on the calling thread
     bool Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& filename, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM, int mipLevels = 0);
 
-    bool AsyncInitialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::string& filePath, DXGI_FORMAT format, int mipLevels, std::mutex deviceContextMutex);
+    // Initialize single texture from decoded data, images with every mip (see HasEveryMip) are created in one go with them as initial data
+    // Note: uses the immediate context, only call it from the thread that renders
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const ImageData& image, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM, int mipLevels = 0);
+
+    // Incremental version of the above, so TextureLoader can spread large uploads over frames
+    // BeginUpload creates the texture, UploadRows fills rows, EndUpload creates the view and generates mips if the image has none
+    // Rows are rows of every mip in turn, block rows for block compressed DDS images
+    bool BeginUpload(ID3D11Device* device, const ImageData& image, DXGI_FORMAT format, int mipLevels);
+    // Stops at the end of a mip, returns the rows uploaded
+    int UploadRows(ID3D11DeviceContext* deviceContext, const ImageData& image, int firstRow, int rowCount);
+    bool EndUpload(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
+    static int GetUploadRowCount(const ImageData& image);
+    // DDS images, images with mips built on the CPU and single mip textures don't need GenerateMips (nor a render target bind)
+    static bool HasEveryMip(const ImageData& image, int mipLevels);
+    static size_t GetUploadSize(const ImageData& image);
+    // Of the mip row is in
+    static int GetRowPitch(const ImageData& image, int row);
+
+    // Shared view (e.g. a 1x1 default color) returned by GetTextureSRV until the texture is initialized, keeps a reference
+    void SetPlaceholder(ID3D11ShaderResourceView* placeholderView);
+
+    /// Mip streaming, see TextureStreamer
+    // DDS images (.dds files and cooked textures) can be streamed, their mips stay readable in the mapped file
+    static bool IsStreamable(const ImageData& image) { return image.ddsFile != nullptr; }
+    // Coarsest valid first mip (see IsValidFirstMip) no larger than maxSize texels on either side, the mip tail a streamed texture starts with
+    static int GetMipTailFirstMip(const ImageData& image, int maxSize);
+    // Block compressed textures must start with a mip whose size is a multiple of 4
+    static bool IsValidFirstMip(const ImageData& image, int mip);
+    // Creates the texture with mips firstMip and coarser only, takes ownership of image (left empty) to stream the finer mips from later
+    bool InitializeStreamed(ID3D11Device* device, ID3D11DeviceContext* deviceContext, ImageData& image, int firstMip);
+    // Reallocates the texture to hold mips mip and coarser, the complete mips both hold are copied on the GPU
+    // Mips finer than those are filled by StreamRows, until then the view is clamped to the finest complete mip (MostDetailedMip)
+    bool SetResidentMip(ID3D11Device* device, ID3D11DeviceContext* deviceContext, int mip);
+    // Uploads rows of the missing mips, coarsest first, the view moves to each mip once it is complete
+    // Stops once byteCount bytes are uploaded but always uploads a row if any is missing, uploadedBytes is what was uploaded
+    bool StreamRows(ID3D11Device* device, ID3D11DeviceContext* deviceContext, size_t byteCount, size_t& uploadedBytes);
+    // Finest mip an object needs this frame (see GameObject::RequestTextureMips), read and reset by TextureStreamer::Update
+    void RequestMip(int mip) { m_RequestedMip = std::min(m_RequestedMip, mip); }
+    int GetRequestedMip() const { return m_RequestedMip; }
+    void ResetRequestedMip() { m_RequestedMip = INT_MAX; }
+    // Mip whose texels are about a pixel each when the whole texture covers screenSize pixels (finer when in between)
+    int GetMipForScreenSize(float screenSize) const;
+    bool IsStreamed() const { return m_StreamingImage.ddsFile != nullptr; }
+    // Of the full chain, 1 for textures that are not streamed
+    int GetMipCount() const;
+    bool IsValidResidentMip(int mip) const { return IsValidFirstMip(m_StreamingImage, mip); }
+    // Finest mip held by the texture, and the finest one shaders sample (coarser while finer mips stream in)
+    int GetResidentMip() const { return m_ResidentMip; }
+    int GetViewMip() const { return m_ViewMip; }
+    // GPU size of mips mip and coarser, of streamed textures only
+    size_t GetMipChainSize(int mip) const;
 
     // Initialize cubemap texture
     bool Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const std::array<ID3D11Texture2D*, 6>& sourceHDRTexArray);
@@ -27,27 +110,41 @@ public:
     int GetHeight();
 
 private:
-    // Used in LoadTarga32Bit()
+    // Used in LoadTarga(), 18 bytes as stored in the file
     struct TargaHeader {
-        unsigned char data1[12];
+        unsigned char idLength;
+        unsigned char colorMapType;
+        // 2 uncompressed true color, 10 run length encoded true color
+        unsigned char imageType;
+        unsigned char colorMapSpec[5];
+        unsigned short xOrigin;
+        unsigned short yOrigin;
         unsigned short width;
         unsigned short height;
         unsigned char bpp;
-        unsigned char data2;
+        // Bits 0-3 alpha bits, bit 4 right to left, bit 5 top to bottom
+        unsigned char descriptor;
     };
 
     // Ordered texture file names of 6 cubemap faces
     static const inline std::array<std::string, 6> kCubeMapFaceName = {"right", "left", "top", "bottom", "back", "front"};
 
-    // Bandaid solution to check if we are using STB lib
-    bool m_IsSTBLoad {};
-
 private:
-    static bool LoadTarga32Bit(const char* filename, unsigned char** pData, int& width, int& height);
-
-    // Temp pointer to load texture binary data (declared as member only for memory cleanup in Shutdown())
-    unsigned char* m_TempUCharTexData {};
-    float* m_TempFloatTexData {};
+    // 24 and 32 bit true color, uncompressed or run length encoded, to RGBA texels with the top row first
+    static bool LoadTarga(const char* filename, unsigned char** pData, int& width, int& height);
+    // initialData holds every subresource, or is null for an empty texture
+    bool CreateTexture(ID3D11Device* device, const ImageData& image, DXGI_FORMAT format, int mipLevels, const D3D11_SUBRESOURCE_DATA* initialData);
+    // Streamed texture holding mips firstMip and coarser of m_StreamingImage
+    bool CreateMipChainTexture(ID3D11Device* device, int firstMip, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture) const;
+    // Replaces the view (or placeholder) with one whose finest mip is the texture's mostDetailedMip
+    bool CreateView(ID3D11Device* device, int mostDetailedMip);
+    // Rows of a mip of image to a subresource of m_Texture, in block rows for block compressed images
+    void UploadMipRows(ID3D11DeviceContext* deviceContext, const ImageData& image, int mip, int subresource, int firstRow, int rowCount);
+    // Channels without a source are 0, alpha 255
+    static bool PackChannels(const std::vector<std::string>& sourceFilePaths, ImageData& image);
+    static void GenerateMips(ImageData& image, DXGI_FORMAT format, int mipLevels);
+    // Mip chain of image (see MipGenerator) compressed to format and written to the cache
+    static bool CookFile(const std::string& filePath, const std::vector<std::string>& sourceFilePaths, const ImageData& image, DXGI_FORMAT format);
 
     // optionally member scoped, 
     // see https://stackoverflow.com/questions/54000030/how-when-to-release-resources-and-resource-views-in-directx
@@ -56,4 +153,12 @@ private:
     ID3D11ShaderResourceView* m_TextureView {};
     int m_Width {};
     int m_Height {};
+
+    // Streamed textures only: the image mips are streamed from, m_Texture's mip 0 is its m_ResidentMip
+    ImageData m_StreamingImage {};
+    int m_ResidentMip {};
+    int m_ViewMip {};
+    // Rows of mip m_ViewMip - 1 uploaded so far
+    int m_StreamedRowCount {};
+    int m_RequestedMip {INT_MAX};
 };
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "TextureCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+static_assert(sizeof(TextureCache::Metadata) <= sizeof(uint32_t) * DDSFile::kMetadataCount, "TextureCache::Metadata must fit in the DDS header's reserved words");
+
+namespace {
+	constexpr uint64_t s_StampOffsetBasis = 0xCBF29CE484222325;
+	constexpr uint64_t s_StampPrime = 0x100000001B3;
+}
+
+std::string TextureCache::GetCachePath(const std::string& filePath) {
+	return filePath + ".dds";
+}
+
+bool TextureCache::GetBlockFormat(DXGI_FORMAT format, BlockCompressor::BlockFormat& blockFormat) {
+	switch(format) {
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			blockFormat = BlockCompressor::kBC1;
+			return true;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			blockFormat = BlockCompressor::kBC3;
+			return true;
+		case DXGI_FORMAT_BC4_UNORM:
+			blockFormat = BlockCompressor::kBC4;
+			return true;
+		case DXGI_FORMAT_BC5_UNORM:
+			blockFormat = BlockCompressor::kBC5;
+			return true;
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			blockFormat = BlockCompressor::kBC7;
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool TextureCache::GetSourceStamp(const std::vector<std::string>& sourceFilePaths, uint64_t& sourceStamp) {
+	// FNV-1a over each source's size and write time, in source order
+	sourceStamp = s_StampOffsetBasis;
+	auto HashValue = [&sourceStamp](uint64_t value) {
+		for(int i = 0; i < 8; i++) {
+			sourceStamp = (sourceStamp ^ ((value >> (i * 8)) & 0xFF)) * s_StampPrime;
+		}
+	};
+
+	for(const std::string& sourceFilePath : sourceFilePaths) {
+		std::error_code errorCode {};
+		uint64_t fileSize = std::filesystem::file_size(sourceFilePath, errorCode);
+		if(errorCode) {
+			return false;
+		}
+
+		std::filesystem::file_time_type fileTime = std::filesystem::last_write_time(sourceFilePath, errorCode);
+		if(errorCode) {
+			return false;
+		}
+
+		HashValue(fileSize);
+		HashValue((uint64_t)fileTime.time_since_epoch().count());
+	}
+
+	return true;
+}
+
+bool TextureCache::Load(const std::string& sourceFilePath, DXGI_FORMAT format, DDSFile& ddsFile) {
+	return Load(sourceFilePath, {sourceFilePath}, format, ddsFile);
+}
+
+bool TextureCache::Load(const std::string& filePath, const std::vector<std::string>& sourceFilePaths, DXGI_FORMAT format, DDSFile& ddsFile) {
+	uint64_t sourceStamp {};
+	if(!GetSourceStamp(sourceFilePaths, sourceStamp)) {
+		return false;
+	}
+
+	if(!ddsFile.Initialize(GetCachePath(filePath))) {
+		return false;
+	}
+
+	Metadata metadata {};
+	memcpy(&metadata, ddsFile.GetMetadata(), sizeof(Metadata));
+	bool b_IsValid = metadata.magic == kMagic && metadata.version == kVersion && metadata.sourceStamp == sourceStamp;
+	if(!b_IsValid || ddsFile.GetFormat() != format) {
+		ddsFile.Shutdown();
+		return false;
+	}
+
+	return true;
+}
+
+bool TextureCache::Write(const std::string& sourceFilePath, DXGI_FORMAT format, int width, int height, const std::vector<std::vector<unsigned char>>& mips) {
+	return Write(sourceFilePath, {sourceFilePath}, format, width, height, mips);
+}
+
+bool TextureCache::Write(const std::string& filePath, const std::vector<std::string>& sourceFilePaths, DXGI_FORMAT format, int width, int height, const std::vector<std::vector<unsigned char>>& mips) {
+	Metadata metadata {};
+	metadata.magic = kMagic;
+	metadata.version = kVersion;
+	if(!GetSourceStamp(sourceFilePaths, metadata.sourceStamp)) {
+		return false;
+	}
+
+	uint32_t ddsMetadata[DDSFile::kMetadataCount] {};
+	memcpy(ddsMetadata, &metadata, sizeof(Metadata));
+	return DDSFile::Write(GetCachePath(filePath), format, width, height, mips, ddsMetadata);
+}
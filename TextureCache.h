@@ -0,0 +1,44 @@
+#pragma once
+#include "BlockCompressor.h"
+#include "DDSFile.h"
+
+#include <d3d11.h>
+#include <string>
+#include <cstdint>
+#include <vector>
+
+// Cooked textures: block compressed mip chains stored next to the source file as DDS files (e.g. rock_albedo.tga.dds)
+// Textures packed from several sources (see Texture::DecodeFile) are named by the caller instead (e.g. rock_packed.dds)
+// The cache stamp lives in the DDS header's reserved words (see DDSFile::GetMetadata), so any DDS viewer still opens a cooked texture
+class TextureCache {
+public:
+	// Bump when the encoders or the mip filter change, old caches are then re-cooked
+	static constexpr uint32_t kVersion = 4;
+	static constexpr uint32_t kMagic = 0x58455442; // "BTEX"
+
+	// Layout of DDSFile::GetMetadata in cooked textures
+	struct Metadata {
+		uint32_t magic;
+		uint32_t version;
+
+		// Hash of every source file's size and write time, cache is considered stale if any of them changes
+		uint64_t sourceStamp;
+	};
+
+public:
+	// Maps cooked texture of sourceFilePath, fails if it does not exist, is invalid, is out of date or was cooked to another format
+	static bool Load(const std::string& sourceFilePath, DXGI_FORMAT format, DDSFile& ddsFile);
+	// Same for a texture cooked from several sources, stored at GetCachePath(filePath)
+	static bool Load(const std::string& filePath, const std::vector<std::string>& sourceFilePaths, DXGI_FORMAT format, DDSFile& ddsFile);
+
+	// Cook texture to disk, mips hold the compressed mip chain from mip 0, mip n is max(1, size >> n) texels
+	static bool Write(const std::string& sourceFilePath, DXGI_FORMAT format, int width, int height, const std::vector<std::vector<unsigned char>>& mips);
+	static bool Write(const std::string& filePath, const std::vector<std::string>& sourceFilePaths, DXGI_FORMAT format, int width, int height, const std::vector<std::vector<unsigned char>>& mips);
+	static std::string GetCachePath(const std::string& filePath);
+
+	// Encoder of a block compressed format, false for formats BlockCompressor can't write
+	static bool GetBlockFormat(DXGI_FORMAT format, BlockCompressor::BlockFormat& blockFormat);
+
+private:
+	static bool GetSourceStamp(const std::vector<std::string>& sourceFilePaths, uint64_t& sourceStamp);
+};
@@ -0,0 +1,306 @@
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+	// Largest single UpdateSubresource, so the time budget is checked between reasonably small copies
+	constexpr int s_MaxUploadStepSize = 256 * 1024;
+	// Weight of the last upload step in the running upload cost estimate
+	constexpr float s_UploadCostSmoothing = 0.25f;
+}
+
+void TextureLoader::Initialize(int threadCount) {
+	if(threadCount <= 0) {
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+
+	mb_IsShuttingDown = false;
+	m_Workers.reserve(threadCount);
+	for(int i = 0; i < threadCount; i++) {
+		m_Workers.emplace_back(&TextureLoader::WorkerLoop, this);
+	}
+}
+
+void TextureLoader::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock {m_Mutex};
+		mb_IsShuttingDown = true;
+	}
+	m_LoadQueued.notify_all();
+
+	for(std::thread& worker : m_Workers) {
+		worker.join();
+	}
+	m_Workers.clear();
+
+	// Decoded but never (fully) uploaded
+	for(Entry& entry : m_Entries) {
+		Texture::FreeImageData(entry.image);
+	}
+	m_Entries.clear();
+	m_FreeHandles.clear();
+	m_NextLoadIndex = 0;
+	m_QueuedHandles.clear();
+	m_DecodedHandles.clear();
+	m_PendingCount = 0;
+}
+
+TextureLoader::Handle TextureLoader::Load(Texture* texture, const std::string& filePath, DXGI_FORMAT format, int mipLevels, LoadPriority priority, int mipTailSize) {
+	return Load(texture, filePath, {filePath}, format, mipLevels, priority, mipTailSize);
+}
+
+TextureLoader::Handle TextureLoader::Load(Texture* texture, const std::string& filePath, const std::vector<std::string>& sourceFilePaths, DXGI_FORMAT format, int mipLevels, LoadPriority priority, int mipTailSize) {
+	Handle handle {};
+	{
+		std::lock_guard<std::mutex> lock {m_Mutex};
+		if(!m_FreeHandles.empty()) {
+			handle = m_FreeHandles.back();
+			m_FreeHandles.pop_back();
+		}
+		else {
+			handle = (Handle)m_Entries.size();
+			m_Entries.emplace_back();
+		}
+
+		Entry& entry = m_Entries[handle];
+		entry.texture = texture;
+		entry.filePath = filePath;
+		entry.sourceFilePaths = sourceFilePaths;
+		entry.format = format;
+		entry.mipLevels = mipLevels;
+		entry.mipTailSize = mipTailSize;
+		entry.priority = priority;
+		entry.loadIndex = m_NextLoadIndex++;
+		entry.state = kQueued;
+
+		m_QueuedHandles.push_back(handle);
+		m_PendingCount++;
+	}
+	m_LoadQueued.notify_one();
+
+	return handle;
+}
+
+bool TextureLoader::Upload(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const UploadBudget& budget) {
+	auto startTime = std::chrono::steady_clock::now();
+	auto GetElapsedMilliseconds = [&startTime]() { return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count(); };
+
+	bool result = true;
+	m_LastUploadStats = UploadStats {};
+	while(true) {
+		// Always makes progress, then stops once either budget is used up
+		if(m_LastUploadStats.uploadedBytes > 0) {
+			bool b_IsOverByteBudget = budget.byteCount > 0 && m_LastUploadStats.uploadedBytes >= budget.byteCount;
+			bool b_IsOverTimeBudget = budget.milliseconds > 0.0f && GetElapsedMilliseconds() >= budget.milliseconds;
+			if(b_IsOverByteBudget || b_IsOverTimeBudget) {
+				break;
+			}
+		}
+
+		Handle handle {};
+		{
+			std::lock_guard<std::mutex> lock {m_Mutex};
+			handle = FindNextHandle(m_DecodedHandles);
+		}
+		if(handle == kNoHandle) {
+			break;
+		}
+
+		Entry& entry = m_Entries[handle];
+		if(entry.state == kLoadFailed) {
+			std::cout << entry.filePath << ": could not load texture\n";
+			FinishUpload(handle, false);
+			result = false;
+			continue;
+		}
+
+		// Streamed images only upload their mip tail (a few KB), the texture keeps the image to stream finer mips from
+		if(entry.mipTailSize > 0 && Texture::IsStreamable(entry.image)) {
+			bool b_IsUploaded = entry.texture->InitializeStreamed(device, deviceContext, entry.image, Texture::GetMipTailFirstMip(entry.image, entry.mipTailSize));
+			if(!b_IsUploaded) {
+				std::cout << entry.filePath << ": could not create texture\n";
+				result = false;
+			}
+			else {
+				m_LastUploadStats.uploadedBytes += (uint32_t)entry.texture->GetMipChainSize(entry.texture->GetResidentMip());
+			}
+			FinishUpload(handle, b_IsUploaded);
+			continue;
+		}
+
+		// Images with every mip that fit in what is left of both budgets are created in one go with them as initial data
+		if(entry.uploadedRowCount == 0 && Texture::HasEveryMip(entry.image, entry.mipLevels)) {
+			size_t uploadSize = Texture::GetUploadSize(entry.image);
+			bool b_FitsByteBudget = budget.byteCount == 0 || m_LastUploadStats.uploadedBytes + uploadSize <= budget.byteCount;
+			bool b_FitsTimeBudget = budget.milliseconds <= 0.0f || (m_UploadMillisecondsPerByte > 0.0f && GetElapsedMilliseconds() + m_UploadMillisecondsPerByte * uploadSize <= budget.milliseconds);
+			if(b_FitsByteBudget && b_FitsTimeBudget) {
+				float stepStartTime = GetElapsedMilliseconds();
+				bool b_IsUploaded = entry.texture->Initialize(device, deviceContext, entry.image, entry.format, entry.mipLevels);
+				if(!b_IsUploaded) {
+					std::cout << entry.filePath << ": could not create texture\n";
+					result = false;
+				}
+				else {
+					m_LastUploadStats.uploadedBytes += (uint32_t)uploadSize;
+					float stepMillisecondsPerByte = (GetElapsedMilliseconds() - stepStartTime) / uploadSize;
+					m_UploadMillisecondsPerByte = m_UploadMillisecondsPerByte > 0.0f ? m_UploadMillisecondsPerByte + s_UploadCostSmoothing * (stepMillisecondsPerByte - m_UploadMillisecondsPerByte) : stepMillisecondsPerByte;
+				}
+				FinishUpload(handle, b_IsUploaded);
+				continue;
+			}
+		}
+
+		// As many rows as both budgets have left (time estimated from the last steps' cost)
+		// A single row over budget is only uploaded when it is the first upload of the call
+		int uploadRowCount = Texture::GetUploadRowCount(entry.image);
+		int rowPitch = Texture::GetRowPitch(entry.image, entry.uploadedRowCount);
+		int rowCount = std::min(uploadRowCount - entry.uploadedRowCount, std::max(1, s_MaxUploadStepSize / rowPitch));
+		int budgetRowCount = rowCount;
+		if(budget.byteCount > 0) {
+			budgetRowCount = std::min(budgetRowCount, (int)((budget.byteCount - m_LastUploadStats.uploadedBytes) / rowPitch));
+		}
+		if(budget.milliseconds > 0.0f && m_UploadMillisecondsPerByte > 0.0f) {
+			float millisecondsLeft = std::max(0.0f, budget.milliseconds - GetElapsedMilliseconds());
+			budgetRowCount = std::min(budgetRowCount, (int)(millisecondsLeft / (m_UploadMillisecondsPerByte * rowPitch)));
+		}
+		if(budgetRowCount == 0 && m_LastUploadStats.uploadedBytes > 0) {
+			break;
+		}
+		rowCount = std::max(1, budgetRowCount);
+
+		if(entry.uploadedRowCount == 0 && !entry.texture->BeginUpload(device, entry.image, entry.format, entry.mipLevels)) {
+			std::cout << entry.filePath << ": could not create texture\n";
+			FinishUpload(handle, false);
+			result = false;
+			continue;
+		}
+
+		float stepStartTime = GetElapsedMilliseconds();
+		rowCount = entry.texture->UploadRows(deviceContext, entry.image, entry.uploadedRowCount, rowCount);
+		entry.uploadedRowCount += rowCount;
+		m_LastUploadStats.uploadedBytes += (uint32_t)(rowCount * rowPitch);
+
+		float stepMillisecondsPerByte = (GetElapsedMilliseconds() - stepStartTime) / (rowCount * rowPitch);
+		m_UploadMillisecondsPerByte = m_UploadMillisecondsPerByte > 0.0f ? m_UploadMillisecondsPerByte + s_UploadCostSmoothing * (stepMillisecondsPerByte - m_UploadMillisecondsPerByte) : stepMillisecondsPerByte;
+
+		if(entry.uploadedRowCount == uploadRowCount) {
+			bool b_IsUploaded = entry.texture->EndUpload(device, deviceContext);
+			if(!b_IsUploaded) {
+				std::cout << entry.filePath << ": could not create texture view\n";
+				result = false;
+			}
+			FinishUpload(handle, b_IsUploaded);
+		}
+	}
+
+	m_LastUploadStats.milliseconds = GetElapsedMilliseconds();
+	{
+		std::lock_guard<std::mutex> lock {m_Mutex};
+		m_LastUploadStats.backlogCount = (int)m_DecodedHandles.size();
+	}
+
+	return result;
+}
+
+bool TextureLoader::WaitAll(ID3D11Device* device, ID3D11DeviceContext* deviceContext) {
+	bool result = true;
+	while(true) {
+		{
+			std::unique_lock<std::mutex> lock {m_Mutex};
+			m_LoadDecoded.wait(lock, [this]() { return !m_DecodedHandles.empty() || m_PendingCount == 0; });
+			if(m_DecodedHandles.empty()) {
+				break;
+			}
+		}
+
+		if(!Upload(device, deviceContext, UploadBudget {})) {
+			result = false;
+		}
+	}
+
+	return result;
+}
+
+void TextureLoader::Release(Handle handle) {
+	std::lock_guard<std::mutex> lock {m_Mutex};
+	Entry& entry = m_Entries[handle];
+	entry.isReleased = true;
+	// Failed decodes still pass the upload stage (which reports them), FinishUpload frees those
+	if(entry.state == kUploaded || (entry.state == kLoadFailed && std::find(m_DecodedHandles.begin(), m_DecodedHandles.end(), handle) == m_DecodedHandles.end())) {
+		FreeEntry(handle);
+	}
+}
+
+TextureLoader::LoadState TextureLoader::GetLoadState(Handle handle) const {
+	std::lock_guard<std::mutex> lock {m_Mutex};
+	return m_Entries[handle].state;
+}
+
+TextureLoader::Handle TextureLoader::FindNextHandle(const std::vector<Handle>& handles) const {
+	Handle nextHandle = kNoHandle;
+	for(Handle handle : handles) {
+		if(nextHandle == kNoHandle || m_Entries[handle].priority > m_Entries[nextHandle].priority ||
+			(m_Entries[handle].priority == m_Entries[nextHandle].priority && m_Entries[handle].loadIndex < m_Entries[nextHandle].loadIndex)) {
+			nextHandle = handle;
+		}
+	}
+	return nextHandle;
+}
+
+void TextureLoader::FinishUpload(Handle handle, bool b_IsUploaded) {
+	Texture::FreeImageData(m_Entries[handle].image);
+	m_LastUploadStats.finishedCount++;
+
+	std::lock_guard<std::mutex> lock {m_Mutex};
+	m_Entries[handle].state = b_IsUploaded ? kUploaded : kLoadFailed;
+	m_DecodedHandles.erase(std::find(m_DecodedHandles.begin(), m_DecodedHandles.end(), handle));
+	m_PendingCount--;
+	if(m_Entries[handle].isReleased) {
+		FreeEntry(handle);
+	}
+}
+
+void TextureLoader::FreeEntry(Handle handle) {
+	m_Entries[handle] = Entry {};
+	m_FreeHandles.push_back(handle);
+}
+
+void TextureLoader::WorkerLoop() {
+	while(true) {
+		Handle handle {};
+		std::string filePath {};
+		std::vector<std::string> sourceFilePaths {};
+		DXGI_FORMAT format {};
+		int mipLevels {};
+		{
+			std::unique_lock<std::mutex> lock {m_Mutex};
+			m_LoadQueued.wait(lock, [this]() { return mb_IsShuttingDown || !m_QueuedHandles.empty(); });
+			if(mb_IsShuttingDown) {
+				return;
+			}
+			handle = FindNextHandle(m_QueuedHandles);
+			m_QueuedHandles.erase(std::find(m_QueuedHandles.begin(), m_QueuedHandles.end(), handle));
+			filePath = m_Entries[handle].filePath;
+			sourceFilePaths = m_Entries[handle].sourceFilePaths;
+			format = m_Entries[handle].format;
+			mipLevels = m_Entries[handle].mipLevels;
+		}
+
+		// Block compressed formats are read from (or cooked to) the texture cache
+		Texture::ImageData image {};
+		bool b_IsDecoded = Texture::DecodeFile(filePath, sourceFilePaths, format, mipLevels, image);
+		if(!b_IsDecoded) {
+			Texture::FreeImageData(image);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock {m_Mutex};
+			m_Entries[handle].image = image;
+			m_Entries[handle].state = b_IsDecoded ? kDecoded : kLoadFailed;
+			m_DecodedHandles.push_back(handle);
+		}
+		m_LoadDecoded.notify_all();
+	}
+}
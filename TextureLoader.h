@@ -0,0 +1,137 @@
+#pragma once
+#include <d3d11.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Texture.h"
+
+// Loads textures in two stages: files are decoded on a pool of worker threads that never touch the device,
+// then the upload stage creates and fills the textures on the thread that owns the immediate context
+// Load is called from the main thread and returns a handle to poll until it is released, Upload/WaitAll run the upload stage
+// Upload is meant to run once per frame under a budget, large textures are uploaded a few rows at a time over several frames
+class TextureLoader {
+public:
+	using Handle = uint32_t;
+
+	enum LoadState {
+		kQueued,
+		kDecoded,
+		kUploaded,
+		kLoadFailed
+	};
+
+	// Higher priorities are decoded and uploaded first, loads of the same priority in order
+	enum LoadPriority {
+		kBackgroundPriority,
+		kDefaultPriority,
+		// Something on screen is waiting for it (e.g. a material picked in the UI)
+		kUrgentPriority,
+		Num_LoadPriorities
+	};
+
+	// Per Upload call, 0 means no limit
+	// Uploads are sized to fit what is left of both, the time of a step is estimated from the cost of the previous ones
+	// Note: a call uploads at least one row, so a budget is only exceeded by a single row larger than it, or by texture creation
+	struct UploadBudget {
+		uint32_t byteCount;
+		float milliseconds;
+	};
+
+	struct UploadStats {
+		uint32_t uploadedBytes;
+		float milliseconds;
+		int finishedCount;
+		// Decoded loads still waiting for (the rest of) their upload
+		int backlogCount;
+	};
+
+public:
+	TextureLoader() {}
+	TextureLoader(const TextureLoader&) {}
+	~TextureLoader() {}
+
+	// threadCount 0 uses one worker per hardware thread, except the main thread's
+	void Initialize(int threadCount = 0);
+	// Waits for the decodes in flight, queued loads are dropped and their textures keep their placeholder
+	void Shutdown();
+
+	// Queues texture to be decoded from filePath, its placeholder (see Texture::SetPlaceholder) is replaced once the upload stage finished it
+	// Block compressed formats are cooked by the worker on a cache miss (see Texture::DecodeFile), mipLevels is ignored for them
+	// Mips of 8 bit textures are built by the worker too, so only .hdr textures with mips still use GenerateMips
+	// mipTailSize 0 uploads every mip, otherwise streamable images (see Texture::IsStreamable) only get the mips up to that size and are left to TextureStreamer
+	Handle Load(Texture* texture, const std::string& filePath, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM, int mipLevels = 0, LoadPriority priority = kDefaultPriority, int mipTailSize = 0);
+	// Texture packed from one channel of each source file, filePath names it (see Texture::DecodeFile)
+	Handle Load(Texture* texture, const std::string& filePath, const std::vector<std::string>& sourceFilePaths, DXGI_FORMAT format, int mipLevels = 0, LoadPriority priority = kDefaultPriority, int mipTailSize = 0);
+
+	// Done with handle, its entry is recycled once the load finished (right away if it has) and a later Load may return the same handle
+	// Note: only stops polling, a released load still finishes and replaces its texture's placeholder
+	void Release(Handle handle);
+
+	// Upload stage: uploads decoded loads by priority until the budget is used up, returns false if any load failed during the call
+	bool Upload(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const UploadBudget& budget);
+	// Runs the upload stage without a budget as decodes finish until every queued load is uploaded or failed
+	bool WaitAll(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
+
+	// handle must not be released yet
+	LoadState GetLoadState(Handle handle) const;
+	int GetThreadCount() const { return (int)m_Workers.size(); }
+	// Of the last Upload call
+	UploadStats GetLastUploadStats() const { return m_LastUploadStats; }
+
+private:
+	struct Entry {
+		Texture* texture {};
+		std::string filePath {};
+		std::vector<std::string> sourceFilePaths {};
+		DXGI_FORMAT format {};
+		int mipLevels {};
+		int mipTailSize {};
+		LoadPriority priority {};
+		// Order of the Load calls, handles are reused so they do not tell it
+		uint64_t loadIndex {};
+		LoadState state {};
+		// Owned by the entry between decode and upload
+		Texture::ImageData image {};
+		// Rows of image already uploaded (see Texture::UploadRows), the texture is created with the first ones
+		int uploadedRowCount {};
+		// Set by Release, the entry is freed when the load finishes
+		bool isReleased {};
+	};
+
+	void WorkerLoop();
+	// Highest priority, oldest first, kNoHandle if handles is empty
+	Handle FindNextHandle(const std::vector<Handle>& handles) const;
+	void FinishUpload(Handle handle, bool b_IsUploaded);
+	// Resets the entry and puts its handle on the free list, m_Mutex must be held
+	void FreeEntry(Handle handle);
+
+private:
+	static constexpr Handle kNoHandle = UINT32_MAX;
+
+	std::vector<std::thread> m_Workers {};
+
+	std::vector<Entry> m_Entries {};
+	// Entries of released loads that finished, reused by Load before m_Entries grows
+	std::vector<Handle> m_FreeHandles {};
+	uint64_t m_NextLoadIndex {};
+	std::vector<Handle> m_QueuedHandles {};
+	// Decoded or failed, waiting for (the rest of) the upload stage
+	std::vector<Handle> m_DecodedHandles {};
+	// Loads not through the upload stage yet
+	int m_PendingCount {};
+	bool mb_IsShuttingDown {};
+
+	// Note: guards everything above except m_Workers, decoding and uploading run unlocked
+	// Decoded entries are only touched by the upload stage, and m_Entries only grows (or has an entry reused) in Load on the same thread
+	mutable std::mutex m_Mutex {};
+	std::condition_variable m_LoadQueued {};
+	std::condition_variable m_LoadDecoded {};
+
+	UploadStats m_LastUploadStats {};
+	// Running estimate of UploadRows' cost, for the time budget
+	float m_UploadMillisecondsPerByte {};
+};
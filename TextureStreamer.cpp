@@ -0,0 +1,227 @@
+#include "TextureStreamer.h"
+#include "Texture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+
+namespace {
+	// Frames a resident mip stays after the last request for it, about 4 seconds at 60 fps (same as Model's LODs)
+	constexpr int s_EvictionFrameCount = 240;
+	// Largest upload between two looks at the time budget (same as TextureLoader's)
+	constexpr size_t s_MaxUploadStepSize = 256 * 1024;
+	// Weight of the last upload step in the running upload cost estimate
+	constexpr float s_UploadCostSmoothing = 0.25f;
+
+	bool IsValidMip(const TextureStreamer::ResidencyRequest& request, int mip) {
+		return (request.validMipMask >> mip) & 1;
+	}
+
+	// Next coarser mip the texture can keep as its finest, -1 at the tail
+	int GetNextValidMip(const TextureStreamer::ResidencyRequest& request, int mip) {
+		for(mip++; mip <= request.tailMip; mip++) {
+			if(IsValidMip(request, mip)) {
+				return mip;
+			}
+		}
+		return -1;
+	}
+}
+
+void TextureStreamer::Add(Texture* texture) {
+	Entry entry {};
+	entry.texture = texture;
+	m_Entries.push_back(entry);
+}
+
+void TextureStreamer::Shutdown() {
+	m_Entries.clear();
+	m_LastStats = Stats {};
+}
+
+bool TextureStreamer::Update(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const Budget& budget) {
+	auto startTime = std::chrono::steady_clock::now();
+	auto GetElapsedMilliseconds = [&startTime]() { return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count(); };
+
+	bool result = true;
+	m_LastStats = Stats {};
+
+	/// Requests since the last call, finer mips count right away, coarser ones only after s_EvictionFrameCount frames
+	std::vector<ResidencyRequest> requests {};
+	std::vector<Texture*> textures {};
+	for(Entry& entry : m_Entries) {
+		Texture* texture = entry.texture;
+		int requestedMip = texture->GetRequestedMip();
+		texture->ResetRequestedMip();
+		if(!texture->IsStreamed()) {
+			continue;
+		}
+
+		if(entry.tailMip < 0) {
+			entry.tailMip = texture->GetResidentMip();
+			entry.requestedMip = entry.tailMip;
+			entry.finestUnusedRequest = INT_MAX;
+		}
+		requestedMip = std::min(requestedMip, entry.tailMip);
+		if(requestedMip <= entry.requestedMip) {
+			entry.requestedMip = requestedMip;
+			entry.unusedFrameCount = 0;
+			entry.finestUnusedRequest = INT_MAX;
+		}
+		else {
+			entry.finestUnusedRequest = std::min(entry.finestUnusedRequest, requestedMip);
+			if(++entry.unusedFrameCount >= s_EvictionFrameCount) {
+				entry.requestedMip = entry.finestUnusedRequest;
+				entry.unusedFrameCount = 0;
+				entry.finestUnusedRequest = INT_MAX;
+			}
+		}
+
+		ResidencyRequest request {};
+		for(int mip = 0; mip < texture->GetMipCount(); mip++) {
+			request.mipChainSizes[mip] = texture->GetMipChainSize(mip);
+			if(texture->IsValidResidentMip(mip)) {
+				request.validMipMask |= 1u << mip;
+			}
+		}
+		request.tailMip = entry.tailMip;
+		request.requestedMip = entry.requestedMip;
+		requests.push_back(request);
+		textures.push_back(texture);
+		m_LastStats.requestedBytes += request.mipChainSizes[request.requestedMip];
+	}
+
+	std::vector<int> residentMips {};
+	SelectResidentMips(requests, budget.residentByteCount, residentMips);
+
+	/// Reallocate, evictions first so their memory is back before anything grows
+	// Evictions always run, they keep the resident memory under its budget; textures that grow wait for a frame with time left
+	bool b_HasMadeProgress = false;
+	auto IsOverTimeBudget = [&]() { return b_HasMadeProgress && budget.milliseconds > 0.0f && GetElapsedMilliseconds() >= budget.milliseconds; };
+	for(int pass = 0; pass < 2; pass++) {
+		bool b_IsEvictionPass = pass == 0;
+		for(size_t i = 0; i < textures.size(); i++) {
+			int residentMip = textures[i]->GetResidentMip();
+			if(residentMips[i] == residentMip || (residentMips[i] > residentMip) != b_IsEvictionPass) {
+				continue;
+			}
+			if(!b_IsEvictionPass && IsOverTimeBudget()) {
+				break;
+			}
+			if(!textures[i]->SetResidentMip(device, deviceContext, residentMips[i])) {
+				result = false;
+			}
+			b_HasMadeProgress = b_HasMadeProgress || !b_IsEvictionPass;
+		}
+	}
+
+	/// Missing mips, textures whose view is the most mips short of their resident mip first
+	std::vector<Texture*> streamingTextures {};
+	for(Texture* texture : textures) {
+		if(texture->GetViewMip() > texture->GetResidentMip()) {
+			streamingTextures.push_back(texture);
+		}
+	}
+	std::stable_sort(streamingTextures.begin(), streamingTextures.end(), [](const Texture* a, const Texture* b) {
+		return a->GetViewMip() - a->GetResidentMip() > b->GetViewMip() - b->GetResidentMip();
+	});
+
+	// As many bytes as both budgets have left (time estimated from the last steps' cost), then stops once either is used up
+	size_t uploadedBytes = 0;
+	for(size_t i = 0; i < streamingTextures.size(); ) {
+		Texture* texture = streamingTextures[i];
+		size_t byteCount = budget.uploadByteCount > 0 ? budget.uploadByteCount - std::min<size_t>(uploadedBytes, budget.uploadByteCount) : SIZE_MAX;
+		if(budget.milliseconds > 0.0f) {
+			byteCount = std::min(byteCount, s_MaxUploadStepSize);
+			if(m_UploadMillisecondsPerByte > 0.0f) {
+				float millisecondsLeft = std::max(0.0f, budget.milliseconds - GetElapsedMilliseconds());
+				byteCount = std::min(byteCount, (size_t)(millisecondsLeft / m_UploadMillisecondsPerByte));
+			}
+		}
+		if(b_HasMadeProgress && (byteCount == 0 || IsOverTimeBudget())) {
+			break;
+		}
+
+		// StreamRows uploads a row even when byteCount is smaller
+		float stepStartTime = GetElapsedMilliseconds();
+		size_t streamedBytes = 0;
+		if(!texture->StreamRows(device, deviceContext, byteCount, streamedBytes)) {
+			result = false;
+		}
+		uploadedBytes += streamedBytes;
+		b_HasMadeProgress = b_HasMadeProgress || streamedBytes > 0;
+
+		if(streamedBytes > 0) {
+			float stepMillisecondsPerByte = (GetElapsedMilliseconds() - stepStartTime) / streamedBytes;
+			m_UploadMillisecondsPerByte = m_UploadMillisecondsPerByte > 0.0f ? m_UploadMillisecondsPerByte + s_UploadCostSmoothing * (stepMillisecondsPerByte - m_UploadMillisecondsPerByte) : stepMillisecondsPerByte;
+		}
+		// The same texture again while it has missing rows, the step may have stopped short of the budget
+		if(streamedBytes == 0 || texture->GetViewMip() <= texture->GetResidentMip()) {
+			i++;
+		}
+	}
+
+	m_LastStats.streamedCount = (int)textures.size();
+	m_LastStats.uploadedBytes = (uint32_t)uploadedBytes;
+	m_LastStats.milliseconds = GetElapsedMilliseconds();
+	for(Texture* texture : textures) {
+		m_LastStats.residentBytes += texture->GetMipChainSize(texture->GetResidentMip());
+		if(texture->GetViewMip() > texture->GetResidentMip()) {
+			m_LastStats.streamingCount++;
+		}
+	}
+
+	return result;
+}
+
+void TextureStreamer::SelectResidentMips(const std::vector<ResidencyRequest>& requests, size_t residentByteCount, std::vector<int>& residentMips) {
+	residentMips.resize(requests.size());
+	size_t residentBytes = 0;
+	for(size_t i = 0; i < requests.size(); i++) {
+		const ResidencyRequest& request = requests[i];
+		int mip = std::clamp(request.requestedMip, 0, request.tailMip);
+		int finerMip = mip;
+		while(finerMip >= 0 && !IsValidMip(request, finerMip)) {
+			finerMip--;
+		}
+		if(finerMip >= 0) {
+			mip = finerMip;
+		}
+		else {
+			mip = GetNextValidMip(request, mip);
+		}
+
+		residentMips[i] = mip;
+		residentBytes += request.mipChainSizes[mip];
+	}
+
+	if(residentByteCount == 0) {
+		return;
+	}
+
+	// The largest finest mip goes first, so textures lose detail evenly instead of the last ones losing all of it
+	while(residentBytes > residentByteCount) {
+		int droppedIndex = -1;
+		int droppedMip = -1;
+		size_t droppedBytes = 0;
+		for(size_t i = 0; i < requests.size(); i++) {
+			int nextMip = GetNextValidMip(requests[i], residentMips[i]);
+			if(nextMip < 0) {
+				continue;
+			}
+			size_t bytes = requests[i].mipChainSizes[residentMips[i]] - requests[i].mipChainSizes[nextMip];
+			if(bytes > droppedBytes) {
+				droppedIndex = (int)i;
+				droppedMip = nextMip;
+				droppedBytes = bytes;
+			}
+		}
+		if(droppedIndex < 0) {
+			break;
+		}
+
+		residentMips[droppedIndex] = droppedMip;
+		residentBytes -= droppedBytes;
+	}
+}
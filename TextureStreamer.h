@@ -0,0 +1,83 @@
+#pragma once
+#include <d3d11.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DDSFile.h"
+
+class Texture;
+
+// Keeps only the mips objects need on the GPU: streamed textures (see Texture::InitializeStreamed) start with their mip tail,
+// objects request the finest mip their projected texel density needs every frame (see GameObject::RequestTextureMips)
+// Update then picks every texture's resident mip under a memory budget, reallocates the textures whose mip changed and uploads their missing mips under a per frame budget
+// Finer mips are streamed in right away, unused ones are only evicted some frames after the last request (like Model::UpdateResidency)
+class TextureStreamer {
+public:
+	struct Budget {
+		// GPU memory of every streamed texture's resident mips, 0 means no limit
+		size_t residentByteCount;
+		// Per Update call, 0 means no limit
+		uint32_t uploadByteCount;
+		// Per Update call, spent reallocating textures that grow and uploading their rows, 0 means no limit
+		// Note: the first reallocation or row is done whatever is left of either budget, so streaming always makes progress
+		float milliseconds;
+	};
+
+	struct Stats {
+		int streamedCount;
+		// Textures whose view is still clamped above their resident mip
+		int streamingCount;
+		size_t residentBytes;
+		// What the requests alone would keep resident
+		size_t requestedBytes;
+		uint32_t uploadedBytes;
+		float milliseconds;
+	};
+
+	// Residency of one texture as SelectResidentMips sees it, so it can run without a device
+	struct ResidencyRequest {
+		// GPU size of mip n and every coarser mip
+		size_t mipChainSizes[DDSFile::kMaxMipCount];
+		// Bit n is set if mip n can be the finest resident mip (see Texture::IsValidFirstMip), tailMip always is
+		uint32_t validMipMask;
+		// Coarsest resident mip, the one the texture was initialized with
+		int tailMip;
+		int requestedMip;
+	};
+
+public:
+	TextureStreamer() {}
+	TextureStreamer(const TextureStreamer&) {}
+	~TextureStreamer() {}
+
+	// Textures are only streamed once they are initialized streamed, until then Update skips them
+	void Add(Texture* texture);
+	void Shutdown();
+
+	// Once per frame after the requests, returns false if a texture could not be reallocated or its view created
+	bool Update(ID3D11Device* device, ID3D11DeviceContext* deviceContext, const Budget& budget);
+	// Of the last Update call
+	Stats GetLastStats() const { return m_LastStats; }
+
+	// Each texture's requested mip (the finest valid mip at or above it), then the finest mip of whichever texture's is largest is dropped until the total fits
+	// Never coarser than a texture's tail, so the total stays over budget when the tails alone don't fit
+	static void SelectResidentMips(const std::vector<ResidencyRequest>& requests, size_t residentByteCount, std::vector<int>& residentMips);
+
+private:
+	struct Entry {
+		Texture* texture {};
+		// -1 until the texture is seen streamed
+		int tailMip {-1};
+		// Finest mip requested lately, kept for s_EvictionFrameCount frames after the requests stopped asking for it
+		int requestedMip {};
+		int unusedFrameCount {};
+		int finestUnusedRequest {};
+	};
+
+private:
+	std::vector<Entry> m_Entries {};
+	Stats m_LastStats {};
+	// Running estimate of the upload cost, to turn the time budget into rows (like TextureLoader's)
+	float m_UploadMillisecondsPerByte {};
+};
@@ -0,0 +1,336 @@
+#include "VertexPacker.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+	constexpr float s_Pi = 3.14159265f;
+
+	// Smallest |w| that survives snorm8 quantization, keeps the handedness sign of w = 0 frames
+	constexpr float s_QTangentBias = 1.0f / 127.0f;
+
+	// snorm16 octahedral normals are off by thousandths of a degree, the limit is the resolution of the float acos the angle is measured with
+	constexpr float s_MaxNormalAngle = 0.05f;
+	// Every snorm8 quaternion component is off by up to 1/254 (~0.9 degrees of rotation), the w bias that keeps the handedness can add as much again
+	constexpr float s_MaxTangentAngle = 2.0f;
+
+	struct Float3 {
+		float x, y, z;
+	};
+
+	Float3 ToFloat3(const XMFLOAT3& v) { return Float3 {v.x, v.y, v.z}; }
+	XMFLOAT3 ToXMFloat3(const Float3& v) { return XMFLOAT3(v.x, v.y, v.z); }
+
+	float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	Float3 Cross(const Float3& a, const Float3& b) { return Float3 {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+	Float3 Scale(const Float3& v, float s) { return Float3 {v.x * s, v.y * s, v.z * s}; }
+	Float3 Subtract(const Float3& a, const Float3& b) { return Float3 {a.x - b.x, a.y - b.y, a.z - b.z}; }
+
+	Float3 Normalize(const Float3& v) {
+		float length = std::sqrt(Dot(v, v));
+		return length > FLT_MIN ? Scale(v, 1.0f / length) : Float3 {0.0f, 0.0f, 0.0f};
+	}
+
+	float AngleDegrees(const Float3& a, const Float3& b) {
+		return std::acos(std::clamp(Dot(Normalize(a), Normalize(b)), -1.0f, 1.0f)) * (180.0f / s_Pi);
+	}
+
+	float SignNotZero(float value) { return value >= 0.0f ? 1.0f : -1.0f; }
+
+	int16_t ToSnorm16(float value) { return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f); }
+	float FromSnorm16(int16_t value) { return std::max((float)value / 32767.0f, -1.0f); }
+	int8_t ToSnorm8(float value) { return (int8_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f); }
+	float FromSnorm8(int8_t value) { return std::max((float)value / 127.0f, -1.0f); }
+
+	/// Tangent frame helpers
+	// Orthonormal tangent frame from the source vertex, handedness is +1 if the binormal matches cross(normal, tangent)
+	void BuildOrthonormalFrame(const MeshVertex& vertex, Float3& normal, Float3& tangent, float& handedness) {
+		normal = Normalize(ToFloat3(vertex.normal));
+		if(Dot(normal, normal) == 0.0f) {
+			normal = Float3 {0.0f, 1.0f, 0.0f};
+		}
+
+		// Gram-Schmidt, fall back to any perpendicular axis when the tangent is missing, degenerate or parallel to the normal
+		tangent = ToFloat3(vertex.tangent);
+		if(!std::isfinite(tangent.x) || !std::isfinite(tangent.y) || !std::isfinite(tangent.z)) {
+			tangent = Float3 {0.0f, 0.0f, 0.0f};
+		}
+		tangent = Normalize(Subtract(tangent, Scale(normal, Dot(normal, tangent))));
+		if(Dot(tangent, tangent) == 0.0f) {
+			Float3 axis = std::abs(normal.x) < 0.9f ? Float3 {1.0f, 0.0f, 0.0f} : Float3 {0.0f, 1.0f, 0.0f};
+			tangent = Normalize(Cross(axis, normal));
+		}
+
+		handedness = Dot(Cross(normal, tangent), ToFloat3(vertex.binormal)) < 0.0f ? -1.0f : 1.0f;
+	}
+
+	// Octahedral normal encoding, maps the unit sphere onto the [-1, 1] square
+	void EncodeOctahedral(const Float3& normal, int16_t output[2]) {
+		float l1Norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		float x = normal.x / l1Norm;
+		float y = normal.y / l1Norm;
+		if(normal.z < 0.0f) {
+			float foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+			float foldedY = (1.0f - std::abs(x)) * SignNotZero(y);
+			x = foldedX;
+			y = foldedY;
+		}
+		output[0] = ToSnorm16(x);
+		output[1] = ToSnorm16(y);
+	}
+
+	Float3 DecodeOctahedral(const int16_t input[2]) {
+		Float3 normal {FromSnorm16(input[0]), FromSnorm16(input[1]), 0.0f};
+		normal.z = 1.0f - std::abs(normal.x) - std::abs(normal.y);
+		float fold = std::max(-normal.z, 0.0f);
+		normal.x += normal.x >= 0.0f ? -fold : fold;
+		normal.y += normal.y >= 0.0f ? -fold : fold;
+		return Normalize(normal);
+	}
+
+	// Quaternion of the rotation whose matrix columns are (tangent, cross(normal, tangent), normal)
+	void EncodeQTangent(const Float3& normal, const Float3& tangent, float handedness, int8_t output[4]) {
+		Float3 binormal = Cross(normal, tangent);
+
+		float m00 = tangent.x, m01 = binormal.x, m02 = normal.x;
+		float m10 = tangent.y, m11 = binormal.y, m12 = normal.y;
+		float m20 = tangent.z, m21 = binormal.z, m22 = normal.z;
+
+		float q[4] {}; // x, y, z, w
+		float trace = m00 + m11 + m22;
+		if(trace > 0.0f) {
+			float s = 0.5f / std::sqrt(trace + 1.0f);
+			q[3] = 0.25f / s;
+			q[0] = (m21 - m12) * s;
+			q[1] = (m02 - m20) * s;
+			q[2] = (m10 - m01) * s;
+		}
+		else if(m00 > m11 && m00 > m22) {
+			float s = 2.0f * std::sqrt(1.0f + m00 - m11 - m22);
+			q[3] = (m21 - m12) / s;
+			q[0] = 0.25f * s;
+			q[1] = (m01 + m10) / s;
+			q[2] = (m02 + m20) / s;
+		}
+		else if(m11 > m22) {
+			float s = 2.0f * std::sqrt(1.0f + m11 - m00 - m22);
+			q[3] = (m02 - m20) / s;
+			q[0] = (m01 + m10) / s;
+			q[1] = 0.25f * s;
+			q[2] = (m12 + m21) / s;
+		}
+		else {
+			float s = 2.0f * std::sqrt(1.0f + m22 - m00 - m11);
+			q[3] = (m10 - m01) / s;
+			q[0] = (m02 + m20) / s;
+			q[1] = (m12 + m21) / s;
+			q[2] = 0.25f * s;
+		}
+
+		float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+		float sign = q[3] < 0.0f ? -1.0f : 1.0f;
+		for(int i = 0; i < 4; i++) {
+			q[i] *= sign / length;
+		}
+
+		// q and -q are the same rotation, so the sign of w is free to store handedness once w can't quantize to 0
+		if(q[3] < s_QTangentBias) {
+			float factor = std::sqrt(1.0f - s_QTangentBias * s_QTangentBias);
+			q[0] *= factor;
+			q[1] *= factor;
+			q[2] *= factor;
+			q[3] = s_QTangentBias;
+		}
+
+		for(int i = 0; i < 4; i++) {
+			output[i] = ToSnorm8(q[i] * handedness);
+		}
+	}
+
+	// Returns the tangent (first column of the rotation), handedness is the sign of w
+	Float3 DecodeQTangent(const int8_t input[4], float& handedness) {
+		float x = FromSnorm8(input[0]);
+		float y = FromSnorm8(input[1]);
+		float z = FromSnorm8(input[2]);
+		float w = FromSnorm8(input[3]);
+		handedness = w < 0.0f ? -1.0f : 1.0f;
+
+		float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+		x *= inverseLength;
+		y *= inverseLength;
+		z *= inverseLength;
+		w *= inverseLength;
+
+		return Float3 {1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y)};
+	}
+}
+
+void VertexPacker::PackVertices(const std::vector<MeshVertex>& vertices, std::vector<PackedMeshVertex>& packedVertices, VertexDecodeParams& decodeParams) {
+	packedVertices.resize(vertices.size());
+	decodeParams = VertexDecodeParams {};
+	if(vertices.empty()) {
+		return;
+	}
+
+	/// Position quantization range
+	Float3 boundsMin {FLT_MAX, FLT_MAX, FLT_MAX};
+	Float3 boundsMax {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for(const MeshVertex& vertex : vertices) {
+		boundsMin = Float3 {std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y), std::min(boundsMin.z, vertex.position.z)};
+		boundsMax = Float3 {std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y), std::max(boundsMax.z, vertex.position.z)};
+	}
+
+	Float3 range = Subtract(boundsMax, boundsMin);
+	decodeParams.positionScale = ToXMFloat3(range);
+	decodeParams.positionBias = ToXMFloat3(boundsMin);
+
+	// Flat axes (e.g. plane y) quantize to 0
+	Float3 quantizeScale {
+		range.x > 0.0f ? 65535.0f / range.x : 0.0f,
+		range.y > 0.0f ? 65535.0f / range.y : 0.0f,
+		range.z > 0.0f ? 65535.0f / range.z : 0.0f
+	};
+
+	for(size_t i = 0; i < vertices.size(); i++) {
+		const MeshVertex& vertex = vertices[i];
+		PackedMeshVertex& packedVertex = packedVertices[i];
+
+		packedVertex.position[0] = (uint16_t)std::lround(std::clamp((vertex.position.x - boundsMin.x) * quantizeScale.x, 0.0f, 65535.0f));
+		packedVertex.position[1] = (uint16_t)std::lround(std::clamp((vertex.position.y - boundsMin.y) * quantizeScale.y, 0.0f, 65535.0f));
+		packedVertex.position[2] = (uint16_t)std::lround(std::clamp((vertex.position.z - boundsMin.z) * quantizeScale.z, 0.0f, 65535.0f));
+		packedVertex.position[3] = 65535;
+
+		packedVertex.texture[0] = FloatToHalf(vertex.texture.x);
+		packedVertex.texture[1] = FloatToHalf(vertex.texture.y);
+
+		Float3 normal {}, tangent {};
+		float handedness {};
+		BuildOrthonormalFrame(vertex, normal, tangent, handedness);
+
+		EncodeOctahedral(normal, packedVertex.normal);
+		EncodeQTangent(normal, tangent, handedness, packedVertex.qtangent);
+	}
+}
+
+MeshVertex VertexPacker::UnpackVertex(const PackedMeshVertex& packedVertex, const VertexDecodeParams& decodeParams) {
+	MeshVertex vertex {};
+	vertex.position.x = (float)packedVertex.position[0] / 65535.0f * decodeParams.positionScale.x + decodeParams.positionBias.x;
+	vertex.position.y = (float)packedVertex.position[1] / 65535.0f * decodeParams.positionScale.y + decodeParams.positionBias.y;
+	vertex.position.z = (float)packedVertex.position[2] / 65535.0f * decodeParams.positionScale.z + decodeParams.positionBias.z;
+
+	vertex.texture.x = HalfToFloat(packedVertex.texture[0]);
+	vertex.texture.y = HalfToFloat(packedVertex.texture[1]);
+
+	Float3 normal = DecodeOctahedral(packedVertex.normal);
+
+	// Re-orthogonalize against the (more precise) octahedral normal
+	float handedness {};
+	Float3 tangent = DecodeQTangent(packedVertex.qtangent, handedness);
+	tangent = Normalize(Subtract(tangent, Scale(normal, Dot(normal, tangent))));
+
+	vertex.normal = ToXMFloat3(normal);
+	vertex.tangent = ToXMFloat3(tangent);
+	vertex.binormal = ToXMFloat3(Scale(Cross(normal, tangent), handedness));
+	return vertex;
+}
+
+VertexPacker::PackingError VertexPacker::MeasurePackingError(const std::vector<MeshVertex>& vertices, const std::vector<PackedMeshVertex>& packedVertices, const VertexDecodeParams& decodeParams) {
+	PackingError error {};
+	for(size_t i = 0; i < vertices.size() && i < packedVertices.size(); i++) {
+		const MeshVertex& source = vertices[i];
+		MeshVertex decoded = UnpackVertex(packedVertices[i], decodeParams);
+
+		Float3 positionDelta = Subtract(ToFloat3(decoded.position), ToFloat3(source.position));
+		error.maxPositionError = std::max(error.maxPositionError, std::sqrt(Dot(positionDelta, positionDelta)));
+		error.maxUVError = std::max({error.maxUVError, std::abs(decoded.texture.x - source.texture.x), std::abs(decoded.texture.y - source.texture.y)});
+
+		// Tangent and binormal are compared against the orthonormal frame that was encoded
+		Float3 normal {}, tangent {};
+		float handedness {};
+		BuildOrthonormalFrame(source, normal, tangent, handedness);
+		Float3 binormal = Scale(Cross(normal, tangent), handedness);
+
+		error.maxNormalAngle = std::max(error.maxNormalAngle, AngleDegrees(ToFloat3(decoded.normal), normal));
+		error.maxTangentAngle = std::max(error.maxTangentAngle, AngleDegrees(ToFloat3(decoded.tangent), tangent));
+		error.maxBinormalAngle = std::max(error.maxBinormalAngle, AngleDegrees(ToFloat3(decoded.binormal), binormal));
+	}
+	return error;
+}
+
+VertexPacker::PackingError VertexPacker::GetPackingErrorLimits(const std::vector<MeshVertex>& vertices, const VertexDecodeParams& decodeParams) {
+	float maxCoordinate = 0.0f;
+	float maxUV = 0.0f;
+	for(const MeshVertex& vertex : vertices) {
+		maxCoordinate = std::max({maxCoordinate, std::abs(vertex.position.x), std::abs(vertex.position.y), std::abs(vertex.position.z)});
+		maxUV = std::max({maxUV, std::abs(vertex.texture.x), std::abs(vertex.texture.y)});
+	}
+
+	// Positions round to the nearest unorm16 step, the decode's float math adds a few ulps
+	Float3 halfStep = Scale(ToFloat3(decodeParams.positionScale), 0.5f / 65535.0f);
+
+	PackingError limits {};
+	limits.maxPositionError = std::sqrt(Dot(halfStep, halfStep)) + maxCoordinate * 4.0f * FLT_EPSILON;
+	limits.maxUVError = maxUV / 2048.0f + 1.0f / 16777216.0f;
+	limits.maxNormalAngle = s_MaxNormalAngle;
+	limits.maxTangentAngle = s_MaxTangentAngle;
+	limits.maxBinormalAngle = s_MaxTangentAngle;
+	return limits;
+}
+
+bool VertexPacker::IsWithinLimits(const PackingError& error, const PackingError& limits) {
+	return error.maxPositionError <= limits.maxPositionError && error.maxUVError <= limits.maxUVError && error.maxNormalAngle <= limits.maxNormalAngle &&
+		error.maxTangentAngle <= limits.maxTangentAngle && error.maxBinormalAngle <= limits.maxBinormalAngle;
+}
+
+uint16_t VertexPacker::FloatToHalf(float value) {
+	uint32_t bits {};
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+	uint32_t absBits = bits & 0x7FFFFFFF;
+
+	// Inf and NaN
+	if(absBits >= 0x7F800000) {
+		return sign | 0x7C00 | (absBits > 0x7F800000 ? 0x0200 : 0);
+	}
+
+	// Rounds to infinity (>= 65520)
+	if(absBits >= 0x477FF000) {
+		return sign | 0x7C00;
+	}
+
+	// Half denormals (< 2^-14), scale up so the mantissa is an integer
+	if(absBits < 0x38800000) {
+		float absValue {};
+		std::memcpy(&absValue, &absBits, sizeof(absValue));
+		return sign | (uint16_t)std::lrint(absValue * 16777216.0f);
+	}
+
+	// Rebias exponent, round mantissa to nearest even
+	uint32_t rounded = absBits + 0x0FFF + ((absBits >> 13) & 1);
+	return sign | (uint16_t)((rounded - 0x38000000) >> 13);
+}
+
+float VertexPacker::HalfToFloat(uint16_t value) {
+	uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1F;
+	uint32_t mantissa = value & 0x03FF;
+
+	uint32_t bits {};
+	if(exponent == 0) {
+		float denormal = (float)mantissa * (1.0f / 16777216.0f);
+		std::memcpy(&bits, &denormal, sizeof(bits));
+		bits |= sign;
+	}
+	else if(exponent == 31) {
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else {
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	float result {};
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
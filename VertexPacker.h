@@ -0,0 +1,30 @@
+#pragma once
+#include "MeshData.h"
+
+// Encodes MeshVertex into PackedMeshVertex
+// Decode functions mirror the HLSL in PBR.vs/Depth.vs so the encoding can be validated on the CPU
+class VertexPacker {
+public:
+	struct PackingError {
+		float maxPositionError;     // world units
+		float maxUVError;
+		float maxNormalAngle;       // degrees
+		float maxTangentAngle;      // degrees, against the orthonormalized source tangent
+		float maxBinormalAngle;     // degrees, against the orthonormalized source binormal
+	};
+
+	// Positions are quantized to the AABB of vertices, decodeParams receives the matching dequantization
+	// Tangent frames are orthonormalized (Gram-Schmidt against the normal), the binormal is reconstructed as cross(normal, tangent) * handedness
+	static void PackVertices(const std::vector<MeshVertex>& vertices, std::vector<PackedMeshVertex>& packedVertices, VertexDecodeParams& decodeParams);
+	static MeshVertex UnpackVertex(const PackedMeshVertex& packedVertex, const VertexDecodeParams& decodeParams);
+
+	// Round trip every vertex and report the largest error
+	static PackingError MeasurePackingError(const std::vector<MeshVertex>& vertices, const std::vector<PackedMeshVertex>& packedVertices, const VertexDecodeParams& decodeParams);
+	// Largest error the formats' precision allows for these vertices, a measured error over it is an encoding bug
+	// Half a unorm16 step per position axis, 11 significant bits of half uvs, 0.05 degrees for normals and 2 degrees for tangents/binormals
+	static PackingError GetPackingErrorLimits(const std::vector<MeshVertex>& vertices, const VertexDecodeParams& decodeParams);
+	static bool IsWithinLimits(const PackingError& error, const PackingError& limits);
+
+	static uint16_t FloatToHalf(float value);
+	static float HalfToFloat(uint16_t value);
+};